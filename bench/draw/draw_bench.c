@@ -0,0 +1,422 @@
+/**
+ * @file draw_bench.c
+ * Microbenchmarks of the LVGL draw primitives with the lv_conf.h of the terminal.
+ *
+ * Build with `make drawbench` (LVGL only, runs on the Pi and on a PC).
+ * Each case draws one primitive into a 320x240 buffer through the display's draw_ctx,
+ * i.e. the same software renderer, masks and caches the UI uses.
+ *
+ *  ./draw_bench [--filter <substr>] [--reps <n>] [--min-ms <ms>] [--json <file>]
+ *
+ * A case is repeated in samples of at least `min-ms` (the op count per sample is calibrated
+ * first) and the median, p10 and p90 of the ns/op of `reps` samples are reported.
+ * Mpix/s is computed from the area of the primitive (the pixels it covers on the screen).
+ */
+
+#include "lvgl/lvgl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HOR_RES         320
+#define VER_RES         240
+#define REPS_DEF        15
+#define MIN_MS_DEF      5
+
+typedef struct {
+    const char * name;
+    void (*draw)(const void * param);
+    const void * param;
+    uint32_t px;                /*Pixels covered by one op*/
+} bench_case_t;
+
+typedef struct {
+    lv_coord_t w;
+    lv_coord_t h;
+    lv_coord_t radius;
+    lv_coord_t shadow;
+    lv_coord_t border;
+    lv_opa_t opa;
+    bool mask;                  /*Clip by a radius mask like the content of a rounded container*/
+} rect_param_t;
+
+typedef struct {
+    const lv_img_dsc_t * img;
+    int16_t angle;              /*[0.1 deg]*/
+    uint16_t zoom;              /*256: 100%*/
+} img_param_t;
+
+typedef struct {
+    const lv_font_t * font;
+    const char * txt;
+} label_param_t;
+
+typedef struct {
+    lv_coord_t radius;
+    lv_coord_t width;
+    uint16_t angle;             /*[deg]*/
+    bool rounded;
+} arc_param_t;
+
+static lv_color_t draw_buf_mem[HOR_RES * VER_RES];
+static lv_disp_draw_buf_t draw_buf;
+static lv_disp_drv_t disp_drv;
+static lv_draw_ctx_t * draw_ctx;
+static lv_area_t screen_area;
+
+static uint8_t img_argb_64_map[64 * 64 * LV_IMG_PX_SIZE_ALPHA_BYTE];
+static uint8_t img_argb_128_map[128 * 128 * LV_IMG_PX_SIZE_ALPHA_BYTE];
+static lv_color_t img_rgb_64_map[64 * 64];
+static lv_color_t img_rgb_128_map[128 * 128];
+static lv_img_dsc_t img_argb_64;
+static lv_img_dsc_t img_argb_128;
+static lv_img_dsc_t img_rgb_64;
+static lv_img_dsc_t img_rgb_128;
+static uint8_t img_a8_128_map[128 * 128];
+static lv_img_dsc_t img_a8_128;
+
+static void flush_cb(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_p);
+static void init_image(lv_img_dsc_t * argb, uint8_t * argb_map, lv_img_dsc_t * rgb, lv_color_t * rgb_map,
+                       lv_coord_t size);
+static void init_alpha_image(lv_img_dsc_t * a8, uint8_t * a8_map, const lv_img_dsc_t * argb);
+static void draw_rect(const void * param);
+static void draw_img(const void * param);
+static void draw_label(const void * param);
+static void draw_arc(const void * param);
+static uint64_t now_ns(void);
+static int cmp_double(const void * a, const void * b);
+
+/*Text of the buttons and labels of the UI*/
+static const char txt_short[] = "Connect";
+static const char txt_long[] = "Connected:HomeNet IP:192.168.1.50";
+static const char txt_options[] = "HomeNet\nOffice-5G\nCafeGuest\nTP-LINK_3F2A\nLab\nLibrary";
+
+static const rect_param_t rect_32 = { 32, 32, 0, 0, 0, LV_OPA_COVER, false };
+static const rect_param_t rect_64 = { 64, 64, 0, 0, 0, LV_OPA_COVER, false };
+static const rect_param_t rect_160 = { 160, 120, 0, 0, 0, LV_OPA_COVER, false };
+static const rect_param_t rect_full = { HOR_RES, VER_RES, 0, 0, 0, LV_OPA_COVER, false };
+static const rect_param_t rect_64_opa = { 64, 64, 0, 0, 0, LV_OPA_50, false };
+static const rect_param_t rect_full_opa = { HOR_RES, VER_RES, 0, 0, 0, LV_OPA_50, false };
+static const rect_param_t rect_64_r8 = { 64, 64, 8, 0, 0, LV_OPA_COVER, false };
+static const rect_param_t rect_160_r8 = { 160, 120, 8, 0, 0, LV_OPA_COVER, false };
+static const rect_param_t rect_64_circle = { 64, 64, LV_RADIUS_CIRCLE, 0, 0, LV_OPA_COVER, false };
+static const rect_param_t rect_64_border = { 64, 64, 8, 0, 2, LV_OPA_COVER, false };
+static const rect_param_t rect_64_shadow = { 64, 64, 8, 10, 0, LV_OPA_COVER, false };
+static const rect_param_t rect_160_shadow = { 160, 120, 8, 20, 0, LV_OPA_COVER, false };
+static const rect_param_t rect_64_mask = { 64, 64, 0, 0, 0, LV_OPA_COVER, true };
+static const rect_param_t rect_full_mask = { HOR_RES, VER_RES, 0, 0, 0, LV_OPA_COVER, true };
+
+static const img_param_t img_argb_64_p = { &img_argb_64, 0, LV_IMG_ZOOM_NONE };
+static const img_param_t img_argb_128_p = { &img_argb_128, 0, LV_IMG_ZOOM_NONE };
+static const img_param_t img_rgb_64_p = { &img_rgb_64, 0, LV_IMG_ZOOM_NONE };
+static const img_param_t img_rgb_128_p = { &img_rgb_128, 0, LV_IMG_ZOOM_NONE };
+static const img_param_t img_argb_64_rot = { &img_argb_64, 450, LV_IMG_ZOOM_NONE };
+static const img_param_t img_argb_64_zoom = { &img_argb_64, 0, 384 };
+static const img_param_t img_a8_128_p = { &img_a8_128, 0, LV_IMG_ZOOM_NONE };
+static const img_param_t img_rgb_128_rot = { &img_rgb_128, 450, LV_IMG_ZOOM_NONE };
+
+static const label_param_t label_14_short = { &lv_font_montserrat_14, txt_short };
+static const label_param_t label_14_long = { &lv_font_montserrat_14, txt_long };
+static const label_param_t label_24_long = { &lv_font_montserrat_24, txt_long };
+static const label_param_t label_14_options = { &lv_font_montserrat_14, txt_options };
+
+static const arc_param_t arc_spinner = { 30, 6, 60, true };
+static const arc_param_t arc_ring_30 = { 30, 6, 360, false };
+static const arc_param_t arc_ring_100 = { 100, 10, 360, false };
+
+#define RECT_PX(p)      ((p).w * (p).h)
+#define IMG_PX(s)       ((s) * (s))
+#define ARC_PX(p)       ((2 * (p).radius) * (2 * (p).radius))
+
+static const bench_case_t cases[] = {
+    { "rect_32x32", draw_rect, &rect_32, RECT_PX(rect_32) },
+    { "rect_64x64", draw_rect, &rect_64, RECT_PX(rect_64) },
+    { "rect_160x120", draw_rect, &rect_160, RECT_PX(rect_160) },
+    { "rect_320x240", draw_rect, &rect_full, RECT_PX(rect_full) },
+    { "rect_64x64_opa50", draw_rect, &rect_64_opa, RECT_PX(rect_64_opa) },
+    { "rect_320x240_opa50", draw_rect, &rect_full_opa, RECT_PX(rect_full_opa) },
+    { "rect_64x64_radius8", draw_rect, &rect_64_r8, RECT_PX(rect_64_r8) },
+    { "rect_160x120_radius8", draw_rect, &rect_160_r8, RECT_PX(rect_160_r8) },
+    { "rect_64x64_circle", draw_rect, &rect_64_circle, RECT_PX(rect_64_circle) },
+    { "rect_64x64_border2", draw_rect, &rect_64_border, RECT_PX(rect_64_border) },
+    { "rect_64x64_shadow10", draw_rect, &rect_64_shadow, RECT_PX(rect_64_shadow) },
+    { "rect_160x120_shadow20", draw_rect, &rect_160_shadow, RECT_PX(rect_160_shadow) },
+    { "rect_64x64_mask", draw_rect, &rect_64_mask, RECT_PX(rect_64_mask) },
+    { "rect_320x240_mask", draw_rect, &rect_full_mask, RECT_PX(rect_full_mask) },
+    { "img_argb_64x64", draw_img, &img_argb_64_p, IMG_PX(64) },
+    { "img_argb_128x128", draw_img, &img_argb_128_p, IMG_PX(128) },
+    { "img_rgb565_64x64", draw_img, &img_rgb_64_p, IMG_PX(64) },
+    { "img_rgb565_128x128", draw_img, &img_rgb_128_p, IMG_PX(128) },
+    { "img_a8_128x128", draw_img, &img_a8_128_p, IMG_PX(128) },
+    { "img_argb_64x64_rot45", draw_img, &img_argb_64_rot, IMG_PX(64) },
+    { "img_argb_64x64_zoom150", draw_img, &img_argb_64_zoom, IMG_PX(96) },
+    { "img_rgb565_128x128_rot45", draw_img, &img_rgb_128_rot, IMG_PX(128) },
+    { "text_a4_14px_7ch", draw_label, &label_14_short, 0 },
+    { "text_a4_14px_33ch", draw_label, &label_14_long, 0 },
+    { "text_a4_24px_33ch", draw_label, &label_24_long, 0 },
+    { "text_a4_14px_6lines", draw_label, &label_14_options, 0 },
+    { "arc_spinner_r30", draw_arc, &arc_spinner, ARC_PX(arc_spinner) },
+    { "arc_ring_r30", draw_arc, &arc_ring_30, ARC_PX(arc_ring_30) },
+    { "arc_ring_r100", draw_arc, &arc_ring_100, ARC_PX(arc_ring_100) },
+};
+
+#define CASE_CNT    (sizeof(cases) / sizeof(cases[0]))
+
+int main(int argc, char ** argv)
+{
+    const char * filter = NULL;
+    const char * json_path = NULL;
+    int reps = REPS_DEF;
+    int min_ms = MIN_MS_DEF;
+    int i;
+    for(i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+        else if(strcmp(argv[i], "--json") == 0 && i + 1 < argc) json_path = argv[++i];
+        else if(strcmp(argv[i], "--reps") == 0 && i + 1 < argc) reps = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc) min_ms = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--filter <substr>] [--reps <n>] [--min-ms <ms>] [--json <file>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(reps < 1) reps = 1;
+
+    lv_init();
+
+    /*A display only to get the draw_ctx of the configured renderer*/
+    lv_disp_draw_buf_init(&draw_buf, draw_buf_mem, NULL, HOR_RES * VER_RES);
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = HOR_RES;
+    disp_drv.ver_res = VER_RES;
+    disp_drv.draw_buf = &draw_buf;
+    disp_drv.flush_cb = flush_cb;
+    lv_disp_t * disp = lv_disp_drv_register(&disp_drv);
+    draw_ctx = disp_drv.draw_ctx;
+
+    lv_area_set(&screen_area, 0, 0, HOR_RES - 1, VER_RES - 1);
+    draw_ctx->buf = draw_buf_mem;
+    draw_ctx->buf_area = &screen_area;
+    draw_ctx->clip_area = &screen_area;
+    _lv_refr_set_disp_refreshing(disp);
+
+    init_image(&img_argb_64, img_argb_64_map, &img_rgb_64, img_rgb_64_map, 64);
+    init_image(&img_argb_128, img_argb_128_map, &img_rgb_128, img_rgb_128_map, 128);
+    init_alpha_image(&img_a8_128, img_a8_128_map, &img_argb_128);
+
+    FILE * json = NULL;
+    if(json_path) {
+        json = fopen(json_path, "w");
+        if(json == NULL) {
+            fprintf(stderr, "can't open %s\n", json_path);
+            return 1;
+        }
+        fprintf(json, "{\n");
+    }
+
+    printf("%-28s %10s %10s %10s %10s\n", "case", "ns/op", "p10", "p90", "Mpix/s");
+
+    double * samples = malloc(reps * sizeof(double));
+    bool first = true;
+    uint32_t c;
+    for(c = 0; c < CASE_CNT; c++) {
+        const bench_case_t * bc = &cases[c];
+        if(filter && strstr(bc->name, filter) == NULL) continue;
+
+        /*Warm up the caches and find how many ops fill a sample*/
+        uint32_t ops = 1;
+        while(1) {
+            uint64_t t0 = now_ns();
+            uint32_t k;
+            for(k = 0; k < ops; k++) bc->draw(bc->param);
+            uint64_t t = now_ns() - t0;
+            if(t >= (uint64_t)min_ms * 1000000 || ops >= (1u << 24)) break;
+            ops *= 2;
+        }
+
+        int r;
+        for(r = 0; r < reps; r++) {
+            uint64_t t0 = now_ns();
+            uint32_t k;
+            for(k = 0; k < ops; k++) bc->draw(bc->param);
+            samples[r] = (double)(now_ns() - t0) / ops;
+        }
+        qsort(samples, reps, sizeof(double), cmp_double);
+
+        double med = samples[reps / 2];
+        double p10 = samples[reps / 10];
+        double p90 = samples[(reps * 9) / 10 < reps ? (reps * 9) / 10 : reps - 1];
+        double mpix = bc->px ? bc->px * 1000.0 / med : 0.0;
+
+        if(bc->px) printf("%-28s %10.0f %10.0f %10.0f %10.1f\n", bc->name, med, p10, p90, mpix);
+        else printf("%-28s %10.0f %10.0f %10.0f %10s\n", bc->name, med, p10, p90, "-");
+
+        if(json) {
+            fprintf(json, "%s  \"%s\": { \"ns_per_op\": %.1f, \"p10\": %.1f, \"p90\": %.1f, \"mpix_per_s\": %.2f, \"ops\": %u }",
+                    first ? "" : ",\n", bc->name, med, p10, p90, mpix, ops);
+        }
+        first = false;
+    }
+    free(samples);
+
+    if(json) {
+        fprintf(json, "\n}\n");
+        fclose(json);
+    }
+
+    return 0;
+}
+
+static void flush_cb(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_p)
+{
+    lv_disp_flush_ready(drv);
+}
+
+/*An icon like image: a gradient circle with a soft edge on transparent background, and the same without alpha*/
+static void init_image(lv_img_dsc_t * argb, uint8_t * argb_map, lv_img_dsc_t * rgb, lv_color_t * rgb_map,
+                       lv_coord_t size)
+{
+    int32_t r = size / 2;
+    int32_t x, y;
+    for(y = 0; y < size; y++) {
+        for(x = 0; x < size; x++) {
+            lv_color_t c = lv_color_make(x * 255 / size, y * 255 / size, 128);
+            int32_t dx = x - r, dy = y - r;
+            int32_t dist2 = dx * dx + dy * dy;
+            uint8_t * px = &argb_map[(y * size + x) * LV_IMG_PX_SIZE_ALPHA_BYTE];
+            lv_opa_t a = dist2 < (r - 1) * (r - 1) ? LV_OPA_COVER : dist2 < r * r ? LV_OPA_50 : LV_OPA_TRANSP;
+            memcpy(px, &c, sizeof(lv_color_t));
+            px[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = a;
+            rgb_map[y * size + x] = c;
+        }
+    }
+
+    argb->header.always_zero = 0;
+    argb->header.w = size;
+    argb->header.h = size;
+    argb->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    argb->data_size = size * size * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    argb->data = argb_map;
+
+    *rgb = *argb;
+    rgb->header.cf = LV_IMG_CF_TRUE_COLOR;
+    rgb->data_size = size * size * sizeof(lv_color_t);
+    rgb->data = (const uint8_t *)rgb_map;
+}
+
+/*The alpha channel of an image as an A8 image, like the pre-rendered options of a roller*/
+static void init_alpha_image(lv_img_dsc_t * a8, uint8_t * a8_map, const lv_img_dsc_t * argb)
+{
+    uint32_t px_cnt = argb->header.w * argb->header.h;
+    uint32_t i;
+    for(i = 0; i < px_cnt; i++) a8_map[i] = argb->data[i * LV_IMG_PX_SIZE_ALPHA_BYTE + LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
+
+    *a8 = *argb;
+    a8->header.cf = LV_IMG_CF_ALPHA_8BIT;
+    a8->data_size = px_cnt;
+    a8->data = a8_map;
+}
+
+static void draw_rect(const void * param)
+{
+    const rect_param_t * p = param;
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+    dsc.bg_color = lv_color_hex(0x2196F3);
+    dsc.bg_opa = p->opa;
+    dsc.radius = p->radius;
+    if(p->border) {
+        dsc.border_width = p->border;
+        dsc.border_color = lv_color_hex(0x101010);
+    }
+    if(p->shadow) {
+        dsc.shadow_width = p->shadow;
+        dsc.shadow_color = lv_color_black();
+        dsc.shadow_opa = LV_OPA_50;
+    }
+
+    /*Centered on the screen*/
+    lv_area_t a;
+    a.x1 = (HOR_RES - p->w) / 2;
+    a.y1 = (VER_RES - p->h) / 2;
+    a.x2 = a.x1 + p->w - 1;
+    a.y2 = a.y1 + p->h - 1;
+
+    if(p->mask) {
+        lv_draw_mask_radius_param_t mp;
+        lv_draw_mask_radius_init(&mp, &a, 16, false);
+        int16_t id = lv_draw_mask_add(&mp, NULL);
+        lv_draw_rect(draw_ctx, &dsc, &a);
+        lv_draw_mask_remove_id(id);
+        lv_draw_mask_free_param(&mp);
+    }
+    else {
+        lv_draw_rect(draw_ctx, &dsc, &a);
+    }
+}
+
+static void draw_img(const void * param)
+{
+    const img_param_t * p = param;
+    lv_draw_img_dsc_t dsc;
+    lv_draw_img_dsc_init(&dsc);
+    dsc.angle = p->angle;
+    dsc.zoom = p->zoom;
+    lv_coord_t w = p->img->header.w;
+    lv_coord_t h = p->img->header.h;
+    dsc.pivot.x = w / 2;
+    dsc.pivot.y = h / 2;
+
+    lv_area_t a;
+    a.x1 = (HOR_RES - w) / 2;
+    a.y1 = (VER_RES - h) / 2;
+    a.x2 = a.x1 + w - 1;
+    a.y2 = a.y1 + h - 1;
+    lv_draw_img(draw_ctx, &dsc, &a, p->img);
+}
+
+static void draw_label(const void * param)
+{
+    const label_param_t * p = param;
+    lv_draw_label_dsc_t dsc;
+    lv_draw_label_dsc_init(&dsc);
+    dsc.font = p->font;
+    dsc.color = lv_color_white();
+
+    lv_area_t a;
+    lv_area_set(&a, 4, VER_RES / 2, HOR_RES - 1, VER_RES - 1);
+    lv_draw_label(draw_ctx, &dsc, &a, p->txt, NULL);
+}
+
+static void draw_arc(const void * param)
+{
+    const arc_param_t * p = param;
+    lv_draw_arc_dsc_t dsc;
+    lv_draw_arc_dsc_init(&dsc);
+    dsc.color = lv_color_hex(0x2196F3);
+    dsc.width = p->width;
+    dsc.rounded = p->rounded;
+
+    lv_point_t center = { HOR_RES / 2, VER_RES / 2 };
+    lv_draw_arc(draw_ctx, &dsc, &center, p->radius, 0, p->angle);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*LV_TICK_CUSTOM of lv_conf.h (main.cpp isn't linked)*/
+uint32_t custom_tick_get(void)
+{
+    return now_ns() / 1000000;
+}
+
+static int cmp_double(const void * a, const void * b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
@@ -0,0 +1,88 @@
+#include "battery.h"
+#include "battery_history.h"
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+
+#define BATTERY_R_INT_MOHM  150     // The cell with its protection board and wiring
+#define BATTERY_LOAD_MA     450     // No current sensor: the usual draw of the Pi, the panel and the backlight
+#define BATTERY_SMOOTH_S    60      // Time constant of the open-circuit voltage filter
+
+typedef struct
+{
+    int32_t x;
+    int32_t y;
+} curve_point_t;
+
+// Divider input [uV] -> battery voltage [mV]: the 30 / 20000 ohm divider and the drop of the
+// protection diode. Measure a few points with a multimeter to calibrate a board
+static const curve_point_t cal_curve[] = {
+    {0, 100},
+    {4500, 3105},
+    {6300, 4306},
+};
+
+// Open-circuit voltage [mV] -> state of charge [%] of a Li-ion cell at room temperature
+static const curve_point_t ocv_curve[] = {
+    {3000, 0}, {3450, 5}, {3680, 10}, {3740, 20}, {3770, 30}, {3790, 40},
+    {3820, 50}, {3870, 60}, {3920, 70}, {3980, 80}, {4060, 90}, {4200, 100},
+};
+
+#define CURVE_LEN(c)    (sizeof(c) / sizeof(c[0]))
+
+static int32_t interpolate(const curve_point_t *curve, uint32_t cnt, int32_t x, bool clamp);
+
+static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
+static battery_state_t state;
+static bool has_state = false;
+static float ocv_filtered;
+
+void battery_update(const tm7711_reading_t *reading)
+{
+    int32_t mv = interpolate(cal_curve, CURVE_LEN(cal_curve), reading->value, false);
+    int32_t ocv_mv = mv + BATTERY_LOAD_MA * BATTERY_R_INT_MOHM / 1000;
+
+    pthread_mutex_lock(&state_mutex);
+    if(!has_state)
+    {
+        ocv_filtered = ocv_mv;
+    }
+    else
+    {
+        // The readings come at 2 Hz while the Message screen is shown, every 10 s otherwise
+        float dt = (reading->time_us - state.time_us) / 1e6f;
+        if(dt < 0) dt = 0;
+        ocv_filtered += (ocv_mv - ocv_filtered) * dt / (BATTERY_SMOOTH_S + dt);
+    }
+    state.mv = mv;
+    state.ocv_mv = lroundf(ocv_filtered);
+    state.soc = interpolate(ocv_curve, CURVE_LEN(ocv_curve), state.ocv_mv, true);
+    state.time_us = reading->time_us;
+    has_state = true;
+    battery_state_t cur = state;
+    pthread_mutex_unlock(&state_mutex);
+
+    battery_history_add(time(NULL), cur.mv, cur.soc);
+}
+
+bool battery_get_state(battery_state_t *out)
+{
+    pthread_mutex_lock(&state_mutex);
+    *out = state;
+    bool res = has_state;
+    pthread_mutex_unlock(&state_mutex);
+    return res;
+}
+
+// Piecewise linear, outside the curve the first or last segment is extended, or the end is kept with `clamp`
+static int32_t interpolate(const curve_point_t *curve, uint32_t cnt, int32_t x, bool clamp)
+{
+    if(clamp && x <= curve[0].x) return curve[0].y;
+    if(clamp && x >= curve[cnt - 1].x) return curve[cnt - 1].y;
+
+    uint32_t i = 1;
+    while(i < cnt - 1 && x > curve[i].x) i++;
+    const curve_point_t *a = &curve[i - 1];
+    const curve_point_t *b = &curve[i];
+    return a->y + (int64_t)(x - a->x) * (b->y - a->y) / (b->x - a->x);
+}
@@ -0,0 +1,31 @@
+#ifndef BATTERY_HH
+#define BATTERY_HH
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "devices/tm7711/tm7711.h"
+
+/*
+ * State of charge of the 1S Li-ion battery, estimated from the TM7711 readings.
+ *
+ * The divider voltage is turned into the battery voltage with a calibration table, the drop
+ * on the internal resistance under the estimated load is added back to get the open-circuit
+ * voltage, which is smoothed and looked up on the OCV curve of the cell. Each estimate is
+ * added to the history (see battery_history.h).
+ */
+
+typedef struct
+{
+    int32_t mv;             // Terminal voltage
+    int32_t ocv_mv;         // Open-circuit voltage, load compensated and smoothed
+    uint8_t soc;            // State of charge [%]
+    int64_t time_us;        // CLOCK_MONOTONIC time of the reading
+} battery_state_t;
+
+// Feed a TM7711_BATTERY reading, from one thread
+void battery_update(const tm7711_reading_t *reading);
+
+// The last estimate, from any thread. false: none yet
+bool battery_get_state(battery_state_t *state);
+
+#endif // BATTERY_HH
@@ -0,0 +1,5 @@
+BATTERY_NAME ?= devices/battery
+
+override CXXFLAGS := -I$(LVGL_DIR) $(CXXFLAGS)
+
+CXXSRCS += $(wildcard $(LVGL_DIR)/$(BATTERY_NAME)/*.cpp)
@@ -0,0 +1,249 @@
+#include "battery_history.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define FILE_MAGIC      "BATHIST1"      // The header, as long as a record
+
+typedef struct
+{
+    uint32_t bucket_s;
+    uint32_t capacity;
+    bool is_saved;
+} level_cfg_t;
+
+static const level_cfg_t level_cfgs[BATTERY_HISTORY_LEVEL_CNT] = {
+    {10, 360, false},
+    {60, 1440, true},
+    {3600, 8 * 7 * 24, true},
+};
+
+typedef struct
+{
+    battery_point_t *points;    // Ring of `capacity` points
+    uint32_t head;              // The next point written
+    uint32_t cnt;
+    int64_t bucket;             // time / bucket_s of the bucket being filled
+    int64_t mv_sum;
+    uint32_t soc_sum;
+    uint32_t sample_cnt;        // 0: no bucket being filled
+} level_t;
+
+static void load(void);
+static int compact(void);
+static int append(const battery_point_t *point);
+static void close_bucket(battery_history_level_t id);
+static void push(level_t *lv, const battery_point_t *point);
+static const char *get_path(void);
+
+static battery_point_t seconds_points[360];
+static battery_point_t minutes_points[1440];
+static battery_point_t hours_points[8 * 7 * 24];
+static level_t levels[BATTERY_HISTORY_LEVEL_CNT] = {
+    {seconds_points, 0, 0, 0, 0, 0, 0},
+    {minutes_points, 0, 0, 0, 0, 0, 0},
+    {hours_points, 0, 0, 0, 0, 0, 0},
+};
+
+static pthread_mutex_t history_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool is_loaded = false;
+static int file_fd = -1;            // Opened for appending
+static uint32_t file_records;
+
+void battery_history_add(int64_t time, int32_t mv, uint8_t soc)
+{
+    pthread_mutex_lock(&history_mutex);
+    load();
+
+    uint32_t i;
+    for(i = 0; i < BATTERY_HISTORY_LEVEL_CNT; i++)
+    {
+        // Also when the clock was set back
+        level_t *lv = &levels[i];
+        int64_t bucket = time / level_cfgs[i].bucket_s;
+        if(lv->sample_cnt && bucket != lv->bucket) close_bucket((battery_history_level_t)i);
+
+        lv->bucket = bucket;
+        lv->mv_sum += mv;
+        lv->soc_sum += soc;
+        lv->sample_cnt++;
+    }
+    pthread_mutex_unlock(&history_mutex);
+}
+
+uint32_t battery_history_get(battery_history_level_t level, battery_point_t *points, uint32_t max)
+{
+    if(max == 0) return 0;
+
+    pthread_mutex_lock(&history_mutex);
+    load();
+
+    const level_t *lv = &levels[level];
+    uint32_t capacity = level_cfgs[level].capacity;
+    uint32_t open_cnt = lv->sample_cnt ? 1 : 0;
+    uint32_t cnt = lv->cnt + open_cnt < max ? lv->cnt : max - open_cnt;
+
+    uint32_t i;
+    for(i = 0; i < cnt; i++) points[i] = lv->points[(lv->head + capacity - cnt + i) % capacity];
+    if(open_cnt)
+    {
+        battery_point_t *point = &points[cnt++];
+        point->time = lv->bucket * level_cfgs[level].bucket_s;
+        point->mv = lv->mv_sum / lv->sample_cnt;
+        point->soc = lv->soc_sum / lv->sample_cnt;
+        point->level = level;
+    }
+    pthread_mutex_unlock(&history_mutex);
+    return cnt;
+}
+
+uint32_t battery_history_get_span(battery_history_level_t level)
+{
+    return level_cfgs[level].bucket_s * level_cfgs[level].capacity;
+}
+
+// Read the saved levels once, call with history_mutex locked
+static void load(void)
+{
+    if(is_loaded) return;
+    is_loaded = true;
+
+    const char *path = get_path();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        if(errno != ENOENT) printf("[battery] %s: %s\n", path, strerror(errno));
+        return;
+    }
+
+    char magic[sizeof(battery_point_t)];
+    bool is_valid = read(fd, magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, FILE_MAGIC, sizeof(magic)) == 0;
+    battery_point_t point;
+    ssize_t len = 0;
+    while(is_valid && (len = read(fd, &point, sizeof(point))) == sizeof(point))
+    {
+        file_records++;
+        if(point.level < BATTERY_HISTORY_LEVEL_CNT && level_cfgs[point.level].is_saved) push(&levels[point.level], &point);
+    }
+    close(fd);
+
+    // A power cut in the middle of a record: the next ones would be shifted
+    if(!is_valid || len != 0)
+    {
+        printf("[battery] %s is damaged, rewritten\n", path);
+        int res = compact();
+        if(res < 0) printf("[battery] can't save the history: %s\n", strerror(-res));
+    }
+}
+
+// Rewrite the file with the points of the rings through a temporary file. 0 or -errno
+static int compact(void)
+{
+    if(file_fd >= 0) close(file_fd);
+    file_fd = -1;
+
+    const char *path = get_path();
+    char tmp_path[PATH_MAX];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0 && errno == ENOENT)
+    {
+        // /var/lib/lvgl-terminal on the first run
+        char dir[PATH_MAX];
+        snprintf(dir, sizeof(dir), "%s", path);
+        char *slash = dir;
+        while((slash = strchr(slash + 1, '/')) != NULL)
+        {
+            *slash = '\0';
+            mkdir(dir, 0755);
+            *slash = '/';
+        }
+        fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if(fd < 0) return -errno;
+
+    int res = 0;
+    if(write(fd, FILE_MAGIC, sizeof(battery_point_t)) != sizeof(battery_point_t)) res = errno ? -errno : -EIO;
+    file_records = 0;
+    uint32_t i, j;
+    for(i = 0; res == 0 && i < BATTERY_HISTORY_LEVEL_CNT; i++)
+    {
+        const level_t *lv = &levels[i];
+        uint32_t capacity = level_cfgs[i].capacity;
+        for(j = 0; res == 0 && level_cfgs[i].is_saved && j < lv->cnt; j++)
+        {
+            const battery_point_t *point = &lv->points[(lv->head + capacity - lv->cnt + j) % capacity];
+            if(write(fd, point, sizeof(battery_point_t)) != sizeof(battery_point_t)) res = errno ? -errno : -EIO;
+            file_records++;
+        }
+    }
+    if(res == 0 && fsync(fd) < 0) res = -errno;
+    if(close(fd) < 0 && res == 0) res = -errno;
+    if(res == 0 && rename(tmp_path, path) < 0) res = -errno;
+    if(res < 0) unlink(tmp_path);
+    return res;
+}
+
+// Add a record to the end of the file, create it if it's missing. 0 or -errno
+static int append(const battery_point_t *point)
+{
+    uint32_t max_records = 0;
+    uint32_t i;
+    for(i = 0; i < BATTERY_HISTORY_LEVEL_CNT; i++)
+    {
+        if(level_cfgs[i].is_saved) max_records += level_cfgs[i].capacity;
+    }
+
+    // The point is already in its ring
+    if(file_records >= 2 * max_records) return compact();
+
+    if(file_fd < 0)
+    {
+        file_fd = open(get_path(), O_WRONLY | O_APPEND | O_CLOEXEC);
+        if(file_fd < 0 && errno == ENOENT) return compact();
+        if(file_fd < 0) return -errno;
+    }
+    if(write(file_fd, point, sizeof(battery_point_t)) != sizeof(battery_point_t)) return errno ? -errno : -EIO;
+    file_records++;
+    return 0;
+}
+
+// The bucket of a level is complete, call with history_mutex locked
+static void close_bucket(battery_history_level_t id)
+{
+    level_t *lv = &levels[id];
+    battery_point_t point;
+    point.time = lv->bucket * level_cfgs[id].bucket_s;
+    point.mv = lv->mv_sum / lv->sample_cnt;
+    point.soc = lv->soc_sum / lv->sample_cnt;
+    point.level = id;
+    push(lv, &point);
+
+    lv->mv_sum = 0;
+    lv->soc_sum = 0;
+    lv->sample_cnt = 0;
+
+    if(!level_cfgs[id].is_saved) return;
+    int res = append(&point);
+    if(res < 0) printf("[battery] can't save the history: %s\n", strerror(-res));
+}
+
+static void push(level_t *lv, const battery_point_t *point)
+{
+    uint32_t capacity = level_cfgs[point->level].capacity;
+    lv->points[lv->head] = *point;
+    lv->head = (lv->head + 1) % capacity;
+    if(lv->cnt < capacity) lv->cnt++;
+}
+
+static const char *get_path(void)
+{
+    const char *path = getenv("BATTERY_HISTORY_FILE");
+    return path && path[0] ? path : BATTERY_HISTORY_PATH;
+}
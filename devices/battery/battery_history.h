@@ -0,0 +1,44 @@
+#ifndef BATTERY_HISTORY_HH
+#define BATTERY_HISTORY_HH
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * History of the battery in three resolutions: each level keeps the averages of its buckets
+ * in a ring, so a chart of weeks reads a thousand hourly points instead of the readings.
+ *
+ * The minutes and the hours are appended to a file as they're completed (8-byte records in the
+ * native byte order, no rewrite per record). When the file has twice as many records as the
+ * rings, it's rewritten with only their points. BATTERY_HISTORY_FILE overrides the path.
+ * The functions lock the history, they can be called from any thread.
+ */
+
+#define BATTERY_HISTORY_PATH    "/var/lib/lvgl-terminal/battery_history"
+
+typedef enum
+{
+    BATTERY_HISTORY_SECONDS,        // 10 s buckets, the last hour, not saved
+    BATTERY_HISTORY_MINUTES,        // The last day
+    BATTERY_HISTORY_HOURS,          // The last 8 weeks
+    BATTERY_HISTORY_LEVEL_CNT,
+} battery_history_level_t;
+
+typedef struct
+{
+    uint32_t time;          // Unix time of the start of the bucket
+    uint16_t mv;
+    uint8_t soc;            // [%]
+    uint8_t level;          // battery_history_level_t
+} battery_point_t;
+
+// Add an estimate to the bucket of each level
+void battery_history_add(int64_t time, int32_t mv, uint8_t soc);
+
+// The last points of a level, the oldest first and the unfinished bucket last. The number written
+uint32_t battery_history_get(battery_history_level_t level, battery_point_t *points, uint32_t max);
+
+// The time covered by a level [s]
+uint32_t battery_history_get_span(battery_history_level_t level);
+
+#endif // BATTERY_HISTORY_HH
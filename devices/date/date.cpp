@@ -6,8 +6,19 @@
 
 const char* weekday[7] = {"Sun.", "Mon.", "Tue.", "Wed.", "Thu.", "Fri.", "Sat."};
 
-void date_loop(void)
+static void date_timer_cb(lv_timer_t *timer);
+
+// The clock is a timer of the LVGL thread, it's shown right away and then every second
+void date_timer_create(void)
+{
+    lv_timer_t *timer = lv_timer_create(date_timer_cb, 1000, NULL);
+    date_timer_cb(timer);
+}
+
+static void date_timer_cb(lv_timer_t *timer)
 {
+    if(ui_Main == NULL) return;
+
     time_t current_time;
     struct tm *time_info;
     char time_string[100];
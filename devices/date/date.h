@@ -5,6 +5,6 @@
 #include <stdio.h>
 #include <cstdint>
 
-void date_loop(void);
+void date_timer_create(void);
 
 #endif 
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "cv.h"
+#include <pthread.h>
 #include "lvgl/lvgl.h"
 #include "ui/src/ui.h"
+#include "ui/src/ui_async.h"
 
 #define IMG_WIDTH       168
 #define IMG_HEIGHT      168
@@ -22,18 +24,31 @@ static lv_img_dsc_t cv_img_dsc = {
     .data_size = IMG_WIDTH * IMG_HEIGHT * 2,
     .data = NULL  // Dynamically update this pointer
 };
-lv_obj_t * cv_img;
+lv_obj_t * cv_img;      // Children of ui_OpenCV, NULL while it's deleted
 lv_obj_t * cv_label;
 
+// What the OpenCV screen shows. The camera thread sets it, cv_view_apply() shows it in the LVGL thread
+typedef enum {
+    CV_VIEW_LOADING,
+    CV_VIEW_FRAME,          // The last frame in cv_img_dsc
+    CV_VIEW_STOPPED,
+    CV_VIEW_FAILED,
+} cv_view_t;
+
+static pthread_mutex_t view_mutex = PTHREAD_MUTEX_INITIALIZER;
+static cv_view_t view = CV_VIEW_STOPPED;
+static bool view_is_queued = false;
+
+static void cv_view_set(cv_view_t new_view);
+static void cv_view_apply(void * user_data);
+static void cv_obj_deleted_cb(lv_event_t * e);
+
 bool cv_init()
 {
-    cv_label = lv_label_create(ui_OpenCV);
-    lv_label_set_text(cv_label, "Loading Camera...");
-    lv_obj_align(cv_label, LV_ALIGN_CENTER, 0, 0);
+    cv_view_set(CV_VIEW_LOADING);
 
     cap.open(0);
     if(!cap.isOpened()) {
-        lv_label_set_text(cv_label, "Failed to Open Camera!");
         return 0;
     }
 
@@ -44,11 +59,6 @@ bool cv_init()
     double fps = 0;
 #endif
 
-    cv_img = lv_img_create(ui_OpenCV);
-    lv_obj_align(cv_img, LV_ALIGN_CENTER, 0, 0);  
-    lv_img_set_zoom(cv_img, 256);  
-    lv_label_set_text(cv_label, " ");
-
     return 1;
 }
 
@@ -107,15 +117,69 @@ void cv_loop()
 
     uint16_t *display_buffer = (uint16_t*)trans_frame.data;
     cv_img_dsc.data = (const uint8_t*)transfor_image(display_buffer);
-    lv_img_set_src(cv_img, &cv_img_dsc);
+    cv_view_set(CV_VIEW_FRAME);
 }
 
 void cv_deinit(bool ret)
 {
     cap.release();
-    cv_img_dsc.data = (const uint8_t*)new uint16_t[IMG_WIDTH * IMG_HEIGHT]{0xFFFF}; 
-    lv_img_set_src(cv_img, cv_img_dsc.data); 
-    if(!ret) lv_label_set_text(cv_label, "Failed to Open Camera!");
+    cv_view_set(ret ? CV_VIEW_STOPPED : CV_VIEW_FAILED);
+}
+
+// Called by the camera thread, the frames coming before cv_view_apply() runs are shown once
+static void cv_view_set(cv_view_t new_view)
+{
+    pthread_mutex_lock(&view_mutex);
+    view = new_view;
+    if(!view_is_queued) view_is_queued = ui_async_call(cv_view_apply, NULL) == LV_RES_OK;
+    pthread_mutex_unlock(&view_mutex);
+}
+
+// Runs in the LVGL thread, the image and the label are created on the OpenCV screen when it exists
+static void cv_view_apply(void * user_data)
+{
+    pthread_mutex_lock(&view_mutex);
+    view_is_queued = false;
+    cv_view_t shown = view;
+    pthread_mutex_unlock(&view_mutex);
+    if(ui_OpenCV == NULL) return;
+
+    if(cv_label == NULL) {
+        cv_label = lv_label_create(ui_OpenCV);
+        lv_obj_align(cv_label, LV_ALIGN_CENTER, 0, 0);
+        lv_obj_add_event_cb(cv_label, cv_obj_deleted_cb, LV_EVENT_DELETE, &cv_label);
+    }
+    if(cv_img == NULL) {
+        cv_img = lv_img_create(ui_OpenCV);
+        lv_obj_align(cv_img, LV_ALIGN_CENTER, 0, 0);
+        lv_img_set_zoom(cv_img, 256);
+        lv_obj_add_event_cb(cv_img, cv_obj_deleted_cb, LV_EVENT_DELETE, &cv_img);
+    }
+
+    switch(shown) {
+        case CV_VIEW_LOADING:
+            lv_label_set_text(cv_label, "Loading Camera...");
+            break;
+        case CV_VIEW_FRAME:
+            lv_label_set_text(cv_label, " ");
+            lv_obj_clear_flag(cv_img, LV_OBJ_FLAG_HIDDEN);
+            lv_img_set_src(cv_img, &cv_img_dsc);
+            break;
+        case CV_VIEW_STOPPED:
+            lv_obj_add_flag(cv_img, LV_OBJ_FLAG_HIDDEN);
+            break;
+        case CV_VIEW_FAILED:
+            lv_obj_add_flag(cv_img, LV_OBJ_FLAG_HIDDEN);
+            lv_label_set_text(cv_label, "Failed to Open Camera!");
+            break;
+    }
+}
+
+// The OpenCV screen was deleted, its objects are created again with it
+static void cv_obj_deleted_cb(lv_event_t * e)
+{
+    lv_obj_t ** obj = (lv_obj_t **)lv_event_get_user_data(e);
+    *obj = NULL;
 }
 
 uint8_t* transfor_image(uint16_t *data) 
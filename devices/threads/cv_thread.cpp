@@ -1,36 +1,47 @@
 #include "threads_conf.h"
 
-bool cv_is_running = false;
-bool cv_ret = false;
-pthread_t thread_cv;
+static bool cv_start(service_t *svc);
+static void cv_stop(service_t *svc);
+static void cv_tick(service_t *svc);
 
-void cv_create_thread(void) 
+// A frame every 10 ms while the OpenCV screen is shown
+static const service_desc_t cv_desc = {
+    "cv", 10, cv_start, cv_stop, cv_tick, NULL, NULL, NULL,
+};
+service_t cv_service;
+
+void cv_service_init(void)
+{
+    service_init(&cv_service, &cv_desc, NULL);
+}
+
+void cv_service_start(void)
+{
+    service_start(&cv_service);
+}
+
+void cv_service_stop(void)
+{
+    service_stop(&cv_service);
+}
+
+static bool cv_start(service_t *svc)
 {
-    if(!cv_is_running) 
-    {
-        cv_is_running = true;
-        pthread_create(&thread_cv, NULL, cv_thread, NULL);
-    }
+    if(cv_init()) return true;
+
+    // The camera can't be opened, the service stays stopped
+    cv_deinit(false);
+    return false;
 }
 
-void cv_destroy_thread(void) 
+static void cv_stop(service_t *svc)
 {
-    if(cv_is_running)
-    {
-        cv_is_running = false;
-        pthread_join(thread_cv, NULL);
-    }
+    cv_deinit(true);
 }
 
-void* cv_thread(void* arg) 
+static void cv_tick(service_t *svc)
 {
-    cv_ret = cv_init(); 
-    while(1) 
-    {
-        if(!cv_is_running || !cv_ret)break;
-        cv_loop();
-        usleep(10000); 
-    }
-    cv_deinit(cv_ret);
-    return NULL;
-}
\ No newline at end of file
+    LV_TRACE_BEGIN("cv_loop");
+    cv_loop();
+    LV_TRACE_END("cv_loop");
+}
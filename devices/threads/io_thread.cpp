@@ -0,0 +1,15 @@
+#include "threads_conf.h"
+
+// Coroutines of the devices which only wait for timers and fds, on one thread
+reactor_t io_reactor;
+
+void io_create_thread(void)
+{
+    int res = reactor_init(&io_reactor, "io");
+    if(res < 0)
+    {
+        printf("[io] reactor: %s\n", strerror(-res));
+        return;
+    }
+    reactor_spawn(&io_reactor, message_task());
+}
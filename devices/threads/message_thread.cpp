@@ -1,34 +1,150 @@
 #include "threads_conf.h"
+#include "ui/src/ui.h"
+#include "ui/src/ui_async.h"
+#include <stdlib.h>
+#include <time.h>
+#include <sys/epoll.h>
 
-bool message_is_running = false;
-pthread_t thread_message;
+#define BATTERY_INTERVAL_MS     10000       // Between two battery readings while the Message screen is hidden
+#define CHART_REFRESH_MS        10000
 
-void message_create_thread(void) 
+static co_event_t message_shown = CO_EVENT_INITIALIZER(&io_reactor);
+static pthread_mutex_t message_mutex = PTHREAD_MUTEX_INITIALIZER;  // Held while the screen is updated
+static bool message_is_shown = false;
+static bool message_is_queued = false;      // message_apply() waits in the UI queue
+static battery_history_level_t chart_level = BATTERY_HISTORY_SECONDS;
+static bool chart_is_stale = true;
+static uint32_t chart_tick;                 // lv_tick_get() of the last chart
+static battery_point_t chart_points[1440];  // The longest level
+
+static void message_apply(void *user_data);
+static void message_show(void);
+static void message_show_chart(void);
+
+// The ADC is sampled continuously while the Message screen is shown, otherwise one battery
+// reading every BATTERY_INTERVAL_MS keeps the history going. The samples wake this coroutine up
+co_task message_task(void)
 {
-    if(!message_is_running) 
+    while(1)
     {
-        message_is_running = true;
-        pthread_create(&thread_message, NULL, message_thread, NULL);
+        int res = tm7711_start();
+        if(res < 0)
+        {
+            printf("[tm7711] %s\n", strerror(-res));
+            co_await co_event_wait_for(&message_shown, BATTERY_INTERVAL_MS);
+            continue;
+        }
+
+        bool has_battery = false;
+        while(1)
+        {
+            LV_TRACE_BEGIN("tm7711_loop");
+            uint32_t updated = tm7711_loop();
+            LV_TRACE_END("tm7711_loop");
+
+            tm7711_reading_t battery;
+            if((updated & (1 << TM7711_BATTERY)) && tm7711_get_reading(TM7711_BATTERY, &battery))
+            {
+                battery_update(&battery);
+                has_battery = true;
+            }
+
+            pthread_mutex_lock(&message_mutex);
+            bool is_shown = message_is_shown;
+            if(is_shown && updated && !message_is_queued)
+            {
+                message_is_queued = ui_async_call(message_apply, NULL) == LV_RES_OK;
+            }
+            pthread_mutex_unlock(&message_mutex);
+            if(!is_shown && has_battery) break;
+
+            co_await reactor_poll(&io_reactor, tm7711_get_fd(), EPOLLIN);
+        }
+        tm7711_pause();
+
+        // Woken up right away when the screen is shown
+        co_await co_event_wait_for(&message_shown, BATTERY_INTERVAL_MS);
     }
 }
 
-void message_destroy_thread(void) 
+void message_task_start(void)
+{
+    pthread_mutex_lock(&message_mutex);
+    message_is_shown = true;
+    chart_is_stale = true;
+    pthread_mutex_unlock(&message_mutex);
+    co_event_set(&message_shown);
+}
+
+// The queued updates are dropped after it returns, the screen can be deleted. The ADC is paused after the next battery reading
+void message_task_suspend(void)
 {
-    if(message_is_running)
+    pthread_mutex_lock(&message_mutex);
+    message_is_shown = false;
+    pthread_mutex_unlock(&message_mutex);
+}
+
+// Show the next level of the history, called by the chart
+void message_chart_next_view(void)
+{
+    pthread_mutex_lock(&message_mutex);
+    chart_level = (battery_history_level_t)((chart_level + 1) % BATTERY_HISTORY_LEVEL_CNT);
+    if(message_is_shown && ui_Message != NULL) message_show_chart();
+    pthread_mutex_unlock(&message_mutex);
+}
+
+// Show the new samples in the LVGL thread
+static void message_apply(void *user_data)
+{
+    pthread_mutex_lock(&message_mutex);
+    message_is_queued = false;
+    if(message_is_shown && ui_Message != NULL) message_show();
+    pthread_mutex_unlock(&message_mutex);
+}
+
+// The battery and the temperature, call in the LVGL thread with message_mutex locked
+static void message_show(void)
+{
+    if(chart_is_stale || lv_tick_elaps(chart_tick) >= CHART_REFRESH_MS) message_show_chart();
+
+    battery_state_t battery;
+    if(!battery_get_state(&battery)) return;
+    tm7711_reading_t temp;
+    if(!tm7711_get_reading(TM7711_TEMPERATURE, &temp))
     {
-        message_is_running = false;
-        pthread_join(thread_message, NULL);
+        lv_label_set_text_fmt(ui_BatteryLabel, "Battery: %d.%03d V (%d%%)", battery.mv / 1000, battery.mv % 1000,
+                              battery.soc);
+        return;
     }
+    int32_t deci_c = temp.value / 10;
+    lv_label_set_text_fmt(ui_BatteryLabel, "Battery: %d.%03d V (%d%%)\nTemp: %s%d.%d C", battery.mv / 1000,
+                          battery.mv % 1000, battery.soc, deci_c < 0 ? "-" : "", abs(deci_c) / 10, abs(deci_c) % 10);
 }
 
-void* message_thread(void* arg) 
+// The state of charge over the span of the level, a chart point per slot of time, empty without a point
+static void message_show_chart(void)
 {
-    tm7711_init(); 
-    while(1) 
+    static const char *const view_names[BATTERY_HISTORY_LEVEL_CNT] = {"Last hour", "Last day", "Last 8 weeks"};
+    lv_label_set_text(ui_BatteryChartLabel, view_names[chart_level]);
+
+    lv_chart_series_t *series = lv_chart_get_series_next(ui_BatteryChart, NULL);
+    lv_coord_t *values = lv_chart_get_y_array(ui_BatteryChart, series);
+    uint32_t slot_cnt = lv_chart_get_point_count(ui_BatteryChart);
+    uint32_t i;
+    for(i = 0; i < slot_cnt; i++) values[i] = LV_CHART_POINT_NONE;
+
+    // The newest point falls in the last slot
+    uint32_t span = battery_history_get_span(chart_level);
+    int64_t start = (int64_t)time(NULL) - span;
+    uint32_t cnt = battery_history_get(chart_level, chart_points, sizeof(chart_points) / sizeof(chart_points[0]));
+    for(i = 0; i < cnt; i++)
     {
-        if(!message_is_running)break;
-        tm7711_loop();
-        usleep(10000); 
+        int64_t offset = (int64_t)chart_points[i].time - start;
+        if(offset < 0) continue;
+        uint32_t slot = offset * slot_cnt / span;
+        values[slot < slot_cnt ? slot : slot_cnt - 1] = chart_points[i].soc;
     }
-    return NULL;
-}
\ No newline at end of file
+    lv_chart_refresh(ui_BatteryChart);
+    chart_is_stale = false;
+    chart_tick = lv_tick_get();
+}
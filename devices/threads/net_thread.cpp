@@ -0,0 +1,64 @@
+#include "threads_conf.h"
+#include <errno.h>
+
+pthread_t thread_net;
+net_monitor_t net_monitor;
+bool net_reconnect_is_armed = true;     // Reconnect when the interface is found without a connection
+bool net_reconnect_is_pending = false;
+
+static void net_state_cb(const net_state_t *state, void *user_data);
+
+void net_create_thread(void)
+{
+    pthread_create(&thread_net, NULL, net_thread, NULL);
+    pthread_setname_np(thread_net, "net");
+}
+
+void* net_thread(void* arg)
+{
+    while(1)
+    {
+        // Sleeps in epoll_wait until the kernel reports a change
+        int res = net_monitor_open(&net_monitor, "wlan0");
+        if(res == 0)
+        {
+            do
+            {
+                res = net_monitor_run(&net_monitor, net_state_cb, NULL);
+
+                // The callback stopped the monitor to connect to a known network, then it's resynced
+                if(res == -ECANCELED && net_reconnect_is_pending)
+                {
+                    net_reconnect_is_pending = false;
+                    LV_TRACE_BEGIN("wifi_reconnect");
+                    wifi_reconnect();
+                    LV_TRACE_END("wifi_reconnect");
+                    res = 0;
+                }
+            } while(res == 0);
+            net_monitor_close(&net_monitor);
+        }
+        printf("[net] monitor: %s\n", strerror(-res));
+        sleep(5);
+    }
+    return NULL;
+}
+
+static void net_state_cb(const net_state_t *state, void *user_data)
+{
+    wifi_status_update(state);
+
+    // After booting and after each lost connection, not again until it's connected.
+    // NetworkManager doesn't autoconnect the profiles, only this reconnects the known networks.
+    bool connected = state->carrier && state->ssid[0] != '\0';
+    if(connected)
+    {
+        net_reconnect_is_armed = true;
+    }
+    else if(state->exists && net_reconnect_is_armed)
+    {
+        net_reconnect_is_armed = false;
+        net_reconnect_is_pending = true;
+        net_monitor_cancel(&net_monitor);
+    }
+}
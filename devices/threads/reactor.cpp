@@ -0,0 +1,248 @@
+#include "reactor.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define EPOLL_EVENTS_MAX    8
+
+static void *reactor_thread(void *arg);
+static void post(reactor_t *r, std::coroutine_handle<> h);
+static void add_timer(reactor_t *r, int64_t due_ms, std::coroutine_handle<> h, co_event_t *event, bool *timed_out);
+static void remove_timer(reactor_t *r, uint32_t i);
+static void resume_ready(reactor_t *r);
+static int resume_timers(reactor_t *r);
+static int64_t now_ms(void);
+
+int reactor_init(reactor_t *r, const char *name)
+{
+    r->ready_cnt = 0;
+    r->timer_cnt = 0;
+    pthread_mutex_init(&r->mutex, NULL);
+    r->epfd = epoll_create1(EPOLL_CLOEXEC);
+    r->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(r->epfd < 0 || r->wake_fd < 0) return -errno;
+
+    // The wakeups have no awaiter
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if(epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->wake_fd, &ev) < 0) return -errno;
+
+    int res = pthread_create(&r->thread, NULL, reactor_thread, r);
+    if(res != 0) return -res;
+    pthread_setname_np(r->thread, name);
+    return 0;
+}
+
+void reactor_spawn(reactor_t *r, co_task task)
+{
+    post(r, task.release());
+}
+
+void co_event_init(co_event_t *ev, reactor_t *r)
+{
+    ev->reactor = r;
+    pthread_mutex_init(&ev->mutex, NULL);
+    ev->is_set = false;
+    ev->waiter = nullptr;
+}
+
+void co_event_set(co_event_t *ev)
+{
+    pthread_mutex_lock(&ev->mutex);
+    std::coroutine_handle<> waiter = ev->waiter;
+    ev->waiter = nullptr;
+    if(!waiter) ev->is_set = true;
+    pthread_mutex_unlock(&ev->mutex);
+
+    // Resumed in the reactor's thread
+    if(waiter) post(ev->reactor, waiter);
+}
+
+void reactor_sleep_t::await_suspend(std::coroutine_handle<> h)
+{
+    add_timer(reactor, now_ms() + ms, h, NULL, NULL);
+}
+
+bool reactor_poll_t::await_suspend(std::coroutine_handle<> h)
+{
+    // One-shot, so the fd is reported once and removed when the coroutine is resumed
+    handle = h;
+    struct epoll_event ev;
+    ev.events = events | EPOLLONESHOT;
+    ev.data.ptr = this;
+    if(epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        res = -errno;
+        return false;
+    }
+    return true;
+}
+
+bool co_event_wait_t::await_suspend(std::coroutine_handle<> h)
+{
+    pthread_mutex_lock(&event->mutex);
+    bool is_set = event->is_set;
+    event->is_set = false;
+    if(!is_set) event->waiter = h;
+    pthread_mutex_unlock(&event->mutex);
+    return !is_set;
+}
+
+bool co_event_wait_for_t::await_suspend(std::coroutine_handle<> h)
+{
+    pthread_mutex_lock(&event->mutex);
+    bool is_set = event->is_set;
+    event->is_set = false;
+    if(!is_set) event->waiter = h;
+    pthread_mutex_unlock(&event->mutex);
+    if(is_set) return false;
+
+    handle = h;
+    add_timer(event->reactor, now_ms() + ms, h, event, &timed_out);
+    return true;
+}
+
+bool co_event_wait_for_t::await_resume()
+{
+    // Woken up by the event, the timeout isn't needed anymore
+    reactor_t *r = event->reactor;
+    uint32_t i;
+    for(i = 0; handle && i < r->timer_cnt; i++)
+    {
+        if(r->timers[i].timed_out == &timed_out)
+        {
+            remove_timer(r, i);
+            break;
+        }
+    }
+    return !timed_out;
+}
+
+static void *reactor_thread(void *arg)
+{
+    reactor_t *r = (reactor_t *)arg;
+    while(1)
+    {
+        resume_ready(r);
+        int timeout = resume_timers(r);
+
+        struct epoll_event evs[EPOLL_EVENTS_MAX];
+        int n = epoll_wait(r->epfd, evs, EPOLL_EVENTS_MAX, timeout);
+        if(n < 0)
+        {
+            if(errno != EINTR) printf("[reactor] epoll_wait: %s\n", strerror(errno));
+            continue;
+        }
+
+        int i;
+        for(i = 0; i < n; i++)
+        {
+            reactor_poll_t *poll = (reactor_poll_t *)evs[i].data.ptr;
+            if(poll == NULL)
+            {
+                uint64_t cnt;
+                if(read(r->wake_fd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN) printf("[reactor] wake_fd: %s\n", strerror(errno));
+                continue;
+            }
+            epoll_ctl(r->epfd, EPOLL_CTL_DEL, poll->fd, NULL);
+            poll->res = evs[i].events;
+            poll->handle.resume();
+        }
+    }
+    return NULL;
+}
+
+// Queue a coroutine to be resumed in the reactor's thread, from any thread
+static void post(reactor_t *r, std::coroutine_handle<> h)
+{
+    pthread_mutex_lock(&r->mutex);
+    if(r->ready_cnt == REACTOR_READY_MAX)
+    {
+        printf("[reactor] more than %d ready coroutines\n", REACTOR_READY_MAX);
+        abort();
+    }
+    r->ready[r->ready_cnt++] = h;
+    pthread_mutex_unlock(&r->mutex);
+
+    uint64_t one = 1;
+    if(write(r->wake_fd, &one, sizeof(one)) < 0) printf("[reactor] can't wake up: %s\n", strerror(errno));
+}
+
+static void resume_ready(reactor_t *r)
+{
+    std::coroutine_handle<> ready[REACTOR_READY_MAX];
+    pthread_mutex_lock(&r->mutex);
+    uint32_t cnt = r->ready_cnt;
+    uint32_t i;
+    for(i = 0; i < cnt; i++) ready[i] = r->ready[i];
+    r->ready_cnt = 0;
+    pthread_mutex_unlock(&r->mutex);
+
+    for(i = 0; i < cnt; i++) ready[i].resume();
+}
+
+static void add_timer(reactor_t *r, int64_t due_ms, std::coroutine_handle<> h, co_event_t *event, bool *timed_out)
+{
+    // The table is sized for the coroutines of the terminal, running out of it is a bug
+    if(r->timer_cnt == REACTOR_TIMER_MAX)
+    {
+        printf("[reactor] more than %d timers\n", REACTOR_TIMER_MAX);
+        abort();
+    }
+    reactor_timer_t *timer = &r->timers[r->timer_cnt++];
+    timer->due_ms = due_ms;
+    timer->handle = h;
+    timer->event = event;
+    timer->timed_out = timed_out;
+}
+
+static void remove_timer(reactor_t *r, uint32_t i)
+{
+    r->timers[i] = r->timers[--r->timer_cnt];
+}
+
+// Resume the coroutines whose time has come. The ms until the next timer, -1: none
+static int resume_timers(reactor_t *r)
+{
+    while(r->timer_cnt > 0)
+    {
+        uint32_t next = 0;
+        uint32_t i;
+        for(i = 1; i < r->timer_cnt; i++)
+        {
+            if(r->timers[i].due_ms < r->timers[next].due_ms) next = i;
+        }
+
+        int64_t wait_ms = r->timers[next].due_ms - now_ms();
+        if(wait_ms > 0) return wait_ms;
+
+        // Removed first, the coroutine may sleep again right away
+        reactor_timer_t timer = r->timers[next];
+        remove_timer(r, next);
+        if(timer.event)
+        {
+            // The event may have been set in the meantime, then it resumes the coroutine
+            pthread_mutex_lock(&timer.event->mutex);
+            bool is_waiting = timer.event->waiter == timer.handle;
+            if(is_waiting) timer.event->waiter = nullptr;
+            pthread_mutex_unlock(&timer.event->mutex);
+            if(!is_waiting) continue;
+            *timer.timed_out = true;
+        }
+        timer.handle.resume();
+    }
+    return -1;
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
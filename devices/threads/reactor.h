@@ -0,0 +1,196 @@
+#ifndef REACTOR_HH
+#define REACTOR_HH
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <coroutine>
+#include <exception>
+
+/*
+ * A single-threaded executor of C++20 coroutines, driven by epoll.
+ *
+ * Device workflows are written as sequential code (`co_await reactor_sleep(r, 10)`,
+ * `co_await reactor_poll(r, fd, EPOLLIN)`) and many of them share the reactor's thread
+ * instead of having a thread each. The thread sleeps in epoll_wait until a timer is due,
+ * a file descriptor is ready (a netlink socket, a GPIO edge: the value file of a sysfs or
+ * the line event fd of a gpiochip with EPOLLPRI/EPOLLIN) or another thread sets an event.
+ *
+ * A coroutine must not block: a blocking call stops all the others on the same reactor.
+ * Only reactor_spawn() and co_event_set() can be called from other threads.
+ */
+
+#define REACTOR_TIMER_MAX   16      // Coroutines sleeping at the same time
+#define REACTOR_READY_MAX   16      // Coroutines spawned or woken by other threads, not resumed yet
+
+typedef struct reactor_s reactor_t;
+
+// A coroutine returning nothing. It starts when it's spawned or awaited, not when it's called
+class co_task
+{
+public:
+    struct promise_type;
+    typedef std::coroutine_handle<promise_type> handle_t;
+
+    struct final_awaiter
+    {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(handle_t h) noexcept
+        {
+            // Back to the awaiting coroutine, a spawned one frees itself
+            std::coroutine_handle<> cont = h.promise().continuation;
+            if(cont) return cont;
+            h.destroy();
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    struct promise_type
+    {
+        std::coroutine_handle<> continuation;
+        co_task get_return_object() { return co_task(handle_t::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        final_awaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit co_task(handle_t h) : handle(h) {}
+    co_task(co_task &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    co_task(const co_task &) = delete;
+    co_task &operator=(const co_task &) = delete;
+    ~co_task() { if(handle) handle.destroy(); }
+
+    // `co_await task` runs it to its end, then the caller goes on
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+    {
+        handle.promise().continuation = caller;
+        return handle;
+    }
+    void await_resume() noexcept {}
+
+    // Hand the frame over to the reactor
+    handle_t release(void)
+    {
+        handle_t h = handle;
+        handle = nullptr;
+        return h;
+    }
+
+private:
+    handle_t handle;
+};
+
+typedef struct
+{
+    int64_t due_ms;
+    std::coroutine_handle<> handle;
+    struct co_event_s *event;       // A timeout of co_event_wait_for(), NULL: a sleep
+    bool *timed_out;
+} reactor_timer_t;
+
+struct reactor_s
+{
+    int epfd;
+    int wake_fd;                    // eventfd, something was added to `ready`
+    pthread_t thread;
+    pthread_mutex_t mutex;          // Protects `ready`
+    std::coroutine_handle<> ready[REACTOR_READY_MAX];
+    uint32_t ready_cnt;
+    reactor_timer_t timers[REACTOR_TIMER_MAX];  // Only used in the reactor's thread
+    uint32_t timer_cnt;
+};
+
+// Wakes up the coroutine waiting for it, the setting is kept if none is waiting
+typedef struct co_event_s
+{
+    reactor_t *reactor;
+    pthread_mutex_t mutex;
+    bool is_set;
+    std::coroutine_handle<> waiter;
+} co_event_t;
+
+#define CO_EVENT_INITIALIZER(r)     {r, PTHREAD_MUTEX_INITIALIZER, false, nullptr}
+
+// Create the reactor and its thread. 0 or -errno
+int reactor_init(reactor_t *r, const char *name);
+
+// Run a coroutine on the reactor, from any thread
+void reactor_spawn(reactor_t *r, co_task task);
+
+void co_event_init(co_event_t *ev, reactor_t *r);
+
+// Wake up the coroutine waiting for the event, from any thread
+void co_event_set(co_event_t *ev);
+
+/*
+ * The awaitables, `co_await` them in a coroutine running on the reactor
+ */
+
+struct reactor_sleep_t
+{
+    reactor_t *reactor;
+    uint32_t ms;
+    bool await_ready() noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h);
+    void await_resume() noexcept {}
+};
+
+struct reactor_poll_t
+{
+    reactor_t *reactor;
+    int fd;
+    uint32_t events;
+    int res;                        // The epoll events that happened or -errno
+    std::coroutine_handle<> handle;
+    bool await_ready() noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h);
+    int await_resume() noexcept { return res; }
+};
+
+struct co_event_wait_t
+{
+    co_event_t *event;
+    bool await_ready() noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h);
+    void await_resume() noexcept {}
+};
+
+struct co_event_wait_for_t
+{
+    co_event_t *event;
+    uint32_t ms;
+    bool timed_out;
+    std::coroutine_handle<> handle;
+    bool await_ready() noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h);
+    bool await_resume();
+};
+
+// Resume the coroutine after `ms` milliseconds
+static inline reactor_sleep_t reactor_sleep(reactor_t *r, uint32_t ms)
+{
+    return reactor_sleep_t{r, ms};
+}
+
+// Resume the coroutine when the fd has one of the epoll events. The events that happened or -errno
+static inline reactor_poll_t reactor_poll(reactor_t *r, int fd, uint32_t events)
+{
+    return reactor_poll_t{r, fd, events, 0, nullptr};
+}
+
+// Resume the coroutine when the event is set, then clear it
+static inline co_event_wait_t co_event_wait(co_event_t *ev)
+{
+    return co_event_wait_t{ev};
+}
+
+// Like co_event_wait(), but at most for `ms` milliseconds. true: the event was set, false: timeout
+static inline co_event_wait_for_t co_event_wait_for(co_event_t *ev, uint32_t ms)
+{
+    return co_event_wait_for_t{ev, ms, false, nullptr};
+}
+
+#endif // REACTOR_HH
@@ -0,0 +1,231 @@
+#include "service.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+static void *service_thread(void *arg);
+static void change_state(service_t *svc, service_state_t state, service_state_t target);
+static void wait_for_target(service_t *svc);
+static int64_t now_ms(void);
+
+int service_init(service_t *svc, const service_desc_t *desc, void *user_data)
+{
+    svc->desc = desc;
+    svc->user_data = user_data;
+    svc->state = SERVICE_STOPPED;
+    svc->target = SERVICE_STOPPED;
+    svc->is_busy = false;
+    svc->cancel_requested = false;
+    svc->queue_head = 0;
+    svc->queue_cnt = 0;
+
+    // The ticks are timed with the monotonic clock
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&svc->mutex, NULL);
+    pthread_cond_init(&svc->cond, &attr);
+    pthread_cond_init(&svc->done_cond, NULL);
+    pthread_condattr_destroy(&attr);
+
+    svc->cancel_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(svc->cancel_fd < 0) return -errno;
+
+    int res = pthread_create(&svc->thread, NULL, service_thread, svc);
+    if(res != 0) return -res;
+    pthread_setname_np(svc->thread, desc->name);
+    return 0;
+}
+
+void service_start(service_t *svc)
+{
+    pthread_mutex_lock(&svc->mutex);
+    svc->target = SERVICE_RUNNING;
+    pthread_cond_signal(&svc->cond);
+    pthread_mutex_unlock(&svc->mutex);
+}
+
+void service_stop(service_t *svc)
+{
+    // A scan or a connection could keep the thread for seconds, also one which is just starting
+    pthread_mutex_lock(&svc->mutex);
+    svc->target = SERVICE_STOPPED;
+    svc->cancel_requested = true;
+    uint64_t one = 1;
+    if(write(svc->cancel_fd, &one, sizeof(one)) < 0) printf("[%s] can't cancel: %s\n", svc->desc->name, strerror(errno));
+    pthread_cond_signal(&svc->cond);
+    pthread_mutex_unlock(&svc->mutex);
+
+    if(svc->desc->cancel_cb) svc->desc->cancel_cb(svc);
+    wait_for_target(svc);
+}
+
+void service_suspend(service_t *svc)
+{
+    pthread_mutex_lock(&svc->mutex);
+    if(svc->target == SERVICE_STOPPED)
+    {
+        pthread_mutex_unlock(&svc->mutex);
+        return;
+    }
+    svc->target = SERVICE_SUSPENDED;
+    pthread_cond_signal(&svc->cond);
+    pthread_mutex_unlock(&svc->mutex);
+    wait_for_target(svc);
+}
+
+int service_send(service_t *svc, uint32_t id, const void *data, uint32_t size)
+{
+    if(size > SERVICE_CMD_DATA_SIZE) return -EMSGSIZE;
+
+    pthread_mutex_lock(&svc->mutex);
+    int res = 0;
+    if(svc->target == SERVICE_STOPPED) res = -EPIPE;
+    else if(svc->queue_cnt == SERVICE_QUEUE_LEN) res = -EAGAIN;
+    else
+    {
+        service_cmd_t *cmd = &svc->queue[(svc->queue_head + svc->queue_cnt) % SERVICE_QUEUE_LEN];
+        cmd->id = id;
+        cmd->size = size;
+        if(size) memcpy(cmd->data, data, size);
+        svc->queue_cnt++;
+        pthread_cond_signal(&svc->cond);
+    }
+    pthread_mutex_unlock(&svc->mutex);
+    return res;
+}
+
+service_state_t service_get_state(const service_t *svc)
+{
+    return (service_state_t)svc->state.load();
+}
+
+bool service_is_canceled(service_t *svc)
+{
+    pthread_mutex_lock(&svc->mutex);
+    bool res = svc->cancel_requested;
+    pthread_mutex_unlock(&svc->mutex);
+    return res;
+}
+
+int service_get_cancel_fd(const service_t *svc)
+{
+    return svc->cancel_fd;
+}
+
+static void *service_thread(void *arg)
+{
+    service_t *svc = (service_t *)arg;
+    const service_desc_t *desc = svc->desc;
+    int64_t next_tick_ms = 0;
+
+    pthread_mutex_lock(&svc->mutex);
+    while(1)
+    {
+        service_state_t state = (service_state_t)svc->state.load();
+
+        // A lifecycle request goes before the commands
+        if(svc->target != state)
+        {
+            change_state(svc, state, svc->target);
+            next_tick_ms = now_ms();
+            continue;
+        }
+
+        if(state == SERVICE_RUNNING && svc->queue_cnt > 0)
+        {
+            service_cmd_t cmd = svc->queue[svc->queue_head];
+            svc->queue_head = (svc->queue_head + 1) % SERVICE_QUEUE_LEN;
+            svc->queue_cnt--;
+            svc->is_busy = true;
+
+            // A stop before this command doesn't cancel it
+            uint64_t cnt;
+            svc->cancel_requested = false;
+            if(read(svc->cancel_fd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN) printf("[%s] cancel_fd: %s\n", desc->name, strerror(errno));
+            pthread_mutex_unlock(&svc->mutex);
+            if(desc->command_cb) desc->command_cb(svc, &cmd);
+            pthread_mutex_lock(&svc->mutex);
+            svc->is_busy = false;
+            pthread_cond_broadcast(&svc->done_cond);
+            continue;
+        }
+
+        int64_t now = now_ms();
+        if(state == SERVICE_RUNNING && desc->period_ms && now >= next_tick_ms)
+        {
+            // The next tick is due a period after this one started, right away if it was late
+            next_tick_ms += desc->period_ms;
+            if(next_tick_ms < now) next_tick_ms = now;
+            svc->is_busy = true;
+            pthread_mutex_unlock(&svc->mutex);
+            desc->tick_cb(svc);
+            pthread_mutex_lock(&svc->mutex);
+            svc->is_busy = false;
+            pthread_cond_broadcast(&svc->done_cond);
+            continue;
+        }
+
+        // Nothing to do until a request, a command or the next tick
+        if(state == SERVICE_RUNNING && desc->period_ms)
+        {
+            struct timespec ts;
+            ts.tv_sec = next_tick_ms / 1000;
+            ts.tv_nsec = (next_tick_ms % 1000) * 1000000;
+            pthread_cond_timedwait(&svc->cond, &svc->mutex, &ts);
+        }
+        else
+        {
+            pthread_cond_wait(&svc->cond, &svc->mutex);
+        }
+    }
+    return NULL;
+}
+
+// Open or close the device for a new state, call with the mutex locked
+static void change_state(service_t *svc, service_state_t state, service_state_t target)
+{
+    const service_desc_t *desc = svc->desc;
+    svc->is_busy = true;
+    pthread_mutex_unlock(&svc->mutex);
+
+    if(state == SERVICE_STOPPED)
+    {
+        if(desc->start_cb && !desc->start_cb(svc)) target = SERVICE_STOPPED;
+    }
+    else if(target == SERVICE_STOPPED)
+    {
+        if(desc->stop_cb) desc->stop_cb(svc);
+    }
+
+    // Reported before the waiting callers return
+    if(target != state && desc->state_cb) desc->state_cb(svc, target);
+
+    pthread_mutex_lock(&svc->mutex);
+    if(target == SERVICE_STOPPED)
+    {
+        svc->queue_cnt = 0;
+        svc->target = SERVICE_STOPPED;     // The device couldn't be started
+    }
+    svc->state = target;
+    svc->is_busy = false;
+    pthread_cond_broadcast(&svc->done_cond);
+}
+
+// Wait until the service thread is idle in the requested state
+static void wait_for_target(service_t *svc)
+{
+    pthread_mutex_lock(&svc->mutex);
+    while(svc->is_busy || svc->state.load() != svc->target) pthread_cond_wait(&svc->done_cond, &svc->mutex);
+    pthread_mutex_unlock(&svc->mutex);
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,96 @@
+#ifndef SERVICE_HH
+#define SERVICE_HH
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <atomic>
+
+/*
+ * A device running in its own thread, created once and kept for the whole run.
+ *
+ * The thread sleeps on a condition variable while the service is stopped or suspended and
+ * between the commands, so an idle service doesn't wake up at all. A running service with a
+ * period also calls tick_cb (e.g. to read a camera frame) with a timed wait in between.
+ * The screens start, stop, suspend or resume it and send commands to its queue; the service
+ * reports its state changes with state_cb. All the callbacks run in the service thread,
+ * except cancel_cb.
+ *
+ * A stop cancels the command in progress: the cancellation is kept until the next command is
+ * dequeued, so a command which starts blocking after the stop still sees it. The devices wait on
+ * the service's cancel fd (readable while canceled) next to their own fds.
+ */
+
+#define SERVICE_QUEUE_LEN       4
+#define SERVICE_CMD_DATA_SIZE   520     // A WiFi SSID and password
+
+typedef enum
+{
+    SERVICE_STOPPED,
+    SERVICE_RUNNING,
+    SERVICE_SUSPENDED,      // Started, but no ticks and commands until resumed
+} service_state_t;
+
+typedef struct
+{
+    uint32_t id;
+    uint32_t size;
+    uint8_t data[SERVICE_CMD_DATA_SIZE];
+} service_cmd_t;
+
+typedef struct service_s service_t;
+
+typedef struct
+{
+    const char *name;       // Name of the thread
+    uint32_t period_ms;     // Interval of tick_cb while running, 0: commands only
+    bool (*start_cb)(service_t *svc);                           // Open the device, false: it stays stopped
+    void (*stop_cb)(service_t *svc);
+    void (*tick_cb)(service_t *svc);
+    void (*command_cb)(service_t *svc, const service_cmd_t *cmd);
+    void (*cancel_cb)(service_t *svc);                          // Interrupt a long command, called by each service_stop()
+    void (*state_cb)(service_t *svc, service_state_t state);
+} service_desc_t;
+
+struct service_s
+{
+    const service_desc_t *desc;
+    void *user_data;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;            // Wakes up the service thread
+    pthread_cond_t done_cond;       // Wakes up the callers waiting for a state
+    std::atomic<int> state;         // service_state_t, read without the mutex
+    service_state_t target;         // The requested state
+    bool is_busy;                   // A callback is running in the service thread
+    bool cancel_requested;          // Stopped since the command in progress was dequeued
+    int cancel_fd;                  // eventfd, readable while cancel_requested
+    service_cmd_t queue[SERVICE_QUEUE_LEN];
+    uint32_t queue_head;
+    uint32_t queue_cnt;
+};
+
+// Create the thread of a stopped service. 0 or -errno
+int service_init(service_t *svc, const service_desc_t *desc, void *user_data);
+
+// Start a stopped service or resume a suspended one, doesn't wait for start_cb
+void service_start(service_t *svc);
+
+// Stop the service and wait until stop_cb returned, the queued commands are dropped
+void service_stop(service_t *svc);
+
+// Stop the ticks and the commands without closing the device, waits for the running one
+void service_suspend(service_t *svc);
+
+// Queue a command for a started service. 0, -EAGAIN: the queue is full, -EPIPE: stopped, -EMSGSIZE
+int service_send(service_t *svc, uint32_t id, const void *data, uint32_t size);
+
+service_state_t service_get_state(const service_t *svc);
+
+// The service was stopped since the running command started, check it before blocking
+bool service_is_canceled(service_t *svc);
+
+// The eventfd of the cancellation, open for the life of the service. Don't read it
+int service_get_cancel_fd(const service_t *svc);
+
+#endif // SERVICE_HH
@@ -2,4 +2,7 @@ THR_NAME ?= devices/threads
 
 override CXXFLAGS := -I$(LVGL_DIR) $(CXXFLAGS)
 
+# The device tasks are C++20 coroutines (see reactor.h), the LVGL headers OR flags of different enums
+override CXXFLAGS += -std=gnu++20 -Wno-deprecated-enum-enum-conversion
+
 CXXSRCS += $(wildcard $(LVGL_DIR)/$(THR_NAME)/*.cpp)
\ No newline at end of file
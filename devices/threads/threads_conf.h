@@ -4,30 +4,36 @@
 #include <pthread.h>
 #include <stdbool.h>   
 #include <unistd.h>   
+#include "lvgl/lvgl.h"
 #include "devices/opencv/cv.h"
 #include "devices/wifi/wifi.h"
 #include "devices/tm7711/tm7711.h"
+#include "devices/battery/battery.h"
+#include "devices/battery/battery_history.h"
 #include "devices/power/power.h"
 #include "devices/date/date.h"
+#include "service.h"
+#include "reactor.h"
 
-void cv_create_thread(void);
-void cv_destroy_thread(void);
-void* cv_thread(void* arg);
+void cv_service_init(void);
+void cv_service_start(void);
+void cv_service_stop(void);
 
-void wifi_create_thread(void);
-void wifi_destroy_thread(void); 
-void* wifi_thread(void* arg);
-void wifi_isflush(void);
-void wifi_isconnect(void);
-void wifi_get_ssid(char *ssid);
-void wifi_get_pass(const char *pass);
-void wifi_get_clear(void);
+void wifi_service_init(void);
+void wifi_service_start(void);
+void wifi_service_stop(void);
+void wifi_service_scan(void);
+void wifi_service_connect(const char *ssid, const char *pass);
 
-void message_create_thread(void);
-void message_destroy_thread(void); 
-void* message_thread(void* arg); 
+extern reactor_t io_reactor;
+void io_create_thread(void);
 
-void date_create_thread(void);
-void* date_thread(void* arg);
+co_task message_task(void);
+void message_task_start(void);
+void message_task_suspend(void);
+void message_chart_next_view(void);
+
+void net_create_thread(void);
+void* net_thread(void* arg);
 
 #endif // THREAD_H
\ No newline at end of file
@@ -1,72 +1,78 @@
 #include "threads_conf.h"
 
-bool wifi_thread_is_running = false;
-bool wifi_thread_is_flush = false;
-bool wifi_thread_is_connect = false;
-char wifi_ssid[256],wifi_pass[256];
-pthread_t thread_wifi;
+#define WIFI_CMD_SCAN       1
+#define WIFI_CMD_CONNECT    2
 
-void wifi_create_thread(void) 
+typedef struct
 {
-    if(!wifi_thread_is_running) 
-    {
-        wifi_thread_is_running = true;
-        pthread_create(&thread_wifi, NULL, wifi_thread, NULL);
-    }
-}
+    char ssid[256];
+    char pass[256];
+} wifi_connect_cmd_t;
+
+static void wifi_command(service_t *svc, const service_cmd_t *cmd);
+static void wifi_state(service_t *svc, service_state_t state);
 
-void wifi_destroy_thread(void) 
+// Scans and connections run as commands, the thread sleeps in between. Leaving the Set screen
+// stops the service, its cancel fd interrupts the scan or the connection in progress
+static const service_desc_t wifi_desc = {
+    "wifi", 0, NULL, NULL, NULL, wifi_command, NULL, wifi_state,
+};
+service_t wifi_service;
+
+void wifi_service_init(void)
 {
-    if(wifi_thread_is_running)
-    {
-        wifi_thread_is_running = false;
-        pthread_join(thread_wifi, NULL);
-    }
+    int res = service_init(&wifi_service, &wifi_desc, NULL);
+    if(res == 0) res = wifi_init(service_get_cancel_fd(&wifi_service));
+    if(res < 0) printf("[wifi] service: %s\n", strerror(-res));
 }
 
-void* wifi_thread(void* arg) 
+void wifi_service_start(void)
 {
-    while(1) 
-    {
-        if(!wifi_thread_is_flush)
-        {
-            if(wifi_scan() == 0)wifi_thread_is_connect = true;
-            wifi_thread_is_flush = true;
-        }
-        if(!wifi_thread_is_connect)
-        {
-            wifi_connect((const char*)wifi_ssid, (const char*)wifi_pass);
-            wifi_get_clear();
-            wifi_thread_is_connect = true;
-        }
-        if(!wifi_thread_is_running)break;
-        usleep(10000); 
-    }
-    return NULL;
+    service_start(&wifi_service);
+    wifi_service_scan();
 }
 
-void wifi_isflush(void)
+void wifi_service_stop(void)
 {
-    if(wifi_thread_is_flush)wifi_thread_is_flush = false;
+    service_stop(&wifi_service);
 }
 
-void wifi_isconnect(void)
+void wifi_service_scan(void)
 {
-    if(wifi_thread_is_connect)wifi_thread_is_connect = false;
+    int res = service_send(&wifi_service, WIFI_CMD_SCAN, NULL, 0);
+    if(res < 0) printf("[wifi] scan: %s\n", strerror(-res));
 }
 
-void wifi_get_ssid(char *ssid)
+void wifi_service_connect(const char *ssid, const char *pass)
 {
-    strcpy(wifi_ssid, ssid);
+    wifi_connect_cmd_t cmd;
+    snprintf(cmd.ssid, sizeof(cmd.ssid), "%s", ssid);
+    snprintf(cmd.pass, sizeof(cmd.pass), "%s", pass);
+    int res = service_send(&wifi_service, WIFI_CMD_CONNECT, &cmd, sizeof(cmd));
+    if(res < 0) printf("[wifi] connect: %s\n", strerror(-res));
 }
 
-void wifi_get_pass(const char *pass)
+static void wifi_command(service_t *svc, const service_cmd_t *cmd)
 {
-    strcpy(wifi_pass, pass);
+    // Stopped right after the command was dequeued
+    if(service_is_canceled(svc)) return;
+
+    if(cmd->id == WIFI_CMD_SCAN)
+    {
+        LV_TRACE_BEGIN("wifi_scan");
+        wifi_scan();
+        LV_TRACE_END("wifi_scan");
+    }
+    else if(cmd->id == WIFI_CMD_CONNECT)
+    {
+        const wifi_connect_cmd_t *conn = (const wifi_connect_cmd_t *)cmd->data;
+        LV_TRACE_BEGIN("wifi_connect");
+        wifi_connect(conn->ssid, conn->pass);
+        LV_TRACE_END("wifi_connect");
+    }
 }
 
-void wifi_get_clear(void)
+static void wifi_state(service_t *svc, service_state_t state)
 {
-    memset(wifi_ssid, '\0', sizeof(wifi_ssid));
-    memset(wifi_pass, '\0', sizeof(wifi_pass));
-}
\ No newline at end of file
+    wifi_status_show(state == SERVICE_RUNNING);
+}
@@ -1,6 +1,14 @@
 #include "tm7711.h"
 #include <wiringPi.h>
 #include "ui/src/ui.h"
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <sys/eventfd.h>
 
 typedef enum __TM7711_CH{
 	TM7711_CH1_10HZ = 0 ,
@@ -17,17 +25,86 @@ typedef enum __TM7711_CH{
 #define	TM7711_SDA_IN	pinMode(TM7711_SDA_PIN	, INPUT )
 #define	TM7711_SDA_T	digitalRead(TM7711_SDA_PIN )
 
-#define	REF	2489
-#define	R1	30
-#define	R2	20000
+#define	REF	2489 // Reference voltage [mV]
+#define	GAIN	128
 
-#define	ADC_BUFF_MAX		20 
-uint32_t adc_buff[ADC_BUFF_MAX+1]={0,} ;
-uint32_t adc_da ;
-uint32_t t1 ;
+// The on-chip sensor, a linear fit through one point. The chip has no factory calibration:
+// measure the code at a known temperature on each board
+#define TEMP_CAL_CODE       0x5A00              // 16-bit code at TEMP_CAL_C
+#define TEMP_CAL_C          25
+#define TEMP_CODE_PER_C     96
 
+#define ADC_EARLY_US        1000                // Wake up before the conversion is due, the chip's clock drifts
+#define ADC_POLL_US         200                 // DOUT polling interval once it's due
+#define ADC_IDLE_POLL_US    10000               // After ADC_TIMEOUT_US without a conversion (no chip)
+#define ADC_TIMEOUT_US      500000
+#define ADC_RT_PRIORITY     50                  // SCHED_FIFO, the 24 clocks must not be preempted
+#define ADC_SETTLE_CONV     1                   // Conversions dropped after a channel switch or a pause
+
+#define ADC_WINDOW          21                  // Samples of a battery reading, about 0.5 s
+#define ADC_RING_SIZE       64                  // Power of 2
+
+// A sensor measured by the scheduler
+typedef struct
+{
+    tm7711_sensor_t sensor;
+    _TM7711_CHANNEL channel;
+    uint32_t interval_ms;   // Time between two visits, 0: the default slot, measured when no other is due
+    uint32_t samples;       // Conversions kept per visit
+} adc_slot_t;
+
+// The battery runs continuously at 40 Hz, a temperature conversion is interleaved every second.
+// The first slot is the default one
+static const adc_slot_t adc_schedule[] = {
+    {TM7711_BATTERY, TM7711_CH1_40HZ, 0, 0},
+    {TM7711_TEMPERATURE, TM7711_TEMP, 1000, 1},
+};
+#define ADC_SLOT_CNT        (sizeof(adc_schedule) / sizeof(adc_schedule[0]))
+
+typedef struct
+{
+    tm7711_sensor_t sensor;
+    uint32_t code;
+    int64_t time_us;
+} adc_sample_t;
+
+typedef struct
+{
+    uint32_t median;
+    uint32_t mean;
+} adc_stats_t;
+
+static void *acquisition_thread(void *arg);
+static uint32_t next_slot(uint32_t cur, const int64_t *due_us, int64_t now);
+static uint32_t get_period_us(_TM7711_CHANNEL channel);
+static void set_realtime(void);
+static bool ring_push(const adc_sample_t *sample);
+static bool ring_pop(adc_sample_t *sample);
+static void publish(tm7711_sensor_t sensor, int32_t value, uint32_t code, int64_t time_us);
+static void get_stats(uint32_t *codes, uint32_t cnt, adc_stats_t *stats);
+static int32_t code_to_uv(uint32_t code);
+static int32_t code_to_centi_c(uint32_t code);
+static void sleep_until_us(int64_t us);
+static int64_t now_us(void);
 uint32_t tm7711_read(_TM7711_CHANNEL next_select);
-void Maopao(uint32_t * buff ,  uint16_t size );
+
+// Samples from the acquisition thread to the reader, lock-free with one writer and one reader
+static adc_sample_t ring[ADC_RING_SIZE];
+static std::atomic<uint32_t> ring_head(0);      // Written by the acquisition thread
+static std::atomic<uint32_t> ring_tail(0);      // Written by the reader
+static std::atomic<uint32_t> ring_overruns(0);
+static int ready_fd = -1;                       // eventfd, samples were pushed
+
+static pthread_t acq_thread;
+static pthread_mutex_t acq_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t acq_cond = PTHREAD_COND_INITIALIZER;
+static std::atomic<bool> acq_is_running(false);
+
+static uint32_t window[ADC_WINDOW];             // Only used by the reader
+static uint32_t window_cnt;
+
+static pthread_mutex_t reading_mutex = PTHREAD_MUTEX_INITIALIZER;
+static tm7711_reading_t readings[TM7711_SENSOR_CNT];    // The last ones, time_us 0: none yet
 
 void tm7711_init(void)
 {
@@ -35,35 +112,253 @@ void tm7711_init(void)
 	TM7711_SDA_IN ;
 	TM7711_CLK_L ;
 	delayMicroseconds(100 ) ; //100us
+}
+
+int tm7711_start(void)
+{
+    if(ready_fd < 0)
+    {
+        tm7711_init();
+        ready_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(ready_fd < 0) return -errno;
+        int res = pthread_create(&acq_thread, NULL, acquisition_thread, NULL);
+        if(res != 0)
+        {
+            close(ready_fd);
+            ready_fd = -1;
+            return -res;
+        }
+        pthread_setname_np(acq_thread, "tm7711");
+    }
 
-	// printf("TM7711 Init\r\n");
+    // A reading only has samples of this visit
+    adc_sample_t sample;
+    while(ring_pop(&sample));
+    window_cnt = 0;
 
-    adc_buff[0] = 1 ;
+    pthread_mutex_lock(&acq_mutex);
+    acq_is_running = true;
+    pthread_cond_signal(&acq_cond);
+    pthread_mutex_unlock(&acq_mutex);
+    return 0;
 }
 
-void tm7711_loop(void)
+void tm7711_pause(void)
 {
-    if(TM7711_SDA_T == 0)
+    pthread_mutex_lock(&acq_mutex);
+    acq_is_running = false;
+    pthread_mutex_unlock(&acq_mutex);
+
+    // The reader waiting for samples sees the pause
+    uint64_t one = 1;
+    if(ready_fd >= 0 && write(ready_fd, &one, sizeof(one)) < 0) printf("[tm7711] can't wake up the reader\n");
+}
+
+int tm7711_get_fd(void)
+{
+    return ready_fd;
+}
+
+uint32_t tm7711_loop(void)
+{
+    uint64_t cnt;
+    if(read(ready_fd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN) printf("[tm7711] %s\n", strerror(errno));
+
+    uint32_t overruns = ring_overruns.exchange(0);
+    if(overruns) printf("[tm7711] %u samples dropped\n", overruns);
+
+    uint32_t updated = 0;
+    adc_sample_t sample;
+    while(ring_pop(&sample))
     {
-        adc_buff[adc_buff[0]] = tm7711_read(TM7711_CH1_10HZ) ;
-        adc_buff[0] += 1 ;
-        if(adc_buff[0] >= ADC_BUFF_MAX)
+        if(sample.sensor == TM7711_TEMPERATURE)
         {
-            Maopao(adc_buff+1 , adc_buff[0] -1 );
-            adc_buff[0] = 1 ;
-            adc_da = adc_buff[ADC_BUFF_MAX/2] ;
-            adc_da >>= 8 ;
-    
-            t1=adc_da ;
-            t1= (t1*REF) / 65535 ;
-            t1= (t1*(R1+R2))/R1 ;
-            t1 = t1 /128 ;
-			t1 = t1 + 100;
-
-			lv_label_set_text_fmt(ui_BatteryLabel, "Battery: %ld.%ld", t1/1000, t1%1000);
-            // printf("battery is : 0X%x , %d, %d mV \r\n",adc_da,adc_da ,t1);
+            publish(TM7711_TEMPERATURE, code_to_centi_c(sample.code), sample.code, sample.time_us);
+            updated |= 1 << TM7711_TEMPERATURE;
+            continue;
         }
+
+        window[window_cnt++] = sample.code;
+        if(window_cnt < ADC_WINDOW) continue;
+        window_cnt = 0;
+
+        // The median drops the spikes of the noisy 40 Hz mode
+        adc_stats_t stats;
+        get_stats(window, ADC_WINDOW, &stats);
+        publish(TM7711_BATTERY, code_to_uv(stats.median), stats.median, sample.time_us);
+        updated |= 1 << TM7711_BATTERY;
     }
+    return updated;
+}
+
+bool tm7711_get_reading(tm7711_sensor_t sensor, tm7711_reading_t *reading)
+{
+    pthread_mutex_lock(&reading_mutex);
+    *reading = readings[sensor];
+    pthread_mutex_unlock(&reading_mutex);
+    return reading->time_us != 0;
+}
+
+// Sleeps until a conversion is due and reads it with the timing of the chip
+static void *acquisition_thread(void *arg)
+{
+    set_realtime();
+
+    int64_t due_us = 0;                 // 0: unknown, e.g. after a pause
+    int64_t slot_due_us[ADC_SLOT_CNT] = {0};
+    uint32_t cur = 0;                   // The slot of the conversion in progress
+    uint32_t settle = ADC_SETTLE_CONV;  // Conversions to drop before the next sample
+    uint32_t kept = 0;                  // Samples of this visit of the slot
+    while(1)
+    {
+        pthread_mutex_lock(&acq_mutex);
+        if(!acq_is_running)
+        {
+            // The conversion waiting in the chip may be from long ago
+            due_us = 0;
+            settle = ADC_SETTLE_CONV;
+        }
+        while(!acq_is_running) pthread_cond_wait(&acq_cond, &acq_mutex);
+        pthread_mutex_unlock(&acq_mutex);
+
+        // DOUT is also the data line, an edge interrupt would fire on each bit. The conversion time
+        // is known instead: sleep until shortly before it, then poll
+        if(due_us) sleep_until_us(due_us - ADC_EARLY_US);
+        int64_t start_us = now_us();
+        while(acq_is_running && TM7711_SDA_T != 0)
+        {
+            int64_t now = now_us();
+            sleep_until_us(now + (now - start_us < ADC_TIMEOUT_US ? ADC_POLL_US : ADC_IDLE_POLL_US));
+        }
+        if(!acq_is_running) continue;
+
+        // The clock pulses after the data select the channel of the next conversion
+        int64_t read_us = now_us();
+        bool keep = settle == 0;
+        uint32_t next = cur;
+        if(keep && kept + 1 >= adc_schedule[cur].samples) next = next_slot(cur, slot_due_us, read_us);
+        uint32_t code = tm7711_read(adc_schedule[next].channel);
+        due_us = now_us() + get_period_us(adc_schedule[next].channel);
+
+        if(keep)
+        {
+            adc_sample_t sample = {adc_schedule[cur].sensor, code, read_us};
+            if(!ring_push(&sample)) ring_overruns++;
+            kept++;
+
+            uint64_t one = 1;
+            if(write(ready_fd, &one, sizeof(one)) < 0) printf("[tm7711] can't wake up the reader\n");
+        }
+        else
+        {
+            settle--;
+        }
+
+        if(next != cur)
+        {
+            if(adc_schedule[cur].interval_ms) slot_due_us[cur] = read_us + adc_schedule[cur].interval_ms * 1000LL;
+            if(adc_schedule[next].channel != adc_schedule[cur].channel) settle = ADC_SETTLE_CONV;
+            cur = next;
+            kept = 0;
+        }
+    }
+    return NULL;
+}
+
+// The slot after a visit of `cur`: the most overdue one, the default slot if none is due
+static uint32_t next_slot(uint32_t cur, const int64_t *due_us, int64_t now)
+{
+    uint32_t next = 0;
+    uint32_t i;
+    for(i = 1; i < ADC_SLOT_CNT; i++)
+    {
+        if(i == cur || due_us[i] > now) continue;
+        if(next == 0 || due_us[i] < due_us[next]) next = i;
+    }
+    return next;
+}
+
+// The output rate of the chip depends on the channel
+static uint32_t get_period_us(_TM7711_CHANNEL channel)
+{
+    return channel == TM7711_CH1_10HZ ? 100000 : 25000;
+}
+
+static void set_realtime(void)
+{
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = ADC_RT_PRIORITY;
+    int res = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if(res != 0) printf("[tm7711] no real-time priority: %s\n", strerror(res));
+}
+
+static bool ring_push(const adc_sample_t *sample)
+{
+    uint32_t head = ring_head.load(std::memory_order_relaxed);
+    if(head - ring_tail.load(std::memory_order_acquire) == ADC_RING_SIZE) return false;
+    ring[head & (ADC_RING_SIZE - 1)] = *sample;
+    ring_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+static bool ring_pop(adc_sample_t *sample)
+{
+    uint32_t tail = ring_tail.load(std::memory_order_relaxed);
+    if(tail == ring_head.load(std::memory_order_acquire)) return false;
+    *sample = ring[tail & (ADC_RING_SIZE - 1)];
+    ring_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+static void publish(tm7711_sensor_t sensor, int32_t value, uint32_t code, int64_t time_us)
+{
+    pthread_mutex_lock(&reading_mutex);
+    readings[sensor].sensor = sensor;
+    readings[sensor].value = value;
+    readings[sensor].code = code;
+    readings[sensor].time_us = time_us;
+    pthread_mutex_unlock(&reading_mutex);
+}
+
+// Median by selection in O(n), the codes are reordered
+static void get_stats(uint32_t *codes, uint32_t cnt, adc_stats_t *stats)
+{
+    std::nth_element(codes, codes + cnt / 2, codes + cnt);
+    stats->median = codes[cnt / 2];
+
+    uint64_t sum = 0;
+    uint32_t i;
+    for(i = 0; i < cnt; i++) sum += codes[i];
+    stats->mean = sum / cnt;
+}
+
+// The differential input voltage of a raw 24-bit code [uV], the battery divider is calibrated by devices/battery
+static int32_t code_to_uv(uint32_t code)
+{
+    return (uint64_t)code * REF * 1000 / (0xFFFFFFULL * GAIN);
+}
+
+// The chip's temperature of a raw 24-bit code [0.01 °C]
+static int32_t code_to_centi_c(uint32_t code)
+{
+    int32_t delta = (int32_t)(code >> 8) - TEMP_CAL_CODE;
+    return TEMP_CAL_C * 100 + delta * 100 / TEMP_CODE_PER_C;
+}
+
+static void sleep_until_us(int64_t us)
+{
+    struct timespec ts;
+    ts.tv_sec = us / 1000000;
+    ts.tv_nsec = (us % 1000000) * 1000;
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+}
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
 }
 
 uint32_t tm7711_read(_TM7711_CHANNEL next_select)
@@ -87,13 +382,13 @@ uint32_t tm7711_read(_TM7711_CHANNEL next_select)
 			delayMicroseconds(5) ; //5us
 			TM7711_CLK_L ;
 			delayMicroseconds(5) ; //5us
-
+			// fall through
 		case TM7711_TEMP :
 			TM7711_CLK_H ;
 			delayMicroseconds(5) ; //5us
 			TM7711_CLK_L ;
 			delayMicroseconds(5) ; //5us
-			
+			// fall through
 		case TM7711_CH1_10HZ :
 			TM7711_CLK_H ;
 			delayMicroseconds(5) ; //5us
@@ -104,25 +399,3 @@ uint32_t tm7711_read(_TM7711_CHANNEL next_select)
 
 	return re_da ;
 }
-
-void Maopao(uint32_t * buff ,  uint16_t size )
-{
-	uint16_t f1 , f2 ;
-	uint32_t da_t;
-	for(f1=0 ; f1<size ; f1++)
-	{
-		for(f2=f1 ; f2<size ; f2++)
-		{
-			if(buff[f1] > buff[f2])
-			{
-				da_t = buff[f1] ;
-				buff[f1] = buff[f2] ;
-				buff[f2] = da_t ;
-			}
-		}
-	}
-}
-
-
-
-
@@ -5,7 +5,46 @@
 #include <stdio.h>
 #include <cstdint>
 
+/*
+ * Battery divider voltage and chip temperature from the TM7711 ADC, sampled by a real-time thread.
+ *
+ * A scheduler in the thread interleaves the channels: the battery is converted at 40 Hz and
+ * a temperature conversion is taken every second, the conversion after a channel switch is
+ * dropped while the chip settles. The thread sleeps until a conversion is due, clocks the bits
+ * out and pushes the raw code to a lock-free ring; the reader is woken up through an eventfd
+ * and turns the samples into readings (the battery is the median of a window of samples).
+ */
+
+typedef enum
+{
+    TM7711_BATTERY,         // Input voltage of the battery divider [uV], see devices/battery
+    TM7711_TEMPERATURE,     // [0.01 °C]
+    TM7711_SENSOR_CNT,
+} tm7711_sensor_t;
+
+typedef struct
+{
+    tm7711_sensor_t sensor;
+    int32_t value;          // In the unit of the sensor
+    uint32_t code;          // The raw 24-bit code it was calculated from
+    int64_t time_us;        // CLOCK_MONOTONIC time of the (last) conversion
+} tm7711_reading_t;
+
 void tm7711_init(void);
-void tm7711_loop(void);
 
-#endif 
\ No newline at end of file
+// Start the acquisition thread the first time, then resume it. 0 or -errno
+int tm7711_start(void);
+
+// Stop sampling, the thread sleeps until tm7711_start(). Can be called from any thread
+void tm7711_pause(void);
+
+// Readable when samples are waiting, also after tm7711_pause()
+int tm7711_get_fd(void);
+
+// Turn the waiting samples into readings, from one thread. The updated sensors, 1 << tm7711_sensor_t
+uint32_t tm7711_loop(void);
+
+// The last reading of a sensor, from any thread. false: none yet
+bool tm7711_get_reading(tm7711_sensor_t sensor, tm7711_reading_t *reading);
+
+#endif 
@@ -0,0 +1,5 @@
+TOUCH_NAME ?= devices/touch
+
+override CXXFLAGS := -I$(LVGL_DIR) $(CXXFLAGS)
+
+CXXSRCS += $(wildcard $(LVGL_DIR)/$(TOUCH_NAME)/*.cpp)
@@ -0,0 +1,278 @@
+#include "touch_replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+/*
+ * File format: the magic followed by touch_sample_t records in the byte order of the machine
+ * (little endian on both the Raspberry Pi and a PC). A record is only written when the
+ * point or the state changed, so an idle screen costs nothing.
+ */
+#define TOUCH_FILE_MAGIC    "TRC1"
+#define PRESSED_BIT         0x8000
+
+#define PENDING_MAX         64
+#define LATENCY_MAX         4096
+#define REDRAW_TIMEOUT_MS   500     // A sample without a flush in this time didn't change the screen
+#define SETTLE_MS           1000    // Wait after the last sample before the results are saved
+
+typedef struct
+{
+    uint32_t time_ms;   // Since touch_replay_init()
+    uint16_t x;         // PRESSED_BIT is set while the screen is touched
+    uint16_t y;
+} touch_sample_t;
+
+typedef enum
+{
+    SAMPLE_PRESS,
+    SAMPLE_MOVE,
+    SAMPLE_RELEASE,
+    SAMPLE_KIND_CNT,
+} sample_kind_t;
+
+typedef struct
+{
+    uint64_t time_us;   // When the sample was taken
+    sample_kind_t kind;
+} pending_t;
+
+static const char *kind_names[SAMPLE_KIND_CNT] = {"press", "move", "release"};
+
+static void record_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data);
+static void replay_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data);
+static void flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+static bool load_samples(const char *path);
+static void replay_finish(void);
+static uint64_t now_us(void);
+
+static void (*orig_read_cb)(lv_indev_drv_t *drv, lv_indev_data_t *data);
+static void (*orig_flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+static uint64_t start_us;
+
+// Recording
+static FILE *record_file;
+static touch_sample_t last_sample;
+static bool has_last_sample;
+
+// Replay
+static touch_sample_t *samples;
+static uint32_t sample_cnt;
+static uint32_t sample_pos;
+static bool replay_done;
+static const char *latency_path;
+
+// Samples read by LVGL and waiting for the next flush
+static pending_t pending[PENDING_MAX];
+static uint32_t pending_cnt;
+static uint32_t latencies[SAMPLE_KIND_CNT][LATENCY_MAX];
+static uint32_t latency_cnt[SAMPLE_KIND_CNT];
+static uint32_t no_redraw_cnt;
+
+void touch_replay_init(lv_indev_t *indev)
+{
+    const char *record_path = getenv("TOUCH_RECORD");
+    const char *replay_path = getenv("TOUCH_REPLAY");
+    start_us = now_us();
+
+    if(replay_path && replay_path[0] != '\0')
+    {
+        if(!load_samples(replay_path)) return;
+        latency_path = getenv("TOUCH_LATENCY_JSON");
+
+        orig_read_cb = indev->driver->read_cb;
+        indev->driver->read_cb = replay_read_cb;
+        lv_disp_drv_t *disp_drv = indev->driver->disp->driver;
+        orig_flush_cb = disp_drv->flush_cb;
+        disp_drv->flush_cb = flush_cb;
+        printf("[touch] replaying %u samples from %s\n", sample_cnt, replay_path);
+    }
+    else if(record_path && record_path[0] != '\0')
+    {
+        record_file = fopen(record_path, "wb");
+        if(record_file == NULL)
+        {
+            printf("[touch] can't create %s\n", record_path);
+            return;
+        }
+        fwrite(TOUCH_FILE_MAGIC, 1, 4, record_file);
+        orig_read_cb = indev->driver->read_cb;
+        indev->driver->read_cb = record_read_cb;
+        printf("[touch] recording to %s\n", record_path);
+    }
+}
+
+static void record_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    orig_read_cb(drv, data);
+
+    touch_sample_t s;
+    s.time_ms = (now_us() - start_us) / 1000;
+    s.x = (uint16_t)LV_CLAMP(0, data->point.x, 0x7FFF);
+    s.y = (uint16_t)LV_CLAMP(0, data->point.y, 0xFFFF);
+    if(data->state == LV_INDEV_STATE_PRESSED) s.x |= PRESSED_BIT;
+
+    if(has_last_sample && s.x == last_sample.x && s.y == last_sample.y) return;
+    fwrite(&s, sizeof(s), 1, record_file);
+    last_sample = s;
+    has_last_sample = true;
+
+    // Save the gesture when the finger is lifted, the program is usually stopped by a signal
+    if(!(s.x & PRESSED_BIT)) fflush(record_file);
+}
+
+static void replay_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    // Keep polling the real driver so it behaves (and costs) the same as without a replay
+    orig_read_cb(drv, data);
+
+    uint64_t now = now_us();
+    uint32_t t = (now - start_us) / 1000;
+
+    // Samples not reflected by a flush in time didn't change anything on the screen
+    uint32_t i;
+    uint32_t kept = 0;
+    for(i = 0; i < pending_cnt; i++)
+    {
+        if(now - pending[i].time_us > REDRAW_TIMEOUT_MS * 1000) no_redraw_cnt++;
+        else pending[kept++] = pending[i];
+    }
+    pending_cnt = kept;
+
+    while(sample_pos < sample_cnt && samples[sample_pos].time_ms <= t)
+    {
+        const touch_sample_t *s = &samples[sample_pos];
+        bool was_pressed = sample_pos > 0 && (samples[sample_pos - 1].x & PRESSED_BIT);
+        bool is_pressed = s->x & PRESSED_BIT;
+        sample_pos++;
+
+        if(!was_pressed && !is_pressed) continue;
+        if(pending_cnt == PENDING_MAX) continue;
+        pending[pending_cnt].time_us = start_us + (uint64_t)s->time_ms * 1000;
+        pending[pending_cnt].kind = is_pressed ? (was_pressed ? SAMPLE_MOVE : SAMPLE_PRESS) : SAMPLE_RELEASE;
+        pending_cnt++;
+    }
+
+    if(sample_pos > 0)
+    {
+        const touch_sample_t *s = &samples[sample_pos - 1];
+        data->point.x = s->x & ~PRESSED_BIT;
+        data->point.y = s->y;
+        data->state = (s->x & PRESSED_BIT) ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    }
+    else
+    {
+        data->state = LV_INDEV_STATE_RELEASED;
+    }
+    data->continue_reading = false;
+
+    // Read again exactly when the next sample is due
+    if(sample_pos < sample_cnt)
+    {
+        uint32_t delay = samples[sample_pos].time_ms - t;
+        lv_timer_set_period(drv->read_timer, LV_CLAMP(1, delay, LV_INDEV_DEF_READ_PERIOD));
+    }
+    else if(!replay_done)
+    {
+        lv_timer_set_period(drv->read_timer, LV_INDEV_DEF_READ_PERIOD);
+        if(sample_cnt == 0 || t >= samples[sample_cnt - 1].time_ms + SETTLE_MS) replay_finish();
+    }
+}
+
+static void flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    orig_flush_cb(drv, area, color_p);
+    if(pending_cnt == 0) return;
+
+    // The first flush after the samples were read shows their effect
+    uint64_t now = now_us();
+    uint32_t i;
+    for(i = 0; i < pending_cnt; i++)
+    {
+        sample_kind_t kind = pending[i].kind;
+        if(latency_cnt[kind] < LATENCY_MAX) latencies[kind][latency_cnt[kind]++] = now - pending[i].time_us;
+    }
+    pending_cnt = 0;
+}
+
+static bool load_samples(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if(f == NULL)
+    {
+        printf("[touch] can't open %s\n", path);
+        return false;
+    }
+
+    char magic[4];
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if(size < 4 || fread(magic, 1, 4, f) != 4 || memcmp(magic, TOUCH_FILE_MAGIC, 4) != 0)
+    {
+        printf("[touch] %s is not a touch recording\n", path);
+        fclose(f);
+        return false;
+    }
+
+    sample_cnt = (size - 4) / sizeof(touch_sample_t);
+    samples = (touch_sample_t *)malloc(sample_cnt * sizeof(touch_sample_t) + 1);
+    if(samples) sample_cnt = fread(samples, sizeof(touch_sample_t), sample_cnt, f);
+    fclose(f);
+    return samples != NULL;
+}
+
+static void replay_finish(void)
+{
+    replay_done = true;
+
+    FILE *f = NULL;
+    if(latency_path && latency_path[0] != '\0')
+    {
+        f = fopen(latency_path, "w");
+        if(f == NULL) printf("[touch] can't create %s\n", latency_path);
+    }
+    if(f) fprintf(f, "{\"no_redraw\": %u", no_redraw_cnt);
+
+    printf("[touch] replay finished, input-to-photon latency:\n");
+    int k;
+    for(k = 0; k < SAMPLE_KIND_CNT; k++)
+    {
+        uint32_t n = latency_cnt[k];
+        if(n == 0) continue;
+
+        uint32_t *l = latencies[k];
+        std::sort(l, l + n);
+        uint64_t sum = 0;
+        uint32_t i;
+        for(i = 0; i < n; i++) sum += l[i];
+        uint32_t avg = sum / n;
+        uint32_t p50 = l[n / 2];
+        uint32_t p95 = l[(n * 95) / 100 < n ? (n * 95) / 100 : n - 1];
+        uint32_t max = l[n - 1];
+
+        printf("  %-8s %4u samples  avg %5.1f  p50 %5.1f  p95 %5.1f  max %5.1f ms\n", kind_names[k], n,
+               avg / 1000.0, p50 / 1000.0, p95 / 1000.0, max / 1000.0);
+        if(f)
+        {
+            fprintf(f, ", \"%s\": {\"n\": %u, \"avg_us\": %u, \"p50_us\": %u, \"p95_us\": %u, \"max_us\": %u}",
+                    kind_names[k], n, avg, p50, p95, max);
+        }
+    }
+    if(no_redraw_cnt) printf("  %u samples didn't change the screen\n", no_redraw_cnt);
+
+    if(f)
+    {
+        fprintf(f, "}\n");
+        fclose(f);
+    }
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -0,0 +1,18 @@
+#ifndef TOUCH_REPLAY_H
+#define TOUCH_REPLAY_H
+
+#include "lvgl/lvgl.h"
+
+/*
+ * Record the touch samples to a file or replay a recording instead of the live touch screen.
+ * Selected with environment variables, without them the input device is left untouched:
+ *  TOUCH_RECORD=<file>         save every change of the touch state with its time
+ *  TOUCH_REPLAY=<file>         replay a recording with the original timing
+ *  TOUCH_LATENCY_JSON=<file>   when the replay is over, save the input-to-photon latency here
+ *
+ * During a replay the time from each sample to the end of the first flush after LVGL read it
+ * is measured separately for presses, moves and releases.
+ */
+void touch_replay_init(lv_indev_t *indev);
+
+#endif
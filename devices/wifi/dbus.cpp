@@ -0,0 +1,658 @@
+#include "dbus.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#define HEADER_SIZE         16
+#define MSG_MAX_SIZE        (1024 * 1024)
+#define SETUP_TIMEOUT_MS    2000
+#define SEND_TIMEOUT_MS     1000
+
+// Header fields
+#define FIELD_PATH          1
+#define FIELD_INTERFACE     2
+#define FIELD_MEMBER        3
+#define FIELD_ERROR_NAME    4
+#define FIELD_REPLY_SERIAL  5
+#define FIELD_DESTINATION   6
+#define FIELD_SENDER        7
+#define FIELD_SIGNATURE     8
+
+static void msg_start(dbus_msg_t *msg, uint8_t type);
+static void msg_end_header(dbus_msg_t *msg);
+static void put_field(dbus_msg_t *msg, uint8_t code, char type, const char *value);
+static void put_field_u32(dbus_msg_t *msg, uint8_t code, uint32_t value);
+static void put_data(dbus_msg_t *msg, const void *data, uint32_t len);
+static void put_align(dbus_msg_t *msg, uint32_t align);
+static bool get_align(dbus_iter_t *it, uint32_t align, uint32_t len);
+static uint32_t type_align(char type);
+static const char *signature_next(const char *signature);
+static int parse_message(dbus_conn_t *conn, uint32_t len, dbus_message_t *msg);
+static int auth(dbus_conn_t *conn);
+static int read_line(int fd, char *line, uint32_t size);
+
+int dbus_open_system(dbus_conn_t *conn)
+{
+    memset(conn, 0, sizeof(dbus_conn_t));
+    conn->sock = -1;
+
+    // Only the "unix:path=..." addresses are supported
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    const char *address = getenv("DBUS_SYSTEM_BUS_ADDRESS");
+    if(address && strncmp(address, "unix:path=", 10) == 0)
+    {
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%.*s", (int)strcspn(address + 10, ",;"), address + 10);
+    }
+    else
+    {
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", DBUS_SYSTEM_BUS_PATH);
+    }
+
+    conn->sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(conn->sock < 0) return -errno;
+
+    // Blocking with a timeout until the bus knows us
+    struct timeval tv = {SETUP_TIMEOUT_MS / 1000, (SETUP_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(conn->sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    int res = 0;
+    if(connect(conn->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) res = -errno;
+    if(res == 0) res = auth(conn);
+
+    dbus_msg_t hello;
+    if(res == 0)
+    {
+        dbus_msg_call(&hello, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", "Hello", "");
+        res = dbus_send(conn, &hello);
+    }
+
+    // The unique name is the first message, signals can only come after it
+    dbus_message_t reply;
+    if(res > 0) res = dbus_read(conn, &reply);
+    if(res == 1 && reply.type == DBUS_METHOD_RETURN)
+    {
+        snprintf(conn->unique_name, sizeof(conn->unique_name), "%s", dbus_get_string(&reply.body));
+        res = 0;
+    }
+    else if(res >= 0)
+    {
+        res = res == 0 ? -ETIMEDOUT : -EPROTO;
+    }
+
+    if(res < 0)
+    {
+        dbus_close(conn);
+        return res;
+    }
+
+    fcntl(conn->sock, F_SETFL, fcntl(conn->sock, F_GETFL) | O_NONBLOCK);
+    return 0;
+}
+
+void dbus_open_fd(dbus_conn_t *conn, int fd)
+{
+    memset(conn, 0, sizeof(dbus_conn_t));
+    conn->sock = fd;
+}
+
+void dbus_close(dbus_conn_t *conn)
+{
+    if(conn->sock >= 0) close(conn->sock);
+    free(conn->rx);
+    conn->sock = -1;
+    conn->rx = NULL;
+    conn->rx_len = 0;
+    conn->rx_size = 0;
+    conn->rx_used = 0;
+}
+
+int dbus_send(dbus_conn_t *conn, dbus_msg_t *msg)
+{
+    if(msg->error)
+    {
+        dbus_msg_free(msg);
+        return -ENOMEM;
+    }
+
+    uint32_t body_len = msg->len - msg->body_start;
+    uint32_t serial = ++conn->serial;
+    if(serial == 0) serial = ++conn->serial;
+    memcpy(msg->data + 4, &body_len, 4);
+    memcpy(msg->data + 8, &serial, 4);
+
+    int res = serial;
+    uint32_t sent = 0;
+    while(sent < msg->len)
+    {
+        ssize_t n = send(conn->sock, msg->data + sent, msg->len - sent, MSG_NOSIGNAL);
+        if(n >= 0)
+        {
+            sent += n;
+            continue;
+        }
+        if(errno == EINTR) continue;
+
+        // The bus is slow to read, messages are small so it's worth waiting a little
+        struct pollfd pfd = {conn->sock, POLLOUT, 0};
+        if((errno != EAGAIN && errno != EWOULDBLOCK) || poll(&pfd, 1, SEND_TIMEOUT_MS) <= 0)
+        {
+            res = errno == EAGAIN || errno == EWOULDBLOCK ? -ETIMEDOUT : -errno;
+            break;
+        }
+    }
+
+    dbus_msg_free(msg);
+    return res;
+}
+
+int dbus_read(dbus_conn_t *conn, dbus_message_t *msg)
+{
+    // Drop the message returned last time
+    if(conn->rx_used)
+    {
+        memmove(conn->rx, conn->rx + conn->rx_used, conn->rx_len - conn->rx_used);
+        conn->rx_len -= conn->rx_used;
+        conn->rx_used = 0;
+    }
+
+    while(1)
+    {
+        if(conn->rx_len >= HEADER_SIZE)
+        {
+            if(conn->rx[0] != 'l') return -EPROTO;
+
+            uint32_t body_len, fields_len;
+            memcpy(&body_len, conn->rx + 4, 4);
+            memcpy(&fields_len, conn->rx + 12, 4);
+            if(body_len > MSG_MAX_SIZE || fields_len > MSG_MAX_SIZE) return -EMSGSIZE;
+
+            uint32_t len = ((HEADER_SIZE + fields_len + 7) & ~7u) + body_len;
+            if(conn->rx_len >= len) return parse_message(conn, len, msg);
+
+            if(len > conn->rx_size)
+            {
+                uint8_t *rx = (uint8_t *)realloc(conn->rx, len);
+                if(rx == NULL) return -ENOMEM;
+                conn->rx = rx;
+                conn->rx_size = len;
+            }
+        }
+        if(conn->rx_size - conn->rx_len < 512)
+        {
+            uint32_t size = conn->rx_size ? conn->rx_size * 2 : 4096;
+            uint8_t *rx = (uint8_t *)realloc(conn->rx, size);
+            if(rx == NULL) return -ENOMEM;
+            conn->rx = rx;
+            conn->rx_size = size;
+        }
+
+        ssize_t n = recv(conn->sock, conn->rx + conn->rx_len, conn->rx_size - conn->rx_len, 0);
+        if(n == 0) return -ECONNRESET;
+        if(n < 0)
+        {
+            if(errno == EINTR) continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -errno;
+        }
+        conn->rx_len += n;
+    }
+}
+
+void dbus_msg_call(dbus_msg_t *msg, const char *destination, const char *path, const char *interface,
+                   const char *member, const char *signature)
+{
+    msg_start(msg, DBUS_METHOD_CALL);
+    put_field(msg, FIELD_PATH, 'o', path);
+    put_field(msg, FIELD_INTERFACE, 's', interface);
+    put_field(msg, FIELD_MEMBER, 's', member);
+    put_field(msg, FIELD_DESTINATION, 's', destination);
+    if(signature[0]) put_field(msg, FIELD_SIGNATURE, 'g', signature);
+    msg_end_header(msg);
+}
+
+void dbus_msg_signal(dbus_msg_t *msg, const char *path, const char *interface, const char *member,
+                     const char *signature)
+{
+    msg_start(msg, DBUS_SIGNAL);
+    put_field(msg, FIELD_PATH, 'o', path);
+    put_field(msg, FIELD_INTERFACE, 's', interface);
+    put_field(msg, FIELD_MEMBER, 's', member);
+    if(signature[0]) put_field(msg, FIELD_SIGNATURE, 'g', signature);
+    msg_end_header(msg);
+}
+
+void dbus_msg_return(dbus_msg_t *msg, const dbus_message_t *call, const char *signature)
+{
+    msg_start(msg, DBUS_METHOD_RETURN);
+    put_field_u32(msg, FIELD_REPLY_SERIAL, call->serial);
+    if(call->sender) put_field(msg, FIELD_DESTINATION, 's', call->sender);
+    if(signature[0]) put_field(msg, FIELD_SIGNATURE, 'g', signature);
+    msg_end_header(msg);
+}
+
+void dbus_msg_error(dbus_msg_t *msg, const dbus_message_t *call, const char *name, const char *text)
+{
+    msg_start(msg, DBUS_ERROR);
+    put_field(msg, FIELD_ERROR_NAME, 's', name);
+    put_field_u32(msg, FIELD_REPLY_SERIAL, call->serial);
+    if(call->sender) put_field(msg, FIELD_DESTINATION, 's', call->sender);
+    put_field(msg, FIELD_SIGNATURE, 'g', "s");
+    msg_end_header(msg);
+    dbus_put_string(msg, text);
+}
+
+void dbus_msg_free(dbus_msg_t *msg)
+{
+    free(msg->data);
+    msg->data = NULL;
+    msg->len = 0;
+    msg->size = 0;
+}
+
+void dbus_put_byte(dbus_msg_t *msg, uint8_t value)
+{
+    put_data(msg, &value, 1);
+}
+
+void dbus_put_bool(dbus_msg_t *msg, bool value)
+{
+    dbus_put_u32(msg, value ? 1 : 0);
+}
+
+void dbus_put_u32(dbus_msg_t *msg, uint32_t value)
+{
+    put_align(msg, 4);
+    put_data(msg, &value, 4);
+}
+
+void dbus_put_string(dbus_msg_t *msg, const char *value)
+{
+    uint32_t len = strlen(value);
+    dbus_put_u32(msg, len);
+    put_data(msg, value, len + 1);
+}
+
+void dbus_put_signature(dbus_msg_t *msg, const char *value)
+{
+    uint8_t len = strlen(value);
+    put_data(msg, &len, 1);
+    put_data(msg, value, len + 1);
+}
+
+uint32_t dbus_array_begin(dbus_msg_t *msg, uint32_t elem_align)
+{
+    dbus_put_u32(msg, 0);
+    uint32_t array = msg->len - 4;
+    put_align(msg, elem_align);
+    return array;
+}
+
+void dbus_array_end(dbus_msg_t *msg, uint32_t array, uint32_t elem_align)
+{
+    if(msg->error) return;
+
+    // The length doesn't include the padding before the first element
+    uint32_t start = (array + 4 + elem_align - 1) & ~(elem_align - 1);
+    uint32_t len = msg->len - start;
+    memcpy(msg->data + array, &len, 4);
+}
+
+void dbus_struct_begin(dbus_msg_t *msg)
+{
+    put_align(msg, 8);
+}
+
+void dbus_put_variant_string(dbus_msg_t *msg, const char *value)
+{
+    dbus_put_signature(msg, "s");
+    dbus_put_string(msg, value);
+}
+
+void dbus_put_variant_bool(dbus_msg_t *msg, bool value)
+{
+    dbus_put_signature(msg, "b");
+    dbus_put_bool(msg, value);
+}
+
+void dbus_put_variant_bytes(dbus_msg_t *msg, const void *data, uint32_t len)
+{
+    dbus_put_signature(msg, "ay");
+    dbus_put_u32(msg, len);
+    put_data(msg, data, len);
+}
+
+uint8_t dbus_get_byte(dbus_iter_t *it)
+{
+    if(!get_align(it, 1, 1)) return 0;
+    return it->data[it->pos++];
+}
+
+uint32_t dbus_get_u32(dbus_iter_t *it)
+{
+    if(!get_align(it, 4, 4)) return 0;
+    uint32_t value;
+    memcpy(&value, it->data + it->pos, 4);
+    it->pos += 4;
+    return value;
+}
+
+const char *dbus_get_string(dbus_iter_t *it)
+{
+    uint32_t len = dbus_get_u32(it);
+    if(it->error || len >= it->len - it->pos || it->data[it->pos + len] != '\0')
+    {
+        it->error = true;
+        return "";
+    }
+    const char *value = (const char *)it->data + it->pos;
+    it->pos += len + 1;
+    return value;
+}
+
+const char *dbus_get_signature(dbus_iter_t *it)
+{
+    uint32_t len = dbus_get_byte(it);
+    if(it->error || len >= it->len - it->pos || it->data[it->pos + len] != '\0')
+    {
+        it->error = true;
+        return "";
+    }
+    const char *value = (const char *)it->data + it->pos;
+    it->pos += len + 1;
+    return value;
+}
+
+uint32_t dbus_array_enter(dbus_iter_t *it, uint32_t elem_align)
+{
+    uint32_t len = dbus_get_u32(it);
+    if(!get_align(it, elem_align, 0) || len > it->len - it->pos)
+    {
+        it->error = true;
+        return it->pos;
+    }
+    return it->pos + len;
+}
+
+void dbus_struct_enter(dbus_iter_t *it)
+{
+    get_align(it, 8, 0);
+}
+
+void dbus_skip(dbus_iter_t *it, const char **signature)
+{
+    const char *sig = *signature;
+    *signature = signature_next(sig);
+    if(it->error) return;
+
+    switch(sig[0])
+    {
+        case 'y':
+            dbus_get_byte(it);
+            break;
+        case 'n':
+        case 'q':
+            if(get_align(it, 2, 2)) it->pos += 2;
+            break;
+        case 'b':
+        case 'i':
+        case 'u':
+        case 'h':
+            dbus_get_u32(it);
+            break;
+        case 'x':
+        case 't':
+        case 'd':
+            if(get_align(it, 8, 8)) it->pos += 8;
+            break;
+        case 's':
+        case 'o':
+            dbus_get_string(it);
+            break;
+        case 'g':
+            dbus_get_signature(it);
+            break;
+        case 'v':
+        {
+            const char *value_sig = dbus_get_signature(it);
+            dbus_skip(it, &value_sig);
+            break;
+        }
+        case 'a':
+        {
+            uint32_t end = dbus_array_enter(it, type_align(sig[1]));
+            if(!it->error) it->pos = end;
+            break;
+        }
+        case '(':
+        case '{':
+        {
+            dbus_struct_enter(it);
+            const char *member = sig + 1;
+            while(!it->error && member < *signature - 1) dbus_skip(it, &member);
+            break;
+        }
+        default:
+            it->error = true;
+            break;
+    }
+}
+
+static void msg_start(dbus_msg_t *msg, uint8_t type)
+{
+    memset(msg, 0, sizeof(dbus_msg_t));
+
+    // Endianness, type, flags, version, body length, serial, then the array of the header fields
+    uint8_t header[12] = {'l', type, 0, 1};
+    put_data(msg, header, sizeof(header));
+    dbus_put_u32(msg, 0);
+}
+
+static void msg_end_header(dbus_msg_t *msg)
+{
+    if(!msg->error)
+    {
+        uint32_t fields_len = msg->len - HEADER_SIZE;
+        memcpy(msg->data + 12, &fields_len, 4);
+    }
+    put_align(msg, 8);
+    msg->body_start = msg->len;
+}
+
+static void put_field(dbus_msg_t *msg, uint8_t code, char type, const char *value)
+{
+    char sig[2] = {type, '\0'};
+    dbus_struct_begin(msg);
+    dbus_put_byte(msg, code);
+    dbus_put_signature(msg, sig);
+    if(type == 'g') dbus_put_signature(msg, value);
+    else dbus_put_string(msg, value);
+}
+
+static void put_field_u32(dbus_msg_t *msg, uint8_t code, uint32_t value)
+{
+    dbus_struct_begin(msg);
+    dbus_put_byte(msg, code);
+    dbus_put_signature(msg, "u");
+    dbus_put_u32(msg, value);
+}
+
+static void put_data(dbus_msg_t *msg, const void *data, uint32_t len)
+{
+    if(msg->error) return;
+
+    if(msg->len + len > msg->size)
+    {
+        uint32_t size = msg->size ? msg->size : 256;
+        while(size < msg->len + len) size *= 2;
+        uint8_t *new_data = (uint8_t *)realloc(msg->data, size);
+        if(new_data == NULL)
+        {
+            msg->error = true;
+            return;
+        }
+        msg->data = new_data;
+        msg->size = size;
+    }
+    memcpy(msg->data + msg->len, data, len);
+    msg->len += len;
+}
+
+static void put_align(dbus_msg_t *msg, uint32_t align)
+{
+    static const uint8_t zeros[8] = {0};
+    put_data(msg, zeros, (align - msg->len % align) % align);
+}
+
+// Skip the padding before a value and check that `len` bytes follow
+static bool get_align(dbus_iter_t *it, uint32_t align, uint32_t len)
+{
+    if(it->error) return false;
+
+    uint32_t pos = (it->pos + align - 1) & ~(align - 1);
+    if(pos > it->len || len > it->len - pos)
+    {
+        it->error = true;
+        return false;
+    }
+    it->pos = pos;
+    return true;
+}
+
+static uint32_t type_align(char type)
+{
+    switch(type)
+    {
+        case 'n':
+        case 'q':
+            return 2;
+        case 'b':
+        case 'i':
+        case 'u':
+        case 'h':
+        case 's':
+        case 'o':
+        case 'a':
+            return 4;
+        case 'x':
+        case 't':
+        case 'd':
+        case '(':
+        case '{':
+            return 8;
+        default:
+            return 1;
+    }
+}
+
+// The signature after its first complete type
+static const char *signature_next(const char *signature)
+{
+    if(signature[0] == '\0') return signature;
+    if(signature[0] == 'a') return signature_next(signature + 1);
+    if(signature[0] != '(' && signature[0] != '{') return signature + 1;
+
+    int depth = 0;
+    do
+    {
+        if(*signature == '(' || *signature == '{') depth++;
+        else if(*signature == ')' || *signature == '}') depth--;
+        signature++;
+    } while(depth > 0 && *signature != '\0');
+    return signature;
+}
+
+static int parse_message(dbus_conn_t *conn, uint32_t len, dbus_message_t *msg)
+{
+    memset(msg, 0, sizeof(dbus_message_t));
+    conn->rx_used = len;
+
+    uint32_t body_len;
+    memcpy(&body_len, conn->rx + 4, 4);
+    memcpy(&msg->serial, conn->rx + 8, 4);
+    msg->type = conn->rx[1];
+    msg->signature = "";
+
+    // The header fields: an array of (byte code, variant value)
+    dbus_iter_t it = {conn->rx, len - body_len, 12, false};
+    uint32_t end = dbus_array_enter(&it, 8);
+    while(!it.error && it.pos < end)
+    {
+        dbus_struct_enter(&it);
+        uint8_t code = dbus_get_byte(&it);
+        const char *sig = dbus_get_signature(&it);
+        if(code == FIELD_REPLY_SERIAL && strcmp(sig, "u") == 0)
+        {
+            msg->reply_serial = dbus_get_u32(&it);
+            continue;
+        }
+
+        const char *value = NULL;
+        if(strcmp(sig, "s") == 0 || strcmp(sig, "o") == 0) value = dbus_get_string(&it);
+        else if(strcmp(sig, "g") == 0) value = dbus_get_signature(&it);
+        else dbus_skip(&it, &sig);
+
+        if(code == FIELD_PATH) msg->path = value;
+        else if(code == FIELD_INTERFACE) msg->interface = value;
+        else if(code == FIELD_MEMBER) msg->member = value;
+        else if(code == FIELD_ERROR_NAME) msg->error_name = value;
+        else if(code == FIELD_DESTINATION) msg->destination = value;
+        else if(code == FIELD_SENDER) msg->sender = value;
+        else if(code == FIELD_SIGNATURE && value) msg->signature = value;
+    }
+    if(it.error) return -EPROTO;
+
+    msg->body.data = conn->rx + len - body_len;
+    msg->body.len = body_len;
+    return 1;
+}
+
+// SASL EXTERNAL authentication with the user id, the kernel passes the credentials of the socket
+static int auth(dbus_conn_t *conn)
+{
+    char uid[16];
+    char cmd[64];
+    snprintf(uid, sizeof(uid), "%u", (unsigned)getuid());
+    int len = snprintf(cmd, sizeof(cmd), "AUTH EXTERNAL ");
+    uint32_t i;
+    for(i = 0; uid[i]; i++) len += snprintf(cmd + len, sizeof(cmd) - len, "%02x", uid[i]);
+    len += snprintf(cmd + len, sizeof(cmd) - len, "\r\n");
+
+    char line[128];
+    if(send(conn->sock, "", 1, MSG_NOSIGNAL) != 1) return -errno;
+    if(send(conn->sock, cmd, len, MSG_NOSIGNAL) != len) return -errno;
+    int res = read_line(conn->sock, line, sizeof(line));
+    if(res < 0) return res;
+    if(strncmp(line, "OK ", 3) != 0) return -EACCES;
+    if(send(conn->sock, "BEGIN\r\n", 7, MSG_NOSIGNAL) != 7) return -errno;
+    return 0;
+}
+
+// Read a line of the authentication byte by byte, nothing after it may be consumed
+static int read_line(int fd, char *line, uint32_t size)
+{
+    uint32_t len = 0;
+    while(len + 1 < size)
+    {
+        char c;
+        ssize_t n = recv(fd, &c, 1, 0);
+        if(n == 0) return -ECONNRESET;
+        if(n < 0)
+        {
+            if(errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? -ETIMEDOUT : -errno;
+        }
+        if(c == '\n') break;
+        if(c != '\r') line[len++] = c;
+    }
+    line[len] = '\0';
+    return len;
+}
@@ -0,0 +1,109 @@
+#ifndef DBUS_HH
+#define DBUS_HH
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * The part of the D-Bus wire protocol needed to talk to NetworkManager, without libdbus:
+ * connecting to the system bus (EXTERNAL authentication and Hello), building messages
+ * and reading the received ones. Only little endian messages are supported.
+ */
+
+#define DBUS_SYSTEM_BUS_PATH    "/run/dbus/system_bus_socket"
+
+#define DBUS_METHOD_CALL        1
+#define DBUS_METHOD_RETURN      2
+#define DBUS_ERROR              3
+#define DBUS_SIGNAL             4
+
+// A message being built
+typedef struct
+{
+    uint8_t *data;
+    uint32_t len;
+    uint32_t size;
+    uint32_t body_start;
+    bool error;             // Out of memory
+} dbus_msg_t;
+
+// Position in the body of a received message
+typedef struct
+{
+    const uint8_t *data;
+    uint32_t len;
+    uint32_t pos;
+    bool error;             // Read past the end or a malformed value
+} dbus_iter_t;
+
+// A received message, valid until the next dbus_read()
+typedef struct
+{
+    uint8_t type;
+    uint32_t serial;
+    uint32_t reply_serial;
+    const char *path;
+    const char *interface;
+    const char *member;
+    const char *error_name;
+    const char *destination;
+    const char *sender;
+    const char *signature;
+    dbus_iter_t body;
+} dbus_message_t;
+
+typedef struct
+{
+    int sock;
+    uint32_t serial;
+    uint8_t *rx;
+    uint32_t rx_len;
+    uint32_t rx_size;
+    uint32_t rx_used;       // Length of the message returned by the last dbus_read()
+    char unique_name[64];
+} dbus_conn_t;
+
+// Connect to the system bus ($DBUS_SYSTEM_BUS_ADDRESS or DBUS_SYSTEM_BUS_PATH). 0 or -errno
+int dbus_open_system(dbus_conn_t *conn);
+// Use a connected socket, e.g. the server side of a test bus
+void dbus_open_fd(dbus_conn_t *conn, int fd);
+void dbus_close(dbus_conn_t *conn);
+
+// Send a message and free it. The serial number or -errno
+int dbus_send(dbus_conn_t *conn, dbus_msg_t *msg);
+// 1: a message was read, 0: no complete message yet (non-blocking socket), -errno
+int dbus_read(dbus_conn_t *conn, dbus_message_t *msg);
+
+// Start a message, the body is added with the dbus_put_...() functions in the order of `signature`
+void dbus_msg_call(dbus_msg_t *msg, const char *destination, const char *path, const char *interface,
+                   const char *member, const char *signature);
+void dbus_msg_signal(dbus_msg_t *msg, const char *path, const char *interface, const char *member,
+                     const char *signature);
+void dbus_msg_return(dbus_msg_t *msg, const dbus_message_t *call, const char *signature);
+void dbus_msg_error(dbus_msg_t *msg, const dbus_message_t *call, const char *name, const char *text);
+void dbus_msg_free(dbus_msg_t *msg);
+
+void dbus_put_byte(dbus_msg_t *msg, uint8_t value);
+void dbus_put_bool(dbus_msg_t *msg, bool value);
+void dbus_put_u32(dbus_msg_t *msg, uint32_t value);
+void dbus_put_string(dbus_msg_t *msg, const char *value);      // Also an object path
+void dbus_put_signature(dbus_msg_t *msg, const char *value);
+// Arrays: the length is written by dbus_array_end(), `elem_align` is the alignment of the element type
+uint32_t dbus_array_begin(dbus_msg_t *msg, uint32_t elem_align);
+void dbus_array_end(dbus_msg_t *msg, uint32_t array, uint32_t elem_align);
+void dbus_struct_begin(dbus_msg_t *msg);                        // Also a dict entry
+void dbus_put_variant_string(dbus_msg_t *msg, const char *value);
+void dbus_put_variant_bool(dbus_msg_t *msg, bool value);
+void dbus_put_variant_bytes(dbus_msg_t *msg, const void *data, uint32_t len);
+
+uint8_t dbus_get_byte(dbus_iter_t *it);
+uint32_t dbus_get_u32(dbus_iter_t *it);
+const char *dbus_get_string(dbus_iter_t *it);                  // Also an object path
+const char *dbus_get_signature(dbus_iter_t *it);
+// Enter an array. The position after it, read the elements while `it->pos` is less
+uint32_t dbus_array_enter(dbus_iter_t *it, uint32_t elem_align);
+void dbus_struct_enter(dbus_iter_t *it);
+// Skip a value of the first complete type of `*signature` and move `*signature` after the type
+void dbus_skip(dbus_iter_t *it, const char **signature);
+
+#endif // DBUS_HH
@@ -0,0 +1,440 @@
+#include "net_monitor.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#define RTNL_BUF_SIZE       16384
+#define REPLY_TIMEOUT_MS    1000
+
+// In <linux/if.h>, which clashes with <net/if.h>
+#ifndef IFF_LOWER_UP
+#define IFF_LOWER_UP        0x10000
+#endif
+
+static int resync(net_monitor_t *mon, bool *link_dirty);
+static int request_dump(net_monitor_t *mon, uint16_t type);
+static int receive(net_monitor_t *mon, uint32_t seq, bool *link_dirty);
+static void handle_message(net_monitor_t *mon, const struct nlmsghdr *nlh, bool *link_dirty);
+static void handle_link(net_monitor_t *mon, const struct nlmsghdr *nlh, bool *link_dirty);
+static void handle_addr(net_monitor_t *mon, const struct nlmsghdr *nlh);
+static void interface_added(net_monitor_t *mon, int ifindex);
+static void interface_removed(net_monitor_t *mon);
+static void update_link(net_monitor_t *mon);
+static void get_state(const net_monitor_t *mon, net_state_t *state);
+static const struct rtattr *find_rtattr(const struct rtattr *rta, int len, uint16_t type);
+static int64_t now_ms(void);
+
+int net_monitor_open(net_monitor_t *mon, const char *ifname)
+{
+    memset(mon, 0, sizeof(net_monitor_t));
+    mon->sock = -1;
+    mon->epfd = -1;
+    mon->cancel_fd = -1;
+    snprintf(mon->ifname, sizeof(mon->ifname), "%s", ifname);
+
+    int res = 0;
+    mon->buf = (uint8_t *)malloc(RTNL_BUF_SIZE);
+    mon->sock = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    mon->epfd = epoll_create1(EPOLL_CLOEXEC);
+    mon->cancel_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(mon->buf == NULL) res = -ENOMEM;
+    else if(mon->sock < 0 || mon->epfd < 0 || mon->cancel_fd < 0) res = -errno;
+
+    // Join the groups before the first dump, so no change is lost in between
+    static const uint32_t groups[] = {RTNLGRP_LINK, RTNLGRP_IPV4_IFADDR, RTNLGRP_IPV6_IFADDR};
+    uint32_t i;
+    for(i = 0; res == 0 && i < sizeof(groups) / sizeof(groups[0]); i++)
+    {
+        if(setsockopt(mon->sock, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &groups[i], sizeof(groups[i])) < 0) res = -errno;
+    }
+    if(res < 0)
+    {
+        net_monitor_close(mon);
+        return res;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = mon->sock;
+    epoll_ctl(mon->epfd, EPOLL_CTL_ADD, mon->sock, &ev);
+    ev.data.fd = mon->cancel_fd;
+    epoll_ctl(mon->epfd, EPOLL_CTL_ADD, mon->cancel_fd, &ev);
+    return 0;
+}
+
+void net_monitor_close(net_monitor_t *mon)
+{
+    if(mon->nl_is_open) nl80211_close(&mon->nl);
+    if(mon->sock >= 0) close(mon->sock);
+    if(mon->epfd >= 0) close(mon->epfd);
+    if(mon->cancel_fd >= 0) close(mon->cancel_fd);
+    free(mon->buf);
+    mon->nl_is_open = false;
+    mon->sock = -1;
+    mon->epfd = -1;
+    mon->cancel_fd = -1;
+    mon->buf = NULL;
+}
+
+int net_monitor_run(net_monitor_t *mon, net_monitor_cb_t cb, void *user_data)
+{
+    // Forget a cancellation which came while the monitor wasn't running
+    uint64_t cnt;
+    if(read(mon->cancel_fd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN) return -errno;
+
+    bool link_dirty = false;
+    bool first = true;
+    int timeout = 0;        // 0: read the queued events before reporting the state
+    int res = resync(mon, &link_dirty);
+    while(res == 0 || res == -ENOBUFS)
+    {
+        // Too many changes were queued, read everything again
+        if(res == -ENOBUFS)
+        {
+            res = resync(mon, &link_dirty);
+            continue;
+        }
+
+        struct epoll_event ev;
+        int n = epoll_wait(mon->epfd, &ev, 1, timeout);
+        if(n < 0)
+        {
+            if(errno != EINTR) res = -errno;
+            continue;
+        }
+
+        // A burst of events (e.g. the link and all its addresses going away) is reported once
+        if(n == 0)
+        {
+            if(link_dirty) update_link(mon);
+            link_dirty = false;
+
+            net_state_t state;
+            get_state(mon, &state);
+            if(first || memcmp(&state, &mon->state, sizeof(net_state_t)) != 0)
+            {
+                mon->state = state;
+                cb(&state, user_data);
+            }
+            first = false;
+            timeout = -1;
+            continue;
+        }
+        timeout = 0;
+
+        if(ev.data.fd == mon->cancel_fd)
+        {
+            if(read(mon->cancel_fd, &cnt, sizeof(cnt)) < 0) return -errno;
+            return -ECANCELED;
+        }
+        if(mon->nl_is_open && ev.data.fd == mon->nl.sock)
+        {
+            if(nl80211_read_events(&mon->nl)) link_dirty = true;
+            continue;
+        }
+
+        res = receive(mon, 0, &link_dirty);
+    }
+    return res;
+}
+
+void net_monitor_cancel(net_monitor_t *mon)
+{
+    uint64_t one = 1;
+    if(mon->cancel_fd < 0) return;
+    if(write(mon->cancel_fd, &one, sizeof(one)) < 0) printf("[net] can't stop the monitor\n");
+}
+
+// Build the table from the dumps of the links and the addresses
+static int resync(net_monitor_t *mon, bool *link_dirty)
+{
+    mon->addr_cnt = 0;
+    *link_dirty = true;
+
+    mon->link_seen = false;
+    int seq = request_dump(mon, RTM_GETLINK);
+    int res = seq < 0 ? seq : receive(mon, seq, link_dirty);
+    if(res < 0) return res;
+
+    // The interface disappeared while the changes were lost
+    if(!mon->link_seen && mon->ifindex != 0) interface_removed(mon);
+
+    seq = request_dump(mon, RTM_GETADDR);
+    return seq < 0 ? seq : receive(mon, seq, link_dirty);
+}
+
+// The sequence number or -errno
+static int request_dump(net_monitor_t *mon, uint16_t type)
+{
+    struct
+    {
+        struct nlmsghdr nlh;
+        struct ifinfomsg ifi;   // Also big enough for the struct ifaddrmsg of RTM_GETADDR
+    } req;
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(type == RTM_GETLINK ? sizeof(struct ifinfomsg) : sizeof(struct ifaddrmsg));
+    req.nlh.nlmsg_type = type;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nlh.nlmsg_seq = ++mon->seq;
+    if(req.nlh.nlmsg_seq == 0) req.nlh.nlmsg_seq = ++mon->seq;     // 0 is left for the events
+    req.ifi.ifi_family = AF_UNSPEC;
+
+    while(send(mon->sock, &req, req.nlh.nlmsg_len, 0) < 0)
+    {
+        if(errno != EINTR) return -errno;
+    }
+    return req.nlh.nlmsg_seq;
+}
+
+// Process the messages, with `seq` until the dump is done, without it until none is left
+static int receive(net_monitor_t *mon, uint32_t seq, bool *link_dirty)
+{
+    int64_t deadline = now_ms() + REPLY_TIMEOUT_MS;
+    while(1)
+    {
+        ssize_t len = recv(mon->sock, mon->buf, RTNL_BUF_SIZE, MSG_TRUNC);
+        if(len < 0)
+        {
+            if(errno == EINTR) continue;
+            if(errno != EAGAIN && errno != EWOULDBLOCK) return -errno;
+            if(seq == 0) return 0;
+
+            int64_t left = deadline - now_ms();
+            if(left <= 0) return -ETIMEDOUT;
+            struct pollfd pfd = {mon->sock, POLLIN, 0};
+            poll(&pfd, 1, (int)left);
+            continue;
+        }
+        if(len > RTNL_BUF_SIZE) return -ENOBUFS;
+
+        bool done = false;
+        int msg_len = len;
+        const struct nlmsghdr *nlh = (const struct nlmsghdr *)mon->buf;
+        for(; NLMSG_OK(nlh, msg_len); nlh = NLMSG_NEXT(nlh, msg_len))
+        {
+            if(nlh->nlmsg_type == NLMSG_DONE || nlh->nlmsg_type == NLMSG_ERROR)
+            {
+                if(seq == 0 || nlh->nlmsg_seq != seq) continue;
+                done = true;
+                const struct nlmsgerr *err = (const struct nlmsgerr *)NLMSG_DATA(nlh);
+                if(nlh->nlmsg_type == NLMSG_ERROR && err->error < 0) return err->error;
+                continue;
+            }
+            handle_message(mon, nlh, link_dirty);
+        }
+        if(done) return 0;
+    }
+}
+
+// The replies of the dumps and the events are the same messages
+static void handle_message(net_monitor_t *mon, const struct nlmsghdr *nlh, bool *link_dirty)
+{
+    switch(nlh->nlmsg_type)
+    {
+        case RTM_NEWLINK:
+        case RTM_DELLINK:
+            handle_link(mon, nlh, link_dirty);
+            break;
+        case RTM_NEWADDR:
+        case RTM_DELADDR:
+            handle_addr(mon, nlh);
+            break;
+        default:
+            break;
+    }
+}
+
+static void handle_link(net_monitor_t *mon, const struct nlmsghdr *nlh, bool *link_dirty)
+{
+    if(nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg))) return;
+
+    const struct ifinfomsg *ifi = (const struct ifinfomsg *)NLMSG_DATA(nlh);
+    const struct rtattr *name = find_rtattr(IFLA_RTA(ifi), IFLA_PAYLOAD(nlh), IFLA_IFNAME);
+    bool is_ours = name && strncmp((const char *)RTA_DATA(name), mon->ifname, RTA_PAYLOAD(name)) == 0;
+
+    if(nlh->nlmsg_type == RTM_NEWLINK && is_ours)
+    {
+        mon->link_seen = true;
+        if(ifi->ifi_index != mon->ifindex)
+        {
+            if(mon->ifindex != 0) interface_removed(mon);
+            interface_added(mon, ifi->ifi_index);
+            *link_dirty = true;
+        }
+
+        bool carrier = (ifi->ifi_flags & IFF_LOWER_UP) != 0;
+        if(carrier != mon->carrier) *link_dirty = true;
+        mon->up = (ifi->ifi_flags & IFF_UP) != 0;
+        mon->carrier = carrier;
+    }
+    else if(mon->ifindex != 0 && ifi->ifi_index == mon->ifindex)
+    {
+        // Deleted or renamed
+        interface_removed(mon);
+        *link_dirty = true;
+    }
+}
+
+static void handle_addr(net_monitor_t *mon, const struct nlmsghdr *nlh)
+{
+    if(nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifaddrmsg))) return;
+
+    const struct ifaddrmsg *ifa = (const struct ifaddrmsg *)NLMSG_DATA(nlh);
+    if(mon->ifindex == 0 || (int)ifa->ifa_index != mon->ifindex) return;
+    if(ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6) return;
+
+    // IFA_LOCAL is the address of a point-to-point IPv4 link, IFA_ADDRESS the peer
+    int len = IFA_PAYLOAD(nlh);
+    const struct rtattr *a = find_rtattr(IFA_RTA(ifa), len, IFA_LOCAL);
+    if(a == NULL) a = find_rtattr(IFA_RTA(ifa), len, IFA_ADDRESS);
+    uint32_t addr_len = ifa->ifa_family == AF_INET ? 4 : 16;
+    if(a == NULL || RTA_PAYLOAD(a) < addr_len) return;
+
+    uint32_t flags = ifa->ifa_flags;
+    const struct rtattr *flags_attr = find_rtattr(IFA_RTA(ifa), len, IFA_FLAGS);
+    if(flags_attr && RTA_PAYLOAD(flags_attr) >= 4) flags = *(const uint32_t *)RTA_DATA(flags_attr);
+
+    net_addr_t addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.family = ifa->ifa_family;
+    addr.prefix = ifa->ifa_prefixlen;
+    addr.scope = ifa->ifa_scope;
+    addr.tentative = (flags & IFA_F_TENTATIVE) != 0;
+    memcpy(addr.addr, RTA_DATA(a), addr_len);
+
+    uint32_t i;
+    for(i = 0; i < mon->addr_cnt; i++)
+    {
+        if(mon->addrs[i].family == addr.family && memcmp(mon->addrs[i].addr, addr.addr, 16) == 0) break;
+    }
+
+    if(nlh->nlmsg_type == RTM_DELADDR)
+    {
+        if(i == mon->addr_cnt) return;
+        memmove(&mon->addrs[i], &mon->addrs[i + 1], (mon->addr_cnt - i - 1) * sizeof(net_addr_t));
+        mon->addr_cnt--;
+    }
+    else if(i < mon->addr_cnt || mon->addr_cnt < NET_ADDR_MAX)
+    {
+        if(i == mon->addr_cnt) mon->addr_cnt++;
+        mon->addrs[i] = addr;
+    }
+}
+
+// The connection events of a wireless interface come through nl80211
+static void interface_added(net_monitor_t *mon, int ifindex)
+{
+    mon->ifindex = ifindex;
+    mon->addr_cnt = 0;
+
+    int res = nl80211_open(&mon->nl, mon->ifname, -1);
+    if(res == 0)
+    {
+        res = nl80211_watch_link(&mon->nl);
+        if(res < 0) nl80211_close(&mon->nl);
+    }
+    if(res < 0)
+    {
+        printf("[net] no connection events of %s: %s\n", mon->ifname, strerror(-res));
+        return;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = mon->nl.sock;
+    epoll_ctl(mon->epfd, EPOLL_CTL_ADD, mon->nl.sock, &ev);
+    mon->nl_is_open = true;
+}
+
+static void interface_removed(net_monitor_t *mon)
+{
+    if(mon->nl_is_open)
+    {
+        epoll_ctl(mon->epfd, EPOLL_CTL_DEL, mon->nl.sock, NULL);
+        nl80211_close(&mon->nl);
+    }
+    mon->nl_is_open = false;
+    mon->ifindex = 0;
+    mon->up = false;
+    mon->carrier = false;
+    mon->addr_cnt = 0;
+}
+
+// Read the network and the signal after a connection event
+static void update_link(net_monitor_t *mon)
+{
+    bool was_connected = mon->link.connected;
+    if(!mon->carrier || !mon->nl_is_open || nl80211_get_link(&mon->nl, &mon->link) < 0)
+    {
+        memset(&mon->link, 0, sizeof(wifi_link_t));
+        return;
+    }
+
+    // The thresholds belong to the connection
+    if(mon->link.connected && !was_connected)
+    {
+        static const int32_t thresholds[] = NET_SIGNAL_THRESHOLDS;
+        int res = nl80211_set_signal_thresholds(&mon->nl, thresholds, sizeof(thresholds) / sizeof(thresholds[0]));
+        if(res < 0) printf("[net] no signal events: %s\n", strerror(-res));
+    }
+}
+
+static void get_state(const net_monitor_t *mon, net_state_t *state)
+{
+    // Zeroed as a whole, the states are compared with memcmp()
+    memset(state, 0, sizeof(net_state_t));
+    state->exists = mon->ifindex != 0;
+    state->up = mon->up;
+    state->carrier = mon->carrier;
+    if(mon->link.connected)
+    {
+        memcpy(state->ssid, mon->link.ssid, sizeof(state->ssid));
+        state->signal_dbm = mon->link.signal_dbm;
+        memcpy(state->bssid, mon->link.bssid, sizeof(state->bssid));
+        state->freq_mhz = mon->link.freq_mhz;
+    }
+
+    const net_addr_t *ipv4 = NULL;
+    const net_addr_t *ipv6 = NULL;
+    uint32_t i;
+    for(i = 0; i < mon->addr_cnt; i++)
+    {
+        const net_addr_t *a = &mon->addrs[i];
+        if(a->family == AF_INET && ipv4 == NULL) ipv4 = a;
+        if(a->family != AF_INET6 || a->tentative) continue;
+        if(ipv6 == NULL || (a->scope == RT_SCOPE_UNIVERSE && ipv6->scope != RT_SCOPE_UNIVERSE)) ipv6 = a;
+    }
+    if(ipv4)
+    {
+        inet_ntop(AF_INET, ipv4->addr, state->ipv4, sizeof(state->ipv4));
+        state->ipv4_prefix = ipv4->prefix;
+    }
+    if(ipv6) inet_ntop(AF_INET6, ipv6->addr, state->ipv6, sizeof(state->ipv6));
+}
+
+// The first attribute of a type in a list, NULL if it's missing
+static const struct rtattr *find_rtattr(const struct rtattr *rta, int len, uint16_t type)
+{
+    for(; RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+        if(rta->rta_type == type) return rta;
+    }
+    return NULL;
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,77 @@
+#ifndef NET_MONITOR_HH
+#define NET_MONITOR_HH
+
+#include "nl80211_scan.h"
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/*
+ * Network status of an interface kept up to date by the kernel's events instead of polling.
+ *
+ * An rtnetlink socket joined to the link, IPv4 and IPv6 address groups keeps a table of the
+ * interface and its addresses, the nl80211 connection events (see nl80211_watch_link()) tell
+ * when the SSID or the signal changes. The thread running net_monitor_run() sleeps in
+ * epoll_wait between the events and the callback only gets the state when something shown
+ * has changed.
+ */
+
+#define NET_ADDR_MAX            8
+#define NET_SIGNAL_THRESHOLDS   {-80, -70, -60}     // Signal levels of the events [dBm]
+
+typedef struct
+{
+    bool exists;            // The interface is present
+    bool up;                // IFF_UP
+    bool carrier;           // IFF_LOWER_UP
+    char ssid[33];          // Empty while not connected
+    uint8_t bssid[6];       // The AP, changes when roaming
+    uint32_t freq_mhz;      // Its channel, 0: unknown
+    int32_t signal_dbm;     // 0: unknown
+    char ipv4[INET_ADDRSTRLEN];
+    uint8_t ipv4_prefix;
+    char ipv6[INET6_ADDRSTRLEN];    // A global address, the link-local one without it
+} net_state_t;
+
+typedef void (*net_monitor_cb_t)(const net_state_t *state, void *user_data);
+
+// An address of the interface
+typedef struct
+{
+    uint8_t family;
+    uint8_t prefix;
+    uint8_t scope;
+    bool tentative;         // IPv6 duplicate address detection hasn't finished
+    uint8_t addr[16];
+} net_addr_t;
+
+typedef struct
+{
+    int sock;               // rtnetlink socket
+    int epfd;
+    int cancel_fd;          // eventfd, stops net_monitor_run()
+    char ifname[16];
+    int ifindex;            // 0: the interface doesn't exist
+    bool link_seen;         // The interface was in the link dump
+    uint32_t seq;
+    uint8_t *buf;
+    bool up;
+    bool carrier;
+    net_addr_t addrs[NET_ADDR_MAX];
+    uint32_t addr_cnt;
+    nl80211_t nl;           // Connection events of the interface, opened while it exists
+    bool nl_is_open;
+    wifi_link_t link;
+    net_state_t state;      // Last state passed to the callback
+} net_monitor_t;
+
+// Open the sockets, the interface may appear later. 0 or -errno
+int net_monitor_open(net_monitor_t *mon, const char *ifname);
+void net_monitor_close(net_monitor_t *mon);
+
+// Report the state, then each change until canceled. -ECANCELED or -errno
+int net_monitor_run(net_monitor_t *mon, net_monitor_cb_t cb, void *user_data);
+
+// Stop net_monitor_run(), can be called from any thread
+void net_monitor_cancel(net_monitor_t *mon);
+
+#endif // NET_MONITOR_HH
@@ -0,0 +1,686 @@
+#include "nl80211_scan.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+
+#define NL_BUF_SIZE         32768   // A dump message with the information elements of a few BSSs
+#define REQ_BUF_SIZE        128
+#define REPLY_TIMEOUT_MS    1000
+#define CQM_THRESHOLD_MAX   4
+#define CQM_HYSTERESIS_DB   3
+#define WLAN_EID_SSID       0
+#define WLAN_EID_RSN        48
+#define WLAN_EID_VENDOR     221
+#define WLAN_CAPABILITY_PRIVACY 0x0010
+
+enum
+{
+    SCAN_IDLE,
+    SCAN_RUNNING,
+    SCAN_DONE,
+    SCAN_ABORTED,
+};
+
+// Called for every reply of a request, with NULL at the end of each received datagram
+typedef int (*msg_handler_t)(nl80211_t *nl, const struct nlmsghdr *nlh, void *ctx);
+
+// A request being built
+typedef struct
+{
+    uint32_t buf[REQ_BUF_SIZE / 4];
+    struct nlmsghdr *nlh;
+} req_t;
+
+typedef struct
+{
+    const nl80211_scan_cb_t *cb;
+    int cnt;
+    bool pending;           // Results were reported since the last flush
+} dump_ctx_t;
+
+static int send_cmd(nl80211_t *nl, uint16_t family, uint8_t cmd, uint16_t flags, uint16_t attr,
+                    const void *data, uint16_t len);
+static void req_start(nl80211_t *nl, req_t *req, uint16_t family, uint8_t cmd, uint16_t flags);
+static void req_put(req_t *req, uint16_t type, const void *data, uint16_t len);
+static int req_send(nl80211_t *nl, req_t *req);
+static int scan(nl80211_t *nl, const wifi_scan_target_t *target, uint32_t timeout_ms, const nl80211_scan_cb_t *cb);
+static int trigger_scan(nl80211_t *nl, const wifi_scan_target_t *target);
+static int set_cqm(nl80211_t *nl, const int32_t *thresholds_dbm, uint32_t cnt);
+static int receive(nl80211_t *nl, uint32_t seq, int64_t deadline_ms, msg_handler_t handler, void *ctx);
+static int wait_readable(nl80211_t *nl, int64_t deadline_ms);
+static void handle_event(nl80211_t *nl, const struct nlmsghdr *nlh);
+static int family_handler(nl80211_t *nl, const struct nlmsghdr *nlh, void *ctx);
+static int bss_handler(nl80211_t *nl, const struct nlmsghdr *nlh, void *ctx);
+static int interface_handler(nl80211_t *nl, const struct nlmsghdr *nlh, void *ctx);
+static int station_handler(nl80211_t *nl, const struct nlmsghdr *nlh, void *ctx);
+static int dump_results(nl80211_t *nl, wifi_scan_phase_t phase, const nl80211_scan_cb_t *cb);
+static const struct nlattr *find_attr(const void *data, int len, uint16_t type);
+static const struct nlattr *genl_attrs(const struct nlmsghdr *nlh, int *len);
+static void parse_ies(const uint8_t *ies, int len, wifi_bss_t *bss);
+static wifi_security_t rsn_security(const uint8_t *rsn, int len);
+static int64_t now_ms(void);
+
+#define NLA_DATA(a)         ((const uint8_t *)(a) + NLA_HDRLEN)
+#define NLA_PAYLOAD(a)      ((int)(a)->nla_len - NLA_HDRLEN)
+
+int nl80211_open(nl80211_t *nl, const char *ifname, int cancel_fd)
+{
+    memset(nl, 0, sizeof(nl80211_t));
+    nl->sock = -1;
+    nl->epfd = -1;
+    nl->cancel_fd = cancel_fd;
+
+    int res = 0;
+    nl->ifindex = if_nametoindex(ifname);
+    nl->buf = (uint8_t *)malloc(NL_BUF_SIZE);
+    nl->sock = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_GENERIC);
+    nl->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if(nl->ifindex == 0) res = -ENODEV;
+    else if(nl->buf == NULL) res = -ENOMEM;
+    else if(nl->sock < 0 || nl->epfd < 0) res = -errno;
+    if(res < 0)
+    {
+        nl80211_close(nl);
+        return res;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = nl->sock;
+    epoll_ctl(nl->epfd, EPOLL_CTL_ADD, nl->sock, &ev);
+    ev.data.fd = nl->cancel_fd;
+    if(nl->cancel_fd >= 0) epoll_ctl(nl->epfd, EPOLL_CTL_ADD, nl->cancel_fd, &ev);
+
+    // Ask the generic netlink controller for the ids of nl80211 and its "scan" multicast group
+    int seq = send_cmd(nl, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, NLM_F_ACK, CTRL_ATTR_FAMILY_NAME,
+                       "nl80211", sizeof("nl80211"));
+    if(seq >= 0) res = receive(nl, seq, now_ms() + REPLY_TIMEOUT_MS, family_handler, NULL);
+    else res = seq;
+    if(res == 0 && (nl->family == 0 || nl->scan_group == 0)) res = -EPROTONOSUPPORT;
+
+    // The events of the scans are received together with the replies
+    if(res == 0 && setsockopt(nl->sock, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &nl->scan_group,
+                              sizeof(nl->scan_group)) < 0)
+    {
+        res = -errno;
+    }
+
+    if(res < 0) nl80211_close(nl);
+    return res;
+}
+
+void nl80211_close(nl80211_t *nl)
+{
+    if(nl->sock >= 0) close(nl->sock);
+    if(nl->epfd >= 0) close(nl->epfd);
+    free(nl->buf);
+    nl->sock = -1;
+    nl->epfd = -1;
+    nl->buf = NULL;
+}
+
+int nl80211_scan(nl80211_t *nl, uint32_t timeout_ms, const nl80211_scan_cb_t *cb)
+{
+    return scan(nl, NULL, timeout_ms, cb);
+}
+
+int nl80211_scan_directed(nl80211_t *nl, const wifi_scan_target_t *target, uint32_t timeout_ms,
+                          const nl80211_scan_cb_t *cb)
+{
+    return scan(nl, target, timeout_ms, cb);
+}
+
+// A scan of all networks on all channels, or of the target only
+static int scan(nl80211_t *nl, const wifi_scan_target_t *target, uint32_t timeout_ms, const nl80211_scan_cb_t *cb)
+{
+    int64_t deadline = now_ms() + timeout_ms;
+
+    // Canceled before it started, don't trigger a scan for nothing
+    struct pollfd pfd = {nl->cancel_fd, POLLIN, 0};
+    if(nl->cancel_fd >= 0 && poll(&pfd, 1, 0) == 1) return -ECANCELED;
+
+    // The results of the last scan can be shown right away
+    int res = dump_results(nl, WIFI_SCAN_CACHED, cb);
+    if(res < 0) return res;
+
+    nl->scan_state = SCAN_RUNNING;
+    res = trigger_scan(nl, target);
+    if(res >= 0) res = receive(nl, res, now_ms() + REPLY_TIMEOUT_MS, NULL, NULL);
+
+    // Another scan (e.g. of NetworkManager) is running, its results are just as good
+    if(res == -EBUSY) res = 0;
+
+    if(res == -EPERM)
+    {
+        printf("[wifi] triggering a scan needs CAP_NET_ADMIN, only the earlier results are shown\n");
+        nl->scan_state = SCAN_IDLE;
+        return 0;
+    }
+
+    if(res == 0 && nl->scan_state == SCAN_RUNNING) res = receive(nl, 0, deadline, NULL, NULL);
+    nl->scan_state = SCAN_IDLE;
+    if(res < 0) return res;
+
+    return dump_results(nl, WIFI_SCAN_FRESH, cb);
+}
+
+// NL80211_CMD_TRIGGER_SCAN, with the SSID, BSSID and channel of the target. The sequence number or -errno
+static int trigger_scan(nl80211_t *nl, const wifi_scan_target_t *target)
+{
+    static const uint8_t any_bssid[6] = {0, 0, 0, 0, 0, 0};
+
+    req_t req;
+    uint32_t ifindex = nl->ifindex;
+    req_start(nl, &req, nl->family, NL80211_CMD_TRIGGER_SCAN, NLM_F_ACK);
+    req_put(&req, NL80211_ATTR_IFINDEX, &ifindex, sizeof(ifindex));
+    if(target == NULL) return req_send(nl, &req);
+
+    // Nested lists: probe requests with this SSID (also finds a hidden network), only on this channel
+    uint32_t nest[(NLA_HDRLEN + 32 + 3) / 4];
+    struct nlattr *a = (struct nlattr *)nest;
+    uint16_t ssid_len = strlen(target->ssid);
+    a->nla_type = 1;
+    a->nla_len = NLA_HDRLEN + ssid_len;
+    memcpy((uint8_t *)a + NLA_HDRLEN, target->ssid, ssid_len);
+    req_put(&req, NL80211_ATTR_SCAN_SSIDS | NLA_F_NESTED, nest, NLA_ALIGN(a->nla_len));
+
+    if(target->freq_mhz)
+    {
+        a->nla_type = 1;
+        a->nla_len = NLA_HDRLEN + 4;
+        memcpy((uint8_t *)a + NLA_HDRLEN, &target->freq_mhz, 4);
+        req_put(&req, NL80211_ATTR_SCAN_FREQUENCIES | NLA_F_NESTED, nest, a->nla_len);
+    }
+
+    // Older kernels take the BSSID of a scan in NL80211_ATTR_MAC, newer ones too
+    if(memcmp(target->bssid, any_bssid, 6) != 0) req_put(&req, NL80211_ATTR_MAC, target->bssid, 6);
+    return req_send(nl, &req);
+}
+
+int nl80211_watch_link(nl80211_t *nl)
+{
+    if(nl->mlme_group == 0) return -EPROTONOSUPPORT;
+
+    // The scans of NetworkManager would only wake up the watcher
+    setsockopt(nl->sock, SOL_NETLINK, NETLINK_DROP_MEMBERSHIP, &nl->scan_group, sizeof(nl->scan_group));
+    if(setsockopt(nl->sock, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &nl->mlme_group, sizeof(nl->mlme_group)) < 0)
+    {
+        return -errno;
+    }
+    return 0;
+}
+
+int nl80211_set_signal_thresholds(nl80211_t *nl, const int32_t *thresholds_dbm, uint32_t cnt)
+{
+    if(cnt > CQM_THRESHOLD_MAX) cnt = CQM_THRESHOLD_MAX;
+    int res = set_cqm(nl, thresholds_dbm, cnt);
+
+    // Drivers without NL80211_EXT_FEATURE_CQM_RSSI_LIST take a single threshold
+    if((res == -EOPNOTSUPP || res == -EINVAL) && cnt > 1) res = set_cqm(nl, &thresholds_dbm[cnt / 2], 1);
+    return res;
+}
+
+bool nl80211_read_events(nl80211_t *nl)
+{
+    while(1)
+    {
+        ssize_t len = recv(nl->sock, nl->buf, NL_BUF_SIZE, MSG_TRUNC);
+        if(len < 0)
+        {
+            if(errno == EINTR) continue;
+            // Events were lost, the connection has to be read again
+            if(errno == ENOBUFS)
+            {
+                nl->link_changed = true;
+                continue;
+            }
+            break;
+        }
+        if(len > NL_BUF_SIZE) continue;
+
+        int msg_len = len;
+        const struct nlmsghdr *nlh = (const struct nlmsghdr *)nl->buf;
+        for(; NLMSG_OK(nlh, msg_len); nlh = NLMSG_NEXT(nlh, msg_len))
+        {
+            if(nlh->nlmsg_seq == 0 && nlh->nlmsg_pid == 0) handle_event(nl, nlh);
+        }
+    }
+
+    bool changed = nl->link_changed;
+    nl->link_changed = false;
+    return changed;
+}
+
+int nl80211_get_link(nl80211_t *nl, wifi_link_t *link)
+{
+    memset(link, 0, sizeof(wifi_link_t));
+
+    // The interface has an SSID while it's connected
+    uint32_t ifindex = nl->ifindex;
+    int res = send_cmd(nl, nl->family, NL80211_CMD_GET_INTERFACE, NLM_F_ACK, NL80211_ATTR_IFINDEX,
+                       &ifindex, sizeof(ifindex));
+    if(res >= 0) res = receive(nl, res, now_ms() + REPLY_TIMEOUT_MS, interface_handler, link);
+    if(res < 0 || !link->connected) return res;
+
+    // The only station of a client interface is its AP
+    res = send_cmd(nl, nl->family, NL80211_CMD_GET_STATION, NLM_F_DUMP, NL80211_ATTR_IFINDEX,
+                   &ifindex, sizeof(ifindex));
+    if(res >= 0) res = receive(nl, res, now_ms() + REPLY_TIMEOUT_MS, station_handler, link);
+    return res;
+}
+
+// Ask for the BSS list of the interface kept by the kernel
+static int dump_results(nl80211_t *nl, wifi_scan_phase_t phase, const nl80211_scan_cb_t *cb)
+{
+    uint32_t ifindex = nl->ifindex;
+    int seq = send_cmd(nl, nl->family, NL80211_CMD_GET_SCAN, NLM_F_DUMP, NL80211_ATTR_IFINDEX,
+                       &ifindex, sizeof(ifindex));
+    if(seq < 0) return seq;
+
+    if(cb->begin_cb) cb->begin_cb(phase, cb->user_data);
+    dump_ctx_t ctx = {cb, 0, false};
+    int res = receive(nl, seq, now_ms() + REPLY_TIMEOUT_MS, bss_handler, &ctx);
+    return res < 0 ? res : ctx.cnt;
+}
+
+// Send a generic netlink command with a single attribute. The sequence number or -errno
+static int send_cmd(nl80211_t *nl, uint16_t family, uint8_t cmd, uint16_t flags, uint16_t attr,
+                    const void *data, uint16_t len)
+{
+    req_t req;
+    req_start(nl, &req, family, cmd, flags);
+    req_put(&req, attr, data, len);
+    return req_send(nl, &req);
+}
+
+static void req_start(nl80211_t *nl, req_t *req, uint16_t family, uint8_t cmd, uint16_t flags)
+{
+    memset(req->buf, 0, sizeof(req->buf));
+
+    req->nlh = (struct nlmsghdr *)req->buf;
+    req->nlh->nlmsg_type = family;
+    req->nlh->nlmsg_flags = NLM_F_REQUEST | flags;
+    req->nlh->nlmsg_seq = ++nl->seq;
+    if(req->nlh->nlmsg_seq == 0) req->nlh->nlmsg_seq = ++nl->seq;   // 0 is left for the events
+    req->nlh->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+
+    struct genlmsghdr *genl = (struct genlmsghdr *)NLMSG_DATA(req->nlh);
+    genl->cmd = cmd;
+    genl->version = 1;
+}
+
+static void req_put(req_t *req, uint16_t type, const void *data, uint16_t len)
+{
+    struct nlattr *a = (struct nlattr *)((uint8_t *)req->buf + req->nlh->nlmsg_len);
+    a->nla_type = type;
+    a->nla_len = NLA_HDRLEN + len;
+    memcpy((uint8_t *)a + NLA_HDRLEN, data, len);
+    req->nlh->nlmsg_len += NLA_ALIGN(a->nla_len);
+}
+
+// The sequence number or -errno
+static int req_send(nl80211_t *nl, req_t *req)
+{
+    while(send(nl->sock, req->buf, req->nlh->nlmsg_len, 0) < 0)
+    {
+        if(errno != EINTR) return -errno;
+    }
+    return req->nlh->nlmsg_seq;
+}
+
+// NL80211_CMD_SET_CQM with the RSSI thresholds and a hysteresis
+static int set_cqm(nl80211_t *nl, const int32_t *thresholds_dbm, uint32_t cnt)
+{
+    uint32_t cqm[(2 * NLA_HDRLEN + 4 * CQM_THRESHOLD_MAX + 4) / 4];
+    struct nlattr *a = (struct nlattr *)cqm;
+    a->nla_type = NL80211_ATTR_CQM_RSSI_THOLD;
+    a->nla_len = NLA_HDRLEN + 4 * cnt;
+    memcpy((uint8_t *)a + NLA_HDRLEN, thresholds_dbm, 4 * cnt);
+
+    uint32_t hysteresis = CQM_HYSTERESIS_DB;
+    a = (struct nlattr *)((uint8_t *)a + NLA_ALIGN(a->nla_len));
+    a->nla_type = NL80211_ATTR_CQM_RSSI_HYST;
+    a->nla_len = NLA_HDRLEN + 4;
+    memcpy((uint8_t *)a + NLA_HDRLEN, &hysteresis, 4);
+    uint16_t cqm_len = (uint8_t *)a + NLA_ALIGN(a->nla_len) - (uint8_t *)cqm;
+
+    req_t req;
+    uint32_t ifindex = nl->ifindex;
+    req_start(nl, &req, nl->family, NL80211_CMD_SET_CQM, NLM_F_ACK);
+    req_put(&req, NL80211_ATTR_IFINDEX, &ifindex, sizeof(ifindex));
+    req_put(&req, NL80211_ATTR_CQM | NLA_F_NESTED, cqm, cqm_len);
+    int seq = req_send(nl, &req);
+    if(seq < 0) return seq;
+    return receive(nl, seq, now_ms() + REPLY_TIMEOUT_MS, NULL, NULL);
+}
+
+/*
+ * Read the messages until the request `seq` is finished (acknowledged, the end of a dump or an error)
+ * or, with `seq` 0, until the scan is over. Events are processed in both cases.
+ */
+static int receive(nl80211_t *nl, uint32_t seq, int64_t deadline_ms, msg_handler_t handler, void *ctx)
+{
+    int res = 0;
+    while(1)
+    {
+        ssize_t len = recv(nl->sock, nl->buf, NL_BUF_SIZE, MSG_TRUNC);
+        if(len < 0)
+        {
+            if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            {
+                int wait_res = wait_readable(nl, deadline_ms);
+                if(wait_res < 0) return wait_res;
+                continue;
+            }
+            // Too many events were queued, the end of the scan might have been lost
+            if(errno == ENOBUFS)
+            {
+                if(nl->scan_state == SCAN_RUNNING) nl->scan_state = SCAN_DONE;
+                if(seq == 0) return res;
+                continue;
+            }
+            return -errno;
+        }
+        if(len > NL_BUF_SIZE) return -EMSGSIZE;
+
+        bool done = false;
+        int msg_len = len;
+        const struct nlmsghdr *nlh = (const struct nlmsghdr *)nl->buf;
+        for(; NLMSG_OK(nlh, msg_len); nlh = NLMSG_NEXT(nlh, msg_len))
+        {
+            if(nlh->nlmsg_seq == 0 && nlh->nlmsg_pid == 0)
+            {
+                handle_event(nl, nlh);
+                continue;
+            }
+            if(seq == 0 || nlh->nlmsg_seq != seq) continue;    // Late reply of a canceled request
+
+            if(nlh->nlmsg_type == NLMSG_DONE)
+            {
+                done = true;
+            }
+            else if(nlh->nlmsg_type == NLMSG_ERROR)
+            {
+                const struct nlmsgerr *err = (const struct nlmsgerr *)NLMSG_DATA(nlh);
+                if(res == 0) res = err->error;
+                done = true;
+            }
+            else if(handler && res == 0)
+            {
+                res = handler(nl, nlh, ctx);
+            }
+        }
+        if(handler) handler(nl, NULL, ctx);
+
+        if(seq == 0 ? nl->scan_state != SCAN_RUNNING : done) return res;
+    }
+}
+
+// 0: the socket is readable, -ETIMEDOUT or -ECANCELED
+static int wait_readable(nl80211_t *nl, int64_t deadline_ms)
+{
+    int64_t left = deadline_ms - now_ms();
+    if(left <= 0) return -ETIMEDOUT;
+
+    struct epoll_event ev;
+    int n = epoll_wait(nl->epfd, &ev, 1, (int)left);
+    if(n < 0) return errno == EINTR ? 0 : -errno;
+    if(n == 0) return -ETIMEDOUT;
+
+    // Left readable, the waits after this one are canceled too
+    if(ev.data.fd == nl->cancel_fd) return -ECANCELED;
+    return 0;
+}
+
+// Multicast messages of the "scan" and "mlme" groups
+static void handle_event(nl80211_t *nl, const struct nlmsghdr *nlh)
+{
+    if(nlh->nlmsg_type != nl->family) return;
+
+    int len;
+    const struct nlattr *attrs = genl_attrs(nlh, &len);
+    const struct nlattr *ifindex = find_attr(attrs, len, NL80211_ATTR_IFINDEX);
+    if(ifindex == NULL || NLA_PAYLOAD(ifindex) < 4 || *(const uint32_t *)NLA_DATA(ifindex) != (uint32_t)nl->ifindex)
+    {
+        return;
+    }
+
+    const struct genlmsghdr *genl = (const struct genlmsghdr *)NLMSG_DATA(nlh);
+    switch(genl->cmd)
+    {
+        case NL80211_CMD_NEW_SCAN_RESULTS:
+            if(nl->scan_state == SCAN_RUNNING) nl->scan_state = SCAN_DONE;
+            break;
+        case NL80211_CMD_SCAN_ABORTED:
+            if(nl->scan_state == SCAN_RUNNING) nl->scan_state = SCAN_ABORTED;
+            break;
+        case NL80211_CMD_CONNECT:
+        case NL80211_CMD_DISCONNECT:
+        case NL80211_CMD_ROAM:
+        case NL80211_CMD_NOTIFY_CQM:
+            nl->link_changed = true;
+            break;
+        default:
+            break;
+    }
+}
+
+// Reply of CTRL_CMD_GETFAMILY
+static int family_handler(nl80211_t *nl, const struct nlmsghdr *nlh, void *ctx)
+{
+    if(nlh == NULL) return 0;
+
+    int len;
+    const struct nlattr *attrs = genl_attrs(nlh, &len);
+    const struct nlattr *id = find_attr(attrs, len, CTRL_ATTR_FAMILY_ID);
+    if(id && NLA_PAYLOAD(id) >= 2) nl->family = *(const uint16_t *)NLA_DATA(id);
+
+    const struct nlattr *groups = find_attr(attrs, len, CTRL_ATTR_MCAST_GROUPS);
+    if(groups == NULL) return 0;
+
+    // A nested list of groups, each with a name and an id
+    const struct nlattr *g = (const struct nlattr *)NLA_DATA(groups);
+    int rem = NLA_PAYLOAD(groups);
+    while(rem >= NLA_HDRLEN && g->nla_len >= NLA_HDRLEN && g->nla_len <= rem)
+    {
+        const struct nlattr *name = find_attr(NLA_DATA(g), NLA_PAYLOAD(g), CTRL_ATTR_MCAST_GRP_NAME);
+        const struct nlattr *grp_id = find_attr(NLA_DATA(g), NLA_PAYLOAD(g), CTRL_ATTR_MCAST_GRP_ID);
+        if(name && grp_id && NLA_PAYLOAD(grp_id) >= 4)
+        {
+            if(strncmp((const char *)NLA_DATA(name), "scan", NLA_PAYLOAD(name)) == 0)
+            {
+                nl->scan_group = *(const uint32_t *)NLA_DATA(grp_id);
+            }
+            else if(strncmp((const char *)NLA_DATA(name), "mlme", NLA_PAYLOAD(name)) == 0)
+            {
+                nl->mlme_group = *(const uint32_t *)NLA_DATA(grp_id);
+            }
+        }
+        rem -= NLA_ALIGN(g->nla_len);
+        g = (const struct nlattr *)((const uint8_t *)g + NLA_ALIGN(g->nla_len));
+    }
+    return 0;
+}
+
+// A BSS of NL80211_CMD_GET_SCAN
+static int bss_handler(nl80211_t *nl, const struct nlmsghdr *nlh, void *ctx)
+{
+    dump_ctx_t *dump = (dump_ctx_t *)ctx;
+    if(nlh == NULL)
+    {
+        if(dump->pending && dump->cb->flush_cb) dump->cb->flush_cb(dump->cb->user_data);
+        dump->pending = false;
+        return 0;
+    }
+    if(nlh->nlmsg_type != nl->family) return 0;
+
+    int len;
+    const struct nlattr *attrs = genl_attrs(nlh, &len);
+    const struct nlattr *bss_attr = find_attr(attrs, len, NL80211_ATTR_BSS);
+    if(bss_attr == NULL) return 0;
+
+    const void *bss_data = NLA_DATA(bss_attr);
+    int bss_len = NLA_PAYLOAD(bss_attr);
+    wifi_bss_t bss;
+    memset(&bss, 0, sizeof(bss));
+
+    const struct nlattr *a = find_attr(bss_data, bss_len, NL80211_BSS_BSSID);
+    if(a == NULL || NLA_PAYLOAD(a) < 6) return 0;
+    memcpy(bss.bssid, NLA_DATA(a), 6);
+
+    a = find_attr(bss_data, bss_len, NL80211_BSS_FREQUENCY);
+    if(a && NLA_PAYLOAD(a) >= 4) bss.freq_mhz = *(const uint32_t *)NLA_DATA(a);
+
+    a = find_attr(bss_data, bss_len, NL80211_BSS_SIGNAL_MBM);
+    if(a && NLA_PAYLOAD(a) >= 4) bss.signal_mbm = *(const int32_t *)NLA_DATA(a);
+
+    a = find_attr(bss_data, bss_len, NL80211_BSS_SEEN_MS_AGO);
+    if(a && NLA_PAYLOAD(a) >= 4) bss.age_ms = *(const uint32_t *)NLA_DATA(a);
+
+    a = find_attr(bss_data, bss_len, NL80211_BSS_STATUS);
+    if(a && NLA_PAYLOAD(a) >= 4) bss.associated = *(const uint32_t *)NLA_DATA(a) == NL80211_BSS_STATUS_ASSOCIATED;
+
+    // Without a WPA or RSN element the privacy bit means WEP
+    a = find_attr(bss_data, bss_len, NL80211_BSS_CAPABILITY);
+    if(a && NLA_PAYLOAD(a) >= 2 && (*(const uint16_t *)NLA_DATA(a) & WLAN_CAPABILITY_PRIVACY)) bss.security = WIFI_SEC_WEP;
+
+    // The probe response has the SSID of a hidden network which the beacon doesn't
+    a = find_attr(bss_data, bss_len, NL80211_BSS_INFORMATION_ELEMENTS);
+    if(a == NULL) a = find_attr(bss_data, bss_len, NL80211_BSS_BEACON_IES);
+    if(a) parse_ies(NLA_DATA(a), NLA_PAYLOAD(a), &bss);
+
+    if(dump->cb->bss_cb) dump->cb->bss_cb(&bss, dump->cb->user_data);
+    dump->cnt++;
+    dump->pending = true;
+    return 0;
+}
+
+// Reply of NL80211_CMD_GET_INTERFACE
+static int interface_handler(nl80211_t *nl, const struct nlmsghdr *nlh, void *ctx)
+{
+    if(nlh == NULL || nlh->nlmsg_type != nl->family) return 0;
+
+    wifi_link_t *link = (wifi_link_t *)ctx;
+    int len;
+    const struct nlattr *attrs = genl_attrs(nlh, &len);
+    const struct nlattr *ssid = find_attr(attrs, len, NL80211_ATTR_SSID);
+    if(ssid == NULL || NLA_PAYLOAD(ssid) == 0) return 0;
+
+    int ssid_len = NLA_PAYLOAD(ssid) > 32 ? 32 : NLA_PAYLOAD(ssid);
+    memcpy(link->ssid, NLA_DATA(ssid), ssid_len);
+    link->ssid[ssid_len] = '\0';
+    link->connected = true;
+
+    const struct nlattr *freq = find_attr(attrs, len, NL80211_ATTR_WIPHY_FREQ);
+    if(freq && NLA_PAYLOAD(freq) >= 4) link->freq_mhz = *(const uint32_t *)NLA_DATA(freq);
+    return 0;
+}
+
+// A station of NL80211_CMD_GET_STATION
+static int station_handler(nl80211_t *nl, const struct nlmsghdr *nlh, void *ctx)
+{
+    if(nlh == NULL || nlh->nlmsg_type != nl->family) return 0;
+
+    wifi_link_t *link = (wifi_link_t *)ctx;
+    int len;
+    const struct nlattr *attrs = genl_attrs(nlh, &len);
+    const struct nlattr *mac = find_attr(attrs, len, NL80211_ATTR_MAC);
+    if(mac && NLA_PAYLOAD(mac) >= 6) memcpy(link->bssid, NLA_DATA(mac), 6);
+
+    const struct nlattr *info = find_attr(attrs, len, NL80211_ATTR_STA_INFO);
+    if(info == NULL) return 0;
+    const struct nlattr *signal = find_attr(NLA_DATA(info), NLA_PAYLOAD(info), NL80211_STA_INFO_SIGNAL);
+    if(signal && NLA_PAYLOAD(signal) >= 1) link->signal_dbm = *(const int8_t *)NLA_DATA(signal);
+    return 0;
+}
+
+// The first attribute of a type in a list, NULL if it's missing
+static const struct nlattr *find_attr(const void *data, int len, uint16_t type)
+{
+    const struct nlattr *a = (const struct nlattr *)data;
+    while(len >= NLA_HDRLEN && a->nla_len >= NLA_HDRLEN && a->nla_len <= len)
+    {
+        if((a->nla_type & NLA_TYPE_MASK) == type) return a;
+        len -= NLA_ALIGN(a->nla_len);
+        a = (const struct nlattr *)((const uint8_t *)a + NLA_ALIGN(a->nla_len));
+    }
+    return NULL;
+}
+
+// The attributes after the generic netlink header
+static const struct nlattr *genl_attrs(const struct nlmsghdr *nlh, int *len)
+{
+    *len = (int)nlh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    if(*len < 0) *len = 0;
+    return (const struct nlattr *)((const uint8_t *)NLMSG_DATA(nlh) + GENL_HDRLEN);
+}
+
+// SSID (empty for a hidden network) and security of the information elements
+static void parse_ies(const uint8_t *ies, int len, wifi_bss_t *bss)
+{
+    static const uint8_t wpa_oui[4] = {0x00, 0x50, 0xF2, 0x01};
+
+    while(len >= 2 && ies[1] + 2 <= len)
+    {
+        const uint8_t *data = ies + 2;
+        int data_len = ies[1];
+        if(ies[0] == WLAN_EID_SSID)
+        {
+            int ssid_len = data_len > 32 ? 32 : data_len;
+            memcpy(bss->ssid, data, ssid_len);
+            bss->ssid[ssid_len] = '\0';    // Some hidden networks send zeros, it's empty then too
+        }
+        else if(ies[0] == WLAN_EID_RSN)
+        {
+            bss->security = rsn_security(data, data_len);
+        }
+        else if(ies[0] == WLAN_EID_VENDOR && data_len >= 4 && memcmp(data, wpa_oui, 4) == 0)
+        {
+            if(bss->security < WIFI_SEC_WPA) bss->security = WIFI_SEC_WPA;
+        }
+        len -= data_len + 2;
+        ies += data_len + 2;
+    }
+}
+
+// WPA3 if SAE is the only key management of the RSN element
+static wifi_security_t rsn_security(const uint8_t *rsn, int len)
+{
+    // Version, group cipher, pairwise ciphers, then the AKM suites
+    int pos = 2 + 4;
+    if(pos + 2 > len) return WIFI_SEC_WPA2;
+    pos += 2 + 4 * (rsn[pos] | rsn[pos + 1] << 8);
+    if(pos + 2 > len) return WIFI_SEC_WPA2;
+
+    int akm_cnt = rsn[pos] | rsn[pos + 1] << 8;
+    pos += 2;
+    bool sae = false;
+    bool other = false;
+    int i;
+    for(i = 0; i < akm_cnt && pos + 4 <= len; i++, pos += 4)
+    {
+        // 00-0F-AC:8 SAE, 00-0F-AC:24 SAE with group-dependent hash
+        bool is_sae = rsn[pos] == 0x00 && rsn[pos + 1] == 0x0F && rsn[pos + 2] == 0xAC &&
+                      (rsn[pos + 3] == 8 || rsn[pos + 3] == 24);
+        if(is_sae) sae = true;
+        else other = true;
+    }
+    return sae && !other ? WIFI_SEC_WPA3 : WIFI_SEC_WPA2;
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,114 @@
+#ifndef NL80211_SCAN_HH
+#define NL80211_SCAN_HH
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * WiFi scanner talking nl80211 (generic netlink) to the kernel directly, without iwlib.
+ *
+ * A scan first reports the results the kernel still has from the last scan (also the ones
+ * started by NetworkManager), then triggers a new scan, waits for NL80211_CMD_NEW_SCAN_RESULTS
+ * on the "scan" multicast group with epoll and reports the fresh results. The results are
+ * passed to the callbacks as each netlink message is parsed, so the UI can show them while
+ * the rest are still being received. A directed scan (see nl80211_scan_directed()) only probes
+ * for one network on the channel where it was last seen, which takes tens of milliseconds.
+ *
+ * The same socket can follow the connection instead (see nl80211_watch_link()): the events of
+ * the "mlme" group tell when the interface connects, disconnects, roams or the signal crosses
+ * one of the thresholds, then nl80211_get_link() reads the network and its signal.
+ */
+
+typedef enum
+{
+    WIFI_SEC_OPEN,
+    WIFI_SEC_WEP,
+    WIFI_SEC_WPA,
+    WIFI_SEC_WPA2,
+    WIFI_SEC_WPA3,          // SAE only, a WPA2/WPA3 network is WIFI_SEC_WPA2
+} wifi_security_t;
+
+typedef struct
+{
+    uint8_t bssid[6];
+    char ssid[33];          // Empty for a hidden network
+    uint32_t freq_mhz;
+    int32_t signal_mbm;     // Signal strength [1/100 dBm]
+    uint32_t age_ms;        // Time since the BSS was last seen by a scan
+    wifi_security_t security;
+    bool associated;        // The interface is connected to this BSS
+} wifi_bss_t;
+
+// The network the interface is connected to
+typedef struct
+{
+    bool connected;
+    char ssid[33];
+    uint8_t bssid[6];
+    uint32_t freq_mhz;      // Channel of the AP, 0: unknown
+    int32_t signal_dbm;     // Signal of the AP, 0: unknown
+} wifi_link_t;
+
+// The network looked for by a directed scan
+typedef struct
+{
+    char ssid[33];
+    uint8_t bssid[6];       // The AP seen last time, all zero: any AP
+    uint32_t freq_mhz;      // The only channel scanned, 0: all channels
+} wifi_scan_target_t;
+
+typedef enum
+{
+    WIFI_SCAN_CACHED,       // Results of an earlier scan
+    WIFI_SCAN_FRESH,        // Results of the scan just finished
+} wifi_scan_phase_t;
+
+typedef struct
+{
+    void (*begin_cb)(wifi_scan_phase_t phase, void *user_data);     // The results replace the earlier ones
+    void (*bss_cb)(const wifi_bss_t *bss, void *user_data);
+    void (*flush_cb)(void *user_data);                              // A netlink message was processed
+    void *user_data;
+} nl80211_scan_cb_t;
+
+typedef struct
+{
+    int sock;               // Generic netlink socket
+    int epfd;
+    int cancel_fd;          // eventfd of the owner, the scans are canceled while it's readable. -1: none
+    int ifindex;
+    uint16_t family;        // Id of the nl80211 family
+    uint32_t scan_group;    // Id of the "scan" multicast group
+    uint32_t mlme_group;    // Id of the "mlme" multicast group
+    uint32_t seq;
+    int scan_state;
+    bool link_changed;      // A connection or signal event was received
+    uint8_t *buf;
+} nl80211_t;
+
+/*
+ * Open the socket and look up the nl80211 family and the interface. 0 or -errno
+ * `cancel_fd` stops the scans with -ECANCELED while it's readable (e.g. the eventfd of a service,
+ * see service_get_cancel_fd()). It's never read or closed here: its owner clears it when the next
+ * operation starts, so a cancellation which comes before a scan starts waiting isn't lost.
+ */
+int nl80211_open(nl80211_t *nl, const char *ifname, int cancel_fd);
+void nl80211_close(nl80211_t *nl);
+
+// Scan and wait for the results at most `timeout_ms`. The number of fresh results or -errno
+int nl80211_scan(nl80211_t *nl, uint32_t timeout_ms, const nl80211_scan_cb_t *cb);
+
+// Scan like nl80211_scan(), but send probe requests only for the target network on its channel
+int nl80211_scan_directed(nl80211_t *nl, const wifi_scan_target_t *target, uint32_t timeout_ms,
+                          const nl80211_scan_cb_t *cb);
+
+// Receive the connection events instead of the scan events, `sock` becomes readable when one comes. 0 or -errno
+int nl80211_watch_link(nl80211_t *nl);
+// Ask for an event when the signal crosses one of the ascending thresholds (armed again after connecting)
+int nl80211_set_signal_thresholds(nl80211_t *nl, const int32_t *thresholds_dbm, uint32_t cnt);
+// Process the received events without waiting. true: the connection or its signal changed
+bool nl80211_read_events(nl80211_t *nl);
+// Read the network of the interface and the signal of the AP. 0 or -errno
+int nl80211_get_link(nl80211_t *nl, wifi_link_t *link);
+
+#endif // NL80211_SCAN_HH
@@ -0,0 +1,417 @@
+#include "nm_client.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/epoll.h>
+
+#define NM_SERVICE          "org.freedesktop.NetworkManager"
+#define NM_PATH             "/org/freedesktop/NetworkManager"
+#define NM_SETTINGS_PATH    "/org/freedesktop/NetworkManager/Settings"
+#define NM_IFACE            "org.freedesktop.NetworkManager"
+#define NM_SETTINGS_IFACE   "org.freedesktop.NetworkManager.Settings"
+#define NM_CONNECTION_IFACE "org.freedesktop.NetworkManager.Settings.Connection"
+#define NM_DEVICE_IFACE     "org.freedesktop.NetworkManager.Device"
+#define PATH_MAX_LEN        128
+#define OPEN_TIMEOUT_MS     2000
+
+// NMDeviceState
+#define NM_DEVICE_STATE_PREPARE     40
+#define NM_DEVICE_STATE_CONFIG      50
+#define NM_DEVICE_STATE_NEED_AUTH   60
+#define NM_DEVICE_STATE_IP_CONFIG   70
+#define NM_DEVICE_STATE_IP_CHECK    80
+#define NM_DEVICE_STATE_ACTIVATED   100
+#define NM_DEVICE_STATE_FAILED      120
+
+// NMDeviceStateReason
+#define NM_REASON_NO_SECRETS                7
+#define NM_REASON_SUPPLICANT_DISCONNECT     8
+#define NM_REASON_SUPPLICANT_CONFIG_FAILED  9
+#define NM_REASON_SUPPLICANT_FAILED         10
+#define NM_REASON_SUPPLICANT_TIMEOUT        11
+#define NM_REASON_SSID_NOT_FOUND            53
+
+// A method call waiting for its reply
+typedef struct
+{
+    int serial;
+    bool replied;
+    int error;              // The error reply as -errno
+    uint32_t path_cnt;
+    char paths[2][PATH_MAX_LEN];
+} call_t;
+
+// State of a connection attempt
+typedef struct
+{
+    nm_event_cb_t cb;
+    void *user_data;
+    bool activating;        // The activation was requested, the states of the device belong to it
+    bool started;           // The device left the disconnected state
+    int result;             // 1: running, 0: connected, -errno: failed
+} attempt_t;
+
+static int call_wait(nm_client_t *nm, dbus_msg_t *msg, int64_t deadline_ms, call_t *call, attempt_t *att);
+static int run(nm_client_t *nm, int64_t deadline_ms, call_t *call, attempt_t *att);
+static void handle_message(nm_client_t *nm, dbus_message_t *msg, call_t *call, attempt_t *att);
+static void handle_state(uint32_t state, uint32_t reason, attempt_t *att);
+static int error_to_errno(const char *name);
+static void put_settings(dbus_msg_t *msg, const char *ssid, const char *pass, const char *uuid);
+static uint32_t group_begin(dbus_msg_t *msg, const char *name);
+static void put_setting(dbus_msg_t *msg, const char *key, const char *value);
+static void make_uuid(const char *ssid, char *uuid);
+static int64_t now_ms(void);
+
+int nm_open(nm_client_t *nm, const char *ifname, int cancel_fd)
+{
+    memset(nm, 0, sizeof(nm_client_t));
+    nm->epfd = -1;
+    nm->cancel_fd = cancel_fd;
+
+    int res = dbus_open_system(&nm->bus);
+    if(res < 0) return res;
+
+    nm->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if(nm->epfd < 0)
+    {
+        res = -errno;
+        nm_close(nm);
+        return res;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = nm->bus.sock;
+    epoll_ctl(nm->epfd, EPOLL_CTL_ADD, nm->bus.sock, &ev);
+    ev.data.fd = nm->cancel_fd;
+    if(nm->cancel_fd >= 0) epoll_ctl(nm->epfd, EPOLL_CTL_ADD, nm->cancel_fd, &ev);
+
+    int64_t deadline = now_ms() + OPEN_TIMEOUT_MS;
+    call_t call;
+    dbus_msg_t msg;
+    dbus_msg_call(&msg, NM_SERVICE, NM_PATH, NM_IFACE, "GetDeviceByIpIface", "s");
+    dbus_put_string(&msg, ifname);
+    res = call_wait(nm, &msg, deadline, &call, NULL);
+    if(res == 0 && (call.error || call.path_cnt == 0)) res = call.error ? call.error : -EPROTO;
+    if(res == 0) snprintf(nm->device, sizeof(nm->device), "%s", call.paths[0]);
+
+    // The progress of a connection comes from the state of the device
+    if(res == 0)
+    {
+        char rule[256];
+        snprintf(rule, sizeof(rule), "type='signal',interface='%s',member='StateChanged',path='%s'",
+                 NM_DEVICE_IFACE, nm->device);
+        dbus_msg_call(&msg, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", "AddMatch", "s");
+        dbus_put_string(&msg, rule);
+        res = call_wait(nm, &msg, deadline, &call, NULL);
+        if(res == 0) res = call.error;
+    }
+
+    if(res < 0) nm_close(nm);
+    return res;
+}
+
+void nm_close(nm_client_t *nm)
+{
+    dbus_close(&nm->bus);
+    if(nm->epfd >= 0) close(nm->epfd);
+    nm->epfd = -1;
+}
+
+int nm_connect(nm_client_t *nm, const char *ssid, const char *pass, uint32_t timeout_ms,
+               nm_event_cb_t cb, void *user_data)
+{
+    int64_t deadline = now_ms() + timeout_ms;
+
+    // Canceled before it started, don't ask NetworkManager for nothing
+    struct pollfd pfd = {nm->cancel_fd, POLLIN, 0};
+    if(nm->cancel_fd >= 0 && poll(&pfd, 1, 0) == 1) return -ECANCELED;
+
+    char uuid[40];
+    make_uuid(ssid, uuid);
+    attempt_t att = {cb, user_data, false, false, 1};
+    call_t call;
+    dbus_msg_t msg;
+
+    // Update the profile of the network if it was connected before, add it otherwise
+    dbus_msg_call(&msg, NM_SERVICE, NM_SETTINGS_PATH, NM_SETTINGS_IFACE, "GetConnectionByUuid", "s");
+    dbus_put_string(&msg, uuid);
+    int res = call_wait(nm, &msg, deadline, &call, &att);
+    if(res < 0) return res;
+
+    if(call.error == 0 && call.path_cnt > 0)
+    {
+        char profile[PATH_MAX_LEN];
+        snprintf(profile, sizeof(profile), "%s", call.paths[0]);
+        dbus_msg_call(&msg, NM_SERVICE, profile, NM_CONNECTION_IFACE, "Update", "a{sa{sv}}");
+        put_settings(&msg, ssid, pass, uuid);
+        res = call_wait(nm, &msg, deadline, &call, &att);
+        if(res == 0) res = call.error;
+        if(res < 0)
+        {
+            if(cb) cb(NM_EVENT_FAILED, 0, user_data);
+            return res;
+        }
+
+        dbus_msg_call(&msg, NM_SERVICE, NM_PATH, NM_IFACE, "ActivateConnection", "ooo");
+        dbus_put_string(&msg, profile);
+        dbus_put_string(&msg, nm->device);
+        dbus_put_string(&msg, "/");
+    }
+    else if(call.error == -ENOENT)
+    {
+        dbus_msg_call(&msg, NM_SERVICE, NM_PATH, NM_IFACE, "AddAndActivateConnection", "a{sa{sv}}oo");
+        put_settings(&msg, ssid, pass, uuid);
+        dbus_put_string(&msg, nm->device);
+        dbus_put_string(&msg, "/");
+    }
+    else
+    {
+        return call.error ? call.error : -EPROTO;
+    }
+
+    att.activating = true;
+    res = call_wait(nm, &msg, deadline, &call, &att);
+    if(res == 0 && call.error) res = call.error;
+    if(res == 0 && call.path_cnt == 0) res = -EPROTO;
+    if(res < 0)
+    {
+        if(cb && res != -ECANCELED && res != -ETIMEDOUT) cb(NM_EVENT_FAILED, 0, user_data);
+        return res;
+    }
+
+    // The active connection is the last path of the reply
+    char active[PATH_MAX_LEN];
+    snprintf(active, sizeof(active), "%s", call.paths[call.path_cnt - 1]);
+    if(att.result == 1) res = run(nm, deadline, NULL, &att);
+    if(res == 0) return att.result;
+
+    // Canceled or timed out: don't leave NetworkManager trying
+    dbus_msg_call(&msg, NM_SERVICE, NM_PATH, NM_IFACE, "DeactivateConnection", "o");
+    dbus_put_string(&msg, active);
+    dbus_send(&nm->bus, &msg);
+    return res;
+}
+
+int nm_delete(nm_client_t *nm, const char *ssid, uint32_t timeout_ms)
+{
+    int64_t deadline = now_ms() + timeout_ms;
+
+    char uuid[40];
+    make_uuid(ssid, uuid);
+    call_t call;
+    dbus_msg_t msg;
+    dbus_msg_call(&msg, NM_SERVICE, NM_SETTINGS_PATH, NM_SETTINGS_IFACE, "GetConnectionByUuid", "s");
+    dbus_put_string(&msg, uuid);
+    int res = call_wait(nm, &msg, deadline, &call, NULL);
+    if(res < 0) return res;
+    if(call.error == -ENOENT) return 0;
+    if(call.error || call.path_cnt == 0) return call.error ? call.error : -EPROTO;
+
+    char profile[PATH_MAX_LEN];
+    snprintf(profile, sizeof(profile), "%s", call.paths[0]);
+    dbus_msg_call(&msg, NM_SERVICE, profile, NM_CONNECTION_IFACE, "Delete", "");
+    res = call_wait(nm, &msg, deadline, &call, NULL);
+    if(res == 0) res = call.error == -ENOENT ? 0 : call.error;
+    return res;
+}
+
+// Send a method call and wait for its reply. 0: replied (see `call->error`), -errno
+static int call_wait(nm_client_t *nm, dbus_msg_t *msg, int64_t deadline_ms, call_t *call, attempt_t *att)
+{
+    memset(call, 0, sizeof(call_t));
+    call->serial = dbus_send(&nm->bus, msg);
+    if(call->serial < 0) return call->serial;
+    return run(nm, deadline_ms, call, att);
+}
+
+// Process the messages until the call is replied or, without a call, the attempt is over
+static int run(nm_client_t *nm, int64_t deadline_ms, call_t *call, attempt_t *att)
+{
+    while(1)
+    {
+        dbus_message_t msg;
+        int res = dbus_read(&nm->bus, &msg);
+        if(res < 0) return res;
+        if(res == 1)
+        {
+            handle_message(nm, &msg, call, att);
+            if(call ? call->replied : att->result != 1) return 0;
+            continue;
+        }
+
+        int64_t left = deadline_ms - now_ms();
+        if(left <= 0) return -ETIMEDOUT;
+
+        struct epoll_event ev;
+        int n = epoll_wait(nm->epfd, &ev, 1, (int)left);
+        if(n < 0 && errno != EINTR) return -errno;
+        // Left readable, the waits after this one are canceled too
+        if(n == 1 && ev.data.fd == nm->cancel_fd) return -ECANCELED;
+    }
+}
+
+static void handle_message(nm_client_t *nm, dbus_message_t *msg, call_t *call, attempt_t *att)
+{
+    if(msg->type == DBUS_SIGNAL)
+    {
+        if(att == NULL || !att->activating || msg->path == NULL || msg->member == NULL) return;
+        if(strcmp(msg->path, nm->device) != 0 || strcmp(msg->member, "StateChanged") != 0) return;
+        if(strcmp(msg->signature, "uuu") != 0) return;
+
+        uint32_t state = dbus_get_u32(&msg->body);
+        dbus_get_u32(&msg->body);
+        uint32_t reason = dbus_get_u32(&msg->body);
+        if(!msg->body.error) handle_state(state, reason, att);
+        return;
+    }
+
+    if(call == NULL || (int)msg->reply_serial != call->serial) return;
+    if(msg->type != DBUS_METHOD_RETURN && msg->type != DBUS_ERROR) return;
+    call->replied = true;
+
+    if(msg->type == DBUS_ERROR)
+    {
+        call->error = error_to_errno(msg->error_name);
+        const char *text = strcmp(msg->signature, "s") == 0 ? dbus_get_string(&msg->body) : "";
+        if(call->error != -ENOENT) printf("[wifi] NetworkManager: %s %s\n", msg->error_name, text);
+        return;
+    }
+
+    // The object paths of the reply
+    const char *sig = msg->signature;
+    while(*sig == 'o' && call->path_cnt < 2)
+    {
+        snprintf(call->paths[call->path_cnt++], PATH_MAX_LEN, "%s", dbus_get_string(&msg->body));
+        sig++;
+    }
+    if(msg->body.error) call->error = -EPROTO;
+}
+
+static void handle_state(uint32_t state, uint32_t reason, attempt_t *att)
+{
+    if(att->result != 1) return;
+
+    nm_event_t event;
+    switch(state)
+    {
+        case NM_DEVICE_STATE_PREPARE:
+            event = NM_EVENT_PREPARE;
+            break;
+        case NM_DEVICE_STATE_CONFIG:
+            event = NM_EVENT_ASSOCIATE;
+            break;
+        case NM_DEVICE_STATE_NEED_AUTH:
+            event = NM_EVENT_NEED_AUTH;
+            break;
+        case NM_DEVICE_STATE_IP_CONFIG:
+            event = NM_EVENT_IP_CONFIG;
+            break;
+        case NM_DEVICE_STATE_IP_CHECK:
+            event = NM_EVENT_IP_CHECK;
+            break;
+        case NM_DEVICE_STATE_ACTIVATED:
+            // Still the state of the earlier connection until the device was prepared again
+            if(!att->started) return;
+            event = NM_EVENT_CONNECTED;
+            att->result = 0;
+            break;
+        case NM_DEVICE_STATE_FAILED:
+            event = NM_EVENT_FAILED;
+            if(reason == NM_REASON_SSID_NOT_FOUND) att->result = -ENOENT;
+            else if(reason >= NM_REASON_NO_SECRETS && reason <= NM_REASON_SUPPLICANT_TIMEOUT) att->result = -EACCES;
+            else att->result = -EIO;
+            break;
+        default:
+            return;
+    }
+
+    att->started = true;
+    if(att->cb) att->cb(event, reason, att->user_data);
+}
+
+static int error_to_errno(const char *name)
+{
+    if(name == NULL) return -EIO;
+    if(strstr(name, "InvalidConnection") || strstr(name, "UnknownConnection")) return -ENOENT;
+    if(strstr(name, "InvalidProperty") || strstr(name, "InvalidArgs")) return -EINVAL;
+    if(strstr(name, "PermissionDenied") || strstr(name, "AccessDenied")) return -EPERM;
+    if(strstr(name, "ServiceUnknown")) return -ESRCH;
+    return -EIO;
+}
+
+// a{sa{sv}}: the settings of the profile, NetworkManager fills in the rest
+static void put_settings(dbus_msg_t *msg, const char *ssid, const char *pass, const char *uuid)
+{
+    uint32_t settings = dbus_array_begin(msg, 8);
+
+    uint32_t group = group_begin(msg, "connection");
+    put_setting(msg, "id", ssid);
+    put_setting(msg, "uuid", uuid);
+    put_setting(msg, "type", "802-11-wireless");
+    // Only wifi_reconnect() connects on its own, NetworkManager would race it and retry a rejected password
+    dbus_struct_begin(msg);
+    dbus_put_string(msg, "autoconnect");
+    dbus_put_variant_bool(msg, false);
+    dbus_array_end(msg, group, 8);
+
+    group = group_begin(msg, "802-11-wireless");
+    dbus_struct_begin(msg);
+    dbus_put_string(msg, "ssid");
+    dbus_put_variant_bytes(msg, ssid, strlen(ssid));
+    put_setting(msg, "mode", "infrastructure");
+    dbus_array_end(msg, group, 8);
+
+    if(pass[0] != '\0')
+    {
+        group = group_begin(msg, "802-11-wireless-security");
+        put_setting(msg, "key-mgmt", "wpa-psk");
+        put_setting(msg, "psk", pass);
+        dbus_array_end(msg, group, 8);
+    }
+
+    dbus_array_end(msg, settings, 8);
+}
+
+// {sa{sv}}: a setting group, finished with dbus_array_end()
+static uint32_t group_begin(dbus_msg_t *msg, const char *name)
+{
+    dbus_struct_begin(msg);
+    dbus_put_string(msg, name);
+    return dbus_array_begin(msg, 8);
+}
+
+static void put_setting(dbus_msg_t *msg, const char *key, const char *value)
+{
+    dbus_struct_begin(msg);
+    dbus_put_string(msg, key);
+    dbus_put_variant_string(msg, value);
+}
+
+// The same UUID for the same SSID: two FNV-1a hashes formatted as a version 5 UUID
+static void make_uuid(const char *ssid, char *uuid)
+{
+    uint64_t h[2] = {14695981039346656037ULL, 14695981039346656037ULL ^ 0x5A5A5A5AULL};
+    uint32_t i;
+    for(i = 0; i < 2; i++)
+    {
+        const char *p = "raspberrypi-lvgl-terminal:";
+        while(*p) h[i] = (h[i] ^ (uint8_t)*p++) * 1099511628211ULL;
+        p = ssid;
+        while(*p) h[i] = (h[i] ^ (uint8_t)*p++) * 1099511628211ULL;
+    }
+
+    snprintf(uuid, 40, "%08x-%04x-5%03x-%04x-%012llx", (unsigned)(h[0] >> 32), (unsigned)(h[0] >> 16) & 0xFFFF,
+             (unsigned)h[0] & 0xFFF, (unsigned)((h[1] >> 48) & 0x3FFF) | 0x8000,
+             (unsigned long long)(h[1] & 0xFFFFFFFFFFFFULL));
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,57 @@
+#ifndef NM_CLIENT_HH
+#define NM_CLIENT_HH
+
+#include "dbus.h"
+
+/*
+ * Connect to a WiFi network through NetworkManager's D-Bus API instead of `sudo nmcli`.
+ *
+ * The connection profile of a network has a UUID derived from the SSID, so connecting again
+ * updates the profile (e.g. with a new password) instead of adding another one. The profiles aren't
+ * autoconnected by NetworkManager: the application reconnects the known networks (see wifi_known.h)
+ * and deletes the profile of a forgotten network. The activation
+ * is followed by the StateChanged signals of the device, each state is reported to the callback
+ * until the device is activated or fails. A canceled or timed out attempt is deactivated.
+ */
+
+typedef enum
+{
+    NM_EVENT_PREPARE,       // The device is prepared for the connection
+    NM_EVENT_ASSOCIATE,     // Association and WPA handshake
+    NM_EVENT_NEED_AUTH,     // The password was rejected or is missing
+    NM_EVENT_IP_CONFIG,     // DHCP
+    NM_EVENT_IP_CHECK,      // Checking the connectivity
+    NM_EVENT_CONNECTED,
+    NM_EVENT_FAILED,        // `reason` is NetworkManager's NMDeviceStateReason
+} nm_event_t;
+
+typedef void (*nm_event_cb_t)(nm_event_t event, uint32_t reason, void *user_data);
+
+typedef struct
+{
+    dbus_conn_t bus;
+    int epfd;
+    int cancel_fd;          // eventfd of the owner, the attempts are canceled while it's readable. -1: none
+    char device[128];       // Object path of the WiFi device
+} nm_client_t;
+
+/*
+ * Connect to the system bus and find the device of the interface. 0 or -errno
+ * `cancel_fd` stops the connection attempts with -ECANCELED while it's readable, like the one of
+ * nl80211_open(). It's never read or closed here, its owner clears it when the next operation starts.
+ */
+int nm_open(nm_client_t *nm, const char *ifname, int cancel_fd);
+void nm_close(nm_client_t *nm);
+
+/*
+ * Connect to a network with WPA-PSK (without a password: an open network) and wait at most `timeout_ms`.
+ * 0: connected, -EACCES: wrong password, -ENOENT: the network isn't found, -EINVAL: the settings
+ * were refused (e.g. a too short password), -ECANCELED, -ETIMEDOUT, -EIO: failed for another reason
+ */
+int nm_connect(nm_client_t *nm, const char *ssid, const char *pass, uint32_t timeout_ms,
+               nm_event_cb_t cb, void *user_data);
+
+// Delete the profile of a network, e.g. its password was rejected. 0 (also if there's none) or -errno
+int nm_delete(nm_client_t *nm, const char *ssid, uint32_t timeout_ms);
+
+#endif // NM_CLIENT_HH
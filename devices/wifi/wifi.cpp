@@ -1,213 +1,596 @@
 #include "wifi.h"
 #include "ui/src/ui.h"
+#include "ui/src/ui_async.h"
+#include <stdarg.h>
 
 /* WiFi scanning */
-#include <iwlib.h>
-/* WiFi getting IP */
-#include <sys/ioctl.h>
-#include <net/if.h>
-#include <ifaddrs.h>
-#include <arpa/inet.h>
+#include "wifi_store.h"
+#include <errno.h>
+/* WiFi status */
+#include <pthread.h>
 /* WiFi connection */
-#include <sys/wait.h>
+#include "nm_client.h"
+#include "wifi_known.h"
+#include <time.h>
+#include <sys/eventfd.h>
+
+#define SCAN_TIMEOUT_MS             10000
+#define CONNECT_TIMEOUT_MS          45000
+#define DELETE_TIMEOUT_MS           2000
+#define RECONNECT_SCAN_TIMEOUT_MS   2000    // A directed scan of a single channel
+#define RECONNECT_DIRECTED_MAX      3       // Known networks looked for where they were last seen
+
+// Parts of the Set screen changed since view_apply() showed them
+#define VIEW_LABEL                  (1 << 0)
+#define VIEW_ROLLER                 (1 << 1)
+#define VIEW_SPINNER                (1 << 2)    // Hide the spinner of the connection
+
+// Known networks found by the scan of a reconnection
+typedef struct
+{
+    const wifi_known_t *nets;
+    uint32_t cnt;
+    uint32_t max_age_ms;    // Older results were cached before the scan
+    bool fresh;             // The results of the scan just finished are reported
+    int best;               // The strongest network found, -1: none
+    int32_t best_signal_mbm;
+} reconnect_scan_t;
+
+static void scan_flush_cb(void *user_data);
+static void scan_bss_cb(const wifi_bss_t *bss, void *user_data);
+static void roller_update(void);
+static int connect_network(const char* ssid, const char* pass);
+static void connect_event_cb(nm_event_t event, uint32_t reason, void *user_data);
+static int reconnect_network(const wifi_known_t *nets, uint32_t cnt);
+static void reconnect_begin_cb(wifi_scan_phase_t phase, void *user_data);
+static void reconnect_bss_cb(const wifi_bss_t *bss, void *user_data);
+static int status_render(void);
+static void view_set_label(const char *fmt, ...);
+static void view_set_roller(const char *options, bool has_networks);
+static void view_hide_spinner(void);
+static void view_queue(void);
+static void view_apply(void *user_data);
+static void roller_show(const char *options, bool has_networks);
+static int64_t now_ms(void);
+
+static int cancel_fd = -1;                  // Of the WiFi service, cancels the scans and the connections
+static nl80211_t nl = {-1, -1, -1, 0, 0, 0, 0, 0, 0, false, NULL};
+static bool nl_is_open = false;
+static bool roller_has_networks = false;   // The roller shows the networks, not a message
+static nm_client_t nm = {{-1, 0, NULL, 0, 0, 0, ""}, -1, -1, ""};
+static bool nm_is_open = false;
+
+// Reconnections run in the network monitor thread with their own sockets
+static pthread_mutex_t connect_mutex = PTHREAD_MUTEX_INITIALIZER;  // Held by a connection attempt
+static int reconnect_cancel_fd = -1;        // eventfd, set by the user's connection
+static pthread_mutex_t reconnect_cancel_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t connect_waiting = 0;        // User's connections waiting for connect_mutex, see wifi_reconnect()
+static nl80211_t reconnect_nl = {-1, -1, -1, 0, 0, 0, 0, 0, 0, false, NULL};
+static bool reconnect_nl_is_open = false;
+static nm_client_t reconnect_nm = {{-1, 0, NULL, 0, 0, 0, ""}, -1, -1, ""};
+static bool reconnect_nm_is_open = false;
+
+// Last state reported by the network monitor thread
+static pthread_mutex_t status_mutex = PTHREAD_MUTEX_INITIALIZER;
+static net_state_t status;
+static bool status_is_valid = false;
+static bool status_is_shown = false;       // The Set screen exists, see wifi_status_show()
+
+// What the Set screen shows. The WiFi and network threads change it, view_apply() shows it in the LVGL thread
+static pthread_mutex_t view_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char view_label[256];
+static char *view_roller = NULL;            // Options of the roller
+static uint32_t view_roller_size = 0;
+static bool view_roller_has_networks = false;
+static uint32_t view_changes = 0;           // VIEW_LABEL | VIEW_ROLLER | VIEW_SPINNER
+static bool view_is_queued = false;         // view_apply() waits in the UI queue
+static bool roller_shows_networks = false;  // Only used in the LVGL thread
+
+// Set the eventfd of the WiFi service and create the one of the reconnections, they stay open. 0 or -errno
+int wifi_init(int service_cancel_fd)
+{
+    cancel_fd = service_cancel_fd;
+    reconnect_cancel_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return reconnect_cancel_fd < 0 ? -errno : 0;
+}
 
 // Scan nearby WiFi networks
 int wifi_scan(void)
 {
-    int sock = iw_sockets_open();  // Create wireless communication socket
-    if(sock < 0) 
+    if(!nl_is_open)
     {
-        lv_label_set_text(ui_IPAddrLabel, "无法打开无线socket");
-        lv_roller_set_options(ui_WiFiScanRoller, "无法打开无线socket", LV_ROLLER_MODE_NORMAL);
-        return -1;
+        int res = nl80211_open(&nl, "wlan0", cancel_fd);
+        if(res < 0)
+        {
+            printf("[wifi] nl80211: %s\n", strerror(-res));
+            view_set_label("无法打开无线socket");
+            view_set_roller("无法打开无线socket", false);
+            roller_has_networks = false;
+            return -1;
+        }
+        nl_is_open = true;
     }
 
     /****** Scan nearby WiFi ******/
-    lv_label_set_text(ui_IPAddrLabel, "正在检查当前连接...");
-    lv_roller_set_options(ui_WiFiScanRoller, "正在扫描附近WiFi...", LV_ROLLER_MODE_NORMAL);
+    // Rank the known and the connected networks before the others
+    wifi_known_t known[WIFI_KNOWN_MAX];
+    uint32_t known_cnt = wifi_known_get(known, WIFI_KNOWN_MAX);
+    uint32_t i;
+    for(i = 0; i < known_cnt; i++) wifi_store_set_known(known[i].ssid);
 
-    char buffer[4096] = {0};         // Buffer to store WiFi list
-    wireless_scan_head scan_results; // Scan results linked list head
+    pthread_mutex_lock(&status_mutex);
+    char ssid[sizeof(status.ssid)];
+    memcpy(ssid, status.ssid, sizeof(ssid));
+    pthread_mutex_unlock(&status_mutex);
+    wifi_store_set_known(ssid);
 
-    // Execute WiFi scan
-    if(iw_scan(sock, (char *)"wlan0", 30, &scan_results) < 0) 
+    // The networks found earlier are shown while the new scan runs
+    wifi_IP();
+    if(wifi_store_get_options() != NULL)
     {
-        close(sock);
-        lv_label_set_text(ui_IPAddrLabel, "无法连接...");
-        lv_roller_set_options(ui_WiFiScanRoller, "WiFi扫描失败", LV_ROLLER_MODE_NORMAL);
-        return -1;
+        roller_update();
+    }
+    else
+    {
+        view_set_roller("正在扫描附近WiFi...", false);
+        roller_has_networks = false;
     }
 
-    int is_first = 1;  // Flag to mark if it's the first SSID
-    wireless_scan *ap = scan_results.result;
-    
-    // Iterate through scan results
-    while(ap != NULL) 
-    {
-        char ssid[IW_ESSID_MAX_SIZE + 1] = {0};
-        uint32_t ssid_len = strlen(ap->b.essid);
-        
-        // printf("[DEBUG] ESSID: '%s' (len=%d)\n", ap->b.essid, ssid_len);
-
-        if(ssid_len > 0) 
-        {  
-            strncpy(ssid, (const char*)ap->b.essid, ssid_len);
-            ssid[ssid_len] = '\0';
-            
-            // Additional check for empty ESSID
-            if(ssid[0] == '\0')strcpy(ssid, "隐藏网络");
-        } 
-        else strcpy(ssid, "隐藏网络");
-             
-        // Concatenate SSID to buffer
-        if(strlen(buffer) + strlen(ssid) + 2 <= sizeof(buffer))
+    // The results are merged into the store and the roller is updated as they arrive
+    nl80211_scan_cb_t cb = {NULL, scan_bss_cb, scan_flush_cb, NULL};
+    int res = nl80211_scan(&nl, SCAN_TIMEOUT_MS, &cb);
+    if(res < 0)
+    {
+        printf("[wifi] scan: %s\n", strerror(-res));
+
+        // Open the socket again next time, e.g. the interface might have been recreated
+        if(res != -ETIMEDOUT && res != -ECANCELED)
         {
-            if(!is_first)strcat(buffer, "\n");    
-            strcat(buffer, ssid);
-            is_first = 0;
+            nl80211_close(&nl);
+            nl_is_open = false;
         }
-        
-        ap = ap->next;  // Next access point
     }
+    else
+    {
+        wifi_store_expire();
+        roller_update();
+    }
+
+    if(res < 0 && !roller_has_networks)
+    {
+        view_set_label("无法连接...");
+        view_set_roller("WiFi扫描失败", false);
+        return -1;
+    }
+    if(!roller_has_networks) view_set_roller("未发现WiFi", false);
 
-    // Update UI controls
-    lv_roller_set_options(ui_WiFiScanRoller, buffer, LV_ROLLER_MODE_NORMAL);
     if(wifi_IP() == 0)return 0;
     else return -1;
 }
 
+static void scan_bss_cb(const wifi_bss_t *bss, void *user_data)
+{
+    wifi_store_update(bss);
+}
+
+static void scan_flush_cb(void *user_data)
+{
+    roller_update();
+}
+
+// Show the ranked networks of the store
+static void roller_update(void)
+{
+    const char *options = wifi_store_get_options();
+    if(options == NULL) return;
+
+    view_set_roller(options, true);
+    roller_has_networks = true;
+}
+
+// Called by the network monitor thread with each change
+void wifi_status_update(const net_state_t *state)
+{
+    pthread_mutex_lock(&status_mutex);
+    status = *state;
+    status_is_valid = true;
+    status_render();
+    pthread_mutex_unlock(&status_mutex);
+
+    // Follow the AP of a known network, e.g. after roaming, so the next reconnection looks for it there
+    if(state->carrier && state->ssid[0] != '\0') wifi_known_seen(state->ssid, state->bssid, state->freq_mhz);
+}
+
+// The Set screen is shown, the changes of the status are shown on it
+void wifi_status_show(bool shown)
+{
+    pthread_mutex_lock(&status_mutex);
+    status_is_shown = shown;
+    pthread_mutex_unlock(&status_mutex);
+}
+
+// Show the connection and the IP address, 0: connected with an address
 int wifi_IP(void)
 {
-    int sock = iw_sockets_open();
-    if(sock < 0) 
+    pthread_mutex_lock(&status_mutex);
+    int res = status_render();
+    pthread_mutex_unlock(&status_mutex);
+    return res;
+}
+
+// Call with status_mutex locked, the label is updated in the LVGL thread. 0: connected with an address
+static int status_render(void)
+{
+    bool connected = status.carrier && status.ssid[0] != '\0';
+    bool has_addr = status.ipv4[0] != '\0' || status.ipv6[0] != '\0';
+    int res = status_is_valid && connected && has_addr ? 0 : -1;
+    if(!status_is_shown) return res;
+
+    if(!status_is_valid)
     {
-        lv_label_set_text(ui_IPAddrLabel, "无法打开无线socket");
-        return -1;
+        view_set_label("正在检查当前连接...");
+        return res;
+    }
+    if(!status.exists)
+    {
+        view_set_label("未找到无线网卡");
+        return res;
+    }
+    if(!connected)
+    {
+        view_set_label("无连接...");
+        return res;
+    }
+    if(!has_addr)
+    {
+        view_set_label("没有找到IPv4地址...");
+        return res;
     }
 
-    /****** Get current IP address ******/
-    struct wireless_config config;
+    char signal[16] = "";
+    if(status.signal_dbm != 0) snprintf(signal, sizeof(signal), "(%ddBm)", (int)status.signal_dbm);
 
-    if(iw_get_basic_config(sock, (const char *)"wlan0", &config) < 0) 
+    if(status.ipv4[0] != '\0' && status.ipv6[0] != '\0')
     {
-        lv_label_set_text(ui_IPAddrLabel, "无连接...");
-        close(sock);
-        return -1;
+        view_set_label("Connected:%s%s IP:%s IPv6:%s", status.ssid, signal, status.ipv4, status.ipv6);
     }
+    else if(status.ipv4[0] != '\0')
+    {
+        view_set_label("Connected:%s%s IP:%s", status.ssid, signal, status.ipv4);
+    }
+    else
+    {
+        view_set_label("Connected:%s%s IPv6:%s", status.ssid, signal, status.ipv6);
+    }
+    return res;
+}
 
-    close(sock);
+// Show a message or the status below the roller, from any thread
+static void view_set_label(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    pthread_mutex_lock(&view_mutex);
+    vsnprintf(view_label, sizeof(view_label), fmt, args);
+    view_changes |= VIEW_LABEL;
+    view_queue();
+    pthread_mutex_unlock(&view_mutex);
+    va_end(args);
+}
 
-    // Check if SSID is valid
-    if(config.essid[0] == '\0')
+// Show the networks (`has_networks`) or a message in the roller, from any thread
+static void view_set_roller(const char *options, bool has_networks)
+{
+    uint32_t size = strlen(options) + 1;
+    pthread_mutex_lock(&view_mutex);
+    if(size > view_roller_size)
     {
-        lv_label_set_text(ui_IPAddrLabel, "无法获取IP地址...");
-        return -1;
+        char *new_roller = (char *)realloc(view_roller, size);
+        if(new_roller == NULL)
+        {
+            pthread_mutex_unlock(&view_mutex);
+            return;
+        }
+        view_roller = new_roller;
+        view_roller_size = size;
+    }
+    memcpy(view_roller, options, size);
+    view_roller_has_networks = has_networks;
+    view_changes |= VIEW_ROLLER;
+    view_queue();
+    pthread_mutex_unlock(&view_mutex);
+}
+
+static void view_hide_spinner(void)
+{
+    pthread_mutex_lock(&view_mutex);
+    view_changes |= VIEW_SPINNER;
+    view_queue();
+    pthread_mutex_unlock(&view_mutex);
+}
+
+// Call with view_mutex locked. The changes made before view_apply() runs are shown together
+static void view_queue(void)
+{
+    if(view_is_queued) return;
+    view_is_queued = ui_async_call(view_apply, NULL) == LV_RES_OK;
+}
+
+// Runs in the LVGL thread. The changes are dropped while the Set screen is deleted, the next start of
+// the WiFi service scans and shows the status again
+static void view_apply(void *user_data)
+{
+    pthread_mutex_lock(&view_mutex);
+    uint32_t changes = view_changes;
+    view_changes = 0;
+    view_is_queued = false;
+    if(ui_Set == NULL)
+    {
+        roller_shows_networks = false;
     }
-    
-    // Get IP address
-    struct ifaddrs *ifaddr, *ifa;
-    char ipstr[INET_ADDRSTRLEN];
+    else
+    {
+        if(changes & VIEW_LABEL) lv_label_set_text(ui_IPAddrLabel, view_label);
+        if(changes & VIEW_ROLLER) roller_show(view_roller, view_roller_has_networks);
+        if(changes & VIEW_SPINNER) _ui_flag_modify(ui_WiFiConnectWaitSpinner, LV_OBJ_FLAG_HIDDEN, _UI_MODIFY_FLAG_ADD);
+    }
+    pthread_mutex_unlock(&view_mutex);
+}
+
+// Runs in the LVGL thread, the selected network stays selected if it moved
+static void roller_show(const char *options, bool has_networks)
+{
+    char selected[64] = "";
+    if(roller_shows_networks && has_networks) lv_roller_get_selected_str(ui_WiFiScanRoller, selected, sizeof(selected));
+
+    lv_roller_set_options(ui_WiFiScanRoller, options, LV_ROLLER_MODE_NORMAL);
+    roller_shows_networks = has_networks;
+    if(selected[0] == '\0') return;
 
-    if(getifaddrs(&ifaddr) == -1) 
+    uint32_t len = strlen(selected);
+    uint16_t row = 0;
+    const char *p = options;
+    while(1)
     {
-        lv_label_set_text(ui_IPAddrLabel, "无法获取IP地址...");
-        return -1;
+        if(strncmp(p, selected, len) == 0 && (p[len] == '\n' || p[len] == '\0'))
+        {
+            lv_roller_set_selected(ui_WiFiScanRoller, row, LV_ANIM_OFF);
+            break;
+        }
+        p = strchr(p, '\n');
+        if(p == NULL) break;
+        p++;
+        row++;
     }
+}
+
+int wifi_connect(const char* ssid, const char* pass)
+{
+    // Nothing was chosen yet, e.g. the first scan found no connection
+    if(ssid[0] == '\0') return -1;
 
-    for(ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) 
+    // The network chosen by the user replaces a reconnection in progress
+    pthread_mutex_lock(&reconnect_cancel_mutex);
+    connect_waiting++;
+    uint64_t one = 1;
+    if(write(reconnect_cancel_fd, &one, sizeof(one)) < 0) printf("[wifi] can't cancel the reconnection\n");
+    pthread_mutex_unlock(&reconnect_cancel_mutex);
+    pthread_mutex_lock(&connect_mutex);
+    pthread_mutex_lock(&reconnect_cancel_mutex);
+    connect_waiting--;
+    pthread_mutex_unlock(&reconnect_cancel_mutex);
+    int res = connect_network(ssid, pass);
+    pthread_mutex_unlock(&connect_mutex);
+    return res;
+}
+
+// Call with connect_mutex locked
+static int connect_network(const char* ssid, const char* pass)
+{
+    if(!nm_is_open)
     {
-        if(ifa->ifa_addr == NULL || strcmp(ifa->ifa_name, (const char *)"wlan0") != 0) continue;
-        
-        if(ifa->ifa_addr->sa_family == AF_INET) 
-        {   
-            // IPv4
-            struct sockaddr_in *addr = (struct sockaddr_in *)ifa->ifa_addr;
-            inet_ntop(AF_INET, &addr->sin_addr, ipstr, sizeof(ipstr));
-            // printf("WiFi Name: %s, IP Address: %s\n", config.essid, ipstr);
-            lv_label_set_text_fmt(ui_IPAddrLabel, "Connected:%s IP:%s", config.essid, ipstr);
-            freeifaddrs(ifaddr);
-            return 0;
+        int res = nm_open(&nm, "wlan0", cancel_fd);
+        if(res < 0)
+        {
+            // Canceled while looking up the device: the Set screen was left, nothing to report
+            if(res != -ECANCELED)
+            {
+                printf("[wifi] NetworkManager: %s\n", strerror(-res));
+                view_set_label("无法连接NetworkManager");
+            }
+            view_hide_spinner();
+            return -1;
         }
+        nm_is_open = true;
+    }
+
+    // The progress is shown as NetworkManager reports it
+    int res = nm_connect(&nm, ssid, pass, CONNECT_TIMEOUT_MS, connect_event_cb, NULL);
+    view_hide_spinner();
+    if(res == 0)
+    {
+        // The AP reported by the network monitor before the network became known
+        wifi_known_remember(ssid, pass);
+        pthread_mutex_lock(&status_mutex);
+        net_state_t state = status;
+        pthread_mutex_unlock(&status_mutex);
+        if(strcmp(state.ssid, ssid) == 0) wifi_known_seen(ssid, state.bssid, state.freq_mhz);
+
+        // The progress messages covered the status pushed by the network monitor
+        wifi_store_set_known(ssid);
+        wifi_IP();
+        return 0;
+    }
+
+    printf("[wifi] connect: %s\n", strerror(-res));
+    // The profile has the rejected password now, the known network keeps the one that worked
+    if(res == -EACCES && nm_delete(&nm, ssid, DELETE_TIMEOUT_MS) < 0) printf("[wifi] can't delete the profile of %s\n", ssid);
+    if(res == -EACCES) view_set_label("密码错误");
+    else if(res == -ENOENT) view_set_label("未找到该WiFi");
+    else if(res == -EINVAL) view_set_label("密码格式错误");
+    else if(res == -ETIMEDOUT) view_set_label("连接超时");
+    else view_set_label("连接失败");
+
+    // Open the bus again next time, e.g. NetworkManager might have been restarted
+    if(res != -EACCES && res != -ENOENT && res != -EINVAL && res != -ETIMEDOUT && res != -ECANCELED)
+    {
+        nm_close(&nm);
+        nm_is_open = false;
     }
+    return -1;
+}
 
-    freeifaddrs(ifaddr);
-    lv_label_set_text(ui_IPAddrLabel, "没有找到IPv4地址...");
-    return -1; 
+static void connect_event_cb(nm_event_t event, uint32_t reason, void *user_data)
+{
+    switch(event)
+    {
+        case NM_EVENT_PREPARE:
+            view_set_label("正在准备连接...");
+            break;
+        case NM_EVENT_ASSOCIATE:
+            view_set_label("正在关联并验证密码...");
+            break;
+        case NM_EVENT_NEED_AUTH:
+            view_set_label("密码错误...");
+            break;
+        case NM_EVENT_IP_CONFIG:
+            view_set_label("正在获取IP地址(DHCP)...");
+            break;
+        case NM_EVENT_IP_CHECK:
+            view_set_label("正在检查网络...");
+            break;
+        case NM_EVENT_FAILED:
+            printf("[wifi] connection failed, reason %u\n", reason);
+            break;
+        default:
+            break;
+    }
 }
 
-int wifi_connect(const char* ssid, const char* pass)
+// Connect to a known network after booting or losing the connection, called by the network monitor thread
+int wifi_reconnect(void)
 {
-    // Escape special characters in SSID and password
-    char safe_ssid[256], safe_pass[256];
-    escape_shell_chars(ssid, safe_ssid, sizeof(safe_ssid));
-    escape_shell_chars(pass, safe_pass, sizeof(safe_pass));
+    wifi_known_t nets[WIFI_KNOWN_MAX];
+    uint32_t cnt = wifi_known_get(nets, WIFI_KNOWN_MAX);
+    if(cnt == 0) return -ENOENT;
 
-    // printf("%s,%s\r\n",safe_ssid,safe_pass);
+    // The user is connecting to a network
+    if(pthread_mutex_trylock(&connect_mutex) != 0) return -EBUSY;
 
-    // Build nmcli command
-    char cmd[512];
-    snprintf(cmd, sizeof(cmd), 
-        "sudo nmcli --terse dev wifi connect %s password %s 2>&1",
-        safe_ssid, safe_pass);
+    // The user's connection may be about to take connect_mutex, its cancellation is kept for it
+    pthread_mutex_lock(&reconnect_cancel_mutex);
+    if(connect_waiting > 0)
+    {
+        pthread_mutex_unlock(&reconnect_cancel_mutex);
+        pthread_mutex_unlock(&connect_mutex);
+        return -EBUSY;
+    }
+    uint64_t val;
+    if(read(reconnect_cancel_fd, &val, sizeof(val)) < 0 && errno != EAGAIN) printf("[wifi] reconnect_cancel_fd: %s\n", strerror(errno));
+    pthread_mutex_unlock(&reconnect_cancel_mutex);
+    int res = reconnect_network(nets, cnt);
+    pthread_mutex_unlock(&connect_mutex);
+    return res;
+}
 
-    // Execute command and capture output
-    FILE *fp = popen(cmd, "r");
-    if(!fp) 
+// Call with connect_mutex locked
+static int reconnect_network(const wifi_known_t *nets, uint32_t cnt)
+{
+    int64_t start = now_ms();
+    if(!reconnect_nl_is_open)
     {
-        lv_label_set_text(ui_IPAddrLabel, "连接失败");
-        _ui_flag_modify(ui_WiFiConnectWaitSpinner, LV_OBJ_FLAG_HIDDEN, _UI_MODIFY_FLAG_ADD);
-        return -1;
+        int res = nl80211_open(&reconnect_nl, "wlan0", reconnect_cancel_fd);
+        if(res < 0) return res;
+        reconnect_nl_is_open = true;
+    }
+    if(!reconnect_nm_is_open)
+    {
+        int res = nm_open(&reconnect_nm, "wlan0", reconnect_cancel_fd);
+        if(res < 0) return res;
+        reconnect_nm_is_open = true;
     }
 
-    // Read command output
-    char output[512] = {0};
-    char line[128];
-    while(fgets(line, sizeof(line), fp)) 
+    // A directed scan on the channel where a network was last seen finds it in tens of milliseconds
+    reconnect_scan_t found = {nets, cnt, RECONNECT_SCAN_TIMEOUT_MS, false, -1, 0};
+    nl80211_scan_cb_t cb = {reconnect_begin_cb, reconnect_bss_cb, NULL, &found};
+    const char *how = "directed";
+    int res = 0;
+    uint32_t i;
+    for(i = 0; i < cnt && i < RECONNECT_DIRECTED_MAX && found.best < 0 && res != -ECANCELED; i++)
     {
-        strncat(output, line, sizeof(output)-1);
+        if(nets[i].freq_mhz == 0) continue;
+
+        wifi_scan_target_t target;
+        memcpy(target.ssid, nets[i].ssid, sizeof(target.ssid));
+        memcpy(target.bssid, nets[i].bssid, sizeof(target.bssid));
+        target.freq_mhz = nets[i].freq_mhz;
+        res = nl80211_scan_directed(&reconnect_nl, &target, RECONNECT_SCAN_TIMEOUT_MS, &cb);
     }
-    _ui_flag_modify(ui_WiFiConnectWaitSpinner, LV_OBJ_FLAG_HIDDEN, _UI_MODIFY_FLAG_ADD);
 
-    // Get execution status
-    int status = pclose(fp);
-    int exit_code = WEXITSTATUS(status);
+    // The networks moved to another channel or were never connected by this device
+    if(found.best < 0 && res != -ECANCELED)
+    {
+        how = "full";
+        found.max_age_ms = SCAN_TIMEOUT_MS;
+        res = nl80211_scan(&reconnect_nl, SCAN_TIMEOUT_MS, &cb);
+    }
+    if(res < 0 && res != -ETIMEDOUT && res != -ECANCELED)
+    {
+        nl80211_close(&reconnect_nl);
+        reconnect_nl_is_open = false;
+    }
+    if(res == -ECANCELED) return res;
+    if(found.best < 0) return res < 0 ? res : -ENOENT;
 
-    // Result processing
-    if(exit_code == 0) 
+    const wifi_known_t *net = &nets[found.best];
+    res = nm_connect(&reconnect_nm, net->ssid, net->psk, CONNECT_TIMEOUT_MS, NULL, NULL);
+    if(res == 0)
     {
-        wifi_IP(); // 更新IP显示
+        printf("[wifi] reconnected to %s in %lld ms (%s scan)\n", net->ssid, (long long)(now_ms() - start), how);
+        wifi_known_remember(net->ssid, net->psk);
         return 0;
     }
-    else 
+
+    printf("[wifi] reconnect to %s: %s\n", net->ssid, strerror(-res));
+    if(res == -EACCES)
     {
-        lv_label_set_text(ui_IPAddrLabel, "连接失败");
-        return -1;
+        wifi_known_forget(net->ssid);
+        if(nm_delete(&reconnect_nm, net->ssid, DELETE_TIMEOUT_MS) < 0) printf("[wifi] can't delete the profile of %s\n", net->ssid);
     }
+    if(res != -EACCES && res != -ENOENT && res != -EINVAL && res != -ETIMEDOUT && res != -ECANCELED)
+    {
+        nm_close(&reconnect_nm);
+        reconnect_nm_is_open = false;
+    }
+    return res;
 }
 
-// Helper function: escape special characters
-void escape_shell_chars(const char *input, char *output, uint16_t out_size) 
+static void reconnect_begin_cb(wifi_scan_phase_t phase, void *user_data)
 {
-    uint16_t j = 0;
-    output[j++] = '\''; // Start single quote
-    for(uint16_t i = 0; input[i] != '\0' && j < out_size-2; ++i) 
+    reconnect_scan_t *found = (reconnect_scan_t *)user_data;
+    found->fresh = phase == WIFI_SCAN_FRESH;
+}
+
+static void reconnect_bss_cb(const wifi_bss_t *bss, void *user_data)
+{
+    reconnect_scan_t *found = (reconnect_scan_t *)user_data;
+    if(!found->fresh || bss->age_ms > found->max_age_ms || bss->ssid[0] == '\0') return;
+
+    uint32_t i;
+    for(i = 0; i < found->cnt; i++)
     {
-        if(input[i] == '\'') 
-        {
-            // Single quote escaped as '\'''
-            if(j + 4 < out_size) 
-            {
-                output[j++] = '\''; // End current quote
-                output[j++] = '\\'; // Backslash
-                output[j++] = '\''; // New quote
-                output[j++] = '\''; // Restart quote
-            }
-        } 
-        else 
+        if(strcmp(bss->ssid, found->nets[i].ssid) != 0) continue;
+        if(found->best < 0 || bss->signal_mbm > found->best_signal_mbm)
         {
-            output[j++] = input[i];
+            found->best = i;
+            found->best_signal_mbm = bss->signal_mbm;
         }
     }
-    output[j++] = '\''; // End single quote
-    output[j] = '\0';
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
@@ -7,10 +7,14 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdint.h>
+#include "net_monitor.h"
 
+int wifi_init(int cancel_fd);
 int wifi_scan(void);
 int wifi_IP(void);
+void wifi_status_update(const net_state_t *state);
+void wifi_status_show(bool shown);
 int wifi_connect(const char* ssid, const char* pass);
-void escape_shell_chars(const char *input, char *output, uint16_t out_size);
+int wifi_reconnect(void);
 
 #endif // WIFI_HH
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include "wifi_known.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define FILE_HEADER     "# Known WiFi networks: SSID (hex), password (hex), BSSID, channel [MHz], last used\n"
+#define LINE_MAX_LEN    320
+
+static void load(void);
+static int save(void);
+static int open_private(const char *path);
+static const char *get_path(void);
+static wifi_known_t *find(const char *ssid);
+static int compare_by_use(const void *a, const void *b);
+static void hex_encode(const char *str, char *hex);
+static bool hex_decode(const char *hex, char *str, uint32_t size);
+
+static pthread_mutex_t known_mutex = PTHREAD_MUTEX_INITIALIZER;
+static wifi_known_t nets[WIFI_KNOWN_MAX];   // The last used first
+static uint32_t net_cnt;
+static bool is_loaded = false;
+
+void wifi_known_remember(const char *ssid, const char *psk)
+{
+    if(ssid[0] == '\0' || strlen(ssid) >= sizeof(nets[0].ssid) || strlen(psk) >= sizeof(nets[0].psk)) return;
+
+    pthread_mutex_lock(&known_mutex);
+    load();
+    wifi_known_t *net = find(ssid);
+    if(net == NULL)
+    {
+        // The store is full: replace the network used the longest time ago
+        net = net_cnt < WIFI_KNOWN_MAX ? &nets[net_cnt++] : &nets[WIFI_KNOWN_MAX - 1];
+        memset(net, 0, sizeof(wifi_known_t));
+        strcpy(net->ssid, ssid);
+    }
+    strcpy(net->psk, psk);
+    net->last_used = time(NULL);
+    qsort(nets, net_cnt, sizeof(wifi_known_t), compare_by_use);
+
+    int res = save();
+    if(res < 0) printf("[wifi] can't save the known networks: %s\n", strerror(-res));
+    pthread_mutex_unlock(&known_mutex);
+}
+
+void wifi_known_seen(const char *ssid, const uint8_t *bssid, uint32_t freq_mhz)
+{
+    pthread_mutex_lock(&known_mutex);
+    load();
+    wifi_known_t *net = find(ssid);
+    if(net && freq_mhz != 0 && (memcmp(net->bssid, bssid, 6) != 0 || net->freq_mhz != freq_mhz))
+    {
+        memcpy(net->bssid, bssid, 6);
+        net->freq_mhz = freq_mhz;
+        net->last_used = time(NULL);
+        qsort(nets, net_cnt, sizeof(wifi_known_t), compare_by_use);
+
+        int res = save();
+        if(res < 0) printf("[wifi] can't save the known networks: %s\n", strerror(-res));
+    }
+    pthread_mutex_unlock(&known_mutex);
+}
+
+void wifi_known_forget(const char *ssid)
+{
+    pthread_mutex_lock(&known_mutex);
+    load();
+    wifi_known_t *net = find(ssid);
+    if(net)
+    {
+        memmove(net, net + 1, (&nets[net_cnt] - (net + 1)) * sizeof(wifi_known_t));
+        net_cnt--;
+
+        int res = save();
+        if(res < 0) printf("[wifi] can't save the known networks: %s\n", strerror(-res));
+    }
+    pthread_mutex_unlock(&known_mutex);
+}
+
+uint32_t wifi_known_get(wifi_known_t *out, uint32_t max)
+{
+    pthread_mutex_lock(&known_mutex);
+    load();
+    uint32_t cnt = net_cnt < max ? net_cnt : max;
+    memcpy(out, nets, cnt * sizeof(wifi_known_t));
+    pthread_mutex_unlock(&known_mutex);
+    return cnt;
+}
+
+// Read the file once, call with known_mutex locked
+static void load(void)
+{
+    if(is_loaded) return;
+    is_loaded = true;
+
+    const char *path = get_path();
+    int fd = open(path, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if(fd < 0)
+    {
+        if(errno != ENOENT) printf("[wifi] %s: %s\n", path, strerror(errno));
+        return;
+    }
+
+    // A file planted by another user could steer the connections, one readable by others leaks the passwords
+    struct stat st;
+    if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid())
+    {
+        printf("[wifi] %s isn't a file of this user, ignored\n", path);
+        close(fd);
+        return;
+    }
+    if((st.st_mode & 077) && fchmod(fd, 0600) == 0) printf("[wifi] %s was readable by others, made private\n", path);
+
+    FILE *f = fdopen(fd, "r");
+    if(f == NULL)
+    {
+        close(fd);
+        return;
+    }
+
+    char line[LINE_MAX_LEN];
+    while(net_cnt < WIFI_KNOWN_MAX && fgets(line, sizeof(line), f))
+    {
+        if(line[0] == '#') continue;
+
+        char ssid_hex[2 * 32 + 1];
+        char psk_hex[2 * 64 + 1];
+        unsigned int b[6];
+        unsigned int freq;
+        long long last_used;
+        if(sscanf(line, "%64s %128s %x:%x:%x:%x:%x:%x %u %lld", ssid_hex, psk_hex,
+                  &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &freq, &last_used) != 10)
+        {
+            continue;
+        }
+
+        wifi_known_t *net = &nets[net_cnt];
+        memset(net, 0, sizeof(wifi_known_t));
+        if(!hex_decode(ssid_hex, net->ssid, sizeof(net->ssid)) || net->ssid[0] == '\0') continue;
+        if(strcmp(psk_hex, "-") != 0 && !hex_decode(psk_hex, net->psk, sizeof(net->psk))) continue;
+        uint32_t i;
+        for(i = 0; i < 6; i++) net->bssid[i] = b[i];
+        net->freq_mhz = freq;
+        net->last_used = last_used;
+        net_cnt++;
+    }
+    fclose(f);
+    qsort(nets, net_cnt, sizeof(wifi_known_t), compare_by_use);
+}
+
+// Write a temporary file and rename it over the old one, so a power cut leaves either of them. 0 or -errno
+static int save(void)
+{
+    const char *path = get_path();
+    char tmp_path[PATH_MAX];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    int fd = open_private(tmp_path);
+    if(fd < 0) return fd;
+    FILE *f = fdopen(fd, "w");
+    if(f == NULL)
+    {
+        int res = -errno;
+        close(fd);
+        unlink(tmp_path);
+        return res;
+    }
+
+    fputs(FILE_HEADER, f);
+    uint32_t i;
+    for(i = 0; i < net_cnt; i++)
+    {
+        const wifi_known_t *net = &nets[i];
+        char ssid_hex[2 * 32 + 1];
+        char psk_hex[2 * 64 + 1];
+        hex_encode(net->ssid, ssid_hex);
+        if(net->psk[0] != '\0') hex_encode(net->psk, psk_hex);
+        else strcpy(psk_hex, "-");
+        fprintf(f, "%s %s %02x:%02x:%02x:%02x:%02x:%02x %u %lld\n", ssid_hex, psk_hex,
+                net->bssid[0], net->bssid[1], net->bssid[2], net->bssid[3], net->bssid[4], net->bssid[5],
+                (unsigned int)net->freq_mhz, (long long)net->last_used);
+    }
+
+    int res = 0;
+    if(fflush(f) != 0 || fsync(fd) != 0) res = -errno;
+    if(fclose(f) != 0 && res == 0) res = -errno;
+    if(res == 0 && rename(tmp_path, path) < 0) res = -errno;
+    if(res < 0) unlink(tmp_path);
+    return res;
+}
+
+// Create a file only the owner can read, with its directory if it's missing. The fd or -errno
+static int open_private(const char *path)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600);
+    if(fd < 0 && errno == ENOENT)
+    {
+        char dir[PATH_MAX];
+        snprintf(dir, sizeof(dir), "%s", path);
+        char *slash = strrchr(dir, '/');
+        if(slash && slash != dir)
+        {
+            *slash = '\0';
+            mkdir(dir, 0700);
+        }
+        fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600);
+    }
+    if(fd < 0) return -errno;
+
+    // An existing file keeps its mode and the new one is masked by the umask
+    if(fchmod(fd, 0600) < 0)
+    {
+        int res = -errno;
+        close(fd);
+        return res;
+    }
+    return fd;
+}
+
+static const char *get_path(void)
+{
+    const char *path = getenv("WIFI_KNOWN_FILE");
+    return path && path[0] ? path : WIFI_KNOWN_PATH;
+}
+
+static wifi_known_t *find(const char *ssid)
+{
+    uint32_t i;
+    for(i = 0; i < net_cnt; i++)
+    {
+        if(strcmp(nets[i].ssid, ssid) == 0) return &nets[i];
+    }
+    return NULL;
+}
+
+static int compare_by_use(const void *a, const void *b)
+{
+    int64_t used_a = ((const wifi_known_t *)a)->last_used;
+    int64_t used_b = ((const wifi_known_t *)b)->last_used;
+    return used_a < used_b ? 1 : used_a > used_b ? -1 : 0;
+}
+
+// The SSIDs and passwords may have any bytes, also spaces
+static void hex_encode(const char *str, char *hex)
+{
+    static const char digits[] = "0123456789abcdef";
+    for(; *str; str++)
+    {
+        *hex++ = digits[(uint8_t)*str >> 4];
+        *hex++ = digits[(uint8_t)*str & 0x0F];
+    }
+    *hex = '\0';
+}
+
+static bool hex_decode(const char *hex, char *str, uint32_t size)
+{
+    uint32_t len = strlen(hex);
+    if(len % 2 || len / 2 >= size) return false;
+
+    uint32_t i;
+    for(i = 0; i < len / 2; i++)
+    {
+        unsigned int byte;
+        if(sscanf(hex + 2 * i, "%2x", &byte) != 1) return false;
+        str[i] = byte;
+    }
+    str[len / 2] = '\0';
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef WIFI_KNOWN_HH
+#define WIFI_KNOWN_HH
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Networks connected earlier, kept in a file so they can be connected again after a reboot
+ * without a full scan: the AP and the channel of the last connection are remembered with the
+ * password, a directed scan on that channel finds the network in a few tens of milliseconds.
+ * This store owns the passwords: NetworkManager gets one with each connection and doesn't
+ * autoconnect its profiles (see nm_client.h).
+ *
+ * The file has the passwords, it's only readable by its owner (0600) and written atomically
+ * (a temporary file renamed over it). WIFI_KNOWN_FILE overrides the path.
+ * The functions lock the store, they can be called from any thread.
+ */
+
+#define WIFI_KNOWN_MAX      16
+#define WIFI_KNOWN_PATH     "/var/lib/lvgl-terminal/wifi_known"
+
+typedef struct
+{
+    char ssid[33];
+    char psk[65];           // Empty for an open network
+    uint8_t bssid[6];       // The AP of the last connection, all zero: unknown
+    uint32_t freq_mhz;      // Its channel, 0: unknown
+    int64_t last_used;      // Unix time of the last connection
+} wifi_known_t;
+
+// Remember a network after connecting to it with the password, saved right away
+void wifi_known_remember(const char *ssid, const char *psk);
+
+// The AP of a known network changed (connected or roamed), saved if it's different
+void wifi_known_seen(const char *ssid, const uint8_t *bssid, uint32_t freq_mhz);
+
+// Forget a network, e.g. its password doesn't work anymore
+void wifi_known_forget(const char *ssid);
+
+// The known networks, the last used first. The number of networks written to `nets`
+uint32_t wifi_known_get(wifi_known_t *nets, uint32_t max);
+
+#endif // WIFI_KNOWN_HH
@@ -0,0 +1,197 @@
+#include "wifi_store.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define KNOWN_MAX       16
+#define HIDDEN_NAME     "隐藏网络"
+
+static int compare_by_ssid(const void *a, const void *b);
+static int compare_by_rank(const void *a, const void *b);
+static bool is_better(const wifi_ap_t *a, const wifi_ap_t *b);
+static bool ssid_is_known(const char *ssid);
+static uint32_t now_ms(void);
+
+static wifi_ap_t aps[WIFI_STORE_MAX];
+static uint32_t ap_cnt;
+static char known_ssids[KNOWN_MAX][33];
+static uint32_t known_cnt;
+
+// Options of the roller, grown when a longer list is built
+static char *options;
+static uint32_t options_size;
+
+void wifi_store_update(const wifi_bss_t *bss)
+{
+    uint32_t now = now_ms();
+    wifi_ap_t *ap = NULL;
+    uint32_t i;
+    for(i = 0; i < ap_cnt; i++)
+    {
+        if(memcmp(aps[i].bss.bssid, bss->bssid, 6) == 0)
+        {
+            ap = &aps[i];
+            break;
+        }
+    }
+
+    if(ap == NULL && ap_cnt < WIFI_STORE_MAX) ap = &aps[ap_cnt++];
+
+    // The store is full: replace the AP seen the longest time ago
+    if(ap == NULL)
+    {
+        ap = &aps[0];
+        for(i = 1; i < ap_cnt; i++)
+        {
+            if((int32_t)(aps[i].last_seen_ms - ap->last_seen_ms) < 0) ap = &aps[i];
+        }
+    }
+
+    ap->bss = *bss;
+    ap->last_seen_ms = now - bss->age_ms;
+    if(bss->freq_mhz >= 5925) ap->band = WIFI_BAND_6G;
+    else if(bss->freq_mhz >= 5000) ap->band = WIFI_BAND_5G;
+    else ap->band = WIFI_BAND_2G;
+    ap->known = bss->ssid[0] != '\0' && ssid_is_known(bss->ssid);
+}
+
+void wifi_store_expire(void)
+{
+    uint32_t now = now_ms();
+    uint32_t kept = 0;
+    uint32_t i;
+    for(i = 0; i < ap_cnt; i++)
+    {
+        if(now - aps[i].last_seen_ms <= WIFI_STORE_MAX_AGE_MS) aps[kept++] = aps[i];
+    }
+    ap_cnt = kept;
+}
+
+void wifi_store_set_known(const char *ssid)
+{
+    if(ssid[0] == '\0') return;
+
+    if(!ssid_is_known(ssid))
+    {
+        // Forget the oldest one when the list is full
+        if(known_cnt == KNOWN_MAX)
+        {
+            memmove(known_ssids[0], known_ssids[1], (KNOWN_MAX - 1) * sizeof(known_ssids[0]));
+            known_cnt--;
+        }
+        strncpy(known_ssids[known_cnt], ssid, sizeof(known_ssids[0]) - 1);
+        known_ssids[known_cnt][sizeof(known_ssids[0]) - 1] = '\0';
+        known_cnt++;
+    }
+
+    uint32_t i;
+    for(i = 0; i < ap_cnt; i++)
+    {
+        if(strcmp(aps[i].bss.ssid, ssid) == 0) aps[i].known = true;
+    }
+}
+
+uint32_t wifi_store_get_ranked(const wifi_ap_t **ranked, uint32_t max)
+{
+    // Group the APs of a network with the best one first, hidden networks form a single group
+    const wifi_ap_t *sorted[WIFI_STORE_MAX];
+    uint32_t i;
+    for(i = 0; i < ap_cnt; i++) sorted[i] = &aps[i];
+    qsort(sorted, ap_cnt, sizeof(sorted[0]), compare_by_ssid);
+
+    uint32_t cnt = 0;
+    for(i = 0; i < ap_cnt; i++)
+    {
+        if(cnt > 0 && strcmp(sorted[cnt - 1]->bss.ssid, sorted[i]->bss.ssid) == 0) continue;
+        sorted[cnt++] = sorted[i];
+    }
+    qsort(sorted, cnt, sizeof(sorted[0]), compare_by_rank);
+
+    if(cnt > max) cnt = max;
+    memcpy(ranked, sorted, cnt * sizeof(sorted[0]));
+    return cnt;
+}
+
+const char *wifi_store_get_options(void)
+{
+    const wifi_ap_t *ranked[WIFI_STORE_MAX];
+    uint32_t cnt = wifi_store_get_ranked(ranked, WIFI_STORE_MAX);
+    if(cnt == 0) return NULL;
+
+    // Measure the rows first, then copy them in one pass
+    uint32_t size = 0;
+    uint32_t i;
+    for(i = 0; i < cnt; i++)
+    {
+        const char *ssid = ranked[i]->bss.ssid[0] != '\0' ? ranked[i]->bss.ssid : HIDDEN_NAME;
+        size += strlen(ssid) + 1;
+    }
+
+    if(size > options_size)
+    {
+        char *new_options = (char *)realloc(options, size);
+        if(new_options == NULL) return NULL;
+        options = new_options;
+        options_size = size;
+    }
+
+    char *p = options;
+    for(i = 0; i < cnt; i++)
+    {
+        const char *ssid = ranked[i]->bss.ssid[0] != '\0' ? ranked[i]->bss.ssid : HIDDEN_NAME;
+        uint32_t len = strlen(ssid);
+        memcpy(p, ssid, len);
+        p += len;
+        *p++ = '\n';
+    }
+    p[-1] = '\0';
+    return options;
+}
+
+static int compare_by_ssid(const void *a, const void *b)
+{
+    const wifi_ap_t *ap_a = *(const wifi_ap_t * const *)a;
+    const wifi_ap_t *ap_b = *(const wifi_ap_t * const *)b;
+    int res = strcmp(ap_a->bss.ssid, ap_b->bss.ssid);
+    if(res != 0) return res;
+    if(is_better(ap_a, ap_b)) return -1;
+    if(is_better(ap_b, ap_a)) return 1;
+    return 0;
+}
+
+static int compare_by_rank(const void *a, const void *b)
+{
+    const wifi_ap_t *ap_a = *(const wifi_ap_t * const *)a;
+    const wifi_ap_t *ap_b = *(const wifi_ap_t * const *)b;
+    bool hidden_a = ap_a->bss.ssid[0] == '\0';
+    bool hidden_b = ap_b->bss.ssid[0] == '\0';
+    if(hidden_a != hidden_b) return hidden_a ? 1 : -1;
+    if(ap_a->bss.associated != ap_b->bss.associated) return ap_a->bss.associated ? -1 : 1;
+    if(ap_a->known != ap_b->known) return ap_a->known ? -1 : 1;
+    if(ap_a->bss.signal_mbm != ap_b->bss.signal_mbm) return ap_a->bss.signal_mbm > ap_b->bss.signal_mbm ? -1 : 1;
+    return strcmp(ap_a->bss.ssid, ap_b->bss.ssid);
+}
+
+// The BSS to connect to of the same network: the connected one or the strongest
+static bool is_better(const wifi_ap_t *a, const wifi_ap_t *b)
+{
+    if(a->bss.associated != b->bss.associated) return a->bss.associated;
+    return a->bss.signal_mbm > b->bss.signal_mbm;
+}
+
+static bool ssid_is_known(const char *ssid)
+{
+    uint32_t i;
+    for(i = 0; i < known_cnt; i++)
+    {
+        if(strcmp(known_ssids[i], ssid) == 0) return true;
+    }
+    return false;
+}
+
+static uint32_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
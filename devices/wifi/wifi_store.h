@@ -0,0 +1,46 @@
+#ifndef WIFI_STORE_HH
+#define WIFI_STORE_HH
+
+#include "nl80211_scan.h"
+
+/*
+ * Access points found by the scans, kept between the scans and merged by BSSID.
+ * The list of the roller has one row per SSID (the best BSS of the network), the connected
+ * network first, then the known ones, then the others by signal strength. Hidden networks
+ * share a single row at the end. Only used by the WiFi thread.
+ */
+
+#define WIFI_STORE_MAX          128
+#define WIFI_STORE_MAX_AGE_MS   120000  // Forget an AP not seen by the scans for this long
+
+typedef enum
+{
+    WIFI_BAND_2G,
+    WIFI_BAND_5G,
+    WIFI_BAND_6G,
+} wifi_band_t;
+
+typedef struct
+{
+    wifi_bss_t bss;
+    uint32_t last_seen_ms;  // Monotonic time of the scan which saw it last
+    wifi_band_t band;
+    bool known;             // A network connected earlier
+} wifi_ap_t;
+
+// Add a BSS of a scan or update the one with the same BSSID
+void wifi_store_update(const wifi_bss_t *bss);
+
+// Forget the APs not seen for WIFI_STORE_MAX_AGE_MS, after a scan
+void wifi_store_expire(void);
+
+// Mark the APs of a network as known, they are ranked before the unknown ones
+void wifi_store_set_known(const char *ssid);
+
+// The best AP of each network in the order of the roller. The number of APs written to `aps`
+uint32_t wifi_store_get_ranked(const wifi_ap_t **aps, uint32_t max);
+
+// Options for lv_roller_set_options() in the ranked order, NULL if there are no networks
+const char *wifi_store_get_options(void);
+
+#endif // WIFI_STORE_HH
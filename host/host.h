@@ -0,0 +1,104 @@
+/**
+ * @file host.h
+ * Mock hardware layer of the host build (`make host`).
+ *
+ * The real drivers (ST7789/ILI9341, XPT2046, TM7711) run unchanged and talk to
+ * emulated devices through the wiringPi stand-in:
+ *  - panel:  SPI commands are decoded into a 320x240 RGB565 framebuffer in memory
+ *  - touch:  the XPT2046 bit-banged protocol replays a scripted touch source
+ *  - ADC:    the TM7711 serial protocol returns a synthetic battery voltage
+ *  - camera: see include/opencv2/opencv.hpp
+ *  - WiFi:   nl80211 is answered by host_nl80211.c, rtnetlink by host_rtnl.c and NetworkManager
+ *            by host_nm.cpp, see also host_wifi.c
+ *
+ * Environment variables:
+ *  HOST_TOUCH_SCRIPT   file with touch events, one per line:
+ *                      `<ms> press <x> <y>`                     press or move to a point
+ *                      `<ms> drag <x1> <y1> <x2> <y2> <dur_ms>` press and move in a straight line
+ *                      `<ms> release`
+ *                      `<ms> mark <name>`                       start a benchmark segment (`-`: end it)
+ *                      `<ms> quit`
+ *  HOST_RUN_MS         exit after this many milliseconds
+ *  HOST_FB_DUMP        save the framebuffer as a PPM image to this path on exit
+ *  HOST_SPI_HZ         emulate the transfer time of an SPI bus with this clock (0: instant)
+ *  HOST_BATTERY_MV     battery voltage returned by the ADC [mV] (default 3900)
+ *  BATTERY_HISTORY_FILE path of the battery history, e.g. /tmp/battery_history (default /var/lib/lvgl-terminal/...)
+ *  HOST_ADC_TEMP_C     temperature returned by the ADC's temperature channel [degrees C] (default 30)
+ *  HOST_CAMERA         0: the camera can't be opened
+ *  HOST_CAMERA_FPS     frame rate of the synthetic camera (default 30)
+ *  HOST_WIFI_SSIDS     comma separated list of the networks found by a scan (the ones with "5G" in
+ *                      the name are on the 5 GHz band, with "Guest" open, the others WPA2)
+ *  HOST_WIFI_SCAN_MS   duration of a scan (default 1500)
+ *  HOST_WIFI_PSK       the only password accepted by the secured networks (default: any of 8+ characters)
+ *  HOST_WIFI_CONNECTED the network connected at the start (default HomeNet, empty: none)
+ *  HOST_BENCH_JSON     write the benchmark measurements to this file on exit (see host_bench.c)
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HOST_FB_HOR_RES     320
+#define HOST_FB_VER_RES     240
+
+/*Networks found by a scan without HOST_WIFI_SSIDS (an empty name is a hidden network)*/
+#define HOST_WIFI_DEF_SSIDS "HomeNet,Office-5G,,CafeGuest,TP-LINK_3F2A,Lab"
+
+typedef struct {
+    uint32_t frame_cnt;     /*Number of RAMWR commands (flushed areas)*/
+    uint64_t px_cnt;        /*Number of pixels written*/
+    uint64_t byte_cnt;      /*Number of bytes sent on the bus*/
+    uint64_t busy_us;       /*Time spent in SPI transfers*/
+    uint32_t first_frame_ms;/*When a full screen of pixels was written for the first time*/
+    bool backlight;
+} host_panel_stats_t;
+
+/*Milliseconds since the start of the program*/
+uint32_t host_time_ms(void);
+
+/*Read an integer environment variable*/
+long host_env_int(const char * name, long def);
+
+/*Panel*/
+void host_panel_init(void);
+void host_panel_spi(const uint8_t * data, int len, bool data_mode);
+void host_panel_set_backlight(bool on);
+const uint16_t * host_panel_get_fb(void);
+void host_panel_get_stats(host_panel_stats_t * stats);
+
+/*Touch*/
+void host_touch_write(int pin, int value);
+int host_touch_read(int pin);
+
+/*ADC*/
+void host_adc_clk(int value);
+int host_adc_sda(void);
+
+/*WiFi: the network connected by the fake NetworkManager ("": none, NULL: is any connected)*/
+bool host_wifi_is_connected(const char * ssid);
+void host_wifi_get_connected(char * ssid, uint32_t size);
+void host_wifi_set_connected(const char * ssid);
+int host_wifi_find(const char * ssid);
+bool host_wifi_is_visible(const char * ssid);
+
+/*Netlink: the connection events of the fake WiFi, NETLINK_ROUTE sockets are passed to host_rtnl.c*/
+void host_nl80211_notify_link(bool connected);
+void host_rtnl_notify_link(bool connected);
+int host_rtnl_socket(int type);
+int host_rtnl_setsockopt(int fd, int optname, const void * optval, uint32_t optlen);
+
+/*Benchmark measurements*/
+void host_bench_poll(void);
+void host_bench_mark(const char * name);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*HOST_H*/
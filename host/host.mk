@@ -0,0 +1,30 @@
+HOST_NAME ?= host
+
+# The mock headers shadow wiringPi and OpenCV
+override CFLAGS := -I$(LVGL_DIR)/$(HOST_NAME)/include -I$(LVGL_DIR) $(CFLAGS)
+override CXXFLAGS := -I$(LVGL_DIR)/$(HOST_NAME)/include -I$(LVGL_DIR) $(CXXFLAGS)
+
+# The SquareLine font isn't in the repository, use the built-in CJK font if it's missing
+ifeq ($(wildcard $(LVGL_DIR)/ui/src/fonts/*.c),)
+override CFLAGS := -DLV_FONT_SIMSUN_16_CJK=1 $(CFLAGS)
+override CXXFLAGS := -DLV_FONT_SIMSUN_16_CJK=1 $(CXXFLAGS)
+LDFLAGS += -Wl,--defsym=ui_font_AlimamaShuHeiTi_16=lv_font_simsun_16_cjk
+endif
+
+CSRCS += $(wildcard $(LVGL_DIR)/$(HOST_NAME)/*.c)
+CXXSRCS += $(wildcard $(LVGL_DIR)/$(HOST_NAME)/*.cpp)
+
+# Shell commands (shutdown, reboot) are faked too
+LDFLAGS += -Wl,--wrap=system
+
+# nl80211 (generic netlink) and rtnetlink sockets are answered by a fake kernel
+LDFLAGS += -Wl,--wrap=socket,--wrap=setsockopt,--wrap=if_nametoindex
+
+# The system bus socket is answered by a fake NetworkManager
+LDFLAGS += -Wl,--wrap=connect
+
+# Count the LVGL allocations for the benchmarks
+LDFLAGS += -Wl,--wrap=lv_mem_alloc
+
+BIN = demo_host
+BUILD_DIR = build_host
@@ -0,0 +1,97 @@
+/**
+ * @file host_adc.c
+ * Emulated TM7711 ADC measuring the battery voltage and its own temperature.
+ */
+
+#include "host.h"
+#include <stdlib.h>
+
+/*Constants of the conversion in devices/tm7711/tm7711.cpp and the divider of the default
+ *calibration in devices/battery/battery.cpp*/
+#define REF             2489
+#define R1              30
+#define R2              20000
+#define TEMP_CAL_CODE   0x5A00
+#define TEMP_CAL_C      25
+#define TEMP_CODE_PER_C 96
+
+#define DATA_BITS       24
+
+/*The clock pulses after the data select the next conversion: 25: 10 Hz, 26: temperature, 27: 40 Hz*/
+#define SELECT_TEMP         2
+#define CONV_PERIOD_10HZ    100
+#define CONV_PERIOD_40HZ    25
+
+static uint32_t sample;
+static uint32_t clk_cnt = DATA_BITS + 1;
+static uint32_t conv_start;
+static uint32_t conv_period = CONV_PERIOD_10HZ;
+static uint32_t last_select = 1;
+
+static uint32_t make_sample(uint32_t select);
+static uint32_t make_battery_sample(void);
+static uint32_t make_temp_sample(void);
+
+void host_adc_clk(int value)
+{
+    if(value == 0) return;
+
+    /*The driver reads the next bit after each rising edge*/
+    clk_cnt++;
+    if(clk_cnt == DATA_BITS + 1) {
+        conv_start = host_time_ms();
+        conv_period = CONV_PERIOD_10HZ;
+    }
+    else if(clk_cnt > DATA_BITS + 1) {
+        conv_period = CONV_PERIOD_40HZ;
+    }
+}
+
+int host_adc_sda(void)
+{
+    /*Shifting out the data bits*/
+    if(clk_cnt >= 1 && clk_cnt <= DATA_BITS) return (sample >> (DATA_BITS - clk_cnt)) & 1;
+
+    /*Low: a new conversion is ready*/
+    if(host_time_ms() < conv_start + conv_period) return 1;
+
+    sample = make_sample(clk_cnt - DATA_BITS);
+    clk_cnt = 0;
+    return 0;
+}
+
+/*The first conversion after a channel switch has the settling filter's value: still the old channel*/
+static uint32_t make_sample(uint32_t select)
+{
+    uint32_t prev = last_select;
+    last_select = select;
+    if((select == SELECT_TEMP) != (prev == SELECT_TEMP)) select = prev;
+
+    return select == SELECT_TEMP ? make_temp_sample() : make_battery_sample();
+}
+
+/*Inverse of the driver and the default battery calibration with some noise added*/
+static uint32_t make_battery_sample(void)
+{
+    int64_t mv = host_env_int("HOST_BATTERY_MV", 3900);
+    if(mv < 100) mv = 100;
+
+    int64_t code = (mv - 100) * 128 * R1 / (R1 + R2) * 65535 / REF;
+    code = (code << 8) + (rand() % 4096) - 2048;
+    if(code < 0) code = 0;
+    if(code > 0xFFFFFF) code = 0xFFFFFF;
+
+    return code;
+}
+
+/*Inverse of the temperature calculation of the driver*/
+static uint32_t make_temp_sample(void)
+{
+    int64_t centi_c = host_env_int("HOST_ADC_TEMP_C", 30) * 100;
+    int64_t code = TEMP_CAL_CODE + (centi_c - TEMP_CAL_C * 100) * TEMP_CODE_PER_C / 100;
+    code = (code << 8) + (rand() % 256);
+    if(code < 0) code = 0;
+    if(code > 0xFFFFFF) code = 0xFFFFFF;
+
+    return code;
+}
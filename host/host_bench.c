@@ -0,0 +1,356 @@
+/**
+ * @file host_bench.c
+ * Measurements of the host build for the scenario benchmarks (scripts/bench.py).
+ *
+ * Enabled by setting HOST_BENCH_JSON to the path of the result file written on exit.
+ * The run is split into segments by the `mark` events of the touch script.
+ * For each segment (and for the whole run as "all") it records:
+ *  - the duration of each refresh (render_start_cb -> monitor_cb) split to rendering and flushing,
+ *  - the number of pixels and SPI bytes sent to the panel,
+ *  - the number and size of `lv_mem_alloc` calls,
+ *  - the CPU time used by each thread.
+ */
+
+#include "host.h"
+#include "lvgl/lvgl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#define SEGMENT_MAX     32
+#define THREAD_MAX      32
+#define FRAME_MAX       100000
+#define SAMPLE_PERIOD   200     /*[ms] between two CPU time samples*/
+
+typedef struct {
+    int tid;
+    char name[16];
+    uint64_t cpu_user_us;
+    uint64_t cpu_sys_us;
+} thread_time_t;
+
+typedef struct {
+    char name[32];
+    uint32_t start_ms;
+    uint32_t end_ms;
+    uint32_t last_frame_ms;     /*End of the last refresh*/
+    uint32_t * frame_us;
+    uint32_t frame_cnt;
+    uint64_t render_us;
+    uint64_t flush_us;
+    uint64_t px_cnt;
+    uint64_t spi_bytes;
+    uint64_t alloc_cnt;
+    uint64_t alloc_bytes;
+    thread_time_t threads_start[THREAD_MAX];
+    thread_time_t threads_end[THREAD_MAX];
+} segment_t;
+
+void * __wrap_lv_mem_alloc(size_t size);
+void * __real_lv_mem_alloc(size_t size);
+
+static bool enabled;
+static bool hooked;
+static const char * json_path;
+static segment_t segments[SEGMENT_MAX];   /*[0] is the whole run*/
+static uint32_t segment_cnt;
+static segment_t * active_seg;
+
+static thread_time_t threads[THREAD_MAX];
+static uint32_t last_sample_ms;
+
+static uint64_t frame_start_us;
+static host_panel_stats_t frame_start_panel;
+
+static volatile uint64_t alloc_cnt;
+static volatile uint64_t alloc_bytes;
+
+static uint64_t now_us(void);
+static void render_start_cb(lv_disp_drv_t * drv);
+static void monitor_cb(lv_disp_drv_t * drv, uint32_t time, uint32_t px);
+static void segment_start(segment_t * seg, const char * name);
+static void segment_end(segment_t * seg);
+static void sample_threads(void);
+static void write_json(void);
+
+static void (*prev_render_start_cb)(lv_disp_drv_t * drv);
+static void (*prev_monitor_cb)(lv_disp_drv_t * drv, uint32_t time, uint32_t px);
+
+/*Called from the LVGL thread when the touch driver polls*/
+void host_bench_poll(void)
+{
+    if(!hooked) {
+        hooked = true;
+        json_path = getenv("HOST_BENCH_JSON");
+        enabled = json_path && json_path[0] != '\0';
+        if(!enabled) return;
+
+        lv_disp_t * disp = lv_disp_get_default();
+        prev_render_start_cb = disp->driver->render_start_cb;
+        prev_monitor_cb = disp->driver->monitor_cb;
+        disp->driver->render_start_cb = render_start_cb;
+        disp->driver->monitor_cb = monitor_cb;
+
+        sample_threads();
+        segment_start(&segments[0], "all");
+        segment_cnt = 1;
+        atexit(write_json);
+    }
+
+    if(!enabled) return;
+
+    uint32_t t = host_time_ms();
+    if(t - last_sample_ms >= SAMPLE_PERIOD) sample_threads();
+}
+
+void host_bench_mark(const char * name)
+{
+    if(!enabled) return;
+
+    sample_threads();
+    if(active_seg) segment_end(active_seg);
+    active_seg = NULL;
+
+    /*`mark -` only closes the current segment*/
+    if(strcmp(name, "-") == 0 || segment_cnt >= SEGMENT_MAX) return;
+
+    active_seg = &segments[segment_cnt];
+    segment_cnt++;
+    segment_start(active_seg, name);
+}
+
+void * __wrap_lv_mem_alloc(size_t size)
+{
+    __atomic_add_fetch(&alloc_cnt, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&alloc_bytes, size, __ATOMIC_RELAXED);
+    return __real_lv_mem_alloc(size);
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void render_start_cb(lv_disp_drv_t * drv)
+{
+    frame_start_us = now_us();
+    host_panel_get_stats(&frame_start_panel);
+    if(prev_render_start_cb) prev_render_start_cb(drv);
+}
+
+static void add_frame(segment_t * seg, uint32_t frame_us, uint32_t flush_us, uint32_t px, uint64_t bytes)
+{
+    if(seg->frame_cnt < FRAME_MAX) {
+        if(seg->frame_us == NULL) seg->frame_us = malloc(FRAME_MAX * sizeof(uint32_t));
+        if(seg->frame_us) seg->frame_us[seg->frame_cnt] = frame_us;
+    }
+    seg->frame_cnt++;
+    seg->render_us += frame_us > flush_us ? frame_us - flush_us : 0;
+    seg->flush_us += flush_us;
+    seg->px_cnt += px;
+    seg->spi_bytes += bytes;
+    seg->last_frame_ms = host_time_ms();
+}
+
+static void monitor_cb(lv_disp_drv_t * drv, uint32_t time, uint32_t px)
+{
+    host_panel_stats_t panel;
+    host_panel_get_stats(&panel);
+    uint32_t frame_us = now_us() - frame_start_us;
+    uint32_t flush_us = panel.busy_us - frame_start_panel.busy_us;
+    uint64_t bytes = panel.byte_cnt - frame_start_panel.byte_cnt;
+
+    add_frame(&segments[0], frame_us, flush_us, px, bytes);
+    if(active_seg) add_frame(active_seg, frame_us, flush_us, px, bytes);
+
+    if(prev_monitor_cb) prev_monitor_cb(drv, time, px);
+}
+
+static void segment_start(segment_t * seg, const char * name)
+{
+    snprintf(seg->name, sizeof(seg->name), "%s", name);
+    seg->start_ms = host_time_ms();
+    seg->last_frame_ms = seg->start_ms;
+    seg->alloc_cnt = alloc_cnt;
+    seg->alloc_bytes = alloc_bytes;
+    memcpy(seg->threads_start, threads, sizeof(threads));
+}
+
+static void segment_end(segment_t * seg)
+{
+    seg->end_ms = host_time_ms();
+    seg->alloc_cnt = alloc_cnt - seg->alloc_cnt;
+    seg->alloc_bytes = alloc_bytes - seg->alloc_bytes;
+    memcpy(seg->threads_end, threads, sizeof(threads));
+}
+
+/*Read the CPU time of all threads from /proc. Exited threads keep their last sampled value.*/
+static void sample_threads(void)
+{
+    last_sample_ms = host_time_ms();
+
+    DIR * dir = opendir("/proc/self/task");
+    if(dir == NULL) return;
+
+    long ticks = sysconf(_SC_CLK_TCK);
+    int pid = getpid();
+    struct dirent * ent;
+    while((ent = readdir(dir)) != NULL) {
+        int tid = atoi(ent->d_name);
+        if(tid <= 0) continue;
+
+        char path[64];
+        char buf[512];
+        snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+        FILE * f = fopen(path, "r");
+        if(f == NULL) continue;
+        size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+        fclose(f);
+        buf[len] = '\0';
+
+        /*pid (comm) state ppid ... utime(14) stime(15)*/
+        char * name_start = strchr(buf, '(');
+        char * name_end = strrchr(buf, ')');
+        if(name_start == NULL || name_end == NULL) continue;
+        unsigned long utime, stime;
+        if(sscanf(name_end + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2) continue;
+
+        uint32_t i;
+        for(i = 0; i < THREAD_MAX; i++) {
+            if(threads[i].tid == tid || threads[i].tid == 0) break;
+        }
+        if(i == THREAD_MAX) continue;
+
+        threads[i].tid = tid;
+        if(tid == pid) {
+            strcpy(threads[i].name, "main");
+        }
+        else {
+            size_t name_len = name_end - name_start - 1;
+            if(name_len >= sizeof(threads[i].name)) name_len = sizeof(threads[i].name) - 1;
+            memcpy(threads[i].name, name_start + 1, name_len);
+            threads[i].name[name_len] = '\0';
+        }
+        threads[i].cpu_user_us = (uint64_t)utime * 1000000 / ticks;
+        threads[i].cpu_sys_us = (uint64_t)stime * 1000000 / ticks;
+    }
+    closedir(dir);
+}
+
+static int cmp_u32(const void * a, const void * b)
+{
+    uint32_t va = *(const uint32_t *)a;
+    uint32_t vb = *(const uint32_t *)b;
+    return va < vb ? -1 : va > vb;
+}
+
+static void write_threads(FILE * f, const segment_t * seg)
+{
+    /*Sum the threads with the same name (e.g. a worker started twice)*/
+    char names[THREAD_MAX][16];
+    uint64_t user[THREAD_MAX];
+    uint64_t sys[THREAD_MAX];
+    uint32_t name_cnt = 0;
+    uint32_t i, j;
+    for(i = 0; i < THREAD_MAX && seg->threads_end[i].tid; i++) {
+        const thread_time_t * e = &seg->threads_end[i];
+        uint64_t u0 = 0, s0 = 0;
+        for(j = 0; j < THREAD_MAX && seg->threads_start[j].tid; j++) {
+            if(seg->threads_start[j].tid == e->tid) {
+                u0 = seg->threads_start[j].cpu_user_us;
+                s0 = seg->threads_start[j].cpu_sys_us;
+                break;
+            }
+        }
+        for(j = 0; j < name_cnt; j++) {
+            if(strcmp(names[j], e->name) == 0) break;
+        }
+        if(j == name_cnt) {
+            strcpy(names[j], e->name);
+            user[j] = 0;
+            sys[j] = 0;
+            name_cnt++;
+        }
+        user[j] += e->cpu_user_us - u0;
+        sys[j] += e->cpu_sys_us - s0;
+    }
+
+    fprintf(f, "      \"threads\": {");
+    for(i = 0; i < name_cnt; i++) {
+        fprintf(f, "%s\n        \"%s\": { \"user_ms\": %.1f, \"sys_ms\": %.1f }", i ? "," : "", names[i],
+                user[i] / 1000.0, sys[i] / 1000.0);
+    }
+    fprintf(f, "\n      }\n");
+}
+
+static void write_segment(FILE * f, segment_t * seg, bool last)
+{
+    uint32_t stored = seg->frame_cnt < FRAME_MAX ? seg->frame_cnt : FRAME_MAX;
+    uint32_t min = 0, max = 0, p50 = 0, p95 = 0, p99 = 0;
+    double avg = 0;
+    if(stored && seg->frame_us) {
+        qsort(seg->frame_us, stored, sizeof(uint32_t), cmp_u32);
+        uint64_t sum = 0;
+        uint32_t i;
+        for(i = 0; i < stored; i++) sum += seg->frame_us[i];
+        avg = (double)sum / stored;
+        min = seg->frame_us[0];
+        max = seg->frame_us[stored - 1];
+        p50 = seg->frame_us[stored * 50 / 100];
+        p95 = seg->frame_us[stored * 95 / 100];
+        p99 = seg->frame_us[stored * 99 / 100];
+    }
+
+    fprintf(f, "    \"%s\": {\n", seg->name);
+    fprintf(f, "      \"duration_ms\": %u,\n", seg->end_ms - seg->start_ms);
+    fprintf(f, "      \"settle_ms\": %u,\n", seg->last_frame_ms - seg->start_ms);
+    fprintf(f, "      \"frames\": %u,\n", seg->frame_cnt);
+    fprintf(f, "      \"frame_us\": { \"min\": %u, \"avg\": %.1f, \"p50\": %u, \"p95\": %u, \"p99\": %u, \"max\": %u },\n",
+            min, avg, p50, p95, p99, max);
+    fprintf(f, "      \"render_us\": %llu,\n", (unsigned long long)seg->render_us);
+    fprintf(f, "      \"flush_us\": %llu,\n", (unsigned long long)seg->flush_us);
+    fprintf(f, "      \"px\": %llu,\n", (unsigned long long)seg->px_cnt);
+    fprintf(f, "      \"spi_bytes\": %llu,\n", (unsigned long long)seg->spi_bytes);
+    fprintf(f, "      \"lv_alloc_cnt\": %llu,\n", (unsigned long long)seg->alloc_cnt);
+    fprintf(f, "      \"lv_alloc_bytes\": %llu,\n", (unsigned long long)seg->alloc_bytes);
+    write_threads(f, seg);
+    fprintf(f, "    }%s\n", last ? "" : ",");
+}
+
+static void write_json(void)
+{
+    sample_threads();
+    if(active_seg) segment_end(active_seg);
+    segment_end(&segments[0]);
+
+    FILE * f = fopen(json_path, "w");
+    if(f == NULL) {
+        fprintf(stderr, "[host] can't open %s\n", json_path);
+        return;
+    }
+
+    host_panel_stats_t panel;
+    host_panel_get_stats(&panel);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"first_frame_ms\": %u,\n", panel.first_frame_ms);
+    fprintf(f, "  \"run_ms\": %u,\n", host_time_ms());
+    fprintf(f, "  \"lv_mem_max_used\": %u,\n", (unsigned)mon.max_used);
+    fprintf(f, "  \"max_rss_kb\": %ld,\n", usage.ru_maxrss);
+    fprintf(f, "  \"segments\": {\n");
+    uint32_t i;
+    for(i = 0; i < segment_cnt; i++) write_segment(f, &segments[i], i == segment_cnt - 1);
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+    fclose(f);
+}
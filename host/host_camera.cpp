@@ -0,0 +1,327 @@
+/**
+ * @file host_camera.cpp
+ * Synthetic camera and the OpenCV stand-in functions (see include/opencv2/opencv.hpp).
+ */
+
+#include <opencv2/opencv.hpp>
+#include "host.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+
+#define FRAME_W     640
+#define FRAME_H     480
+
+namespace cv
+{
+
+static int64 now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+bool VideoCapture::open(int index)
+{
+    opened_ = index == 0 && host_env_int("HOST_CAMERA", 1) != 0;
+    frame_idx_ = 0;
+    next_frame_us_ = now_us();
+    return opened_;
+}
+
+VideoCapture & VideoCapture::operator>>(Mat & image)
+{
+    if(!opened_) {
+        image = Mat();
+        return *this;
+    }
+
+    /*Deliver the frames at the camera's rate*/
+    long fps = host_env_int("HOST_CAMERA_FPS", 30);
+    if(fps > 0) {
+        int64 wait = next_frame_us_ - now_us();
+        if(wait > 0) {
+            struct timespec ts = { (time_t)(wait / 1000000), (long)(wait % 1000000) * 1000 };
+            nanosleep(&ts, NULL);
+        }
+        next_frame_us_ = std::max(next_frame_us_ + 1000000 / fps, now_us());
+    }
+
+    /*Gradient background with a red disc going around*/
+    Mat frame(FRAME_H, FRAME_W, CV_8UC3);
+    double a = frame_idx_ * 0.05;
+    int cx = FRAME_W / 2 + (int)(180 * std::cos(a));
+    int cy = FRAME_H / 2 + (int)(140 * std::sin(a));
+    int r2 = 60 * 60;
+    for(int y = 0; y < FRAME_H; y++) {
+        uint8_t * p = frame.ptr<uint8_t>(y);
+        for(int x = 0; x < FRAME_W; x++) {
+            int dx = x - cx;
+            int dy = y - cy;
+            if(dx * dx + dy * dy <= r2) {
+                p[0] = 30;
+                p[1] = 30;
+                p[2] = 220;
+            }
+            else {
+                p[0] = 60 + (x * 120) / FRAME_W;
+                p[1] = 60 + (y * 120) / FRAME_H;
+                p[2] = 40 + ((x + y + frame_idx_ * 4) & 0x3F);
+            }
+            p += 3;
+        }
+    }
+
+    frame_idx_++;
+    image = frame;
+    return *this;
+}
+
+Mat operator|(const Mat & a, const Mat & b)
+{
+    Mat res(a.rows, a.cols, a.type());
+    size_t n = a.total() * a.channels();
+    for(size_t i = 0; i < n; i++) res.data[i] = a.data[i] | b.data[i];
+    return res;
+}
+
+void resize(const Mat & src, Mat & dst, Size dsize)
+{
+    /*Nearest neighbor*/
+    Mat res(dsize.height, dsize.width, src.type());
+    int ch = src.channels();
+    for(int y = 0; y < dsize.height; y++) {
+        const uint8_t * s = src.ptr<uint8_t>(y * src.rows / dsize.height);
+        uint8_t * d = res.ptr<uint8_t>(y);
+        for(int x = 0; x < dsize.width; x++) {
+            const uint8_t * sp = s + (x * src.cols / dsize.width) * ch;
+            for(int c = 0; c < ch; c++) *d++ = sp[c];
+        }
+    }
+    dst = res;
+}
+
+void cvtColor(const Mat & src, Mat & dst, int code)
+{
+    if(code == COLOR_BGR2BGR565) {
+        Mat res(src.rows, src.cols, CV_8UC2);
+        for(int y = 0; y < src.rows; y++) {
+            const uint8_t * s = src.ptr<uint8_t>(y);
+            uint16_t * d = res.ptr<uint16_t>(y);
+            for(int x = 0; x < src.cols; x++) {
+                d[x] = (s[0] >> 3) | ((s[1] & ~3) << 3) | ((s[2] & ~7) << 8);
+                s += 3;
+            }
+        }
+        dst = res;
+    }
+    else if(code == COLOR_BGR2HSV) {
+        /*8 bit version: H is 0..180, S and V are 0..255*/
+        Mat res(src.rows, src.cols, CV_8UC3);
+        for(int y = 0; y < src.rows; y++) {
+            const uint8_t * s = src.ptr<uint8_t>(y);
+            uint8_t * d = res.ptr<uint8_t>(y);
+            for(int x = 0; x < src.cols; x++) {
+                int b = s[0], g = s[1], r = s[2];
+                int v = std::max(r, std::max(g, b));
+                int diff = v - std::min(r, std::min(g, b));
+                int sat = v ? (diff * 255 + v / 2) / v : 0;
+                int h = 0;
+                if(diff) {
+                    if(v == r) h = 60 * (g - b) / diff;
+                    else if(v == g) h = 120 + 60 * (b - r) / diff;
+                    else h = 240 + 60 * (r - g) / diff;
+                    if(h < 0) h += 360;
+                }
+                d[0] = h / 2;
+                d[1] = sat;
+                d[2] = v;
+                s += 3;
+                d += 3;
+            }
+        }
+        dst = res;
+    }
+}
+
+void inRange(const Mat & src, const Scalar & lowerb, const Scalar & upperb, Mat & dst)
+{
+    Mat res(src.rows, src.cols, CV_8UC1);
+    int ch = src.channels();
+    size_t n = src.total();
+    for(size_t i = 0; i < n; i++) {
+        const uint8_t * p = src.data + i * ch;
+        bool in = true;
+        for(int c = 0; c < ch; c++) {
+            if(p[c] < lowerb.val[c] || p[c] > upperb.val[c]) in = false;
+        }
+        res.data[i] = in ? 255 : 0;
+    }
+    dst = res;
+}
+
+Mat getStructuringElement(int shape, Size ksize)
+{
+    Mat k(ksize.height, ksize.width, CV_8UC1);
+    std::fill(k.data, k.data + k.total(), 1);
+    (void)shape;
+    return k;
+}
+
+/*Erode (min) or dilate (max) a single channel image with a rectangle*/
+static Mat morph(const Mat & src, const Mat & kernel, bool dilate)
+{
+    Mat res(src.rows, src.cols, CV_8UC1);
+    int kx = kernel.cols / 2;
+    int ky = kernel.rows / 2;
+    for(int y = 0; y < src.rows; y++) {
+        for(int x = 0; x < src.cols; x++) {
+            uint8_t v = dilate ? 0 : 255;
+            for(int j = std::max(0, y - ky); j <= std::min(src.rows - 1, y + ky); j++) {
+                const uint8_t * s = src.ptr<uint8_t>(j);
+                for(int i = std::max(0, x - kx); i <= std::min(src.cols - 1, x + kx); i++) {
+                    v = dilate ? std::max(v, s[i]) : std::min(v, s[i]);
+                }
+            }
+            res.ptr<uint8_t>(y)[x] = v;
+        }
+    }
+    return res;
+}
+
+void morphologyEx(const Mat & src, Mat & dst, int op, const Mat & kernel)
+{
+    switch(op) {
+        case MORPH_ERODE:
+            dst = morph(src, kernel, false);
+            break;
+        case MORPH_DILATE:
+            dst = morph(src, kernel, true);
+            break;
+        case MORPH_OPEN:
+            dst = morph(morph(src, kernel, false), kernel, true);
+            break;
+        case MORPH_CLOSE:
+            dst = morph(morph(src, kernel, true), kernel, false);
+            break;
+    }
+}
+
+void findContours(const Mat & image, std::vector<std::vector<Point>> & contours, int mode, int method)
+{
+    contours.clear();
+    std::vector<uint8_t> visited(image.total(), 0);
+    std::vector<Point> stack;
+
+    for(int y = 0; y < image.rows; y++) {
+        for(int x = 0; x < image.cols; x++) {
+            size_t idx = (size_t)y * image.cols + x;
+            if(!image.data[idx] || visited[idx]) continue;
+
+            /*Flood fill the component and take its bounding box*/
+            int x1 = x, y1 = y, x2 = x, y2 = y;
+            visited[idx] = 1;
+            stack.push_back(Point(x, y));
+            while(!stack.empty()) {
+                Point p = stack.back();
+                stack.pop_back();
+                x1 = std::min(x1, p.x);
+                y1 = std::min(y1, p.y);
+                x2 = std::max(x2, p.x);
+                y2 = std::max(y2, p.y);
+                const Point nb[4] = { Point(p.x - 1, p.y), Point(p.x + 1, p.y), Point(p.x, p.y - 1), Point(p.x, p.y + 1) };
+                for(const Point & n : nb) {
+                    if(n.x < 0 || n.y < 0 || n.x >= image.cols || n.y >= image.rows) continue;
+                    size_t n_idx = (size_t)n.y * image.cols + n.x;
+                    if(image.data[n_idx] && !visited[n_idx]) {
+                        visited[n_idx] = 1;
+                        stack.push_back(n);
+                    }
+                }
+            }
+
+            contours.push_back({ Point(x1, y1), Point(x2, y1), Point(x2, y2), Point(x1, y2) });
+        }
+    }
+
+    (void)mode;
+    (void)method;
+}
+
+double contourArea(const std::vector<Point> & contour)
+{
+    double area = 0;
+    size_t n = contour.size();
+    for(size_t i = 0; i < n; i++) {
+        const Point & a = contour[i];
+        const Point & b = contour[(i + 1) % n];
+        area += (double)a.x * b.y - (double)b.x * a.y;
+    }
+    return std::fabs(area) / 2;
+}
+
+Rect boundingRect(const std::vector<Point> & points)
+{
+    if(points.empty()) return Rect();
+
+    int x1 = points[0].x, y1 = points[0].y, x2 = x1, y2 = y1;
+    for(const Point & p : points) {
+        x1 = std::min(x1, p.x);
+        y1 = std::min(y1, p.y);
+        x2 = std::max(x2, p.x);
+        y2 = std::max(y2, p.y);
+    }
+    return Rect(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+}
+
+void rectangle(Mat & img, Rect rec, const Scalar & color, int thickness)
+{
+    int ch = img.channels();
+    for(int y = std::max(0, rec.y); y < std::min(img.rows, rec.y + rec.height); y++) {
+        uint8_t * row = img.ptr<uint8_t>(y);
+        for(int x = std::max(0, rec.x); x < std::min(img.cols, rec.x + rec.width); x++) {
+            bool border = x < rec.x + thickness || x >= rec.x + rec.width - thickness ||
+                          y < rec.y + thickness || y >= rec.y + rec.height - thickness;
+            if(!border) continue;
+            for(int c = 0; c < ch; c++) row[x * ch + c] = (uint8_t)color.val[c];
+        }
+    }
+}
+
+void putText(Mat & img, const std::string & text, Point org, int font_face, double font_scale,
+             Scalar color, int thickness)
+{
+    /*Text rendering is not emulated*/
+    (void)img;
+    (void)text;
+    (void)org;
+    (void)font_face;
+    (void)font_scale;
+    (void)color;
+    (void)thickness;
+}
+
+std::string format(const char * fmt, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return buf;
+}
+
+int64 getTickCount()
+{
+    return now_us();
+}
+
+double getTickFrequency()
+{
+    return 1000000.0;
+}
+
+} /*namespace cv*/
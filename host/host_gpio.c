@@ -0,0 +1,154 @@
+/**
+ * @file host_gpio.c
+ * wiringPi stand-in: route the pins to the emulated devices.
+ */
+
+#include "host.h"
+#include "lv_drv_conf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+/*Defined in devices/tm7711/tm7711.cpp*/
+#define TM7711_CLK_PIN  27
+#define TM7711_SDA_PIN  17
+
+#define PIN_NUM         64
+
+static uint8_t pin_level[PIN_NUM];
+static struct timespec start_ts;
+static pthread_once_t setup_once = PTHREAD_ONCE_INIT;
+
+__attribute__((constructor)) static void host_start(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &start_ts);
+}
+
+static void host_setup(void)
+{
+    host_panel_init();
+    printf("[host] mock hardware ready\n");
+}
+
+uint32_t host_time_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start_ts.tv_sec) * 1000 + (now.tv_nsec - start_ts.tv_nsec) / 1000000;
+}
+
+long host_env_int(const char * name, long def)
+{
+    const char * v = getenv(name);
+    if(v == NULL || v[0] == '\0') return def;
+    return strtol(v, NULL, 0);
+}
+
+int wiringPiSetupGpio(void)
+{
+    pthread_once(&setup_once, host_setup);
+    return 0;
+}
+
+void pinMode(int pin, int mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(int pin, int value)
+{
+    if(pin < 0 || pin >= PIN_NUM) return;
+    pin_level[pin] = value ? 1 : 0;
+
+    switch(pin) {
+        case SCLK_PIN:
+        case MOSI_PIN:
+        case CS_PIN:
+            host_touch_write(pin, value);
+            break;
+        case TM7711_CLK_PIN:
+            host_adc_clk(value);
+            break;
+        case PIN_BLK:
+            host_panel_set_backlight(value);
+            break;
+        default:
+            break;
+    }
+}
+
+int digitalRead(int pin)
+{
+    if(pin < 0 || pin >= PIN_NUM) return 0;
+
+    switch(pin) {
+        case IRQ_PIN:
+            host_bench_poll();
+            return host_touch_read(pin);
+        case MISO_PIN:
+            return host_touch_read(pin);
+        case TM7711_SDA_PIN:
+            return host_adc_sda();
+        default:
+            return pin_level[pin];
+    }
+}
+
+void delay(unsigned int ms)
+{
+    delayMicroseconds(ms * 1000);
+}
+
+/*Like wiringPi: busy wait for short delays, sleep for longer ones*/
+void delayMicroseconds(unsigned int us)
+{
+    if(us < 100) {
+        struct timespec now, end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        end.tv_nsec += us * 1000;
+        if(end.tv_nsec >= 1000000000) {
+            end.tv_sec++;
+            end.tv_nsec -= 1000000000;
+        }
+        do {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+        } while(now.tv_sec < end.tv_sec || (now.tv_sec == end.tv_sec && now.tv_nsec < end.tv_nsec));
+    }
+    else {
+        struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+unsigned int millis(void)
+{
+    return host_time_ms();
+}
+
+unsigned int micros(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start_ts.tv_sec) * 1000000 + (now.tv_nsec - start_ts.tv_nsec) / 1000;
+}
+
+int wiringPiSPISetup(int channel, int speed)
+{
+    return wiringPiSPISetupMode(channel, speed, 0);
+}
+
+int wiringPiSPISetupMode(int channel, int speed, int mode)
+{
+    (void)speed;
+    (void)mode;
+    return channel;
+}
+
+int wiringPiSPIDataRW(int channel, unsigned char * data, int len)
+{
+    (void)channel;
+    host_panel_spi(data, len, pin_level[PIN_DC] != 0);
+    return len;
+}
@@ -0,0 +1,572 @@
+/**
+ * @file host_nl80211.c
+ * Fake nl80211 for the WiFi scanner (devices/wifi/nl80211_scan.cpp).
+ * `socket`, `setsockopt` and `if_nametoindex` are wrapped at link time (see host.mk): a generic netlink
+ * socket is replaced by one end of a socketpair and a thread answers on the other end like the kernel,
+ * so the real message parsing runs on the host. It knows the family lookup, NL80211_CMD_TRIGGER_SCAN
+ * (the NL80211_CMD_NEW_SCAN_RESULTS event follows after HOST_WIFI_SCAN_MS, or FAKE_CHANNEL_MS per channel
+ * for a scan of some channels) and the NL80211_CMD_GET_SCAN dump, which sends every BSS of HOST_WIFI_SSIDS in a separate datagram. For the link watcher it answers
+ * NL80211_CMD_GET_INTERFACE, the NL80211_CMD_GET_STATION dump and NL80211_CMD_SET_CQM, and sends the
+ * connection events of the "mlme" group (see host_nl80211_notify_link()).
+ * NETLINK_ROUTE sockets are passed to host_rtnl.c.
+ */
+
+#define _GNU_SOURCE
+#include "host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+
+#define FAKE_FAMILY_ID      28
+#define FAKE_SCAN_GROUP     5
+#define FAKE_MLME_GROUP     7
+#define FAKE_IFINDEX        3
+#define FAKE_SOCK_MAX       4
+#define MSG_BUF_SIZE        512
+#define FAKE_CHANNEL_MS     30      /*Scan time of a channel*/
+#define FAKE_NET_MAX        16
+#define FAKE_FREQ_MAX       8
+
+typedef struct {
+    int fd;                 /*The end given to the application, -1: unused*/
+    int peer;               /*The end of the fake kernel*/
+    uint32_t groups;        /*Joined multicast groups, bit n: group n*/
+} fake_sock_t;
+
+/*A scan running on a socket*/
+typedef struct {
+    uint32_t end_ms;        /*0: no scan is running*/
+    uint32_t freqs[FAKE_FREQ_MAX];
+    uint32_t freq_cnt;      /*0: all channels*/
+} fake_scan_t;
+
+typedef struct {
+    uint32_t buf[MSG_BUF_SIZE / 4];
+    struct nlmsghdr * nlh;
+} msg_t;
+
+static pthread_mutex_t nl_mutex = PTHREAD_MUTEX_INITIALIZER;
+static fake_sock_t socks[FAKE_SOCK_MAX] = {{-1, -1, 0}, {-1, -1, 0}, {-1, -1, 0}, {-1, -1, 0}};
+static uint32_t seen_ms[FAKE_NET_MAX];  /*When a scan found the networks of HOST_WIFI_SSIDS, 0: never*/
+
+int __wrap_socket(int domain, int type, int protocol);
+int __wrap_setsockopt(int fd, int level, int optname, const void * optval, socklen_t optlen);
+unsigned int __wrap_if_nametoindex(const char * ifname);
+int __real_socket(int domain, int type, int protocol);
+int __real_setsockopt(int fd, int level, int optname, const void * optval, socklen_t optlen);
+unsigned int __real_if_nametoindex(const char * ifname);
+
+static void * kernel_thread(void * arg);
+static void handle_request(fake_sock_t * s, const struct nlmsghdr * req, fake_scan_t * scan);
+static void finish_scan(const fake_scan_t * scan);
+static void send_family(fake_sock_t * s, const struct nlmsghdr * req);
+static void send_results(fake_sock_t * s, const struct nlmsghdr * req);
+static void send_event(fake_sock_t * s, uint8_t cmd);
+static void send_interface(fake_sock_t * s, const struct nlmsghdr * req);
+static void send_station(fake_sock_t * s, const struct nlmsghdr * req);
+static void get_bssid(int index, uint8_t * bssid);
+static uint32_t get_freq(int index, const char * ssid, size_t len);
+static int32_t get_signal_dbm(int index);
+static void send_ack(fake_sock_t * s, const struct nlmsghdr * req, int error);
+static void msg_start(msg_t * m, uint16_t type, uint32_t seq, uint8_t cmd);
+static void msg_put(msg_t * m, uint16_t type, const void * data, uint16_t len);
+static struct nlattr * msg_nest_start(msg_t * m, uint16_t type);
+static void msg_nest_end(msg_t * m, struct nlattr * nest);
+static void msg_send(fake_sock_t * s, msg_t * m);
+static const struct nlattr * find_attr(const struct nlmsghdr * nlh, uint16_t type);
+
+int __wrap_socket(int domain, int type, int protocol)
+{
+    if(domain == AF_NETLINK && protocol == NETLINK_ROUTE) return host_rtnl_socket(type);
+    if(domain != AF_NETLINK || protocol != NETLINK_GENERIC) return __real_socket(domain, type, protocol);
+
+    pthread_mutex_lock(&nl_mutex);
+    fake_sock_t * s = NULL;
+    uint32_t i;
+    for(i = 0; i < FAKE_SOCK_MAX; i++) {
+        if(socks[i].fd < 0) {
+            s = &socks[i];
+            break;
+        }
+    }
+
+    int sv[2];
+    if(s == NULL || socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) {
+        pthread_mutex_unlock(&nl_mutex);
+        errno = EMFILE;
+        return -1;
+    }
+    if(type & SOCK_NONBLOCK) fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL) | O_NONBLOCK);
+    s->fd = sv[0];
+    s->peer = sv[1];
+    s->groups = 0;
+    pthread_mutex_unlock(&nl_mutex);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, kernel_thread, s);
+    pthread_detach(thread);
+    return sv[0];
+}
+
+int __wrap_setsockopt(int fd, int level, int optname, const void * optval, socklen_t optlen)
+{
+    if(level != SOL_NETLINK) return __real_setsockopt(fd, level, optname, optval, optlen);
+
+    pthread_mutex_lock(&nl_mutex);
+    uint32_t i;
+    for(i = 0; i < FAKE_SOCK_MAX; i++) {
+        if(socks[i].fd == fd) break;
+    }
+    if(i == FAKE_SOCK_MAX) {
+        pthread_mutex_unlock(&nl_mutex);
+        return host_rtnl_setsockopt(fd, optname, optval, optlen);
+    }
+
+    int res = 0;
+    uint32_t group = optlen >= sizeof(uint32_t) ? *(const uint32_t *)optval : 0;
+    bool known = group == FAKE_SCAN_GROUP || group == FAKE_MLME_GROUP;
+    if(known && optname == NETLINK_ADD_MEMBERSHIP) socks[i].groups |= 1u << group;
+    else if(known && optname == NETLINK_DROP_MEMBERSHIP) socks[i].groups &= ~(1u << group);
+    else {
+        errno = EINVAL;
+        res = -1;
+    }
+    pthread_mutex_unlock(&nl_mutex);
+    return res;
+}
+
+unsigned int __wrap_if_nametoindex(const char * ifname)
+{
+    if(strcmp(ifname, "wlan0") == 0) return FAKE_IFINDEX;
+    return __real_if_nametoindex(ifname);
+}
+
+/*NL80211_CMD_CONNECT or NL80211_CMD_DISCONNECT to the sockets of the "mlme" group*/
+void host_nl80211_notify_link(bool connected)
+{
+    char ssid[33];
+    host_wifi_get_connected(ssid, sizeof(ssid));
+    uint8_t bssid[6];
+    get_bssid(host_wifi_find(ssid), bssid);
+    uint32_t ifindex = FAKE_IFINDEX;
+    uint16_t status = 0;
+
+    msg_t m;
+    msg_start(&m, FAKE_FAMILY_ID, 0, connected ? NL80211_CMD_CONNECT : NL80211_CMD_DISCONNECT);
+    msg_put(&m, NL80211_ATTR_IFINDEX, &ifindex, sizeof(ifindex));
+    if(connected) {
+        msg_put(&m, NL80211_ATTR_MAC, bssid, sizeof(bssid));
+        msg_put(&m, NL80211_ATTR_STATUS_CODE, &status, sizeof(status));
+    }
+
+    pthread_mutex_lock(&nl_mutex);
+    uint32_t i;
+    for(i = 0; i < FAKE_SOCK_MAX; i++) {
+        if(socks[i].fd >= 0 && (socks[i].groups & (1u << FAKE_MLME_GROUP))) msg_send(&socks[i], &m);
+    }
+    pthread_mutex_unlock(&nl_mutex);
+}
+
+/*Answer the requests of a socket until the application closes it*/
+static void * kernel_thread(void * arg)
+{
+    fake_sock_t * s = arg;
+    fake_scan_t scan = {0, {0}, 0};
+    uint32_t buf[MSG_BUF_SIZE / 4];
+
+    while(1) {
+        int timeout = -1;
+        if(scan.end_ms) {
+            uint32_t now = host_time_ms();
+            timeout = scan.end_ms > now ? (int)(scan.end_ms - now) : 0;
+        }
+
+        struct pollfd pfd = {s->peer, POLLIN, 0};
+        int n = poll(&pfd, 1, timeout);
+        if(n < 0 && errno != EINTR) break;
+
+        if(n == 0 && scan.end_ms) {
+            scan.end_ms = 0;
+            finish_scan(&scan);
+            send_event(s, NL80211_CMD_NEW_SCAN_RESULTS);
+            continue;
+        }
+        if(n <= 0) continue;
+
+        ssize_t len = recv(s->peer, buf, sizeof(buf), 0);
+        if(len <= 0) break;
+
+        const struct nlmsghdr * nlh = (const struct nlmsghdr *)buf;
+        int rem = len;
+        for(; NLMSG_OK(nlh, rem); nlh = NLMSG_NEXT(nlh, rem)) handle_request(s, nlh, &scan);
+    }
+
+    pthread_mutex_lock(&nl_mutex);
+    close(s->peer);
+    s->peer = -1;
+    s->fd = -1;
+    pthread_mutex_unlock(&nl_mutex);
+    return NULL;
+}
+
+static void handle_request(fake_sock_t * s, const struct nlmsghdr * req, fake_scan_t * scan)
+{
+    if(req->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN)) {
+        send_ack(s, req, -EINVAL);
+        return;
+    }
+    const struct genlmsghdr * genl = NLMSG_DATA(req);
+
+    if(req->nlmsg_type == GENL_ID_CTRL && genl->cmd == CTRL_CMD_GETFAMILY) {
+        const struct nlattr * name = find_attr(req, CTRL_ATTR_FAMILY_NAME);
+        if(name == NULL || strcmp((const char *)name + NLA_HDRLEN, "nl80211") != 0) {
+            send_ack(s, req, -ENOENT);
+            return;
+        }
+        send_family(s, req);
+        send_ack(s, req, 0);
+        return;
+    }
+
+    if(req->nlmsg_type != FAKE_FAMILY_ID) {
+        send_ack(s, req, -EOPNOTSUPP);
+        return;
+    }
+
+    const struct nlattr * ifindex = find_attr(req, NL80211_ATTR_IFINDEX);
+    if(ifindex == NULL || *(const uint32_t *)((const uint8_t *)ifindex + NLA_HDRLEN) != FAKE_IFINDEX) {
+        send_ack(s, req, -ENODEV);
+        return;
+    }
+
+    if(genl->cmd == NL80211_CMD_TRIGGER_SCAN) {
+        if(scan->end_ms) {
+            send_ack(s, req, -EBUSY);
+            return;
+        }
+
+        /*A scan of a few channels is much shorter than one of all channels*/
+        scan->freq_cnt = 0;
+        const struct nlattr * freqs = find_attr(req, NL80211_ATTR_SCAN_FREQUENCIES);
+        if(freqs) {
+            const struct nlattr * f = (const struct nlattr *)((const uint8_t *)freqs + NLA_HDRLEN);
+            int rem = freqs->nla_len - NLA_HDRLEN;
+            while(rem >= NLA_HDRLEN + 4 && scan->freq_cnt < FAKE_FREQ_MAX) {
+                scan->freqs[scan->freq_cnt++] = *(const uint32_t *)((const uint8_t *)f + NLA_HDRLEN);
+                rem -= NLA_ALIGN(f->nla_len);
+                f = (const struct nlattr *)((const uint8_t *)f + NLA_ALIGN(f->nla_len));
+            }
+        }
+        uint32_t duration = host_env_int("HOST_WIFI_SCAN_MS", 1500);
+        if(scan->freq_cnt) duration = FAKE_CHANNEL_MS * scan->freq_cnt;
+        scan->end_ms = host_time_ms() + duration;
+        if(scan->end_ms == 0) scan->end_ms = 1;
+        send_ack(s, req, 0);
+        send_event(s, NL80211_CMD_TRIGGER_SCAN);
+    }
+    else if(genl->cmd == NL80211_CMD_GET_SCAN && (req->nlmsg_flags & NLM_F_DUMP)) {
+        send_results(s, req);
+    }
+    else if(genl->cmd == NL80211_CMD_GET_INTERFACE) {
+        send_interface(s, req);
+        if(req->nlmsg_flags & NLM_F_ACK) send_ack(s, req, 0);
+    }
+    else if(genl->cmd == NL80211_CMD_GET_STATION && (req->nlmsg_flags & NLM_F_DUMP)) {
+        send_station(s, req);
+    }
+    else if(genl->cmd == NL80211_CMD_SET_CQM) {
+        /*The thresholds are accepted, the signal of the fake networks never changes*/
+        send_ack(s, req, 0);
+    }
+    else {
+        send_ack(s, req, -EOPNOTSUPP);
+    }
+}
+
+/*CTRL_CMD_NEWFAMILY with the id of nl80211 and its multicast groups*/
+static void send_family(fake_sock_t * s, const struct nlmsghdr * req)
+{
+    static const char * group_names[] = {"config", "scan", "regulatory", "mlme"};
+
+    msg_t m;
+    msg_start(&m, GENL_ID_CTRL, req->nlmsg_seq, CTRL_CMD_NEWFAMILY);
+    uint16_t id = FAKE_FAMILY_ID;
+    msg_put(&m, CTRL_ATTR_FAMILY_ID, &id, sizeof(id));
+    msg_put(&m, CTRL_ATTR_FAMILY_NAME, "nl80211", sizeof("nl80211"));
+
+    struct nlattr * groups = msg_nest_start(&m, CTRL_ATTR_MCAST_GROUPS);
+    uint32_t i;
+    for(i = 0; i < sizeof(group_names) / sizeof(group_names[0]); i++) {
+        struct nlattr * group = msg_nest_start(&m, i + 1);
+        uint32_t group_id = FAKE_SCAN_GROUP - 1 + i;
+        msg_put(&m, CTRL_ATTR_MCAST_GRP_ID, &group_id, sizeof(group_id));
+        msg_put(&m, CTRL_ATTR_MCAST_GRP_NAME, group_names[i], strlen(group_names[i]) + 1);
+        msg_nest_end(&m, group);
+    }
+    msg_nest_end(&m, groups);
+    msg_send(s, &m);
+}
+
+/*The dump of NL80211_CMD_GET_SCAN, a datagram for each network*/
+static void send_results(fake_sock_t * s, const struct nlmsghdr * req)
+{
+    /*RSN element: version 1, CCMP group and pairwise cipher, PSK key management*/
+    static const uint8_t rsn_ie[] = {48, 20, 1, 0, 0x00, 0x0F, 0xAC, 4, 1, 0, 0x00, 0x0F, 0xAC, 4,
+                                     1, 0, 0x00, 0x0F, 0xAC, 2, 0, 0
+                                    };
+
+    const char * p = getenv("HOST_WIFI_SSIDS");
+    if(p == NULL) p = HOST_WIFI_DEF_SSIDS;
+
+    uint32_t now = host_time_ms();
+    uint32_t i;
+    for(i = 0; p; i++) {
+        const char * name = p;
+        const char * end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if(len > 32) len = 32;
+        p = end ? end + 1 : NULL;
+
+        /*Only the networks found by a scan are known by the kernel*/
+        pthread_mutex_lock(&nl_mutex);
+        uint32_t seen = i < FAKE_NET_MAX ? seen_ms[i] : 0;
+        pthread_mutex_unlock(&nl_mutex);
+        if(seen == 0) continue;
+
+        /*Networks with "Guest" in the name are open, the others WPA2*/
+        uint8_t bssid[6];
+        get_bssid(i, bssid);
+        uint32_t ifindex = FAKE_IFINDEX;
+        uint32_t freq = get_freq(i, name, len);
+        int32_t signal = get_signal_dbm(i) * 100;
+        uint32_t seen_ms_ago = now - seen;
+        bool open = memmem(name, len, "Guest", 5) != NULL;
+        uint16_t capability = open ? 0x0001 : 0x0011;
+        uint8_t ies[2 + 32 + sizeof(rsn_ie)];
+        ies[0] = 0;
+        ies[1] = len;
+        memcpy(ies + 2, name, len);
+        uint32_t ies_len = 2 + len;
+        if(!open) {
+            memcpy(ies + ies_len, rsn_ie, sizeof(rsn_ie));
+            ies_len += sizeof(rsn_ie);
+        }
+
+        char ssid[33];
+        memcpy(ssid, name, len);
+        ssid[len] = '\0';
+        uint32_t status = NL80211_BSS_STATUS_ASSOCIATED;
+
+        msg_t m;
+        msg_start(&m, FAKE_FAMILY_ID, req->nlmsg_seq, NL80211_CMD_NEW_SCAN_RESULTS);
+        m.nlh->nlmsg_flags |= NLM_F_MULTI;
+        msg_put(&m, NL80211_ATTR_IFINDEX, &ifindex, sizeof(ifindex));
+        struct nlattr * bss = msg_nest_start(&m, NL80211_ATTR_BSS);
+        msg_put(&m, NL80211_BSS_BSSID, bssid, sizeof(bssid));
+        msg_put(&m, NL80211_BSS_FREQUENCY, &freq, sizeof(freq));
+        msg_put(&m, NL80211_BSS_SIGNAL_MBM, &signal, sizeof(signal));
+        msg_put(&m, NL80211_BSS_CAPABILITY, &capability, sizeof(capability));
+        msg_put(&m, NL80211_BSS_SEEN_MS_AGO, &seen_ms_ago, sizeof(seen_ms_ago));
+        msg_put(&m, NL80211_BSS_INFORMATION_ELEMENTS, ies, ies_len);
+        if(host_wifi_is_connected(ssid)) msg_put(&m, NL80211_BSS_STATUS, &status, sizeof(status));
+        msg_nest_end(&m, bss);
+        msg_send(s, &m);
+    }
+
+    msg_t done;
+    msg_start(&done, NLMSG_DONE, req->nlmsg_seq, 0);
+    done.nlh->nlmsg_flags |= NLM_F_MULTI;
+    msg_send(s, &done);
+}
+
+/*Multicast message of the "scan" group*/
+static void send_event(fake_sock_t * s, uint8_t cmd)
+{
+    if(!(s->groups & (1u << FAKE_SCAN_GROUP))) return;
+
+    msg_t m;
+    uint32_t ifindex = FAKE_IFINDEX;
+    msg_start(&m, FAKE_FAMILY_ID, 0, cmd);
+    msg_put(&m, NL80211_ATTR_IFINDEX, &ifindex, sizeof(ifindex));
+    msg_send(s, &m);
+}
+
+/*The networks on the scanned channels were seen, the stronger ones a bit later*/
+static void finish_scan(const fake_scan_t * scan)
+{
+    const char * p = getenv("HOST_WIFI_SSIDS");
+    if(p == NULL) p = HOST_WIFI_DEF_SSIDS;
+
+    uint32_t now = host_time_ms();
+    uint32_t i;
+    for(i = 0; p && i < FAKE_NET_MAX; i++) {
+        const char * end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        uint32_t freq = get_freq(i, p, len);
+        p = end ? end + 1 : NULL;
+
+        bool scanned = scan->freq_cnt == 0;
+        uint32_t f;
+        for(f = 0; f < scan->freq_cnt; f++) {
+            if(scan->freqs[f] == freq) scanned = true;
+        }
+        if(!scanned) continue;
+
+        pthread_mutex_lock(&nl_mutex);
+        seen_ms[i] = now > 100 * i ? now - 100 * i : 1;
+        pthread_mutex_unlock(&nl_mutex);
+    }
+}
+
+/*NL80211_CMD_NEW_INTERFACE of wlan0, with the SSID while connected*/
+static void send_interface(fake_sock_t * s, const struct nlmsghdr * req)
+{
+    char ssid[33];
+    host_wifi_get_connected(ssid, sizeof(ssid));
+    uint32_t ifindex = FAKE_IFINDEX;
+    uint32_t iftype = NL80211_IFTYPE_STATION;
+
+    msg_t m;
+    msg_start(&m, FAKE_FAMILY_ID, req->nlmsg_seq, NL80211_CMD_NEW_INTERFACE);
+    msg_put(&m, NL80211_ATTR_IFINDEX, &ifindex, sizeof(ifindex));
+    msg_put(&m, NL80211_ATTR_IFNAME, "wlan0", sizeof("wlan0"));
+    msg_put(&m, NL80211_ATTR_IFTYPE, &iftype, sizeof(iftype));
+    if(ssid[0] != '\0') {
+        uint32_t freq = get_freq(host_wifi_find(ssid), ssid, strlen(ssid));
+        msg_put(&m, NL80211_ATTR_WIPHY_FREQ, &freq, sizeof(freq));
+        msg_put(&m, NL80211_ATTR_SSID, ssid, strlen(ssid));
+    }
+    msg_send(s, &m);
+}
+
+/*The dump of NL80211_CMD_GET_STATION, the access point while connected*/
+static void send_station(fake_sock_t * s, const struct nlmsghdr * req)
+{
+    char ssid[33];
+    host_wifi_get_connected(ssid, sizeof(ssid));
+    int index = host_wifi_find(ssid);
+
+    if(index >= 0) {
+        uint8_t bssid[6];
+        get_bssid(index, bssid);
+        uint32_t ifindex = FAKE_IFINDEX;
+        int8_t signal = get_signal_dbm(index);
+
+        msg_t m;
+        msg_start(&m, FAKE_FAMILY_ID, req->nlmsg_seq, NL80211_CMD_NEW_STATION);
+        m.nlh->nlmsg_flags |= NLM_F_MULTI;
+        msg_put(&m, NL80211_ATTR_IFINDEX, &ifindex, sizeof(ifindex));
+        msg_put(&m, NL80211_ATTR_MAC, bssid, sizeof(bssid));
+        struct nlattr * info = msg_nest_start(&m, NL80211_ATTR_STA_INFO);
+        msg_put(&m, NL80211_STA_INFO_SIGNAL, &signal, sizeof(signal));
+        msg_nest_end(&m, info);
+        msg_send(s, &m);
+    }
+
+    msg_t done;
+    msg_start(&done, NLMSG_DONE, req->nlmsg_seq, 0);
+    done.nlh->nlmsg_flags |= NLM_F_MULTI;
+    msg_send(s, &done);
+}
+
+/*The networks of HOST_WIFI_SSIDS get 02:00:00:00:00:01, 02:00:00:00:00:02...*/
+static void get_bssid(int index, uint8_t * bssid)
+{
+    static const uint8_t base[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x00};
+    memcpy(bssid, base, sizeof(base));
+    bssid[5] = (uint8_t)(index + 1);
+}
+
+/*Networks with "5G" in the name are on the 5 GHz band*/
+static uint32_t get_freq(int index, const char * ssid, size_t len)
+{
+    return memmem(ssid, len, "5G", 2) ? 5180 + 20 * (index % 8) : 2412 + 5 * ((index * 5) % 13);
+}
+
+/*The first network is the strongest, the others are 7 dB weaker each*/
+static int32_t get_signal_dbm(int index)
+{
+    return -40 - 7 * index;
+}
+
+/*NLMSG_ERROR with the header of the request*/
+static void send_ack(fake_sock_t * s, const struct nlmsghdr * req, int error)
+{
+    msg_t m;
+    memset(m.buf, 0, sizeof(m.buf));
+    m.nlh = (struct nlmsghdr *)m.buf;
+    m.nlh->nlmsg_type = NLMSG_ERROR;
+    m.nlh->nlmsg_seq = req->nlmsg_seq;
+    m.nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct nlmsgerr));
+
+    struct nlmsgerr * err = NLMSG_DATA(m.nlh);
+    err->error = error;
+    err->msg = *req;
+    msg_send(s, &m);
+}
+
+static void msg_start(msg_t * m, uint16_t type, uint32_t seq, uint8_t cmd)
+{
+    memset(m->buf, 0, sizeof(m->buf));
+    m->nlh = (struct nlmsghdr *)m->buf;
+    m->nlh->nlmsg_type = type;
+    m->nlh->nlmsg_seq = seq;
+    if(type == NLMSG_DONE) {
+        m->nlh->nlmsg_len = NLMSG_LENGTH(sizeof(int));
+        return;
+    }
+
+    struct genlmsghdr * genl = NLMSG_DATA(m->nlh);
+    genl->cmd = cmd;
+    genl->version = 1;
+    m->nlh->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+}
+
+static void msg_put(msg_t * m, uint16_t type, const void * data, uint16_t len)
+{
+    struct nlattr * a = (struct nlattr *)((uint8_t *)m->buf + NLMSG_ALIGN(m->nlh->nlmsg_len));
+    a->nla_type = type;
+    a->nla_len = NLA_HDRLEN + len;
+    memcpy((uint8_t *)a + NLA_HDRLEN, data, len);
+    m->nlh->nlmsg_len = NLMSG_ALIGN(m->nlh->nlmsg_len) + NLA_ALIGN(a->nla_len);
+}
+
+static struct nlattr * msg_nest_start(msg_t * m, uint16_t type)
+{
+    struct nlattr * nest = (struct nlattr *)((uint8_t *)m->buf + NLMSG_ALIGN(m->nlh->nlmsg_len));
+    nest->nla_type = type | NLA_F_NESTED;
+    m->nlh->nlmsg_len = NLMSG_ALIGN(m->nlh->nlmsg_len) + NLA_HDRLEN;
+    return nest;
+}
+
+static void msg_nest_end(msg_t * m, struct nlattr * nest)
+{
+    nest->nla_len = (uint8_t *)m->buf + m->nlh->nlmsg_len - (uint8_t *)nest;
+}
+
+static void msg_send(fake_sock_t * s, msg_t * m)
+{
+    if(send(s->peer, m->buf, m->nlh->nlmsg_len, MSG_NOSIGNAL) < 0) printf("[host] nl80211: %s\n", strerror(errno));
+}
+
+static const struct nlattr * find_attr(const struct nlmsghdr * nlh, uint16_t type)
+{
+    const struct nlattr * a = (const struct nlattr *)((const uint8_t *)NLMSG_DATA(nlh) + GENL_HDRLEN);
+    int len = (int)nlh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    while(len >= NLA_HDRLEN && a->nla_len >= NLA_HDRLEN && a->nla_len <= len) {
+        if((a->nla_type & NLA_TYPE_MASK) == type) return a;
+        len -= NLA_ALIGN(a->nla_len);
+        a = (const struct nlattr *)((const uint8_t *)a + NLA_ALIGN(a->nla_len));
+    }
+    return NULL;
+}
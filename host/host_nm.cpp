@@ -0,0 +1,409 @@
+/**
+ * @file host_nm.cpp
+ * Fake system bus with NetworkManager for the WiFi connection (devices/wifi/nm_client.cpp).
+ * `connect` is wrapped at link time (see host.mk): connecting to DBUS_SYSTEM_BUS_PATH gives one end of
+ * a socketpair and a thread answers on the other end like the bus and NetworkManager, so the real
+ * D-Bus code runs on the host. Set DBUS_SYSTEM_BUS_ADDRESS to use a real bus instead.
+ *
+ * The profiles added by AddAndActivateConnection are kept in memory until they are deleted. An activation
+ * goes through the device states PREPARE, CONFIG, IP_CONFIG, IP_CHECK and ACTIVATED in HOST_WIFI_CONNECT_MS. It fails
+ * with SSID_NOT_FOUND for a network which isn't in HOST_WIFI_SSIDS and with NO_SECRETS for a wrong
+ * password (see HOST_WIFI_PSK), a password shorter than 8 characters is refused as invalid.
+ */
+
+#include "host.h"
+#include "devices/wifi/dbus.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define HOST_WIFI_CONNECT_MS    1000
+#define DEVICE_PATH             "/org/freedesktop/NetworkManager/Devices/3"
+#define PROFILE_PATH            "/org/freedesktop/NetworkManager/Settings/"
+#define ACTIVE_PATH             "/org/freedesktop/NetworkManager/ActiveConnection/"
+#define PROFILE_MAX             8
+#define STATE_MAX               6
+
+/*NMDeviceState and NMDeviceStateReason*/
+#define STATE_DISCONNECTED      30
+#define STATE_PREPARE           40
+#define STATE_CONFIG            50
+#define STATE_NEED_AUTH         60
+#define STATE_IP_CONFIG         70
+#define STATE_IP_CHECK          80
+#define STATE_ACTIVATED         100
+#define STATE_FAILED            120
+#define REASON_NO_SECRETS       7
+#define REASON_SSID_NOT_FOUND   53
+
+typedef struct {
+    char uuid[40];
+    char ssid[33];
+    char psk[64];
+} profile_t;
+
+typedef struct {
+    char uuid[40];
+    char ssid[33];
+    char psk[64];
+    bool has_ssid;
+} settings_t;
+
+/*An activation in progress, the states are sent one by one*/
+typedef struct {
+    uint32_t states[STATE_MAX];
+    uint32_t reason;        /*Reason of the last state*/
+    uint32_t cnt;
+    uint32_t next;
+    uint32_t id;            /*Number of the active connection*/
+    char ssid[33];
+} activation_t;
+
+static pthread_mutex_t nm_mutex = PTHREAD_MUTEX_INITIALIZER;
+static profile_t profiles[PROFILE_MAX];
+static uint32_t profile_cnt;
+static uint32_t active_id;
+static uint32_t device_state = STATE_ACTIVATED;
+
+extern "C" int __wrap_connect(int fd, const struct sockaddr * addr, socklen_t len);
+extern "C" int __real_connect(int fd, const struct sockaddr * addr, socklen_t len);
+
+static void * bus_thread(void * arg);
+static bool auth(int fd);
+static void handle_call(dbus_conn_t * bus, dbus_message_t * call, activation_t * act);
+static void activate(dbus_conn_t * bus, dbus_message_t * call, int profile_i, bool add, activation_t * act);
+static void send_state(dbus_conn_t * bus, activation_t * act);
+static bool read_settings(dbus_iter_t * it, settings_t * settings);
+static int find_profile(const char * uuid);
+static bool read_line(int fd, char * line, size_t size);
+
+int __wrap_connect(int fd, const struct sockaddr * addr, socklen_t len)
+{
+    const struct sockaddr_un * un = (const struct sockaddr_un *)addr;
+    if(addr->sa_family != AF_UNIX || strcmp(un->sun_path, DBUS_SYSTEM_BUS_PATH) != 0) {
+        return __real_connect(fd, addr, len);
+    }
+
+    /*The application keeps its socket number, the bus end goes to the thread*/
+    int sv[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) return -1;
+    if(dup2(sv[0], fd) < 0) {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+    close(sv[0]);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, bus_thread, (void *)(intptr_t)sv[1]);
+    pthread_detach(thread);
+    return 0;
+}
+
+/*Answer the calls of a connection until the application closes it*/
+static void * bus_thread(void * arg)
+{
+    int fd = (int)(intptr_t)arg;
+    if(!auth(fd)) {
+        close(fd);
+        return NULL;
+    }
+
+    dbus_conn_t bus;
+    dbus_open_fd(&bus, fd);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    activation_t act;
+    act.cnt = 0;
+    act.next = 0;
+
+    while(1) {
+        /*The states of an activation are spread over HOST_WIFI_CONNECT_MS*/
+        int timeout = act.next < act.cnt ? HOST_WIFI_CONNECT_MS / STATE_MAX : -1;
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int n = poll(&pfd, 1, timeout);
+        if(n < 0 && errno != EINTR) break;
+        if(n == 0) {
+            send_state(&bus, &act);
+            continue;
+        }
+
+        /*Several calls may come in one read*/
+        dbus_message_t call;
+        int res;
+        while((res = dbus_read(&bus, &call)) == 1) {
+            if(call.type == DBUS_METHOD_CALL) handle_call(&bus, &call, &act);
+        }
+        if(res < 0) break;
+    }
+
+    dbus_close(&bus);
+    return NULL;
+}
+
+/*EXTERNAL authentication: a NUL byte, `AUTH EXTERNAL <uid>`, then `BEGIN` after the OK*/
+static bool auth(int fd)
+{
+    char nul;
+    char line[128];
+    if(recv(fd, &nul, 1, 0) != 1 || nul != '\0') return false;
+    if(!read_line(fd, line, sizeof(line)) || strncmp(line, "AUTH EXTERNAL", 13) != 0) return false;
+
+    const char * ok = "OK 0123456789abcdef0123456789abcdef\r\n";
+    if(send(fd, ok, strlen(ok), MSG_NOSIGNAL) < 0) return false;
+    return read_line(fd, line, sizeof(line)) && strcmp(line, "BEGIN") == 0;
+}
+
+static void handle_call(dbus_conn_t * bus, dbus_message_t * call, activation_t * act)
+{
+    const char * member = call->member ? call->member : "";
+    dbus_msg_t reply;
+
+    if(strcmp(member, "Hello") == 0) {
+        dbus_msg_return(&reply, call, "s");
+        dbus_put_string(&reply, ":1.42");
+    }
+    else if(strcmp(member, "AddMatch") == 0) {
+        dbus_msg_return(&reply, call, "");
+    }
+    else if(strcmp(member, "GetDeviceByIpIface") == 0) {
+        const char * ifname = dbus_get_string(&call->body);
+        if(strcmp(ifname, "wlan0") == 0) {
+            dbus_msg_return(&reply, call, "o");
+            dbus_put_string(&reply, DEVICE_PATH);
+        }
+        else {
+            dbus_msg_error(&reply, call, "org.freedesktop.NetworkManager.UnknownDevice", "No device found");
+        }
+    }
+    else if(strcmp(member, "GetConnectionByUuid") == 0) {
+        pthread_mutex_lock(&nm_mutex);
+        int i = find_profile(dbus_get_string(&call->body));
+        pthread_mutex_unlock(&nm_mutex);
+        if(i >= 0) {
+            char path[64];
+            snprintf(path, sizeof(path), PROFILE_PATH "%d", i);
+            dbus_msg_return(&reply, call, "o");
+            dbus_put_string(&reply, path);
+        }
+        else {
+            dbus_msg_error(&reply, call, "org.freedesktop.NetworkManager.Settings.InvalidConnection",
+                           "No connection with the UUID was found");
+        }
+    }
+    else if(strcmp(member, "Update") == 0 || strcmp(member, "AddAndActivateConnection") == 0) {
+        bool add = member[0] == 'A';
+        settings_t settings;
+        if(!read_settings(&call->body, &settings) || !settings.has_ssid) {
+            dbus_msg_error(&reply, call, "org.freedesktop.NetworkManager.Settings.Connection.InvalidProperty",
+                           "802-11-wireless.ssid: property is missing");
+        }
+        else if(settings.psk[0] != '\0' && strlen(settings.psk) < 8) {
+            dbus_msg_error(&reply, call, "org.freedesktop.NetworkManager.Settings.Connection.InvalidProperty",
+                           "802-11-wireless-security.psk: property is invalid");
+        }
+        else {
+            /*Update: the profile of the object path, AddAndActivateConnection: a new one*/
+            pthread_mutex_lock(&nm_mutex);
+            int i = -1;
+            if(add) i = find_profile("");
+            if(add && i < 0 && profile_cnt < PROFILE_MAX) i = profile_cnt++;
+            else if(!add && call->path) sscanf(call->path, PROFILE_PATH "%d", &i);
+            if(i >= 0 && i < (int)profile_cnt) {
+                snprintf(profiles[i].uuid, sizeof(profiles[i].uuid), "%s", settings.uuid);
+                snprintf(profiles[i].ssid, sizeof(profiles[i].ssid), "%s", settings.ssid);
+                snprintf(profiles[i].psk, sizeof(profiles[i].psk), "%s", settings.psk);
+            }
+            if(i >= (int)profile_cnt) i = -1;
+            pthread_mutex_unlock(&nm_mutex);
+
+            if(i < 0) {
+                dbus_msg_error(&reply, call, "org.freedesktop.NetworkManager.Settings.Failed", "Too many profiles");
+            }
+            else if(add) {
+                activate(bus, call, i, true, act);
+                return;
+            }
+            else {
+                dbus_msg_return(&reply, call, "");
+            }
+        }
+    }
+    else if(strcmp(member, "Delete") == 0) {
+        /*The slot stays, its UUID isn't found anymore*/
+        int i = -1;
+        if(call->path) sscanf(call->path, PROFILE_PATH "%d", &i);
+        pthread_mutex_lock(&nm_mutex);
+        if(i >= (int)profile_cnt) i = -1;
+        if(i >= 0) printf("[host] NetworkManager: deleted \"%s\"\n", profiles[i].ssid);
+        if(i >= 0) profiles[i].uuid[0] = '\0';
+        pthread_mutex_unlock(&nm_mutex);
+
+        if(i < 0) dbus_msg_error(&reply, call, "org.freedesktop.NetworkManager.UnknownConnection", "Unknown connection");
+        else dbus_msg_return(&reply, call, "");
+    }
+    else if(strcmp(member, "ActivateConnection") == 0) {
+        int i = -1;
+        sscanf(dbus_get_string(&call->body), PROFILE_PATH "%d", &i);
+        pthread_mutex_lock(&nm_mutex);
+        if(i >= (int)profile_cnt) i = -1;
+        pthread_mutex_unlock(&nm_mutex);
+
+        if(i < 0) {
+            dbus_msg_error(&reply, call, "org.freedesktop.NetworkManager.UnknownConnection", "Unknown connection");
+        }
+        else {
+            activate(bus, call, i, false, act);
+            return;
+        }
+    }
+    else if(strcmp(member, "DeactivateConnection") == 0) {
+        act->next = act->cnt;
+        pthread_mutex_lock(&nm_mutex);
+        device_state = STATE_DISCONNECTED;
+        pthread_mutex_unlock(&nm_mutex);
+        host_wifi_set_connected("");
+        printf("[host] NetworkManager: deactivated\n");
+        dbus_msg_return(&reply, call, "");
+    }
+    else {
+        dbus_msg_error(&reply, call, "org.freedesktop.DBus.Error.UnknownMethod", member);
+    }
+
+    dbus_send(bus, &reply);
+}
+
+/*Reply with the active connection and plan the states of the device*/
+static void activate(dbus_conn_t * bus, dbus_message_t * call, int profile_i, bool add, activation_t * act)
+{
+    pthread_mutex_lock(&nm_mutex);
+    profile_t profile = profiles[profile_i];
+    act->id = ++active_id;
+    pthread_mutex_unlock(&nm_mutex);
+    printf("[host] NetworkManager: activate \"%s\"\n", profile.ssid);
+
+    char path[64];
+    dbus_msg_t reply;
+    dbus_msg_return(&reply, call, add ? "oo" : "o");
+    if(add) {
+        snprintf(path, sizeof(path), PROFILE_PATH "%d", profile_i);
+        dbus_put_string(&reply, path);
+    }
+    snprintf(path, sizeof(path), ACTIVE_PATH "%u", act->id);
+    dbus_put_string(&reply, path);
+    dbus_send(bus, &reply);
+
+    const char * psk = getenv("HOST_WIFI_PSK");
+    bool secured = strstr(profile.ssid, "Guest") == NULL;
+
+    act->cnt = 0;
+    act->next = 0;
+    act->reason = 0;
+    snprintf(act->ssid, sizeof(act->ssid), "%s", profile.ssid);
+    act->states[act->cnt++] = STATE_PREPARE;
+    act->states[act->cnt++] = STATE_CONFIG;
+    if(!host_wifi_is_visible(profile.ssid)) {
+        act->states[act->cnt++] = STATE_FAILED;
+        act->reason = REASON_SSID_NOT_FOUND;
+    }
+    else if(secured && (profile.psk[0] == '\0' || (psk && strcmp(psk, profile.psk) != 0))) {
+        act->states[act->cnt++] = STATE_NEED_AUTH;
+        act->states[act->cnt++] = STATE_FAILED;
+        act->reason = REASON_NO_SECRETS;
+    }
+    else {
+        act->states[act->cnt++] = STATE_IP_CONFIG;
+        act->states[act->cnt++] = STATE_IP_CHECK;
+        act->states[act->cnt++] = STATE_ACTIVATED;
+    }
+
+    /*The earlier connection is dropped*/
+    host_wifi_set_connected("");
+}
+
+static void send_state(dbus_conn_t * bus, activation_t * act)
+{
+    uint32_t state = act->states[act->next++];
+    uint32_t reason = act->next == act->cnt ? act->reason : 0;
+
+    pthread_mutex_lock(&nm_mutex);
+    uint32_t old_state = device_state;
+    device_state = state;
+    pthread_mutex_unlock(&nm_mutex);
+    if(state == STATE_ACTIVATED) host_wifi_set_connected(act->ssid);
+
+    dbus_msg_t msg;
+    dbus_msg_signal(&msg, DEVICE_PATH, "org.freedesktop.NetworkManager.Device", "StateChanged", "uuu");
+    dbus_put_u32(&msg, state);
+    dbus_put_u32(&msg, old_state);
+    dbus_put_u32(&msg, reason);
+    dbus_send(bus, &msg);
+}
+
+/*The settings used by the fake from a{sa{sv}}, the others are skipped*/
+static bool read_settings(dbus_iter_t * it, settings_t * settings)
+{
+    memset(settings, 0, sizeof(settings_t));
+
+    uint32_t end = dbus_array_enter(it, 8);
+    while(!it->error && it->pos < end) {
+        dbus_struct_enter(it);
+        const char * group = dbus_get_string(it);
+        uint32_t group_end = dbus_array_enter(it, 8);
+        while(!it->error && it->pos < group_end) {
+            dbus_struct_enter(it);
+            const char * key = dbus_get_string(it);
+            const char * sig = dbus_get_signature(it);
+
+            if(strcmp(key, "ssid") == 0 && strcmp(sig, "ay") == 0) {
+                uint32_t bytes_end = dbus_array_enter(it, 1);
+                uint32_t len = 0;
+                while(!it->error && it->pos < bytes_end) {
+                    uint8_t c = dbus_get_byte(it);
+                    if(len + 1 < sizeof(settings->ssid)) settings->ssid[len++] = c;
+                }
+                settings->has_ssid = true;
+            }
+            else if(strcmp(sig, "s") == 0 && strcmp(group, "connection") == 0 && strcmp(key, "uuid") == 0) {
+                snprintf(settings->uuid, sizeof(settings->uuid), "%s", dbus_get_string(it));
+            }
+            else if(strcmp(sig, "s") == 0 && strcmp(key, "psk") == 0) {
+                snprintf(settings->psk, sizeof(settings->psk), "%s", dbus_get_string(it));
+            }
+            else {
+                dbus_skip(it, &sig);
+            }
+        }
+    }
+    return !it->error;
+}
+
+/*Call with nm_mutex locked, or before the profile can change*/
+static int find_profile(const char * uuid)
+{
+    uint32_t i;
+    for(i = 0; i < profile_cnt; i++) {
+        if(strcmp(profiles[i].uuid, uuid) == 0) return (int)i;
+    }
+    return -1;
+}
+
+/*Read a line of the authentication byte by byte, the messages follow it*/
+static bool read_line(int fd, char * line, size_t size)
+{
+    size_t len = 0;
+    while(len + 1 < size) {
+        char c;
+        if(recv(fd, &c, 1, 0) != 1) return false;
+        if(c == '\n') break;
+        if(c != '\r') line[len++] = c;
+    }
+    line[len] = '\0';
+    return true;
+}
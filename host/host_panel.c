@@ -0,0 +1,171 @@
+/**
+ * @file host_panel.c
+ * Emulated SPI panel (ST7789 / ILI9341 command set) with a framebuffer in memory.
+ */
+
+#include "host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+/*MIPI DCS commands used by the drivers*/
+#define CMD_CASET   0x2A
+#define CMD_RASET   0x2B
+#define CMD_RAMWR   0x2C
+
+static uint16_t fb[HOST_FB_HOR_RES * HOST_FB_VER_RES];
+static host_panel_stats_t stats;
+static pthread_mutex_t panel_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint8_t cmd;
+static uint32_t param_cnt;
+static uint8_t params[4];
+static uint16_t col_start, col_end, row_start, row_end;
+static uint16_t cur_x, cur_y;
+static int pending_byte = -1;       /*First byte of a pixel split between two transfers*/
+static long spi_hz;
+
+static void write_px(uint16_t c);
+static void dump_fb(void);
+
+void host_panel_init(void)
+{
+    spi_hz = host_env_int("HOST_SPI_HZ", 0);
+    atexit(dump_fb);
+}
+
+void host_panel_spi(const uint8_t * data, int len, bool data_mode)
+{
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    pthread_mutex_lock(&panel_mutex);
+    int i;
+    for(i = 0; i < len; i++) {
+        uint8_t b = data[i];
+        if(!data_mode) {
+            cmd = b;
+            param_cnt = 0;
+            pending_byte = -1;
+            if(cmd == CMD_RAMWR) {
+                cur_x = col_start;
+                cur_y = row_start;
+                stats.frame_cnt++;
+            }
+            continue;
+        }
+
+        switch(cmd) {
+            case CMD_CASET:
+            case CMD_RASET:
+                if(param_cnt < 4) params[param_cnt] = b;
+                param_cnt++;
+                if(param_cnt == 4) {
+                    uint16_t start = (params[0] << 8) | params[1];
+                    uint16_t end = (params[2] << 8) | params[3];
+                    if(cmd == CMD_CASET) {
+                        col_start = start;
+                        col_end = end;
+                    }
+                    else {
+                        row_start = start;
+                        row_end = end;
+                    }
+                }
+                break;
+            case CMD_RAMWR:
+                /*The pixels are sent big-endian (LV_COLOR_16_SWAP)*/
+                if(pending_byte < 0) {
+                    pending_byte = b;
+                }
+                else {
+                    write_px((pending_byte << 8) | b);
+                    pending_byte = -1;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    stats.byte_cnt += len;
+    pthread_mutex_unlock(&panel_mutex);
+
+    /*Emulate the time needed to clock out the data*/
+    if(spi_hz > 0) {
+        uint64_t ns = (uint64_t)len * 8 * 1000000000 / spi_hz;
+        struct timespec ts = { ns / 1000000000, ns % 1000000000 };
+        nanosleep(&ts, NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    pthread_mutex_lock(&panel_mutex);
+    stats.busy_us += (t1.tv_sec - t0.tv_sec) * 1000000 + (t1.tv_nsec - t0.tv_nsec) / 1000;
+    pthread_mutex_unlock(&panel_mutex);
+}
+
+void host_panel_set_backlight(bool on)
+{
+    stats.backlight = on;
+}
+
+const uint16_t * host_panel_get_fb(void)
+{
+    return fb;
+}
+
+void host_panel_get_stats(host_panel_stats_t * stats_out)
+{
+    pthread_mutex_lock(&panel_mutex);
+    *stats_out = stats;
+    pthread_mutex_unlock(&panel_mutex);
+}
+
+static void write_px(uint16_t c)
+{
+    if(cur_x < HOST_FB_HOR_RES && cur_y < HOST_FB_VER_RES) fb[cur_y * HOST_FB_HOR_RES + cur_x] = c;
+    stats.px_cnt++;
+    if(stats.first_frame_ms == 0 && stats.px_cnt >= HOST_FB_HOR_RES * HOST_FB_VER_RES) {
+        stats.first_frame_ms = host_time_ms();
+    }
+
+    /*Wrap inside the window like the controller does*/
+    if(cur_x >= col_end) {
+        cur_x = col_start;
+        cur_y = cur_y >= row_end ? row_start : cur_y + 1;
+    }
+    else {
+        cur_x++;
+    }
+}
+
+static void dump_fb(void)
+{
+    host_panel_stats_t s;
+    host_panel_get_stats(&s);
+    printf("[host] panel: %u flushes, %llu px, %llu bytes, %llu us in SPI transfers\n", s.frame_cnt,
+           (unsigned long long)s.px_cnt, (unsigned long long)s.byte_cnt, (unsigned long long)s.busy_us);
+
+    const char * path = getenv("HOST_FB_DUMP");
+    if(path == NULL || path[0] == '\0') return;
+
+    FILE * f = fopen(path, "wb");
+    if(f == NULL) {
+        fprintf(stderr, "[host] can't open %s\n", path);
+        return;
+    }
+
+    fprintf(f, "P6\n%d %d\n255\n", HOST_FB_HOR_RES, HOST_FB_VER_RES);
+    uint32_t i;
+    for(i = 0; i < HOST_FB_HOR_RES * HOST_FB_VER_RES; i++) {
+        uint16_t c = fb[i];
+        uint8_t rgb[3];
+        rgb[0] = ((c >> 11) & 0x1F) * 255 / 31;
+        rgb[1] = ((c >> 5) & 0x3F) * 255 / 63;
+        rgb[2] = (c & 0x1F) * 255 / 31;
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+    printf("[host] framebuffer saved to %s\n", path);
+}
@@ -0,0 +1,288 @@
+/**
+ * @file host_rtnl.c
+ * Fake rtnetlink for the network status monitor (devices/wifi/net_monitor.cpp).
+ * The `socket` and `setsockopt` wrappers of host_nl80211.c pass the NETLINK_ROUTE sockets here: one end
+ * of a socketpair is given to the application and a thread answers on the other end like the kernel.
+ * It knows the RTM_GETLINK and RTM_GETADDR dumps (lo and wlan0, which has HOST_WIFI_IP and two IPv6
+ * addresses while connected) and sends the link and address events when the fake WiFi connects or
+ * disconnects (see host_rtnl_notify_link()).
+ */
+
+#define _GNU_SOURCE
+#include "host.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#define FAKE_IFINDEX        3
+#define FAKE_SOCK_MAX       4
+#define MSG_BUF_SIZE        256
+#define HOST_WIFI_IP        "192.168.1.50"
+#define HOST_WIFI_IPV6      "2001:db8::50"
+#define HOST_WIFI_IPV6_LL   "fe80::50"
+
+#ifndef IFF_LOWER_UP
+#define IFF_LOWER_UP        0x10000
+#endif
+
+typedef struct {
+    int fd;                 /*The end given to the application, -1: unused*/
+    int peer;               /*The end of the fake kernel*/
+    uint32_t groups;        /*Joined multicast groups, bit n: group n*/
+} fake_sock_t;
+
+typedef struct {
+    uint32_t buf[MSG_BUF_SIZE / 4];
+    struct nlmsghdr * nlh;
+} msg_t;
+
+/*An address of an interface*/
+typedef struct {
+    int ifindex;
+    uint8_t family;
+    uint8_t prefix;
+    uint8_t scope;
+    const char * text;
+} fake_addr_t;
+
+static const fake_addr_t addrs[] = {
+    {1, AF_INET, 8, RT_SCOPE_HOST, "127.0.0.1"},
+    {FAKE_IFINDEX, AF_INET, 24, RT_SCOPE_UNIVERSE, HOST_WIFI_IP},
+    {FAKE_IFINDEX, AF_INET6, 64, RT_SCOPE_UNIVERSE, HOST_WIFI_IPV6},
+    {FAKE_IFINDEX, AF_INET6, 64, RT_SCOPE_LINK, HOST_WIFI_IPV6_LL},
+};
+
+static pthread_mutex_t rtnl_mutex = PTHREAD_MUTEX_INITIALIZER;
+static fake_sock_t socks[FAKE_SOCK_MAX] = {{-1, -1, 0}, {-1, -1, 0}, {-1, -1, 0}, {-1, -1, 0}};
+
+int __real_setsockopt(int fd, int level, int optname, const void * optval, socklen_t optlen);
+
+static void * kernel_thread(void * arg);
+static void handle_request(fake_sock_t * s, const struct nlmsghdr * req);
+static void send_link(int fd, uint16_t type, uint32_t seq, int ifindex, bool connected);
+static void send_addr(int fd, uint16_t type, uint32_t seq, const fake_addr_t * addr);
+static void send_done(fake_sock_t * s, const struct nlmsghdr * req, int error);
+static void msg_start(msg_t * m, uint16_t type, uint32_t seq, const void * hdr, uint32_t hdr_len);
+static void msg_put(msg_t * m, uint16_t type, const void * data, uint16_t len);
+static void msg_send(int fd, msg_t * m);
+
+int host_rtnl_socket(int type)
+{
+    pthread_mutex_lock(&rtnl_mutex);
+    fake_sock_t * s = NULL;
+    uint32_t i;
+    for(i = 0; i < FAKE_SOCK_MAX; i++) {
+        if(socks[i].fd < 0) {
+            s = &socks[i];
+            break;
+        }
+    }
+
+    int sv[2];
+    if(s == NULL || socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) {
+        pthread_mutex_unlock(&rtnl_mutex);
+        errno = EMFILE;
+        return -1;
+    }
+    if(type & SOCK_NONBLOCK) fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL) | O_NONBLOCK);
+    s->fd = sv[0];
+    s->peer = sv[1];
+    s->groups = 0;
+    pthread_mutex_unlock(&rtnl_mutex);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, kernel_thread, s);
+    pthread_detach(thread);
+    return sv[0];
+}
+
+int host_rtnl_setsockopt(int fd, int optname, const void * optval, uint32_t optlen)
+{
+    pthread_mutex_lock(&rtnl_mutex);
+    uint32_t i;
+    for(i = 0; i < FAKE_SOCK_MAX; i++) {
+        if(socks[i].fd == fd) break;
+    }
+    if(i == FAKE_SOCK_MAX) {
+        pthread_mutex_unlock(&rtnl_mutex);
+        return __real_setsockopt(fd, SOL_NETLINK, optname, optval, optlen);
+    }
+
+    int res = 0;
+    uint32_t group = optlen >= sizeof(uint32_t) ? *(const uint32_t *)optval : 0;
+    if(group == 0 || group >= 32) {
+        errno = EINVAL;
+        res = -1;
+    }
+    else if(optname == NETLINK_ADD_MEMBERSHIP) socks[i].groups |= 1u << group;
+    else if(optname == NETLINK_DROP_MEMBERSHIP) socks[i].groups &= ~(1u << group);
+    else {
+        errno = ENOPROTOOPT;
+        res = -1;
+    }
+    pthread_mutex_unlock(&rtnl_mutex);
+    return res;
+}
+
+/*The events of wlan0 connecting or disconnecting*/
+void host_rtnl_notify_link(bool connected)
+{
+    pthread_mutex_lock(&rtnl_mutex);
+    uint32_t i;
+    for(i = 0; i < FAKE_SOCK_MAX; i++) {
+        if(socks[i].fd < 0) continue;
+
+        if(socks[i].groups & (1u << RTNLGRP_LINK)) {
+            send_link(socks[i].peer, RTM_NEWLINK, 0, FAKE_IFINDEX, connected);
+        }
+
+        uint32_t a;
+        for(a = 0; a < sizeof(addrs) / sizeof(addrs[0]); a++) {
+            uint32_t group = addrs[a].family == AF_INET ? RTNLGRP_IPV4_IFADDR : RTNLGRP_IPV6_IFADDR;
+            if(addrs[a].ifindex != FAKE_IFINDEX || !(socks[i].groups & (1u << group))) continue;
+            send_addr(socks[i].peer, connected ? RTM_NEWADDR : RTM_DELADDR, 0, &addrs[a]);
+        }
+    }
+    pthread_mutex_unlock(&rtnl_mutex);
+}
+
+/*Answer the requests of a socket until the application closes it*/
+static void * kernel_thread(void * arg)
+{
+    fake_sock_t * s = arg;
+    uint32_t buf[MSG_BUF_SIZE / 4];
+
+    while(1) {
+        ssize_t len = recv(s->peer, buf, sizeof(buf), 0);
+        if(len <= 0) break;
+
+        const struct nlmsghdr * nlh = (const struct nlmsghdr *)buf;
+        int rem = len;
+        for(; NLMSG_OK(nlh, rem); nlh = NLMSG_NEXT(nlh, rem)) {
+            pthread_mutex_lock(&rtnl_mutex);
+            handle_request(s, nlh);
+            pthread_mutex_unlock(&rtnl_mutex);
+        }
+    }
+
+    pthread_mutex_lock(&rtnl_mutex);
+    close(s->peer);
+    s->peer = -1;
+    s->fd = -1;
+    pthread_mutex_unlock(&rtnl_mutex);
+    return NULL;
+}
+
+/*Called with rtnl_mutex locked, so the dumps and the events don't interleave*/
+static void handle_request(fake_sock_t * s, const struct nlmsghdr * req)
+{
+    bool connected = host_wifi_is_connected(NULL);
+
+    if(!(req->nlmsg_flags & NLM_F_DUMP)) {
+        send_done(s, req, -EOPNOTSUPP);
+    }
+    else if(req->nlmsg_type == RTM_GETLINK) {
+        send_link(s->peer, RTM_NEWLINK, req->nlmsg_seq, 1, true);
+        send_link(s->peer, RTM_NEWLINK, req->nlmsg_seq, FAKE_IFINDEX, connected);
+        send_done(s, req, 0);
+    }
+    else if(req->nlmsg_type == RTM_GETADDR) {
+        uint32_t a;
+        for(a = 0; a < sizeof(addrs) / sizeof(addrs[0]); a++) {
+            if(addrs[a].ifindex == FAKE_IFINDEX && !connected) continue;
+            send_addr(s->peer, RTM_NEWADDR, req->nlmsg_seq, &addrs[a]);
+        }
+        send_done(s, req, 0);
+    }
+    else {
+        send_done(s, req, -EOPNOTSUPP);
+    }
+}
+
+/*lo is always up, wlan0 is up and has a carrier while connected*/
+static void send_link(int fd, uint16_t type, uint32_t seq, int ifindex, bool connected)
+{
+    struct ifinfomsg ifi;
+    memset(&ifi, 0, sizeof(ifi));
+    ifi.ifi_family = AF_UNSPEC;
+    ifi.ifi_index = ifindex;
+    ifi.ifi_flags = IFF_UP;
+    if(connected) ifi.ifi_flags |= IFF_RUNNING | IFF_LOWER_UP;
+
+    const char * name = ifindex == 1 ? "lo" : "wlan0";
+    msg_t m;
+    msg_start(&m, type, seq, &ifi, sizeof(ifi));
+    if(seq) m.nlh->nlmsg_flags |= NLM_F_MULTI;
+    msg_put(&m, IFLA_IFNAME, name, strlen(name) + 1);
+    msg_send(fd, &m);
+}
+
+static void send_addr(int fd, uint16_t type, uint32_t seq, const fake_addr_t * addr)
+{
+    struct ifaddrmsg ifa;
+    memset(&ifa, 0, sizeof(ifa));
+    ifa.ifa_family = addr->family;
+    ifa.ifa_prefixlen = addr->prefix;
+    ifa.ifa_scope = addr->scope;
+    ifa.ifa_index = addr->ifindex;
+
+    uint8_t bytes[16];
+    inet_pton(addr->family, addr->text, bytes);
+    uint16_t len = addr->family == AF_INET ? 4 : 16;
+
+    msg_t m;
+    msg_start(&m, type, seq, &ifa, sizeof(ifa));
+    if(seq) m.nlh->nlmsg_flags |= NLM_F_MULTI;
+    msg_put(&m, IFA_ADDRESS, bytes, len);
+    if(addr->family == AF_INET) msg_put(&m, IFA_LOCAL, bytes, len);
+    msg_send(fd, &m);
+}
+
+/*NLMSG_DONE at the end of a dump, NLMSG_ERROR for an unknown request*/
+static void send_done(fake_sock_t * s, const struct nlmsghdr * req, int error)
+{
+    msg_t m;
+    if(error == 0) {
+        msg_start(&m, NLMSG_DONE, req->nlmsg_seq, &error, sizeof(error));
+        m.nlh->nlmsg_flags |= NLM_F_MULTI;
+    }
+    else {
+        struct nlmsgerr err;
+        err.error = error;
+        err.msg = *req;
+        msg_start(&m, NLMSG_ERROR, req->nlmsg_seq, &err, sizeof(err));
+    }
+    msg_send(s->peer, &m);
+}
+
+static void msg_start(msg_t * m, uint16_t type, uint32_t seq, const void * hdr, uint32_t hdr_len)
+{
+    memset(m->buf, 0, sizeof(m->buf));
+    m->nlh = (struct nlmsghdr *)m->buf;
+    m->nlh->nlmsg_type = type;
+    m->nlh->nlmsg_seq = seq;
+    m->nlh->nlmsg_len = NLMSG_LENGTH(hdr_len);
+    memcpy(NLMSG_DATA(m->nlh), hdr, hdr_len);
+}
+
+static void msg_put(msg_t * m, uint16_t type, const void * data, uint16_t len)
+{
+    struct rtattr * a = (struct rtattr *)((uint8_t *)m->buf + NLMSG_ALIGN(m->nlh->nlmsg_len));
+    a->rta_type = type;
+    a->rta_len = RTA_LENGTH(len);
+    memcpy(RTA_DATA(a), data, len);
+    m->nlh->nlmsg_len = NLMSG_ALIGN(m->nlh->nlmsg_len) + RTA_ALIGN(a->rta_len);
+}
+
+static void msg_send(int fd, msg_t * m)
+{
+    if(send(fd, m->buf, m->nlh->nlmsg_len, MSG_NOSIGNAL) < 0) printf("[host] rtnetlink: %s\n", strerror(errno));
+}
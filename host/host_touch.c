@@ -0,0 +1,201 @@
+/**
+ * @file host_touch.c
+ * Emulated XPT2046 touch controller fed by a touch script.
+ */
+
+#include "host.h"
+#include "lv_drv_conf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SCRIPT_MAX      4096
+#define DRAG_STEP       10      /*[ms] between the points of a drag*/
+
+typedef enum {
+    TOUCH_PRESS,
+    TOUCH_RELEASE,
+    TOUCH_MARK,
+    TOUCH_QUIT,
+} touch_action_t;
+
+typedef struct {
+    uint32_t time;
+    touch_action_t action;
+    int16_t x;
+    int16_t y;
+    char name[24];              /*Segment name of TOUCH_MARK*/
+} touch_event_t;
+
+static touch_event_t script[SCRIPT_MAX];
+static uint32_t script_len;
+static uint32_t script_pos;
+static bool script_loaded;
+static long run_ms;
+
+static bool pressed;
+static uint16_t raw_x, raw_y;
+
+/*Serial interface state*/
+static bool cs_low;
+static bool sclk_high;
+static uint8_t bit_idx;
+static uint8_t byte_idx;
+static uint8_t resp[5];
+
+static void load_script(void);
+static void update(void);
+static uint16_t screen_to_raw(int32_t v, int32_t res, int32_t min, int32_t max, bool inv);
+
+void host_touch_write(int pin, int value)
+{
+    if(pin == CS_PIN) {
+        cs_low = value == 0;
+        bit_idx = 0;
+        byte_idx = 0;
+        if(cs_low) {
+            /*Response to CMD_X_READ, 0, CMD_Y_READ, 0, 0: the 12 bit results are left aligned in 16 bits*/
+            uint16_t x = raw_x << 3;
+            uint16_t y = raw_y << 3;
+            resp[0] = 0;
+            resp[1] = x >> 8;
+            resp[2] = x & 0xFF;
+            resp[3] = y >> 8;
+            resp[4] = y & 0xFF;
+        }
+    }
+    else if(pin == SCLK_PIN) {
+        /*Next bit on the falling edge*/
+        if(sclk_high && value == 0 && cs_low) {
+            bit_idx++;
+            if(bit_idx == 8) {
+                bit_idx = 0;
+                byte_idx++;
+            }
+        }
+        sclk_high = value != 0;
+    }
+}
+
+int host_touch_read(int pin)
+{
+    if(pin == IRQ_PIN) {
+        update();
+        return pressed ? 0 : 1;
+    }
+
+    /*MISO*/
+    if(!cs_low || byte_idx >= sizeof(resp)) return 0;
+    return (resp[byte_idx] >> (7 - bit_idx)) & 1;
+}
+
+/*Apply the script events which are due. Called when the driver polls the IRQ pin (from the LVGL thread).*/
+static void update(void)
+{
+    if(!script_loaded) load_script();
+
+    uint32_t now = host_time_ms();
+    if(run_ms > 0 && now >= (uint32_t)run_ms) {
+        printf("[host] run time (%ld ms) is over\n", run_ms);
+        exit(0);
+    }
+
+    while(script_pos < script_len && script[script_pos].time <= now) {
+        touch_event_t * e = &script[script_pos];
+        script_pos++;
+        switch(e->action) {
+            case TOUCH_PRESS:
+                pressed = true;
+                raw_x = screen_to_raw(e->x, XPT2046_HOR_RES, XPT2046_X_MIN, XPT2046_X_MAX, XPT2046_X_INV);
+                raw_y = screen_to_raw(e->y, XPT2046_VER_RES, XPT2046_Y_MIN, XPT2046_Y_MAX, XPT2046_Y_INV);
+                break;
+            case TOUCH_RELEASE:
+                pressed = false;
+                break;
+            case TOUCH_MARK:
+                host_bench_mark(e->name);
+                break;
+            case TOUCH_QUIT:
+                printf("[host] touch script finished\n");
+                exit(0);
+        }
+    }
+}
+
+static void load_script(void)
+{
+    script_loaded = true;
+    run_ms = host_env_int("HOST_RUN_MS", 0);
+
+    const char * path = getenv("HOST_TOUCH_SCRIPT");
+    if(path == NULL || path[0] == '\0') return;
+
+    FILE * f = fopen(path, "r");
+    if(f == NULL) {
+        fprintf(stderr, "[host] can't open the touch script %s\n", path);
+        return;
+    }
+
+    char line[128];
+    uint32_t line_no = 0;
+    while(fgets(line, sizeof(line), f) && script_len < SCRIPT_MAX) {
+        line_no++;
+        char * p = line;
+        while(*p == ' ' || *p == '\t') p++;
+        if(*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+
+        touch_event_t * e = &script[script_len];
+        memset(e, 0, sizeof(touch_event_t));
+        char action[16];
+        int x = 0, y = 0, x2 = 0, y2 = 0, dur = 0;
+        unsigned int t;
+        int n = sscanf(p, "%u %15s", &t, action);
+        if(n == 2) p = strstr(p, action) + strlen(action);
+        e->time = t;
+        if(n == 2 && strcmp(action, "press") == 0 && sscanf(p, "%d %d", &x, &y) == 2) {
+            e->action = TOUCH_PRESS;
+            e->x = x;
+            e->y = y;
+        }
+        else if(n == 2 && strcmp(action, "drag") == 0 && sscanf(p, "%d %d %d %d %d", &x, &y, &x2, &y2, &dur) == 5) {
+            /*A press at every DRAG_STEP ms on the line*/
+            int steps = dur / DRAG_STEP;
+            if(steps < 1) steps = 1;
+            int i;
+            for(i = 0; i <= steps && script_len < SCRIPT_MAX; i++) {
+                e = &script[script_len];
+                memset(e, 0, sizeof(touch_event_t));
+                e->action = TOUCH_PRESS;
+                e->time = t + i * dur / steps;
+                e->x = x + (x2 - x) * i / steps;
+                e->y = y + (y2 - y) * i / steps;
+                script_len++;
+            }
+            continue;
+        }
+        else if(n == 2 && strcmp(action, "mark") == 0 && sscanf(p, "%23s", e->name) == 1) {
+            e->action = TOUCH_MARK;
+        }
+        else if(n == 2 && strcmp(action, "release") == 0) {
+            e->action = TOUCH_RELEASE;
+        }
+        else if(n == 2 && strcmp(action, "quit") == 0) {
+            e->action = TOUCH_QUIT;
+        }
+        else {
+            fprintf(stderr, "[host] %s:%u: invalid touch event\n", path, line_no);
+            continue;
+        }
+        script_len++;
+    }
+    fclose(f);
+
+    printf("[host] %u touch events loaded from %s\n", script_len, path);
+}
+
+/*Inverse of xpt2046_corr()*/
+static uint16_t screen_to_raw(int32_t v, int32_t res, int32_t min, int32_t max, bool inv)
+{
+    if(inv) v = res - v;
+    return min + (v * (max - min) + res - 1) / res;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file host_wifi.c
+ * Fake wireless interface and shell commands. The scans and the link of the interface are answered by
+ * host_nl80211.c, its addresses by host_rtnl.c and the connections by host_nm.cpp. `system` is wrapped
+ * at link time (see host.mk), so the host build never runs shutdown or reboot.
+ */
+
+#define _GNU_SOURCE
+#include "host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+static pthread_mutex_t wifi_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char connected_ssid[33];
+static bool is_initialized = false;
+
+int __wrap_system(const char * command);
+
+static void init(void);
+
+bool host_wifi_is_connected(const char * ssid)
+{
+    pthread_mutex_lock(&wifi_mutex);
+    init();
+    bool res = ssid ? ssid[0] != '\0' && strcmp(ssid, connected_ssid) == 0 : connected_ssid[0] != '\0';
+    pthread_mutex_unlock(&wifi_mutex);
+    return res;
+}
+
+void host_wifi_get_connected(char * ssid, uint32_t size)
+{
+    pthread_mutex_lock(&wifi_mutex);
+    init();
+    snprintf(ssid, size, "%s", connected_ssid);
+    pthread_mutex_unlock(&wifi_mutex);
+}
+
+/*The kernel tells the monitors when the link goes down or comes up*/
+void host_wifi_set_connected(const char * ssid)
+{
+    pthread_mutex_lock(&wifi_mutex);
+    init();
+    bool was_connected = connected_ssid[0] != '\0';
+    bool changed = strcmp(ssid, connected_ssid) != 0;
+    snprintf(connected_ssid, sizeof(connected_ssid), "%s", ssid);
+    pthread_mutex_unlock(&wifi_mutex);
+    if(!changed) return;
+
+    if(was_connected) {
+        host_nl80211_notify_link(false);
+        host_rtnl_notify_link(false);
+    }
+    if(ssid[0] != '\0') {
+        host_nl80211_notify_link(true);
+        host_rtnl_notify_link(true);
+    }
+}
+int __wrap_system(const char * command)
+{
+    printf("[host] system(\"%s\")\n", command);
+
+    /*Power buttons end the run*/
+    if(strstr(command, "shutdown") || strstr(command, "reboot")) exit(0);
+
+    return 0;
+}
+
+/*The network connected at the start, call with wifi_mutex locked*/
+static void init(void)
+{
+    if(is_initialized) return;
+    is_initialized = true;
+
+    const char * ssid = getenv("HOST_WIFI_CONNECTED");
+    snprintf(connected_ssid, sizeof(connected_ssid), "%s", ssid ? ssid : "HomeNet");
+}
+
+/*The index of a network in HOST_WIFI_SSIDS, -1: not found*/
+int host_wifi_find(const char * ssid)
+{
+    const char * list = getenv("HOST_WIFI_SSIDS");
+    if(list == NULL) list = HOST_WIFI_DEF_SSIDS;
+
+    size_t len = strlen(ssid);
+    if(len == 0) return -1;
+
+    const char * p = list;
+    int i = 0;
+    while(p) {
+        const char * end = strchr(p, ',');
+        size_t item_len = end ? (size_t)(end - p) : strlen(p);
+        if(item_len == len && strncmp(p, ssid, len) == 0) return i;
+        p = end ? end + 1 : NULL;
+        i++;
+    }
+    return -1;
+}
+
+bool host_wifi_is_visible(const char * ssid)
+{
+    return host_wifi_find(ssid) >= 0;
+}
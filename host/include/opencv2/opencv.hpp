@@ -0,0 +1,183 @@
+/**
+ * @file opencv.hpp
+ * Host stand-in for the subset of OpenCV used by devices/opencv.
+ *
+ * `VideoCapture` produces synthetic 640x480 BGR frames: a gradient background with a
+ * red disc moving around, so the red object detection has something to find.
+ * The image processing functions are plain (unoptimized) implementations for 8 bit images.
+ * `findContours` reports each connected component as its bounding box.
+ */
+
+#ifndef HOST_OPENCV_HPP
+#define HOST_OPENCV_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef int64_t int64;
+
+#define CV_8UC1     0
+#define CV_8UC2     8
+#define CV_8UC3     16
+
+namespace cv
+{
+
+enum {
+    COLOR_BGR2HSV = 40,
+    COLOR_BGR2BGR565 = 12,
+};
+
+enum {
+    MORPH_ERODE = 0,
+    MORPH_DILATE = 1,
+    MORPH_OPEN = 2,
+    MORPH_CLOSE = 3,
+};
+
+enum {
+    MORPH_RECT = 0,
+};
+
+enum {
+    RETR_EXTERNAL = 0,
+};
+
+enum {
+    CHAIN_APPROX_SIMPLE = 2,
+};
+
+enum {
+    FONT_HERSHEY_SIMPLEX = 0,
+};
+
+struct Size {
+    int width;
+    int height;
+    Size() : width(0), height(0) {}
+    Size(int w, int h) : width(w), height(h) {}
+};
+
+struct Point {
+    int x;
+    int y;
+    Point() : x(0), y(0) {}
+    Point(int x_, int y_) : x(x_), y(y_) {}
+};
+
+struct Rect {
+    int x;
+    int y;
+    int width;
+    int height;
+    Rect() : x(0), y(0), width(0), height(0) {}
+    Rect(int x_, int y_, int w, int h) : x(x_), y(y_), width(w), height(h) {}
+};
+
+struct Scalar {
+    double val[4];
+    Scalar(double v0 = 0, double v1 = 0, double v2 = 0, double v3 = 0)
+    {
+        val[0] = v0;
+        val[1] = v1;
+        val[2] = v2;
+        val[3] = v3;
+    }
+};
+
+class Mat
+{
+public:
+    int rows;
+    int cols;
+    uint8_t * data;
+
+    Mat() : rows(0), cols(0), data(nullptr), type_(CV_8UC1) {}
+    Mat(int rows_, int cols_, int type) : Mat()
+    {
+        create(rows_, cols_, type);
+    }
+
+    void create(int rows_, int cols_, int type)
+    {
+        if(buf_ && rows == rows_ && cols == cols_ && type_ == type) return;
+        rows = rows_;
+        cols = cols_;
+        type_ = type;
+        buf_ = std::make_shared<std::vector<uint8_t>>((size_t)rows * cols * channels());
+        data = buf_->data();
+    }
+
+    bool empty() const
+    {
+        return data == nullptr;
+    }
+    int type() const
+    {
+        return type_;
+    }
+    int channels() const
+    {
+        return (type_ >> 3) + 1;
+    }
+    size_t total() const
+    {
+        return (size_t)rows * cols;
+    }
+    template<typename T> T * ptr(int row)
+    {
+        return (T *)(data + (size_t)row * cols * channels());
+    }
+    template<typename T> const T * ptr(int row) const
+    {
+        return (const T *)(data + (size_t)row * cols * channels());
+    }
+
+private:
+    int type_;
+    std::shared_ptr<std::vector<uint8_t>> buf_;
+};
+
+Mat operator|(const Mat & a, const Mat & b);
+
+class VideoCapture
+{
+public:
+    VideoCapture() : opened_(false), frame_idx_(0), next_frame_us_(0) {}
+    bool open(int index);
+    bool isOpened() const
+    {
+        return opened_;
+    }
+    void release()
+    {
+        opened_ = false;
+    }
+    VideoCapture & operator>>(Mat & image);
+
+private:
+    bool opened_;
+    uint32_t frame_idx_;
+    int64 next_frame_us_;
+};
+
+void resize(const Mat & src, Mat & dst, Size dsize);
+void cvtColor(const Mat & src, Mat & dst, int code);
+void inRange(const Mat & src, const Scalar & lowerb, const Scalar & upperb, Mat & dst);
+Mat getStructuringElement(int shape, Size ksize);
+void morphologyEx(const Mat & src, Mat & dst, int op, const Mat & kernel);
+void findContours(const Mat & image, std::vector<std::vector<Point>> & contours, int mode, int method);
+double contourArea(const std::vector<Point> & contour);
+Rect boundingRect(const std::vector<Point> & points);
+void rectangle(Mat & img, Rect rec, const Scalar & color, int thickness = 1);
+void putText(Mat & img, const std::string & text, Point org, int font_face, double font_scale,
+             Scalar color, int thickness = 1);
+std::string format(const char * fmt, ...);
+int64 getTickCount();
+double getTickFrequency();
+
+} /*namespace cv*/
+
+#endif /*HOST_OPENCV_HPP*/
@@ -0,0 +1,33 @@
+/**
+ * @file wiringPi.h
+ * Host stand-in for the wiringPi GPIO API.
+ * The pins are routed to the emulated devices in host_gpio.c.
+ */
+
+#ifndef HOST_WIRINGPI_H
+#define HOST_WIRINGPI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INPUT   0
+#define OUTPUT  1
+
+#define LOW     0
+#define HIGH    1
+
+int wiringPiSetupGpio(void);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+void delay(unsigned int ms);
+void delayMicroseconds(unsigned int us);
+unsigned int millis(void);
+unsigned int micros(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*HOST_WIRINGPI_H*/
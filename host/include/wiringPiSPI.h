@@ -0,0 +1,22 @@
+/**
+ * @file wiringPiSPI.h
+ * Host stand-in for the wiringPi SPI API.
+ * Everything written to the bus goes to the emulated panel in host_panel.c.
+ */
+
+#ifndef HOST_WIRINGPISPI_H
+#define HOST_WIRINGPISPI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int wiringPiSPISetup(int channel, int speed);
+int wiringPiSPISetupMode(int channel, int speed, int mode);
+int wiringPiSPIDataRW(int channel, unsigned char * data, int len);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*HOST_WIRINGPISPI_H*/
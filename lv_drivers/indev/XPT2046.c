@@ -99,6 +99,7 @@ void xpt2046_read(lv_indev_drv_t * indev_drv, lv_indev_data_t * data)
     uint8_t irq = digitalRead(IRQ_PIN);
 
     if(irq == 0) {
+        LV_TRACE_BEGIN("xpt2046_spi");
         digitalWrite(CS_PIN, 0);
 
         xpt2046_transferByte(CMD_X_READ);         /*Start x read*/
@@ -125,6 +126,7 @@ void xpt2046_read(lv_indev_drv_t * indev_drv, lv_indev_data_t * data)
 		data->state = LV_INDEV_STATE_PR;
 
         digitalWrite(CS_PIN, 1);
+        LV_TRACE_END("xpt2046_spi");
     } else {
         x = last_x;
         y = last_y;
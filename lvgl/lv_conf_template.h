@@ -83,6 +83,10 @@
 /*Input device read period in milliseconds*/
 #define LV_INDEV_DEF_READ_PERIOD 30     /*[ms]*/
 
+/*Keep the timers in a min-heap ordered by their deadline instead of checking all of them in every
+ *`lv_timer_handler()` call. The handler returns the exact time until the next timer is due.*/
+#define LV_USE_TIMER_HEAP 0
+
 /*Use a custom tick source that tells the elapsed time in milliseconds.
  *It removes the need to manually update the tick with `lv_tick_inc()`)*/
 #define LV_TICK_CUSTOM 0
@@ -113,14 +117,22 @@
 
     /*Allow buffering some shadow calculation.
     *LV_SHADOW_CACHE_SIZE is the max. shadow size to buffer, where shadow size is `shadow_width + radius`
-    *Caching has LV_SHADOW_CACHE_SIZE^2 RAM cost*/
+    *Caching has shadow size^2 RAM cost per buffered shadow*/
     #define LV_SHADOW_CACHE_SIZE 0
+    #if LV_SHADOW_CACHE_SIZE
+        /*Memory budget of the buffered shadows [bytes], a static buffer. The least recently used ones are dropped above it.*/
+        #define LV_SHADOW_CACHE_MEM_SIZE (LV_SHADOW_CACHE_SIZE * LV_SHADOW_CACHE_SIZE)
+    #endif
 
     /* Set number of maximally cached circle data.
     * The circumference of 1/4 circle are saved for anti-aliasing
-    * radius * 4 bytes are used per circle (the most often used radiuses are saved)
+    * radius * 6 + 6 bytes are used per circle (the most recently used radiuses are saved)
     * 0: to disable caching */
     #define LV_CIRCLE_CACHE_SIZE 4
+    #if LV_CIRCLE_CACHE_SIZE
+        /*Memory budget of the cached circles [bytes], a static buffer. The least recently used ones are dropped above it.*/
+        #define LV_CIRCLE_CACHE_MEM_SIZE (LV_CIRCLE_CACHE_SIZE * 256)
+    #endif
 #endif /*LV_DRAW_COMPLEX*/
 
 /**
@@ -172,6 +184,22 @@
  *Only used if software rotation is enabled in the display driver.*/
 #define LV_DISP_ROT_MAX_BUF (10*1024)
 
+/*Allow rendering objects with `LV_OBJ_FLAG_CACHE_BITMAP` once into a cached RGB565(+alpha) bitmap
+ *and redrawing them by blitting the bitmap. The bitmap is re-rendered when the object or its children change.*/
+#define LV_USE_BITMAP_CACHE 0
+#if LV_USE_BITMAP_CACHE
+    /*Memory budget of all cached bitmaps [bytes]. The least recently used bitmaps are evicted above it.*/
+    #define LV_BITMAP_CACHE_SIZE (64 * 1024)
+#endif
+
+/*Skip drawing objects (or the parts of them) which are fully covered by opaque objects drawn later.
+ *Only objects without intermediate layers are considered. It saves blending on stacked panels.*/
+#define LV_USE_OCCLUSION_CULLING 0
+#if LV_USE_OCCLUSION_CULLING
+    /*Max number of opaque objects considered as occluders per refreshed area. The largest ones are kept.*/
+    #define LV_OCCLUSION_MAX_OCCLUDERS 16
+#endif
+
 /*-------------
  * GPU
  *-----------*/
@@ -294,6 +322,28 @@
 /*1: Draw random colored rectangles over the redrawn areas*/
 #define LV_USE_REFR_DEBUG 0
 
+/*1: Record the rendering, flushing, input reading, timers and worker threads into per thread
+ *ring buffers. `lv_trace_dump()` saves them as Chrome trace JSON (Perfetto). Requires POSIX threads*/
+#define LV_USE_TRACE 0
+#if LV_USE_TRACE
+    /*Number of events kept per thread, the oldest ones are overwritten (power of 2)*/
+    #define LV_TRACE_BUF_SIZE 8192
+
+    /*Max. number of threads with a ring buffer*/
+    #define LV_TRACE_THREAD_MAX 16
+#endif
+
+/*1: Charge the redrawn pixels and flushed bytes to the objects and call sites which invalidated them.
+ *`lv_redraw_prof_dump()` saves the ranking as JSON. Records a call stack per invalidation, so use it for profiling only*/
+#define LV_USE_REDRAW_PROF 0
+#if LV_USE_REDRAW_PROF
+    /*Max. number of different object + call stack pairs*/
+    #define LV_REDRAW_PROF_ENTRIES 256
+
+    /*Number of return addresses saved per invalidation*/
+    #define LV_REDRAW_PROF_STACK_DEPTH 12
+#endif
+
 /*Change the built in (v)snprintf functions*/
 #define LV_SPRINTF_CUSTOM 0
 #if LV_SPRINTF_CUSTOM
@@ -498,6 +548,13 @@
 #define LV_USE_ROLLER     1   /*Requires: lv_label*/
 #if LV_USE_ROLLER
     #define LV_ROLLER_INF_PAGES 7 /*Number of extra "pages" when the roller is infinite*/
+
+    /*Render the visible options and some rows around them into 8 bit alpha strips (one with the normal and one
+     *with the selected style) and only blend them while scrolling. They are re-rendered when the scroll leaves the
+     *rendered rows or the options, the size or the font change.*/
+    #define LV_ROLLER_STRIP 0
+    /*Size limit of a strip [bytes] (1 byte/pixel). It limits the rendered rows, a larger visible area is drawn as text*/
+    #define LV_ROLLER_STRIP_MAX_SIZE (64 * 1024)
 #endif
 
 #define LV_USE_SLIDER     1   /*Requires: lv_bar*/
@@ -29,6 +29,7 @@ extern "C" {
 #include "src/misc/lv_async.h"
 #include "src/misc/lv_anim_timeline.h"
 #include "src/misc/lv_printf.h"
+#include "src/misc/lv_trace.h"
 
 #include "src/hal/lv_hal.h"
 
@@ -38,6 +39,8 @@ extern "C" {
 #include "src/core/lv_refr.h"
 #include "src/core/lv_disp.h"
 #include "src/core/lv_theme.h"
+#include "src/core/lv_bitmap_cache.h"
+#include "src/core/lv_redraw_prof.h"
 
 #include "src/font/lv_font.h"
 #include "src/font/lv_font_loader.h"
@@ -0,0 +1,357 @@
+/**
+ * @file lv_bitmap_cache.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_bitmap_cache.h"
+#if LV_USE_BITMAP_CACHE
+
+#include "lv_disp.h"
+#include "lv_refr.h"
+#include "../misc/lv_ll.h"
+#include "../misc/lv_mem.h"
+#include "../draw/lv_draw.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#if LV_COLOR_DEPTH != 16 && LV_COLOR_DEPTH != 32
+    #error "LV_USE_BITMAP_CACHE requires LV_COLOR_DEPTH 16 or 32"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    const lv_obj_t * obj;
+    lv_img_dsc_t img;           /*The rendered surface. `img.data == NULL` if outdated*/
+    lv_coord_t ext_size;        /*The extra draw size used when the surface was rendered*/
+    lv_area_t coords;           /*Where the surface was rendered*/
+    bool masked;                /*The masks of the ancestors (e.g. `clip_corner`) are baked into the surface*/
+} bitmap_entry_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bitmap_entry_t * find_entry(const lv_obj_t * obj);
+static void free_surface(bitmap_entry_t * entry);
+static void drop_entry(bitmap_entry_t * entry);
+static bool make_room(uint32_t size, const bitmap_entry_t * keep);
+static lv_res_t render_surface(bitmap_entry_t * entry, lv_obj_t * obj);
+static void compact_if_opaque(bitmap_entry_t * entry);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_ll_t entry_ll;        /*Most recently used entry is the head*/
+static lv_bitmap_cache_stats_t stats;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void _lv_bitmap_cache_init(void)
+{
+    _lv_ll_init(&entry_ll, sizeof(bitmap_entry_t));
+    lv_memset_00(&stats, sizeof(stats));
+    stats.max_size = LV_BITMAP_CACHE_SIZE;
+}
+
+void lv_bitmap_cache_set_size(uint32_t size)
+{
+    stats.max_size = size;
+    make_room(0, NULL);
+}
+
+void lv_bitmap_cache_clear(void)
+{
+    bitmap_entry_t * entry = _lv_ll_get_head(&entry_ll);
+    while(entry) {
+        bitmap_entry_t * next = _lv_ll_get_next(&entry_ll, entry);
+        drop_entry(entry);
+        entry = next;
+    }
+}
+
+void lv_bitmap_cache_get_stats(lv_bitmap_cache_stats_t * stats_out)
+{
+    LV_ASSERT_NULL(stats_out);
+    *stats_out = stats;
+}
+
+void lv_bitmap_cache_reset_stats(void)
+{
+    stats.hit_cnt = 0;
+    stats.miss_cnt = 0;
+    stats.inv_cnt = 0;
+    stats.evict_cnt = 0;
+    stats.reject_cnt = 0;
+}
+
+lv_res_t _lv_bitmap_cache_draw(lv_draw_ctx_t * draw_ctx, lv_obj_t * obj)
+{
+    if(stats.max_size == 0) return LV_RES_INV;
+
+    /*Children drawn out of the object can't be captured in a surface of the object's size*/
+    if(lv_obj_has_flag(obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE)) return LV_RES_INV;
+
+    lv_coord_t ext_size = _lv_obj_get_ext_draw_size(obj);
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+    lv_area_increase(&coords, ext_size, ext_size);
+
+    /*Nothing to draw on this clip area; don't even render it*/
+    lv_area_t clip_area;
+    if(!_lv_area_intersect(&clip_area, draw_ctx->clip_area, &coords)) return LV_RES_OK;
+
+    bitmap_entry_t * entry = find_entry(obj);
+    if(entry == NULL) {
+        entry = _lv_ll_ins_head(&entry_ll);
+        LV_ASSERT_MALLOC(entry);
+        if(entry == NULL) return LV_RES_INV;
+        lv_memset_00(entry, sizeof(bitmap_entry_t));
+        entry->obj = obj;
+        stats.entry_cnt++;
+    }
+    else if(_lv_ll_get_head(&entry_ll) != entry) {
+        _lv_ll_move_before(&entry_ll, entry, _lv_ll_get_head(&entry_ll));
+    }
+
+    /*Moving keeps the content valid, but resizing doesn't.
+     *Masks stay in place when the object moves (e.g. scrolls in a rounded parent) so a masked surface is outdated too*/
+    if(entry->img.data &&
+       (entry->ext_size != ext_size ||
+        (entry->masked && !_lv_area_is_equal(&entry->coords, &coords)) ||
+        entry->img.header.w != lv_area_get_width(&coords) ||
+        entry->img.header.h != lv_area_get_height(&coords))) {
+        free_surface(entry);
+        stats.inv_cnt++;
+    }
+
+    if(entry->img.data) {
+        stats.hit_cnt++;
+    }
+    else {
+        stats.miss_cnt++;
+        if(render_surface(entry, obj) != LV_RES_OK) {
+            stats.reject_cnt++;
+            drop_entry(entry);
+            return LV_RES_INV;
+        }
+    }
+
+    lv_draw_img_dsc_t dsc;
+    lv_draw_img_dsc_init(&dsc);
+    dsc.antialias = 0;
+
+    const lv_area_t * clip_area_ori = draw_ctx->clip_area;
+    draw_ctx->clip_area = &clip_area;
+    draw_ctx->draw_img_decoded(draw_ctx, &dsc, &coords, entry->img.data, entry->img.header.cf);
+    draw_ctx->clip_area = clip_area_ori;
+
+    return LV_RES_OK;
+}
+
+void _lv_bitmap_cache_obj_invalidated(const lv_obj_t * obj)
+{
+    if(_lv_ll_is_empty(&entry_ll)) return;
+
+    while(obj) {
+        if(lv_obj_has_flag(obj, LV_OBJ_FLAG_CACHE_BITMAP)) {
+            bitmap_entry_t * entry = find_entry(obj);
+            if(entry && entry->img.data) {
+                free_surface(entry);
+                stats.inv_cnt++;
+            }
+        }
+        obj = lv_obj_get_parent(obj);
+    }
+}
+
+void _lv_bitmap_cache_mask_changed(const lv_obj_t * obj)
+{
+    bitmap_entry_t * entry;
+    _LV_LL_READ(&entry_ll, entry) {
+        /*Check the unmasked surfaces too: the object might add a mask now*/
+        if(entry->img.data == NULL) continue;
+
+        const lv_obj_t * parent = lv_obj_get_parent(entry->obj);
+        while(parent && parent != obj) parent = lv_obj_get_parent(parent);
+        if(parent) {
+            free_surface(entry);
+            stats.inv_cnt++;
+        }
+    }
+}
+
+void _lv_bitmap_cache_drop(const lv_obj_t * obj)
+{
+    bitmap_entry_t * entry = find_entry(obj);
+    if(entry) drop_entry(entry);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bitmap_entry_t * find_entry(const lv_obj_t * obj)
+{
+    bitmap_entry_t * entry;
+    _LV_LL_READ(&entry_ll, entry) {
+        if(entry->obj == obj) return entry;
+    }
+
+    return NULL;
+}
+
+static void free_surface(bitmap_entry_t * entry)
+{
+    if(entry->img.data == NULL) return;
+
+    if(entry->img.header.cf == LV_IMG_CF_TRUE_COLOR) stats.opaque_cnt--;
+    stats.used_size -= entry->img.data_size;
+    lv_mem_free((void *)entry->img.data);
+    entry->img.data = NULL;
+    entry->img.data_size = 0;
+}
+
+static void drop_entry(bitmap_entry_t * entry)
+{
+    free_surface(entry);
+    _lv_ll_remove(&entry_ll, entry);
+    lv_mem_free(entry);
+    stats.entry_cnt--;
+}
+
+/**
+ * Evict the least recently used surfaces until `size` more bytes fit into the budget.
+ * @param size      the number of bytes to make room for
+ * @param keep      an entry which shouldn't be evicted (can be NULL)
+ * @return          true: `size` bytes fit now
+ */
+static bool make_room(uint32_t size, const bitmap_entry_t * keep)
+{
+    if(size > stats.max_size) return false;
+
+    bitmap_entry_t * entry = _lv_ll_get_tail(&entry_ll);
+    while(entry && stats.used_size + size > stats.max_size) {
+        bitmap_entry_t * prev = _lv_ll_get_prev(&entry_ll, entry);
+        if(entry != keep && entry->img.data) {
+            stats.evict_cnt++;
+            drop_entry(entry);
+        }
+        entry = prev;
+    }
+
+    return stats.used_size + size <= stats.max_size;
+}
+
+/**
+ * Render an object and its children into a new RGB565+alpha surface.
+ * Works like `lv_snapshot_take_to_buf` but during rendering too.
+ */
+static lv_res_t render_surface(bitmap_entry_t * entry, lv_obj_t * obj)
+{
+    lv_coord_t ext_size = _lv_obj_get_ext_draw_size(obj);
+    lv_area_t area;
+    lv_obj_get_coords(obj, &area);
+    lv_area_increase(&area, ext_size, ext_size);
+
+    uint32_t size = lv_area_get_size(&area) * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    if(!make_room(size, entry)) return LV_RES_INV;
+
+    uint8_t * buf = lv_mem_alloc(size);
+    if(buf == NULL) {
+        LV_LOG_WARN("couldn't allocate %"LV_PRIu32" bytes for a cached bitmap", size);
+        return LV_RES_INV;
+    }
+    lv_memset_00(buf, size);
+
+    lv_disp_t * obj_disp = lv_obj_get_disp(obj);
+    lv_disp_drv_t driver;
+    lv_disp_drv_init(&driver);
+    driver.hor_res = lv_disp_get_hor_res(obj_disp);
+    driver.ver_res = lv_disp_get_ver_res(obj_disp);
+    lv_disp_drv_use_generic_set_px_cb(&driver, LV_IMG_CF_TRUE_COLOR_ALPHA);
+
+    lv_disp_t fake_disp;
+    lv_memset_00(&fake_disp, sizeof(lv_disp_t));
+    fake_disp.driver = &driver;
+
+    lv_draw_ctx_t * draw_ctx = lv_mem_alloc(obj_disp->driver->draw_ctx_size);
+    LV_ASSERT_MALLOC(draw_ctx);
+    if(draw_ctx == NULL) {
+        lv_mem_free(buf);
+        return LV_RES_INV;
+    }
+    obj_disp->driver->draw_ctx_init(&driver, draw_ctx);
+    driver.draw_ctx = draw_ctx;
+    draw_ctx->clip_area = &area;
+    draw_ctx->buf_area = &area;
+    draw_ctx->buf = buf;
+
+    lv_disp_t * refr_ori = _lv_refr_get_disp_refreshing();
+    _lv_refr_set_disp_refreshing(&fake_disp);
+
+    /*The masks of the ancestors are global, so they clip the surface too.
+     *The clip area is not baked in: the surface always covers the whole object*/
+    entry->masked = lv_draw_mask_is_any(&area);
+    entry->coords = area;
+
+    lv_obj_redraw(draw_ctx, obj);
+    lv_draw_wait_for_finish(draw_ctx);
+
+    _lv_refr_set_disp_refreshing(refr_ori);
+    obj_disp->driver->draw_ctx_deinit(&driver, draw_ctx);
+    lv_mem_free(draw_ctx);
+
+    entry->ext_size = ext_size;
+    entry->img.header.always_zero = 0;
+    entry->img.header.w = lv_area_get_width(&area);
+    entry->img.header.h = lv_area_get_height(&area);
+    entry->img.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    entry->img.data_size = size;
+    entry->img.data = buf;
+    stats.used_size += size;
+
+    compact_if_opaque(entry);
+
+    return LV_RES_OK;
+}
+
+/**
+ * Drop the alpha channel if every pixel is fully opaque.
+ * Such surfaces are blitted by plain copy instead of per-pixel blending.
+ */
+static void compact_if_opaque(bitmap_entry_t * entry)
+{
+    uint8_t * buf = (uint8_t *)entry->img.data;
+    uint32_t px_cnt = (uint32_t)entry->img.header.w * entry->img.header.h;
+    uint32_t i;
+    for(i = 0; i < px_cnt; i++) {
+        if(buf[i * LV_IMG_PX_SIZE_ALPHA_BYTE + LV_IMG_PX_SIZE_ALPHA_BYTE - 1] != LV_OPA_COVER) return;
+    }
+
+    for(i = 0; i < px_cnt; i++) {
+        lv_memcpy_small(&buf[i * sizeof(lv_color_t)], &buf[i * LV_IMG_PX_SIZE_ALPHA_BYTE], sizeof(lv_color_t));
+    }
+
+    uint32_t new_size = px_cnt * sizeof(lv_color_t);
+    uint8_t * new_buf = lv_mem_realloc(buf, new_size);
+    if(new_buf) buf = new_buf;
+
+    stats.used_size -= entry->img.data_size - new_size;
+    stats.opaque_cnt++;
+    entry->img.header.cf = LV_IMG_CF_TRUE_COLOR;
+    entry->img.data_size = new_size;
+    entry->img.data = buf;
+}
+
+#endif /*LV_USE_BITMAP_CACHE*/
@@ -0,0 +1,117 @@
+/**
+ * @file lv_bitmap_cache.h
+ *
+ */
+
+#ifndef LV_BITMAP_CACHE_H
+#define LV_BITMAP_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_obj.h"
+
+#if LV_USE_BITMAP_CACHE
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/*Like the rest of LVGL the cache is not thread safe: call its functions and
+ *invalidate cached objects only from the thread running `lv_timer_handler()`*/
+
+/**
+ * Statistics of the bitmap cache.
+ */
+typedef struct {
+    uint32_t hit_cnt;       /**< Redraws served by blitting a cached surface*/
+    uint32_t miss_cnt;      /**< Redraws which had to (re)render the subtree into the cache*/
+    uint32_t inv_cnt;       /**< Cached surfaces dropped because the subtree changed*/
+    uint32_t evict_cnt;     /**< Cached surfaces dropped to stay within the memory budget*/
+    uint32_t reject_cnt;    /**< Objects that couldn't be cached (too large or out of memory)*/
+    uint32_t entry_cnt;     /**< Number of cached surfaces currently stored*/
+    uint32_t opaque_cnt;    /**< Number of cached surfaces without alpha channel (pure copy on blit)*/
+    uint32_t used_size;     /**< Bytes used by the cached surfaces*/
+    uint32_t max_size;      /**< The memory budget in bytes*/
+} lv_bitmap_cache_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Initialize the bitmap cache. Called by `lv_init()`.
+ */
+void _lv_bitmap_cache_init(void);
+
+/**
+ * Set the memory budget of the bitmap cache.
+ * Surfaces are evicted in least recently used order if the new budget is smaller.
+ * @param size      the budget in bytes. 0: disable caching and free all surfaces
+ */
+void lv_bitmap_cache_set_size(uint32_t size);
+
+/**
+ * Drop all cached surfaces.
+ */
+void lv_bitmap_cache_clear(void);
+
+/**
+ * Get the statistics of the bitmap cache
+ * @param stats     store the result here
+ */
+void lv_bitmap_cache_get_stats(lv_bitmap_cache_stats_t * stats);
+
+/**
+ * Reset the hit/miss/invalidation/eviction counters.
+ */
+void lv_bitmap_cache_reset_stats(void);
+
+/**
+ * Draw an object with the `LV_OBJ_FLAG_CACHE_BITMAP` flag from its cached surface.
+ * Renders the object and its children into the cache first if needed.
+ * @param draw_ctx  pointer to the current draw context
+ * @param obj       pointer to an object with the `LV_OBJ_FLAG_CACHE_BITMAP` flag
+ * @return          LV_RES_OK: the object was drawn; LV_RES_INV: it couldn't be cached, draw it normally
+ */
+lv_res_t _lv_bitmap_cache_draw(lv_draw_ctx_t * draw_ctx, lv_obj_t * obj);
+
+/**
+ * Tell the cache that an object was invalidated.
+ * Marks the surface of the object and the surfaces of all its cached ancestors as outdated.
+ * @param obj       pointer to the invalidated object
+ */
+void _lv_bitmap_cache_obj_invalidated(const lv_obj_t * obj);
+
+/**
+ * Tell the cache that the masks an object applies on its children changed (e.g. its radius, `clip_corner` or size).
+ * Marks the surfaces of the cached descendants as outdated.
+ * @param obj       pointer to the object whose masks changed
+ */
+void _lv_bitmap_cache_mask_changed(const lv_obj_t * obj);
+
+/**
+ * Free the cached surface of an object (if any)
+ * @param obj       pointer to an object
+ */
+void _lv_bitmap_cache_drop(const lv_obj_t * obj);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif /*LV_USE_BITMAP_CACHE*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_BITMAP_CACHE_H*/
@@ -1,3 +1,5 @@
+CSRCS += lv_bitmap_cache.c
+CSRCS += lv_redraw_prof.c
 CSRCS += lv_disp.c
 CSRCS += lv_group.c
 CSRCS += lv_indev.c
@@ -15,6 +15,7 @@
 
 #include "../hal/lv_hal_tick.h"
 #include "../misc/lv_timer.h"
+#include "../misc/lv_trace.h"
 #include "../misc/lv_math.h"
 
 /*********************
@@ -80,13 +81,20 @@ void lv_indev_read_timer_cb(lv_timer_t * timer)
     bool continue_reading;
     do {
         /*Read the data*/
+        LV_TRACE_BEGIN("indev_read");
         _lv_indev_read(indev_act, &data);
+        LV_TRACE_END("indev_read");
         continue_reading = data.continue_reading;
 
         /*The active object might be deleted even in the read function*/
         indev_proc_reset_query_handler(indev_act);
         indev_obj_act = NULL;
 
+#if LV_USE_TRACE
+        if(data.state != indev_act->proc.state) {
+            LV_TRACE_INSTANT(data.state == LV_INDEV_STATE_PRESSED ? "pressed" : "released");
+        }
+#endif
         indev_act->proc.state = data.state;
 
         /*Save the last activity time*/
@@ -12,6 +12,8 @@
 #include "lv_group.h"
 #include "lv_disp.h"
 #include "lv_theme.h"
+#include "lv_bitmap_cache.h"
+#include "lv_redraw_prof.h"
 #include "../misc/lv_assert.h"
 #include "../draw/lv_draw.h"
 #include "../misc/lv_anim.h"
@@ -145,6 +147,9 @@ void lv_init(void)
     _lv_refr_init();
 
     _lv_img_decoder_init();
+#if LV_USE_BITMAP_CACHE
+    _lv_bitmap_cache_init();
+#endif
 #if LV_IMG_CACHE_DEF_SIZE
     lv_img_cache_set_size(LV_IMG_CACHE_DEF_SIZE);
 #endif
@@ -277,6 +282,10 @@ void lv_obj_clear_flag(lv_obj_t * obj, lv_obj_flag_t f)
 
     obj->flags &= (~f);
 
+#if LV_USE_BITMAP_CACHE
+    if(f & LV_OBJ_FLAG_CACHE_BITMAP) _lv_bitmap_cache_drop(obj);
+#endif
+
     if(f & LV_OBJ_FLAG_HIDDEN) {
         lv_obj_invalidate(obj);
         if(lv_obj_is_layout_positioned(obj)) {
@@ -461,6 +470,15 @@ static void lv_obj_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
     /*Remove the animations from this object*/
     lv_anim_del(obj, NULL);
 
+#if LV_USE_BITMAP_CACHE
+    /*Free the cached bitmap*/
+    if(lv_obj_has_flag(obj, LV_OBJ_FLAG_CACHE_BITMAP)) _lv_bitmap_cache_drop(obj);
+#endif
+
+#if LV_USE_REDRAW_PROF
+    _lv_redraw_prof_obj_deleted(obj);
+#endif
+
     /*Delete from the group*/
     lv_group_t * group = lv_obj_get_group(obj);
     if(group) lv_group_remove_obj(obj);
@@ -890,6 +908,11 @@ static void lv_obj_set_state(lv_obj_t * obj, lv_state_t new_state)
     lv_state_t prev_state = obj->state;
     obj->state = new_state;
 
+#if LV_USE_BITMAP_CACHE
+    /*The look can depend on the state even if the styles don't (e.g. the image of an image button)*/
+    _lv_bitmap_cache_obj_invalidated(obj);
+#endif
+
     _lv_style_state_cmp_t cmp_res = _lv_obj_style_state_compare(obj, prev_state, new_state);
     /*If there is no difference in styles there is nothing else to do*/
     if(cmp_res == _LV_STYLE_STATE_CMP_SAME) return;
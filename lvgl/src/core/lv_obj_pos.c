@@ -9,6 +9,8 @@
 #include "lv_obj.h"
 #include "lv_disp.h"
 #include "lv_refr.h"
+#include "lv_bitmap_cache.h"
+#include "lv_redraw_prof.h"
 #include "../misc/lv_gc.h"
 
 /*********************
@@ -26,12 +28,14 @@
 static lv_coord_t calc_content_width(lv_obj_t * obj);
 static lv_coord_t calc_content_height(lv_obj_t * obj);
 static void layout_update_core(lv_obj_t * obj);
+static lv_obj_t * mark_layout_path(lv_obj_t * obj);
 static void transform_point(const lv_obj_t * obj, lv_point_t * p, bool inv);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
 static uint32_t layout_cnt;
+static lv_layout_stats_t layout_stats;
 
 /**********************
  *      MACROS
@@ -200,7 +204,13 @@ bool lv_obj_refr_size(lv_obj_t * obj)
     /*Invalidate the new area*/
     lv_obj_invalidate(obj);
 
+#if LV_USE_BITMAP_CACHE
+    /*The radius mask of the children follows the new size*/
+    _lv_bitmap_cache_mask_changed(obj);
+#endif
+
     obj->readjust_scroll_after_layout = 1;
+    mark_layout_path(obj);
 
     /*If the object was out of the parent invalidate the new scrollbar area too.
      *If it wasn't out of the parent but out now, also invalidate the scrollbars*/
@@ -290,7 +300,7 @@ void lv_obj_mark_layout_as_dirty(lv_obj_t * obj)
     obj->layout_inv = 1;
 
     /*Mark the screen as dirty too to mark that there is something to do on this screen*/
-    lv_obj_t * scr = lv_obj_get_screen(obj);
+    lv_obj_t * scr = mark_layout_path(obj);
     scr->scr_layout_inv = 1;
 
     /*Make the display refreshing*/
@@ -313,6 +323,7 @@ void lv_obj_update_layout(const lv_obj_t * obj)
     while(scr->scr_layout_inv) {
         LV_LOG_INFO("Layout update begin");
         scr->scr_layout_inv = 0;
+        layout_stats.passes++;
         layout_update_core(scr);
         LV_LOG_TRACE("Layout update end");
     }
@@ -331,6 +342,11 @@ uint32_t lv_layout_register(lv_layout_update_cb_t cb, void * user_data)
     return layout_cnt;  /*No -1 to skip 0th index*/
 }
 
+void lv_layout_get_stats(lv_layout_stats_t * stats)
+{
+    *stats = layout_stats;
+}
+
 void lv_obj_set_align(lv_obj_t * obj, lv_align_t align)
 {
     lv_obj_set_style_align(obj, align, 0);
@@ -838,6 +854,11 @@ void lv_obj_invalidate_area(const lv_obj_t * obj, const lv_area_t * area)
 {
     LV_ASSERT_OBJ(obj, MY_CLASS);
 
+#if LV_USE_BITMAP_CACHE
+    /*Outdate the cached bitmaps even if the object is not visible or the invalidation is disabled now*/
+    _lv_bitmap_cache_obj_invalidated(obj);
+#endif
+
     lv_disp_t * disp   = lv_obj_get_disp(obj);
     if(!lv_disp_is_invalidation_enabled(disp)) return;
 
@@ -845,7 +866,13 @@ void lv_obj_invalidate_area(const lv_obj_t * obj, const lv_area_t * area)
     lv_area_copy(&area_tmp, area);
     if(!lv_obj_area_is_visible(obj, &area_tmp)) return;
 
+#if LV_USE_REDRAW_PROF
+    _lv_redraw_prof_set_obj(obj);
+#endif
     _lv_inv_area(lv_obj_get_disp(obj),  &area_tmp);
+#if LV_USE_REDRAW_PROF
+    _lv_redraw_prof_set_obj(NULL);
+#endif
 }
 
 void lv_obj_invalidate(const lv_obj_t * obj)
@@ -1130,15 +1157,26 @@ static lv_coord_t calc_content_height(lv_obj_t * obj)
 
 static void layout_update_core(lv_obj_t * obj)
 {
+    layout_stats.visited++;
+
     uint32_t i;
     uint32_t child_cnt = lv_obj_get_child_cnt(obj);
-    for(i = 0; i < child_cnt; i++) {
-        lv_obj_t * child = obj->spec_attr->children[i];
-        layout_update_core(child);
+
+    /*Visit only the children on the path of an invalidated object.
+     *Clear the flag first, so the children marked by the children's layouts are visited in the next pass.*/
+    if(obj->layout_child_inv) {
+        obj->layout_child_inv = 0;
+        for(i = 0; i < child_cnt; i++) {
+            lv_obj_t * child = obj->spec_attr->children[i];
+            if(child->layout_inv || child->layout_child_inv || child->readjust_scroll_after_layout) {
+                layout_update_core(child);
+            }
+        }
     }
 
     if(obj->layout_inv) {
         obj->layout_inv = 0;
+        layout_stats.updated++;
         lv_obj_refr_size(obj);
         lv_obj_refr_pos(obj);
 
@@ -1157,6 +1195,20 @@ static void layout_update_core(lv_obj_t * obj)
     }
 }
 
+/**
+ * Mark the ancestors of an object, so `layout_update_core()` will find it
+ * @param obj       pointer to an object
+ * @return          the screen of the object
+ */
+static lv_obj_t * mark_layout_path(lv_obj_t * obj)
+{
+    while(obj->parent) {
+        obj = obj->parent;
+        obj->layout_child_inv = 1;
+    }
+    return obj;
+}
+
 static void transform_point(const lv_obj_t * obj, lv_point_t * p, bool inv)
 {
     int16_t angle = lv_obj_get_style_transform_angle(obj, 0);
@@ -30,6 +30,12 @@ typedef struct {
     void * user_data;
 } lv_layout_dsc_t;
 
+typedef struct {
+    uint32_t passes;            /**< Number of layout passes (a screen is updated in one or more passes)*/
+    uint32_t visited;           /**< Objects visited by the passes*/
+    uint32_t updated;           /**< Objects whose size, position and layout were recalculated*/
+} lv_layout_stats_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -160,6 +166,13 @@ void lv_obj_update_layout(const struct _lv_obj_t * obj);
  */
 uint32_t lv_layout_register(lv_layout_update_cb_t cb, void * user_data);
 
+/**
+ * Get the number of layout passes and the objects visited by them since the start.
+ * Only the invalidated objects and their ancestors are visited, not the whole screen.
+ * @param stats     store the counters here
+ */
+void lv_layout_get_stats(lv_layout_stats_t * stats);
+
 /**
  * Change the alignment of an object.
  * @param obj       pointer to an object to align
@@ -369,6 +382,8 @@ void lv_obj_get_transformed_area(const struct _lv_obj_t * obj, lv_area_t * area,
 /**
  * Mark an area of an object as invalid.
  * The area will be truncated to the object's area and marked for redraw.
+ * Outdates the cached bitmap of the object and its ancestors too (`LV_OBJ_FLAG_CACHE_BITMAP`),
+ * so call it only from the thread running `lv_timer_handler()`.
  * @param obj       pointer to an object
  * @param           area the area to redraw
  */
@@ -8,6 +8,7 @@
  *********************/
 #include "lv_obj.h"
 #include "lv_disp.h"
+#include "lv_bitmap_cache.h"
 #include "../misc/lv_gc.h"
 
 /*********************
@@ -203,6 +204,14 @@ void lv_obj_refresh_style(lv_obj_t * obj, lv_style_selector_t selector, lv_style
         }
     }
 
+#if LV_USE_BITMAP_CACHE
+    /*The children are clipped with the radius if `clip_corner` is enabled*/
+    if((part == LV_PART_ANY || part == LV_PART_MAIN) &&
+       (prop == LV_STYLE_PROP_ANY || prop == LV_STYLE_RADIUS || prop == LV_STYLE_CLIP_CORNER)) {
+        _lv_bitmap_cache_mask_changed(obj);
+    }
+#endif
+
     if(prop == LV_STYLE_PROP_ANY || is_ext_draw) {
         lv_obj_refresh_ext_draw_size(obj);
     }
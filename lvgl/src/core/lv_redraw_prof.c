@@ -0,0 +1,311 @@
+/**
+ * @file lv_redraw_prof.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_redraw_prof.h"
+#if LV_USE_REDRAW_PROF
+
+#include "lv_disp.h"
+#include "lv_refr.h"
+#include "../widgets/lv_label.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <execinfo.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Invalidations recorded between two refreshes*/
+#define PENDING_MAX     (LV_INV_BUF_SIZE * 4)
+
+/*Frames of the profiler itself on the stack: `_lv_redraw_prof_inv()` and `_lv_inv_area()`*/
+#define STACK_SKIP      2
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    const lv_obj_t * obj;               /*NULL: `_lv_inv_area()` was called directly*/
+    const lv_obj_class_t * class_p;
+    void * stack[LV_REDRAW_PROF_STACK_DEPTH];
+    uint32_t hash;
+    uint32_t inv_cnt;                   /*Number of invalidations*/
+    uint64_t px;                        /*Redrawn pixels charged to this entry*/
+    uint64_t bytes;                     /*Flushed bytes charged to this entry*/
+    uint8_t stack_cnt;
+    uint8_t used : 1;
+    uint8_t deleted : 1;                /*The object was deleted, don't add new records*/
+    char hint[16];                      /*Text of a label to recognize it*/
+} prof_entry_t;
+
+typedef struct {
+    lv_disp_t * disp;
+    lv_area_t area;
+    uint16_t entry;
+} pending_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static prof_entry_t * get_entry(const lv_obj_t * obj, void ** stack, uint32_t stack_cnt);
+static uint32_t get_hash(const lv_obj_t * obj, void ** stack, uint32_t stack_cnt);
+static int compare_px(const void * a, const void * b);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static prof_entry_t entries[LV_REDRAW_PROF_ENTRIES];
+static pending_t pending[PENDING_MAX];
+static uint32_t pending_cnt;
+static const lv_obj_t * cur_obj;
+static uint32_t frame_flush_px;
+
+static uint32_t frame_cnt;
+static uint64_t total_px;
+static uint64_t total_bytes;
+static uint32_t dropped_cnt;            /*Invalidations not recorded because the buffers were full*/
+
+/*Start of the executable (GNU ld), the stacks are written relative to it*/
+extern const char __executable_start;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_res_t lv_redraw_prof_dump(const char * path)
+{
+    FILE * f = fopen(path, "w");
+    if(f == NULL) return LV_RES_INV;
+
+    prof_entry_t ** sorted = malloc(LV_REDRAW_PROF_ENTRIES * sizeof(prof_entry_t *));
+    if(sorted == NULL) {
+        fclose(f);
+        return LV_RES_INV;
+    }
+
+    uint32_t cnt = 0;
+    uint32_t i;
+    for(i = 0; i < LV_REDRAW_PROF_ENTRIES; i++) {
+        if(entries[i].used) sorted[cnt++] = &entries[i];
+    }
+    qsort(sorted, cnt, sizeof(prof_entry_t *), compare_px);
+
+    fprintf(f, "{\"frames\":%u,\"px\":%llu,\"bytes\":%llu,\"dropped\":%u,\"entries\":[", (unsigned)frame_cnt,
+            (unsigned long long)total_px, (unsigned long long)total_bytes, (unsigned)dropped_cnt);
+
+    for(i = 0; i < cnt; i++) {
+        prof_entry_t * e = sorted[i];
+        fprintf(f, "%s\n{\"obj\":\"%p\",\"class\":\"0x%lx\",\"deleted\":%s,\"inv\":%u,\"px\":%llu,\"bytes\":%llu,",
+                i == 0 ? "" : ",", (void *)e->obj,
+                e->class_p ? (unsigned long)((const char *)e->class_p - &__executable_start) : 0UL,
+                e->deleted ? "true" : "false", (unsigned)e->inv_cnt, (unsigned long long)e->px,
+                (unsigned long long)e->bytes);
+
+        /*Escape the label text as a JSON string*/
+        fprintf(f, "\"hint\":\"");
+        const char * c;
+        for(c = e->hint; *c; c++) {
+            if(*c == '"' || *c == '\\') fprintf(f, "\\%c", *c);
+            else if((uint8_t)*c < 0x20) fprintf(f, " ");
+            else fputc(*c, f);
+        }
+        fprintf(f, "\",\"stack\":[");
+
+        uint32_t s;
+        for(s = 0; s < e->stack_cnt; s++) {
+            fprintf(f, "%s\"0x%lx\"", s == 0 ? "" : ",",
+                    (unsigned long)((const char *)e->stack[s] - &__executable_start));
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n]}\n");
+
+    fclose(f);
+    free(sorted);
+    return LV_RES_OK;
+}
+
+void lv_redraw_prof_reset(void)
+{
+    lv_memset_00(entries, sizeof(entries));
+    pending_cnt = 0;
+    frame_cnt = 0;
+    total_px = 0;
+    total_bytes = 0;
+    dropped_cnt = 0;
+}
+
+void _lv_redraw_prof_set_obj(const lv_obj_t * obj)
+{
+    cur_obj = obj;
+}
+
+void _lv_redraw_prof_inv(lv_disp_t * disp, const lv_area_t * area)
+{
+    if(area == NULL) {
+        /*Drop the records of this display*/
+        uint32_t i;
+        uint32_t kept = 0;
+        for(i = 0; i < pending_cnt; i++) {
+            if(pending[i].disp != disp) pending[kept++] = pending[i];
+        }
+        pending_cnt = kept;
+        return;
+    }
+
+    void * stack[LV_REDRAW_PROF_STACK_DEPTH + STACK_SKIP];
+    int stack_cnt = backtrace(stack, LV_REDRAW_PROF_STACK_DEPTH + STACK_SKIP);
+    stack_cnt = LV_MAX(stack_cnt - STACK_SKIP, 0);
+
+    prof_entry_t * e = get_entry(cur_obj, stack + STACK_SKIP, stack_cnt);
+    if(e == NULL || pending_cnt >= PENDING_MAX) {
+        dropped_cnt++;
+        return;
+    }
+    e->inv_cnt++;
+
+    pending[pending_cnt].disp = disp;
+    pending[pending_cnt].area = *area;
+    pending[pending_cnt].entry = e - entries;
+    pending_cnt++;
+}
+
+void _lv_redraw_prof_flush(const lv_area_t * area)
+{
+    frame_flush_px += lv_area_get_size(area);
+}
+
+void _lv_redraw_prof_refr_finish(lv_disp_t * disp)
+{
+    /*Pixels of each record redrawn in this frame*/
+    static uint32_t record_px[PENDING_MAX];
+    lv_memset_00(record_px, sizeof(record_px));
+
+    uint32_t frame_px = 0;
+    uint32_t i;
+    for(i = 0; i < disp->inv_p; i++) {
+        if(disp->inv_area_joined[i]) continue;
+
+        /*Split the pixels of the refreshed area in proportion to the overlapping part of each record*/
+        const lv_area_t * refr_area = &disp->inv_areas[i];
+        uint64_t overlap_sum = 0;
+        uint32_t r;
+        lv_area_t overlap;
+        for(r = 0; r < pending_cnt; r++) {
+            if(pending[r].disp != disp) continue;
+            if(_lv_area_intersect(&overlap, &pending[r].area, refr_area)) overlap_sum += lv_area_get_size(&overlap);
+        }
+        if(overlap_sum == 0) continue;
+
+        uint32_t area_px = lv_area_get_size(refr_area);
+        frame_px += area_px;
+        for(r = 0; r < pending_cnt; r++) {
+            if(pending[r].disp != disp) continue;
+            if(_lv_area_intersect(&overlap, &pending[r].area, refr_area)) {
+                record_px[r] += (uint64_t)area_px * lv_area_get_size(&overlap) / overlap_sum;
+            }
+        }
+    }
+
+    uint64_t frame_bytes = (uint64_t)frame_flush_px * sizeof(lv_color_t);
+    uint32_t kept = 0;
+    for(i = 0; i < pending_cnt; i++) {
+        if(pending[i].disp != disp) {
+            pending[kept] = pending[i];
+            record_px[kept] = record_px[i];
+            kept++;
+            continue;
+        }
+        prof_entry_t * e = &entries[pending[i].entry];
+        e->px += record_px[i];
+        if(frame_px) e->bytes += frame_bytes * record_px[i] / frame_px;
+    }
+    pending_cnt = kept;
+
+    if(disp->inv_p) frame_cnt++;
+    total_px += frame_px;
+    total_bytes += frame_bytes;
+    frame_flush_px = 0;
+}
+
+void _lv_redraw_prof_obj_deleted(const lv_obj_t * obj)
+{
+    uint32_t i;
+    for(i = 0; i < LV_REDRAW_PROF_ENTRIES; i++) {
+        if(entries[i].used && entries[i].obj == obj) entries[i].deleted = 1;
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/*Find or add the entry of an object and call stack. NULL if the table is full*/
+static prof_entry_t * get_entry(const lv_obj_t * obj, void ** stack, uint32_t stack_cnt)
+{
+    uint32_t hash = get_hash(obj, stack, stack_cnt);
+    uint32_t i;
+    for(i = 0; i < LV_REDRAW_PROF_ENTRIES; i++) {
+        prof_entry_t * e = &entries[(hash + i) % LV_REDRAW_PROF_ENTRIES];
+        if(!e->used) {
+            e->used = 1;
+            e->obj = obj;
+            e->class_p = obj ? obj->class_p : NULL;
+            e->hash = hash;
+            e->stack_cnt = stack_cnt;
+            lv_memcpy(e->stack, stack, stack_cnt * sizeof(void *));
+#if LV_USE_LABEL
+            if(obj && lv_obj_check_type(obj, &lv_label_class)) {
+                const char * txt = lv_label_get_text(obj);
+                if(txt) lv_snprintf(e->hint, sizeof(e->hint), "%s", txt);
+            }
+#endif
+            return e;
+        }
+
+        if(e->hash == hash && e->obj == obj && !e->deleted && e->stack_cnt == stack_cnt &&
+           memcmp(e->stack, stack, stack_cnt * sizeof(void *)) == 0) {
+            return e;
+        }
+    }
+
+    return NULL;
+}
+
+/*FNV-1a of the object and the return addresses*/
+static uint32_t get_hash(const lv_obj_t * obj, void ** stack, uint32_t stack_cnt)
+{
+    uint32_t hash = 2166136261u;
+    uintptr_t v = (uintptr_t)obj;
+    uint32_t i;
+    for(i = 0; i <= stack_cnt; i++) {
+        uint32_t b;
+        for(b = 0; b < sizeof(uintptr_t); b++) {
+            hash ^= (v >> (b * 8)) & 0xFF;
+            hash *= 16777619u;
+        }
+        if(i < stack_cnt) v = (uintptr_t)stack[i];
+    }
+    return hash;
+}
+
+static int compare_px(const void * a, const void * b)
+{
+    const prof_entry_t * ea = *(const prof_entry_t * const *)a;
+    const prof_entry_t * eb = *(const prof_entry_t * const *)b;
+    if(ea->px != eb->px) return ea->px < eb->px ? 1 : -1;
+    if(ea->inv_cnt != eb->inv_cnt) return ea->inv_cnt < eb->inv_cnt ? 1 : -1;
+    return 0;
+}
+
+#endif /*LV_USE_REDRAW_PROF*/
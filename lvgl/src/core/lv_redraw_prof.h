@@ -0,0 +1,89 @@
+/**
+ * @file lv_redraw_prof.h
+ * Charge the redrawn pixels and the flushed bytes to the objects (and call sites) which invalidated them.
+ *
+ * Each invalidation is recorded with the object and the call stack of `_lv_inv_area()`.
+ * When the display is refreshed the pixels of every refreshed area are split among the
+ * invalidations inside it in proportion to their overlap, and the flushed bytes of the frame
+ * in proportion to the pixels. `lv_redraw_prof_dump()` writes the totals ranked by pixels.
+ */
+
+#ifndef LV_REDRAW_PROF_H
+#define LV_REDRAW_PROF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_obj.h"
+
+#if LV_USE_REDRAW_PROF
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Write the recorded redraw costs as JSON, ranked by the redrawn pixels.
+ * The call stacks are written relative to the start of the executable,
+ * `scripts/redraw_report.py` resolves them and prints a table.
+ * @param path      path of the file
+ * @return          LV_RES_OK: the file was written; LV_RES_INV: the file can't be opened
+ */
+lv_res_t lv_redraw_prof_dump(const char * path);
+
+/**
+ * Forget everything recorded so far, e.g. to profile only a scenario.
+ */
+void lv_redraw_prof_reset(void);
+
+/**
+ * Set the object whose invalidation is in progress. Called by `lv_obj_invalidate_area()`.
+ * @param obj       pointer to an object or NULL when it's finished
+ */
+void _lv_redraw_prof_set_obj(const lv_obj_t * obj);
+
+/**
+ * Record an invalidated area with the current object and the call stack. Called by `_lv_inv_area()`.
+ * @param disp      the display of the area
+ * @param area      the invalidated area, already clipped to the screen. NULL: the invalid areas were cleared
+ */
+void _lv_redraw_prof_inv(lv_disp_t * disp, const lv_area_t * area);
+
+/**
+ * Count a flushed area of the frame being refreshed. Called before the `flush_cb`.
+ * @param area      the flushed area
+ */
+void _lv_redraw_prof_flush(const lv_area_t * area);
+
+/**
+ * Split the pixels and flushed bytes of the finished refresh among the recorded invalidations.
+ * Called by `_lv_disp_refr_timer()` before the invalid areas are cleared.
+ * @param disp      the refreshed display
+ */
+void _lv_redraw_prof_refr_finish(lv_disp_t * disp);
+
+/**
+ * Forget an object which is being deleted, so a new object at the same address is recorded separately.
+ * @param obj       pointer to the deleted object
+ */
+void _lv_redraw_prof_obj_deleted(const lv_obj_t * obj);
+
+#endif /*LV_USE_REDRAW_PROF*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_REDRAW_PROF_H*/
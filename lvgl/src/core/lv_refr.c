@@ -10,6 +10,7 @@
 #include "lv_refr.h"
 #include "lv_disp.h"
 #include "../hal/lv_hal_tick.h"
+#include "../misc/lv_trace.h"
 #include "../hal/lv_hal_disp.h"
 #include "../misc/lv_timer.h"
 #include "../misc/lv_mem.h"
@@ -18,6 +19,8 @@
 #include "../draw/lv_draw.h"
 #include "../font/lv_font_fmt_txt.h"
 #include "../extra/others/snapshot/lv_snapshot.h"
+#include "lv_bitmap_cache.h"
+#include "lv_redraw_prof.h"
 
 #if LV_USE_PERF_MONITOR || LV_USE_MEM_MONITOR
     #include "../widgets/lv_label.h"
@@ -26,6 +29,10 @@
 /*********************
  *      DEFINES
  *********************/
+#if LV_USE_OCCLUSION_CULLING
+    /*Max number of uncovered pieces of an object tracked while subtracting the occluders*/
+    #define OCCLUSION_MAX_PIECES    8
+#endif
 
 /**********************
  *      TYPEDEFS
@@ -48,6 +55,19 @@ typedef struct {
 #endif
 } mem_monitor_t;
 
+#if LV_USE_OCCLUSION_CULLING
+typedef struct {
+    lv_obj_t * obj;
+    lv_area_t area;             /*The area surely covered by the object*/
+} occluder_t;
+
+typedef enum {
+    OCCLUSION_NONE,             /*Draw the object normally*/
+    OCCLUSION_CLIPPED,          /*Draw the object only on the returned area*/
+    OCCLUSION_CULLED,           /*Don't draw the object at all*/
+} occlusion_res_t;
+#endif
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -62,6 +82,15 @@ static void refr_obj(lv_draw_ctx_t * draw_ctx, lv_obj_t * obj);
 static uint32_t get_max_row(lv_disp_t * disp, lv_coord_t area_w, lv_coord_t area_h);
 static void draw_buf_flush(lv_disp_t * disp);
 static void call_flush_cb(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_p);
+#if LV_USE_OCCLUSION_CULLING
+    static void occluders_collect(const lv_area_t * clip_area);
+    static void occluders_collect_core(lv_obj_t * obj, const lv_area_t * clip_area);
+    static void occluder_add(lv_obj_t * obj, const lv_area_t * area);
+    static void get_inner_area(lv_obj_t * obj, lv_area_t * inner_area);
+    static occlusion_res_t occlusion_test(lv_draw_ctx_t * draw_ctx, lv_obj_t * obj, lv_area_t * visible_area);
+    static bool is_drawn_later(lv_obj_t * obj, lv_obj_t * ref);
+    static uint32_t area_subtract(lv_area_t res[], const lv_area_t * a, const lv_area_t * b);
+#endif
 
 #if LV_USE_PERF_MONITOR
     static void perf_monitor_init(perf_monitor_t * perf_monitor);
@@ -76,6 +105,14 @@ static void call_flush_cb(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_
 static uint32_t px_num;
 static lv_disp_t * disp_refr; /*Display being refreshed*/
 
+#if LV_USE_OCCLUSION_CULLING
+    static occluder_t occluders[LV_OCCLUSION_MAX_OCCLUDERS];
+    static uint32_t occluder_cnt;
+    static lv_disp_t * occluder_disp;   /*The occluders are valid only while this display is being refreshed*/
+    static uint32_t occlusion_suspended;  /*>0 while drawing into an intermediate layer*/
+    static lv_refr_occlusion_stats_t occlusion_stats;
+#endif
+
 #if LV_USE_PERF_MONITOR
     static perf_monitor_t   perf_monitor;
 #endif
@@ -217,6 +254,9 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
     /*Clear the invalidate buffer if the parameter is NULL*/
     if(area_p == NULL) {
         disp->inv_p = 0;
+#if LV_USE_REDRAW_PROF
+        _lv_redraw_prof_inv(disp, NULL);
+#endif
         return;
     }
 
@@ -232,6 +272,10 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
     suc = _lv_area_intersect(&com_area, area_p, &scr_area);
     if(suc == false)  return; /*Out of the screen*/
 
+#if LV_USE_REDRAW_PROF
+    _lv_redraw_prof_inv(disp, &com_area);
+#endif
+
     /*If there were at least 1 invalid area in full refresh mode, redraw the whole screen*/
     if(disp->driver->full_refresh) {
         disp->inv_areas[0] = scr_area;
@@ -287,6 +331,7 @@ void _lv_refr_set_disp_refreshing(lv_disp_t * disp)
 void _lv_disp_refr_timer(lv_timer_t * tmr)
 {
     REFR_TRACE("begin");
+    LV_TRACE_BEGIN("refr");
 
     uint32_t start = lv_tick_get();
     volatile uint32_t elaps = 0;
@@ -306,17 +351,20 @@ void _lv_disp_refr_timer(lv_timer_t * tmr)
     }
 
     /*Refresh the screen's layout if required*/
+    LV_TRACE_BEGIN("layout");
     lv_obj_update_layout(disp_refr->act_scr);
     if(disp_refr->prev_scr) lv_obj_update_layout(disp_refr->prev_scr);
 
     lv_obj_update_layout(disp_refr->top_layer);
     lv_obj_update_layout(disp_refr->sys_layer);
+    LV_TRACE_END("layout");
 
     /*Do nothing if there is no active screen*/
     if(disp_refr->act_scr == NULL) {
         disp_refr->inv_p = 0;
         LV_LOG_WARN("there is no active screen");
         REFR_TRACE("finished");
+        LV_TRACE_END("refr");
         return;
     }
 
@@ -324,6 +372,10 @@ void _lv_disp_refr_timer(lv_timer_t * tmr)
     refr_sync_areas();
     refr_invalid_areas();
 
+#if LV_USE_REDRAW_PROF
+    _lv_redraw_prof_refr_finish(disp_refr);
+#endif
+
     /*If refresh happened ...*/
     if(disp_refr->inv_p != 0) {
 
@@ -356,9 +408,8 @@ void _lv_disp_refr_timer(lv_timer_t * tmr)
     lv_mem_buf_free_all();
     _lv_font_clean_up_fmt_txt();
 
-#if LV_DRAW_COMPLEX
-    _lv_draw_mask_cleanup();
-#endif
+    /*The circles of the radius masks are not cleaned up here to reuse them in the next refresh too.
+     *The cache is limited to `LV_CIRCLE_CACHE_SIZE` entries and `LV_CIRCLE_CACHE_MEM_SIZE` bytes.*/
 
 #if LV_USE_PERF_MONITOR && LV_USE_LABEL
     lv_obj_t * perf_label = perf_monitor.perf_label;
@@ -449,6 +500,7 @@ void _lv_disp_refr_timer(lv_timer_t * tmr)
 #endif
 
     REFR_TRACE("finished");
+    LV_TRACE_END("refr");
 }
 
 #if LV_USE_PERF_MONITOR
@@ -467,6 +519,19 @@ uint32_t lv_refr_get_fps_avg(void)
 }
 #endif
 
+#if LV_USE_OCCLUSION_CULLING
+void lv_refr_get_occlusion_stats(lv_refr_occlusion_stats_t * stats)
+{
+    LV_ASSERT_NULL(stats);
+    *stats = occlusion_stats;
+}
+
+void lv_refr_reset_occlusion_stats(void)
+{
+    lv_memset_00(&occlusion_stats, sizeof(occlusion_stats));
+}
+#endif
+
 
 /**********************
  *   STATIC FUNCTIONS
@@ -609,18 +674,33 @@ static void refr_invalid_areas(void)
     disp_refr->driver->draw_buf->last_part = 0;
     disp_refr->rendering_in_progress = true;
 
+#if LV_USE_OCCLUSION_CULLING
+    /*Collect the occluders once for all areas, the objects don't change while rendering*/
+    lv_area_t inv_area_bbox = disp_refr->inv_areas[last_i];
+    for(i = 0; i < last_i; i++) {
+        if(disp_refr->inv_area_joined[i] == 0) _lv_area_join(&inv_area_bbox, &inv_area_bbox, &disp_refr->inv_areas[i]);
+    }
+    occluders_collect(&inv_area_bbox);
+#endif
+
     for(i = 0; i < disp_refr->inv_p; i++) {
         /*Refresh the unjoined areas*/
         if(disp_refr->inv_area_joined[i] == 0) {
 
             if(i == last_i) disp_refr->driver->draw_buf->last_area = 1;
             disp_refr->driver->draw_buf->last_part = 0;
+            LV_TRACE_BEGIN("refr_area");
             refr_area(&disp_refr->inv_areas[i]);
+            LV_TRACE_END("refr_area");
 
             px_num += lv_area_get_size(&disp_refr->inv_areas[i]);
         }
     }
 
+#if LV_USE_OCCLUSION_CULLING
+    occluder_cnt = 0;
+#endif
+
     disp_refr->rendering_in_progress = false;
 }
 
@@ -708,9 +788,11 @@ static void refr_area_part(lv_draw_ctx_t * draw_ctx)
     bool full_sized = draw_buf->size == (uint32_t)disp_refr->driver->hor_res * disp_refr->driver->ver_res;
     if((draw_buf->buf1 && !draw_buf->buf2) ||
        (draw_buf->buf1 && draw_buf->buf2 && full_sized)) {
+        LV_TRACE_BEGIN("wait_flush");
         while(draw_buf->flushing) {
             if(disp_refr->driver->wait_cb) disp_refr->driver->wait_cb(disp_refr->driver);
         }
+        LV_TRACE_END("wait_flush");
 
         /*If the screen is transparent initialize it when the flushing is ready*/
 #if LV_COLOR_SCREEN_TRANSP
@@ -819,6 +901,13 @@ static lv_obj_t * lv_refr_get_top_obj(const lv_area_t * area_p, lv_obj_t * obj)
     lv_event_send(obj, LV_EVENT_COVER_CHECK, &info);
     if(info.res == LV_COVER_RES_MASKED) return NULL;
 
+#if LV_USE_BITMAP_CACHE
+    /*Start from the cached bitmap instead of breaking it up into its children*/
+    if(lv_obj_has_flag(obj, LV_OBJ_FLAG_CACHE_BITMAP)) {
+        return info.res == LV_COVER_RES_COVER ? obj : NULL;
+    }
+#endif
+
     int32_t i;
     int32_t child_cnt = lv_obj_get_child_cnt(obj);
     for(i = child_cnt - 1; i >= 0; i--) {
@@ -971,7 +1060,22 @@ void refr_obj(lv_draw_ctx_t * draw_ctx, lv_obj_t * obj)
     if(lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) return;
     lv_layer_type_t layer_type = _lv_obj_get_layer_type(obj);
     if(layer_type == LV_LAYER_TYPE_NONE) {
-        lv_obj_redraw(draw_ctx, obj);
+#if LV_USE_OCCLUSION_CULLING
+        const lv_area_t * clip_area_ori = draw_ctx->clip_area;
+        lv_area_t visible_area;
+        occlusion_res_t occlusion = occlusion_test(draw_ctx, obj, &visible_area);
+        if(occlusion == OCCLUSION_CULLED) return;
+        if(occlusion == OCCLUSION_CLIPPED) draw_ctx->clip_area = &visible_area;
+#endif
+#if LV_USE_BITMAP_CACHE
+        if(!lv_obj_has_flag(obj, LV_OBJ_FLAG_CACHE_BITMAP) || _lv_bitmap_cache_draw(draw_ctx, obj) != LV_RES_OK)
+#endif
+        {
+            lv_obj_redraw(draw_ctx, obj);
+        }
+#if LV_USE_OCCLUSION_CULLING
+        draw_ctx->clip_area = clip_area_ori;
+#endif
     }
     else {
         lv_opa_t opa = lv_obj_get_style_opa_layered(obj, 0);
@@ -998,6 +1102,12 @@ void refr_obj(lv_draw_ctx_t * draw_ctx, lv_obj_t * obj)
             LV_LOG_WARN("Couldn't create a new layer context");
             return;
         }
+
+#if LV_USE_OCCLUSION_CULLING
+        /*The layer is drawn in its own (maybe transformed) coordinate system*/
+        occlusion_suspended++;
+#endif
+
         lv_point_t pivot = {
             .x = lv_obj_get_style_transform_pivot_x(obj, 0),
             .y = lv_obj_get_style_transform_pivot_y(obj, 0)
@@ -1047,6 +1157,9 @@ void refr_obj(lv_draw_ctx_t * draw_ctx, lv_obj_t * obj)
         }
 
         lv_draw_layer_destroy(draw_ctx, layer_ctx);
+#if LV_USE_OCCLUSION_CULLING
+        occlusion_suspended--;
+#endif
     }
 }
 
@@ -1281,9 +1394,11 @@ static void draw_buf_flush(lv_disp_t * disp)
      * and driver is ready to receive the new buffer */
     bool full_sized = draw_buf->size == (uint32_t)disp_refr->driver->hor_res * disp_refr->driver->ver_res;
     if(draw_buf->buf1 && draw_buf->buf2 && !full_sized) {
+        LV_TRACE_BEGIN("wait_flush");
         while(draw_buf->flushing) {
             if(disp_refr->driver->wait_cb) disp_refr->driver->wait_cb(disp_refr->driver);
         }
+        LV_TRACE_END("wait_flush");
     }
 
     draw_buf->flushing = 1;
@@ -1324,9 +1439,283 @@ static void call_flush_cb(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_
         .y2 = area->y2 + drv->offset_y
     };
 
+#if LV_USE_REDRAW_PROF
+    _lv_redraw_prof_flush(area);
+#endif
+
+    LV_TRACE_BEGIN("flush_cb");
     drv->flush_cb(drv, &offset_area, color_p);
+    LV_TRACE_END("flush_cb");
 }
 
+#if LV_USE_OCCLUSION_CULLING
+/**
+ * Collect the opaque objects which are visible on the areas being refreshed.
+ * Objects drawn before them can be skipped or clipped on the area they cover.
+ * @param clip_area     the bounding box of the areas being refreshed
+ */
+static void occluders_collect(const lv_area_t * clip_area)
+{
+    occluder_cnt = 0;
+    occluder_disp = disp_refr;
+
+    /*During screen load animations two screens are drawn in a special order. Don't bother with it.*/
+    if(disp_refr->prev_scr) return;
+
+    occluders_collect_core(lv_disp_get_scr_act(disp_refr), clip_area);
+    occluders_collect_core(lv_disp_get_layer_top(disp_refr), clip_area);
+    occluders_collect_core(lv_disp_get_layer_sys(disp_refr), clip_area);
+
+    occlusion_stats.occluder_cnt += occluder_cnt;
+}
+
+/**
+ * Visit an object and its children the same way as `lv_obj_redraw` clips them
+ * and save the ones fully covering some part of their visible area.
+ */
+static void occluders_collect_core(lv_obj_t * obj, const lv_area_t * clip_area)
+{
+    if(obj == NULL) return;
+    if(lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) return;
+    /*Layered objects are blended as a whole, maybe with opacity or transformation*/
+    if(_lv_obj_get_layer_type(obj) != LV_LAYER_TYPE_NONE) return;
+
+    lv_area_t obj_area;
+    bool visible = _lv_area_intersect(&obj_area, clip_area, &obj->coords);
+
+    /*Nothing is drawn before the screens and layers*/
+    if(visible && lv_obj_get_parent(obj)) occluder_add(obj, &obj_area);
+
+    const lv_area_t * clip_area_children = clip_area;
+    if(!lv_obj_has_flag(obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE)) {
+        if(!visible) return;
+        clip_area_children = &obj_area;
+    }
+
+    /*The children are masked by the rounded corners, only the area without the corners is surely drawn*/
+    lv_area_t inner_area;
+    if(lv_obj_get_style_clip_corner(obj, LV_PART_MAIN) && lv_obj_get_style_radius(obj, LV_PART_MAIN) != 0) {
+        get_inner_area(obj, &inner_area);
+        if(!_lv_area_intersect(&inner_area, clip_area_children, &inner_area)) return;
+        clip_area_children = &inner_area;
+    }
+
+    uint32_t i;
+    uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+    for(i = 0; i < child_cnt; i++) {
+        occluders_collect_core(obj->spec_attr->children[i], clip_area_children);
+    }
+}
+
+/**
+ * Save an object as occluder if it covers its visible area (or the area without its rounded corners).
+ * If there are too many occluders only the largest ones are kept.
+ * @param obj       pointer to an object
+ * @param area      the visible area of the object
+ */
+static void occluder_add(lv_obj_t * obj, const lv_area_t * area)
+{
+    /*Find a free slot or the smallest occluder to replace*/
+    occluder_t * slot;
+    if(occluder_cnt < LV_OCCLUSION_MAX_OCCLUDERS) {
+        slot = &occluders[occluder_cnt];
+    }
+    else {
+        slot = &occluders[0];
+        uint32_t i;
+        for(i = 1; i < occluder_cnt; i++) {
+            if(lv_area_get_size(&occluders[i].area) < lv_area_get_size(&slot->area)) slot = &occluders[i];
+        }
+        if(lv_area_get_size(&slot->area) >= lv_area_get_size(area)) return;
+    }
+
+    lv_area_t cover_area = *area;
+    lv_cover_check_info_t info;
+    info.res = LV_COVER_RES_COVER;
+    info.area = &cover_area;
+    lv_event_send(obj, LV_EVENT_COVER_CHECK, &info);
+    if(info.res == LV_COVER_RES_NOT_COVER) {
+        /*Maybe only the rounded corners are transparent. Try without them.*/
+        if(lv_obj_get_style_radius(obj, LV_PART_MAIN) == 0) return;
+
+        lv_area_t inner_area;
+        get_inner_area(obj, &inner_area);
+        if(!_lv_area_intersect(&cover_area, area, &inner_area)) return;
+
+        info.res = LV_COVER_RES_COVER;
+        lv_event_send(obj, LV_EVENT_COVER_CHECK, &info);
+    }
+    if(info.res != LV_COVER_RES_COVER) return;
+
+    /*The cover check considers only the object's own opacity, but it's multiplied by the parents'*/
+    if(lv_obj_get_style_opa_recursive(obj, LV_PART_MAIN) < LV_OPA_MAX) return;
+
+    if(slot == &occluders[occluder_cnt]) occluder_cnt++;
+    slot->obj = obj;
+    slot->area = cover_area;
+}
+
+/**
+ * Get the area of an object without its rounded corners.
+ * @param obj           pointer to an object
+ * @param inner_area    store the result here
+ */
+static void get_inner_area(lv_obj_t * obj, lv_area_t * inner_area)
+{
+    lv_coord_t r = lv_obj_get_style_radius(obj, LV_PART_MAIN);
+    lv_coord_t short_side = LV_MIN(lv_obj_get_width(obj), lv_obj_get_height(obj));
+    r = LV_MIN(r, short_side / 2);
+
+    *inner_area = obj->coords;
+    lv_area_increase(inner_area, -r, -r);
+}
+
+/**
+ * Check how much of an object is covered by the occluders drawn after it.
+ * @param draw_ctx      pointer to the current draw context
+ * @param obj           pointer to the object to draw
+ * @param visible_area  with `OCCLUSION_CLIPPED` store the area to draw here
+ * @return              how to draw the object
+ */
+static occlusion_res_t occlusion_test(lv_draw_ctx_t * draw_ctx, lv_obj_t * obj, lv_area_t * visible_area)
+{
+    if(occluder_cnt == 0 || occlusion_suspended || disp_refr != occluder_disp) return OCCLUSION_NONE;
+
+    /*The children might be drawn anywhere*/
+    if(lv_obj_has_flag(obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE)) return OCCLUSION_NONE;
+
+    lv_area_t obj_area;
+    lv_obj_get_coords(obj, &obj_area);
+    lv_coord_t ext_draw_size = _lv_obj_get_ext_draw_size(obj);
+    lv_area_increase(&obj_area, ext_draw_size, ext_draw_size);
+    if(!_lv_area_intersect(&obj_area, draw_ctx->clip_area, &obj_area)) return OCCLUSION_NONE;
+
+    /*Subtract the occluders one by one from the area of the object*/
+    lv_area_t pieces[OCCLUSION_MAX_PIECES];
+    lv_area_t new_pieces[OCCLUSION_MAX_PIECES];
+    uint32_t piece_cnt = 1;
+    pieces[0] = obj_area;
+
+    uint32_t i;
+    for(i = 0; i < occluder_cnt && piece_cnt > 0; i++) {
+        occluder_t * occluder = &occluders[i];
+        if(!_lv_area_is_on(&occluder->area, &obj_area)) continue;
+        if(!is_drawn_later(occluder->obj, obj)) continue;
+
+        uint32_t new_piece_cnt = 0;
+        uint32_t p;
+        for(p = 0; p < piece_cnt; p++) {
+            lv_area_t diff[4];
+            uint32_t diff_cnt = area_subtract(diff, &pieces[p], &occluder->area);
+            if(new_piece_cnt + diff_cnt > OCCLUSION_MAX_PIECES) return OCCLUSION_NONE;
+            lv_memcpy_small(&new_pieces[new_piece_cnt], diff, diff_cnt * sizeof(lv_area_t));
+            new_piece_cnt += diff_cnt;
+        }
+        lv_memcpy_small(pieces, new_pieces, new_piece_cnt * sizeof(lv_area_t));
+        piece_cnt = new_piece_cnt;
+    }
+
+    uint32_t obj_size = lv_area_get_size(&obj_area);
+    if(piece_cnt == 0) {
+        occlusion_stats.culled_cnt++;
+        occlusion_stats.px_saved += obj_size;
+        return OCCLUSION_CULLED;
+    }
+
+    /*Drawing the bounding box of the uncovered pieces is still correct*/
+    lv_area_t bbox = pieces[0];
+    for(i = 1; i < piece_cnt; i++) {
+        bbox.x1 = LV_MIN(bbox.x1, pieces[i].x1);
+        bbox.y1 = LV_MIN(bbox.y1, pieces[i].y1);
+        bbox.x2 = LV_MAX(bbox.x2, pieces[i].x2);
+        bbox.y2 = LV_MAX(bbox.y2, pieces[i].y2);
+    }
+
+    uint32_t bbox_size = lv_area_get_size(&bbox);
+    if(bbox_size == obj_size) return OCCLUSION_NONE;
+
+    occlusion_stats.clipped_cnt++;
+    occlusion_stats.px_saved += obj_size - bbox_size;
+    *visible_area = bbox;
+    return OCCLUSION_CLIPPED;
+}
+
+/**
+ * Tell whether an object is drawn after an other object and all of its children.
+ * @param obj       pointer to an object
+ * @param ref       pointer to the reference object
+ * @return          true: `obj` is drawn later; false: earlier or `obj` and `ref` are ancestors of each other
+ */
+static bool is_drawn_later(lv_obj_t * obj, lv_obj_t * ref)
+{
+    uint32_t obj_depth = 0;
+    lv_obj_t * obj_root = obj;
+    while(lv_obj_get_parent(obj_root)) {
+        obj_root = lv_obj_get_parent(obj_root);
+        obj_depth++;
+    }
+
+    uint32_t ref_depth = 0;
+    lv_obj_t * ref_root = ref;
+    while(lv_obj_get_parent(ref_root)) {
+        ref_root = lv_obj_get_parent(ref_root);
+        ref_depth++;
+    }
+
+    /*The active screen, the top layer and the sys layer are drawn in this order*/
+    if(obj_root != ref_root) {
+        lv_obj_t * layer_top = lv_disp_get_layer_top(disp_refr);
+        lv_obj_t * layer_sys = lv_disp_get_layer_sys(disp_refr);
+        if(ref_root == layer_sys) return false;
+        if(obj_root == layer_sys) return true;
+        if(ref_root == layer_top) return false;
+        return obj_root == layer_top;
+    }
+
+    while(obj_depth > ref_depth) {
+        obj = lv_obj_get_parent(obj);
+        obj_depth--;
+    }
+    while(ref_depth > obj_depth) {
+        ref = lv_obj_get_parent(ref);
+        ref_depth--;
+    }
+    if(obj == ref) return false;
+
+    /*Go up to the children of the closest common ancestor. The later child is drawn later.*/
+    while(lv_obj_get_parent(obj) != lv_obj_get_parent(ref)) {
+        obj = lv_obj_get_parent(obj);
+        ref = lv_obj_get_parent(ref);
+    }
+
+    return lv_obj_get_index(obj) > lv_obj_get_index(ref);
+}
+
+/**
+ * Get the parts of an area which are not on an other area.
+ * @param res       store the result here (max. 4 areas)
+ * @param a         the area to subtract from
+ * @param b         the area to subtract
+ * @return          number of areas saved in `res` (0: `a` is fully on `b`)
+ */
+static uint32_t area_subtract(lv_area_t res[], const lv_area_t * a, const lv_area_t * b)
+{
+    lv_area_t common;
+    if(!_lv_area_intersect(&common, a, b)) {
+        res[0] = *a;
+        return 1;
+    }
+
+    uint32_t cnt = 0;
+    if(a->y1 < common.y1) lv_area_set(&res[cnt++], a->x1, a->y1, a->x2, common.y1 - 1);
+    if(common.y2 < a->y2) lv_area_set(&res[cnt++], a->x1, common.y2 + 1, a->x2, a->y2);
+    if(a->x1 < common.x1) lv_area_set(&res[cnt++], a->x1, common.y1, common.x1 - 1, common.y2);
+    if(common.x2 < a->x2) lv_area_set(&res[cnt++], common.x2 + 1, common.y1, a->x2, common.y2);
+
+    return cnt;
+}
+#endif
+
 #if LV_USE_PERF_MONITOR
 static void perf_monitor_init(perf_monitor_t * _perf_monitor)
 {
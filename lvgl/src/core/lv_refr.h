@@ -26,6 +26,18 @@ extern "C" {
  *      TYPEDEFS
  **********************/
 
+#if LV_USE_OCCLUSION_CULLING
+/**
+ * Statistics of the occlusion culling. The counters accumulate until reset.
+ */
+typedef struct {
+    uint32_t occluder_cnt;      /**< Opaque objects found above other objects*/
+    uint32_t culled_cnt;        /**< Objects skipped because they were fully covered*/
+    uint32_t clipped_cnt;       /**< Objects drawn only on their uncovered part*/
+    uint32_t px_saved;          /**< Pixels (of object areas) which weren't drawn thanks to the above*/
+} lv_refr_occlusion_stats_t;
+#endif
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -98,6 +110,19 @@ void lv_refr_reset_fps_counter(void);
 uint32_t lv_refr_get_fps_avg(void);
 #endif
 
+#if LV_USE_OCCLUSION_CULLING
+/**
+ * Get the statistics of the occlusion culling
+ * @param stats     store the result here
+ */
+void lv_refr_get_occlusion_stats(lv_refr_occlusion_stats_t * stats);
+
+/**
+ * Reset the occlusion culling counters
+ */
+void lv_refr_reset_occlusion_stats(void);
+#endif
+
 /**
  * Called periodically to handle the refreshing
  * @param timer pointer to the timer itself
@@ -16,8 +16,13 @@
 /*********************
  *      DEFINES
  *********************/
-#define CIRCLE_CACHE_LIFE_MAX   1000
-#define CIRCLE_CACHE_AGING(life, r)   life = LV_MIN(life + (r < 16 ? 1 : (r >> 4)), 1000)
+#define CIRCLE_BUF_SIZE(r)      ((r) * 6 + 6)
+
+#if LV_CIRCLE_CACHE_SIZE
+    #define CIRCLE_CACHE_MEM_SIZE   LV_CIRCLE_CACHE_MEM_SIZE
+#else
+    #define CIRCLE_CACHE_MEM_SIZE   0
+#endif
 
 /**********************
  *      TYPEDEFS
@@ -59,10 +64,22 @@ static void circ_calc_aa4(_lv_draw_mask_radius_circle_dsc_t * c, lv_coord_t radi
 static lv_opa_t * get_next_line(_lv_draw_mask_radius_circle_dsc_t * c, lv_coord_t y, lv_coord_t * len,
                                 lv_coord_t * x_start);
 static inline lv_opa_t /* LV_ATTRIBUTE_FAST_MEM */ mask_mix(lv_opa_t mask_act, lv_opa_t mask_new);
+static _lv_draw_mask_radius_circle_dsc_t * circle_cache_alloc(lv_coord_t radius);
+static _lv_draw_mask_radius_circle_dsc_t * circle_cache_get_lru(bool cached_only);
+static uint8_t * circle_cache_find_gap(uint32_t size);
+static void circle_cache_drop(_lv_draw_mask_radius_circle_dsc_t * entry);
+static uint32_t circle_cache_used_size(void);
+static uint32_t circle_cache_next_stamp(void);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+#if LV_CIRCLE_CACHE_SIZE
+    /*The cached circles are not in the LVGL heap so caching and dropping them doesn't fragment it*/
+    static uint8_t circle_cache_mem[LV_CIRCLE_CACHE_MEM_SIZE];
+#endif
+static uint32_t circle_cache_stamp;
+static lv_draw_mask_circle_cache_stats_t circle_cache_stats;
 
 /**********************
  *      MACROS
@@ -233,13 +250,29 @@ void _lv_draw_mask_cleanup(void)
 {
     uint8_t i;
     for(i = 0; i < LV_CIRCLE_CACHE_SIZE; i++) {
-        if(LV_GC_ROOT(_lv_circle_cache[i]).buf) {
-            lv_mem_free(LV_GC_ROOT(_lv_circle_cache[i]).buf);
-        }
         lv_memset_00(&LV_GC_ROOT(_lv_circle_cache[i]), sizeof(LV_GC_ROOT(_lv_circle_cache[i])));
     }
 }
 
+void lv_draw_mask_get_circle_cache_stats(lv_draw_mask_circle_cache_stats_t * stats)
+{
+    LV_ASSERT_NULL(stats);
+    *stats = circle_cache_stats;
+    stats->entry_cnt = 0;
+    stats->used_size = circle_cache_used_size();
+    stats->max_size = CIRCLE_CACHE_MEM_SIZE;
+
+    uint8_t i;
+    for(i = 0; i < LV_CIRCLE_CACHE_SIZE; i++) {
+        if(LV_GC_ROOT(_lv_circle_cache[i]).buf) stats->entry_cnt++;
+    }
+}
+
+void lv_draw_mask_reset_circle_cache_stats(void)
+{
+    lv_memset_00(&circle_cache_stats, sizeof(circle_cache_stats));
+}
+
 /**
  * Count the currently added masks
  * @return number of active masks
@@ -497,31 +530,31 @@ void lv_draw_mask_radius_init(lv_draw_mask_radius_param_t * param, const lv_area
     for(i = 0; i < LV_CIRCLE_CACHE_SIZE; i++) {
         if(LV_GC_ROOT(_lv_circle_cache[i]).radius == radius) {
             LV_GC_ROOT(_lv_circle_cache[i]).used_cnt++;
-            CIRCLE_CACHE_AGING(LV_GC_ROOT(_lv_circle_cache[i]).life, radius);
+            LV_GC_ROOT(_lv_circle_cache[i]).life++;
+            LV_GC_ROOT(_lv_circle_cache[i]).used_stamp = circle_cache_next_stamp();
             param->circle = &LV_GC_ROOT(_lv_circle_cache[i]);
+            circle_cache_stats.hit_cnt++;
             return;
         }
     }
 
-    /*If not found find a free entry with lowest life*/
-    _lv_draw_mask_radius_circle_dsc_t * entry = NULL;
-    for(i = 0; i < LV_CIRCLE_CACHE_SIZE; i++) {
-        if(LV_GC_ROOT(_lv_circle_cache[i]).used_cnt == 0) {
-            if(!entry) entry = &LV_GC_ROOT(_lv_circle_cache[i]);
-            else if(LV_GC_ROOT(_lv_circle_cache[i]).life < entry->life) entry = &LV_GC_ROOT(_lv_circle_cache[i]);
-        }
-    }
+    circle_cache_stats.miss_cnt++;
 
-    if(!entry) {
+    /*If not found cache it in the place of the least recently used circles*/
+    _lv_draw_mask_radius_circle_dsc_t * entry = circle_cache_alloc(radius);
+    if(entry) {
+        entry->used_cnt++;
+        entry->life = 1;
+        entry->used_stamp = circle_cache_next_stamp();
+    }
+    else {
+        /*Not cached, freed with the mask*/
         entry = lv_mem_alloc(sizeof(_lv_draw_mask_radius_circle_dsc_t));
         LV_ASSERT_MALLOC(entry);
         lv_memset_00(entry, sizeof(_lv_draw_mask_radius_circle_dsc_t));
         entry->life = -1;
-    }
-    else {
-        entry->used_cnt++;
-        entry->life = 0;
-        CIRCLE_CACHE_AGING(entry->life, radius);
+        entry->buf = lv_mem_alloc(CIRCLE_BUF_SIZE(radius));  /*Use uint16_t for opa_start_on_y and x_start_on_y*/
+        LV_ASSERT_MALLOC(entry->buf);
     }
 
     param->circle = entry;
@@ -1367,11 +1400,7 @@ static void circ_calc_aa4(_lv_draw_mask_radius_circle_dsc_t * c, lv_coord_t radi
     if(radius == 0) return;
     c->radius = radius;
 
-    /*Allocate buffers*/
-    if(c->buf) lv_mem_free(c->buf);
-
-    c->buf = lv_mem_alloc(radius * 6 + 6);  /*Use uint16_t for opa_start_on_y and x_start_on_y*/
-    LV_ASSERT_MALLOC(c->buf);
+    /*`buf` has `CIRCLE_BUF_SIZE(radius)` bytes*/
     c->cir_opa = c->buf;
     c->opa_start_on_y = (uint16_t *)(c->buf + 2 * radius + 2);
     c->x_start_on_y = (uint16_t *)(c->buf + 4 * radius + 4);
@@ -1528,4 +1557,123 @@ static inline lv_opa_t LV_ATTRIBUTE_FAST_MEM mask_mix(lv_opa_t mask_act, lv_opa_
 }
 
 
+/**
+ * Get a free cache entry with a `CIRCLE_BUF_SIZE(radius)` byte buffer in the memory budget.
+ * The least recently used circles are dropped to make place for it.
+ * @return      the entry or NULL if the circle can't be cached
+ */
+static _lv_draw_mask_radius_circle_dsc_t * circle_cache_alloc(lv_coord_t radius)
+{
+    uint32_t buf_size = CIRCLE_BUF_SIZE(radius);
+    if(buf_size > CIRCLE_CACHE_MEM_SIZE) return NULL;
+
+    _lv_draw_mask_radius_circle_dsc_t * entry = circle_cache_get_lru(false);
+    if(entry == NULL) return NULL;      /*All entries are used by masks*/
+    if(entry->buf) circle_cache_drop(entry);
+
+    uint8_t * buf = circle_cache_find_gap(buf_size);
+    while(buf == NULL) {
+        _lv_draw_mask_radius_circle_dsc_t * lru = circle_cache_get_lru(true);
+        if(lru == NULL) return NULL;
+        circle_cache_drop(lru);
+        buf = circle_cache_find_gap(buf_size);
+    }
+
+    entry->buf = buf;
+    return entry;
+}
+
+/**
+ * Find the least recently used circle cache entry which is not used by a mask now.
+ * Empty entries come first.
+ * @param cached_only   true: skip the empty entries
+ * @return              the entry or NULL if there is no such
+ */
+static _lv_draw_mask_radius_circle_dsc_t * circle_cache_get_lru(bool cached_only)
+{
+    _lv_draw_mask_radius_circle_dsc_t * lru = NULL;
+    uint8_t i;
+    for(i = 0; i < LV_CIRCLE_CACHE_SIZE; i++) {
+        _lv_draw_mask_radius_circle_dsc_t * c = &LV_GC_ROOT(_lv_circle_cache[i]);
+        if(c->used_cnt > 0) continue;
+        if(cached_only && c->buf == NULL) continue;
+        if(lru == NULL || c->used_stamp < lru->used_stamp) lru = c;
+    }
+    return lru;
+}
+
+/**
+ * Find the first place for a buffer in the memory budget which doesn't overlap the cached circles.
+ * A place can start at the beginning of the budget or at the end of a cached circle.
+ * @param size  size of the buffer in bytes
+ * @return      the start of the place or NULL if there is no such
+ */
+static uint8_t * circle_cache_find_gap(uint32_t size)
+{
+#if LV_CIRCLE_CACHE_SIZE
+    int32_t i;
+    for(i = -1; i < LV_CIRCLE_CACHE_SIZE; i++) {
+        uint32_t start = 0;
+        if(i >= 0) {
+            _lv_draw_mask_radius_circle_dsc_t * c = &LV_GC_ROOT(_lv_circle_cache[i]);
+            if(c->buf == NULL) continue;
+            start = (c->buf - circle_cache_mem) + CIRCLE_BUF_SIZE(c->radius);
+        }
+        if(start + size > LV_CIRCLE_CACHE_MEM_SIZE) continue;
+
+        uint8_t j;
+        for(j = 0; j < LV_CIRCLE_CACHE_SIZE; j++) {
+            _lv_draw_mask_radius_circle_dsc_t * c = &LV_GC_ROOT(_lv_circle_cache[j]);
+            if(c->buf == NULL) continue;
+            uint32_t c_start = c->buf - circle_cache_mem;
+            if(start < c_start + CIRCLE_BUF_SIZE(c->radius) && c_start < start + size) break;
+        }
+        if(j == LV_CIRCLE_CACHE_SIZE) return &circle_cache_mem[start];
+    }
+#else
+    LV_UNUSED(size);
+#endif
+    return NULL;
+}
+
+/**
+ * Drop a cached circle which is not used by a mask
+ */
+static void circle_cache_drop(_lv_draw_mask_radius_circle_dsc_t * entry)
+{
+    lv_memset_00(entry, sizeof(_lv_draw_mask_radius_circle_dsc_t));
+    circle_cache_stats.evict_cnt++;
+}
+
+/**
+ * Get the bytes allocated by the cached circles
+ */
+static uint32_t circle_cache_used_size(void)
+{
+    uint32_t size = 0;
+    uint8_t i;
+    for(i = 0; i < LV_CIRCLE_CACHE_SIZE; i++) {
+        if(LV_GC_ROOT(_lv_circle_cache[i]).buf) size += CIRCLE_BUF_SIZE(LV_GC_ROOT(_lv_circle_cache[i]).radius);
+    }
+    return size;
+}
+
+/**
+ * Get a new value for `used_stamp`.
+ * On overflow the stamps of the cached entries are restarted too to keep them comparable.
+ */
+static uint32_t circle_cache_next_stamp(void)
+{
+    if(circle_cache_stamp == UINT32_MAX) {
+        uint8_t i;
+        for(i = 0; i < LV_CIRCLE_CACHE_SIZE; i++) {
+            LV_GC_ROOT(_lv_circle_cache[i]).used_stamp = 0;
+        }
+        circle_cache_stamp = 0;
+    }
+
+    circle_cache_stamp++;
+    return circle_cache_stamp;
+}
+
 #endif /*LV_DRAW_COMPLEX*/
@@ -158,13 +158,26 @@ typedef struct  {
     lv_opa_t * cir_opa;         /*Opacity of values on the circumference of an 1/4 circle*/
     uint16_t * x_start_on_y;        /*The x coordinate of the circle for each y value*/
     uint16_t * opa_start_on_y;      /*The index of `cir_opa` for each y value*/
-    int32_t life;               /*How many times the entry way used*/
+    int32_t life;               /*How many times the entry way used. -1: not cached, freed with the mask*/
     uint32_t used_cnt;          /*Like a semaphore to count the referencing masks*/
+    uint32_t used_stamp;        /*When the entry was used last. The smallest is the least recently used*/
     lv_coord_t radius;          /*The radius of the entry*/
 } _lv_draw_mask_radius_circle_dsc_t;
 
 typedef _lv_draw_mask_radius_circle_dsc_t _lv_draw_mask_radius_circle_dsc_arr_t[LV_CIRCLE_CACHE_SIZE];
 
+/**
+ * Statistics of the circle cache used by the radius masks.
+ */
+typedef struct {
+    uint32_t hit_cnt;           /**< Radius masks which found their circle in the cache*/
+    uint32_t miss_cnt;          /**< Radius masks which had to calculate their circle*/
+    uint32_t evict_cnt;         /**< Cached circles dropped for an other radius or to stay within the memory budget*/
+    uint32_t entry_cnt;         /**< Number of cached circles*/
+    uint32_t used_size;         /**< Bytes used by the cached circles*/
+    uint32_t max_size;          /**< The memory budget in bytes (`LV_CIRCLE_CACHE_MEM_SIZE`)*/
+} lv_draw_mask_circle_cache_stats_t;
+
 typedef struct {
     /*The first element must be the common descriptor*/
     _lv_draw_mask_common_dsc_t dsc;
@@ -289,11 +302,22 @@ void * lv_draw_mask_remove_custom(void * custom_id);
 void lv_draw_mask_free_param(void * p);
 
 /**
- * Called by LVGL the rendering of a screen is ready to clean up
- * the temporal (cache) data of the masks
+ * Clean up the temporal (cache) data of the masks.
+ * The cached circles are kept between refreshes, call it to free them.
  */
 void _lv_draw_mask_cleanup(void);
 
+/**
+ * Get the statistics of the circle cache of the radius masks
+ * @param stats     store the result here
+ */
+void lv_draw_mask_get_circle_cache_stats(lv_draw_mask_circle_cache_stats_t * stats);
+
+/**
+ * Reset the hit/miss/eviction counters of the circle cache
+ */
+void lv_draw_mask_reset_circle_cache_stats(void);
+
 //! @cond Doxygen_Suppress
 
 /**
@@ -43,6 +43,20 @@ typedef struct {
     uint32_t has_alpha : 1;
 } lv_draw_sw_layer_ctx_t;
 
+#if LV_DRAW_COMPLEX && LV_SHADOW_CACHE_SIZE
+/**
+ * Statistics of the shadow corner cache.
+ */
+typedef struct {
+    uint32_t hit_cnt;       /**< Shadows drawn with a buffered corner*/
+    uint32_t miss_cnt;      /**< Shadows whose corner had to be blurred*/
+    uint32_t evict_cnt;     /**< Corners dropped to stay within the memory budget*/
+    uint32_t entry_cnt;     /**< Number of buffered corners*/
+    uint32_t used_size;     /**< Bytes used by the buffered corners*/
+    uint32_t max_size;      /**< The memory budget in bytes (`LV_SHADOW_CACHE_MEM_SIZE`)*/
+} lv_draw_sw_shadow_cache_stats_t;
+#endif
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -57,6 +71,24 @@ void lv_draw_sw_arc(lv_draw_ctx_t * draw_ctx, const lv_draw_arc_dsc_t * dsc, con
 
 void lv_draw_sw_rect(lv_draw_ctx_t * draw_ctx, const lv_draw_rect_dsc_t * dsc, const lv_area_t * coords);
 
+#if LV_DRAW_COMPLEX && LV_SHADOW_CACHE_SIZE
+/**
+ * Get the statistics of the shadow corner cache
+ * @param stats     store the result here
+ */
+void lv_draw_sw_shadow_cache_get_stats(lv_draw_sw_shadow_cache_stats_t * stats);
+
+/**
+ * Reset the hit/miss/eviction counters of the shadow corner cache
+ */
+void lv_draw_sw_shadow_cache_reset_stats(void);
+
+/**
+ * Drop all buffered shadow corners
+ */
+void lv_draw_sw_shadow_cache_clear(void);
+#endif
+
 void lv_draw_sw_bg(lv_draw_ctx_t * draw_ctx, const lv_draw_rect_dsc_t * dsc, const lv_area_t * coords);
 void lv_draw_sw_letter(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc, const lv_point_t * pos_p,
                        uint32_t letter);
@@ -19,11 +19,22 @@
 #define SHADOW_UPSCALE_SHIFT    6
 #define SHADOW_ENHANCE          1
 #define SPLIT_LIMIT             50
+#define SHADOW_CACHE_ENTRY_MAX  16      /*Buffered corners at most, also within the memory budget*/
 
 
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_DRAW_COMPLEX && LV_SHADOW_CACHE_SIZE
+typedef struct {
+    lv_coord_t size;            /*Corner size: `shadow_width + radius`*/
+    lv_coord_t r;
+    lv_coord_t core_w;          /*Size of the blurred rectangle. Above `size` it doesn't affect the corner.*/
+    lv_coord_t core_h;
+    uint32_t offset;            /*`size * size` opacity values of the top right corner in `sh_cache_mem`*/
+    uint32_t used_stamp;        /*When the entry was used last. The smallest is the least recently used*/
+} sh_cache_entry_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
@@ -40,6 +51,12 @@ static void /* LV_ATTRIBUTE_FAST_MEM */ draw_shadow(lv_draw_ctx_t * draw_ctx, co
 static void /* LV_ATTRIBUTE_FAST_MEM */ shadow_draw_corner_buf(const lv_area_t * coords, uint16_t * sh_buf,
                                                                lv_coord_t s, lv_coord_t r);
 static void /* LV_ATTRIBUTE_FAST_MEM */ shadow_blur_corner(lv_coord_t size, lv_coord_t sw, uint16_t * sh_ups_buf);
+#if LV_SHADOW_CACHE_SIZE
+static const lv_opa_t * sh_cache_get(lv_coord_t size, lv_coord_t r, lv_coord_t core_w, lv_coord_t core_h);
+static void sh_cache_add(lv_coord_t size, lv_coord_t r, lv_coord_t core_w, lv_coord_t core_h, const lv_opa_t * buf);
+static void sh_cache_drop(uint32_t id);
+static uint32_t sh_cache_next_stamp(void);
+#endif
 #endif
 
 void draw_border_generic(lv_draw_ctx_t * draw_ctx, const lv_area_t * outer_area, const lv_area_t * inner_area,
@@ -52,10 +69,13 @@ static void draw_border_simple(lv_draw_ctx_t * draw_ctx, const lv_area_t * outer
 /**********************
  *  STATIC VARIABLES
  **********************/
-#if defined(LV_SHADOW_CACHE_SIZE) && LV_SHADOW_CACHE_SIZE > 0
-    static uint8_t sh_cache[LV_SHADOW_CACHE_SIZE * LV_SHADOW_CACHE_SIZE];
-    static int32_t sh_cache_size = -1;
-    static int32_t sh_cache_r = -1;
+#if LV_DRAW_COMPLEX && LV_SHADOW_CACHE_SIZE
+    /*The corners are stored without gaps in the order of the entries. They are not in the LVGL heap
+     *so buffering and dropping them doesn't fragment it.*/
+    static uint8_t sh_cache_mem[LV_SHADOW_CACHE_MEM_SIZE];
+    static sh_cache_entry_t sh_cache_entries[SHADOW_CACHE_ENTRY_MAX];
+    static uint32_t sh_cache_stamp;
+    static lv_draw_sw_shadow_cache_stats_t sh_cache_stats;
 #endif
 
 /**********************
@@ -66,6 +86,28 @@ static void draw_border_simple(lv_draw_ctx_t * draw_ctx, const lv_area_t * outer
  *   GLOBAL FUNCTIONS
  **********************/
 
+#if LV_DRAW_COMPLEX && LV_SHADOW_CACHE_SIZE
+void lv_draw_sw_shadow_cache_get_stats(lv_draw_sw_shadow_cache_stats_t * stats)
+{
+    LV_ASSERT_NULL(stats);
+    *stats = sh_cache_stats;
+    stats->max_size = LV_SHADOW_CACHE_MEM_SIZE;
+}
+
+void lv_draw_sw_shadow_cache_reset_stats(void)
+{
+    sh_cache_stats.hit_cnt = 0;
+    sh_cache_stats.miss_cnt = 0;
+    sh_cache_stats.evict_cnt = 0;
+}
+
+void lv_draw_sw_shadow_cache_clear(void)
+{
+    sh_cache_stats.entry_cnt = 0;
+    sh_cache_stats.used_size = 0;
+}
+#endif
+
 void lv_draw_sw_rect(lv_draw_ctx_t * draw_ctx, const lv_draw_rect_dsc_t * dsc, const lv_area_t * coords)
 {
 #if LV_DRAW_COMPLEX
@@ -486,8 +528,11 @@ static void LV_ATTRIBUTE_FAST_MEM draw_shadow(lv_draw_ctx_t * draw_ctx, const lv
     lv_opa_t * sh_buf;
 
 #if LV_SHADOW_CACHE_SIZE
-    if(sh_cache_size == corner_size && sh_cache_r == r_sh) {
-        /*Use the cache if available*/
+    lv_coord_t core_w = LV_MIN(lv_area_get_width(&core_area), corner_size);
+    lv_coord_t core_h = LV_MIN(lv_area_get_height(&core_area), corner_size);
+    const lv_opa_t * sh_cache = sh_cache_get(corner_size, r_sh, core_w, core_h);
+    if(sh_cache) {
+        /*Use the cache if available. Copy it because the buffer is mirrored while drawing.*/
         sh_buf = lv_mem_buf_get(corner_size * corner_size);
         lv_memcpy(sh_buf, sh_cache, corner_size * corner_size);
     }
@@ -495,13 +540,7 @@ static void LV_ATTRIBUTE_FAST_MEM draw_shadow(lv_draw_ctx_t * draw_ctx, const lv
         /*A larger buffer is required for calculation*/
         sh_buf = lv_mem_buf_get(corner_size * corner_size * sizeof(uint16_t));
         shadow_draw_corner_buf(&core_area, (uint16_t *)sh_buf, dsc->shadow_width, r_sh);
-
-        /*Cache the corner if it fits into the cache size*/
-        if((uint32_t)corner_size * corner_size < sizeof(sh_cache)) {
-            lv_memcpy(sh_cache, sh_buf, corner_size * corner_size);
-            sh_cache_size = corner_size;
-            sh_cache_r = r_sh;
-        }
+        sh_cache_add(corner_size, r_sh, core_w, core_h, sh_buf);
     }
 #else
     sh_buf = lv_mem_buf_get(corner_size * corner_size * sizeof(uint16_t));
@@ -1037,6 +1076,102 @@ static void LV_ATTRIBUTE_FAST_MEM shadow_draw_corner_buf(const lv_area_t * coord
 
 }
 
+#if LV_SHADOW_CACHE_SIZE
+/**
+ * Find a buffered shadow corner and make it the most recently used one.
+ * @return      the `size * size` opacity values or NULL if not found
+ */
+static const lv_opa_t * sh_cache_get(lv_coord_t size, lv_coord_t r, lv_coord_t core_w, lv_coord_t core_h)
+{
+    uint32_t i;
+    for(i = 0; i < sh_cache_stats.entry_cnt; i++) {
+        sh_cache_entry_t * entry = &sh_cache_entries[i];
+        if(entry->size == size && entry->r == r && entry->core_w == core_w && entry->core_h == core_h) {
+            entry->used_stamp = sh_cache_next_stamp();
+            sh_cache_stats.hit_cnt++;
+            return &sh_cache_mem[entry->offset];
+        }
+    }
+
+    sh_cache_stats.miss_cnt++;
+    return NULL;
+}
+
+/**
+ * Buffer a calculated shadow corner. The least recently used corners are dropped to fit into the budget.
+ * @param buf   `size * size` opacity values
+ */
+static void sh_cache_add(lv_coord_t size, lv_coord_t r, lv_coord_t core_w, lv_coord_t core_h, const lv_opa_t * buf)
+{
+    if(size > LV_SHADOW_CACHE_SIZE) return;
+
+    uint32_t buf_size = (uint32_t)size * size;
+    if(buf_size > LV_SHADOW_CACHE_MEM_SIZE) return;
+
+    while(sh_cache_stats.entry_cnt == SHADOW_CACHE_ENTRY_MAX ||
+          sh_cache_stats.used_size + buf_size > LV_SHADOW_CACHE_MEM_SIZE) {
+        uint32_t lru = 0;
+        uint32_t i;
+        for(i = 1; i < sh_cache_stats.entry_cnt; i++) {
+            if(sh_cache_entries[i].used_stamp < sh_cache_entries[lru].used_stamp) lru = i;
+        }
+        sh_cache_drop(lru);
+        sh_cache_stats.evict_cnt++;
+    }
+
+    sh_cache_entry_t * entry = &sh_cache_entries[sh_cache_stats.entry_cnt];
+    entry->size = size;
+    entry->r = r;
+    entry->core_w = core_w;
+    entry->core_h = core_h;
+    entry->offset = sh_cache_stats.used_size;
+    entry->used_stamp = sh_cache_next_stamp();
+    lv_memcpy(&sh_cache_mem[entry->offset], buf, buf_size);
+
+    sh_cache_stats.entry_cnt++;
+    sh_cache_stats.used_size += buf_size;
+}
+
+/**
+ * Drop a corner and move the ones after it down to close the gap.
+ * The budget is small, so moving them is cheaper than blurring a corner again.
+ */
+static void sh_cache_drop(uint32_t id)
+{
+    uint32_t buf_size = (uint32_t)sh_cache_entries[id].size * sh_cache_entries[id].size;
+    uint32_t i;
+    for(i = sh_cache_entries[id].offset + buf_size; i < sh_cache_stats.used_size; i++) {
+        sh_cache_mem[i - buf_size] = sh_cache_mem[i];
+    }
+
+    for(i = id + 1; i < sh_cache_stats.entry_cnt; i++) {
+        sh_cache_entries[i - 1] = sh_cache_entries[i];
+        sh_cache_entries[i - 1].offset -= buf_size;
+    }
+
+    sh_cache_stats.entry_cnt--;
+    sh_cache_stats.used_size -= buf_size;
+}
+
+/**
+ * Get a new value for `used_stamp`.
+ * On overflow the stamps of the cached entries are restarted too to keep them comparable.
+ */
+static uint32_t sh_cache_next_stamp(void)
+{
+    if(sh_cache_stamp == UINT32_MAX) {
+        uint32_t i;
+        for(i = 0; i < sh_cache_stats.entry_cnt; i++) {
+            sh_cache_entries[i].used_stamp = 0;
+        }
+        sh_cache_stamp = 0;
+    }
+
+    sh_cache_stamp++;
+    return sh_cache_stamp;
+}
+#endif
+
 static void LV_ATTRIBUTE_FAST_MEM shadow_blur_corner(lv_coord_t size, lv_coord_t sw, uint16_t * sh_ups_buf)
 {
     int32_t s_left = sw >> 1;
@@ -229,6 +229,16 @@
     #endif
 #endif
 
+/*Keep the timers in a min-heap ordered by their deadline instead of checking all of them in every
+ *`lv_timer_handler()` call. The handler returns the exact time until the next timer is due.*/
+#ifndef LV_USE_TIMER_HEAP
+    #ifdef CONFIG_LV_USE_TIMER_HEAP
+        #define LV_USE_TIMER_HEAP CONFIG_LV_USE_TIMER_HEAP
+    #else
+        #define LV_USE_TIMER_HEAP 0
+    #endif
+#endif
+
 /*Use a custom tick source that tells the elapsed time in milliseconds.
  *It removes the need to manually update the tick with `lv_tick_inc()`)*/
 #ifndef LV_TICK_CUSTOM
@@ -293,7 +303,7 @@
 
     /*Allow buffering some shadow calculation.
     *LV_SHADOW_CACHE_SIZE is the max. shadow size to buffer, where shadow size is `shadow_width + radius`
-    *Caching has LV_SHADOW_CACHE_SIZE^2 RAM cost*/
+    *Caching has shadow size^2 RAM cost per buffered shadow*/
     #ifndef LV_SHADOW_CACHE_SIZE
         #ifdef CONFIG_LV_SHADOW_CACHE_SIZE
             #define LV_SHADOW_CACHE_SIZE CONFIG_LV_SHADOW_CACHE_SIZE
@@ -301,10 +311,20 @@
             #define LV_SHADOW_CACHE_SIZE 0
         #endif
     #endif
+    #if LV_SHADOW_CACHE_SIZE
+        /*Memory budget of the buffered shadows [bytes], a static buffer. The least recently used ones are dropped above it.*/
+        #ifndef LV_SHADOW_CACHE_MEM_SIZE
+            #ifdef CONFIG_LV_SHADOW_CACHE_MEM_SIZE
+                #define LV_SHADOW_CACHE_MEM_SIZE CONFIG_LV_SHADOW_CACHE_MEM_SIZE
+            #else
+                #define LV_SHADOW_CACHE_MEM_SIZE (LV_SHADOW_CACHE_SIZE * LV_SHADOW_CACHE_SIZE)
+            #endif
+        #endif
+    #endif
 
     /* Set number of maximally cached circle data.
     * The circumference of 1/4 circle are saved for anti-aliasing
-    * radius * 4 bytes are used per circle (the most often used radiuses are saved)
+    * radius * 6 + 6 bytes are used per circle (the most recently used radiuses are saved)
     * 0: to disable caching */
     #ifndef LV_CIRCLE_CACHE_SIZE
         #ifdef CONFIG_LV_CIRCLE_CACHE_SIZE
@@ -313,6 +333,16 @@
             #define LV_CIRCLE_CACHE_SIZE 4
         #endif
     #endif
+    #if LV_CIRCLE_CACHE_SIZE
+        /*Memory budget of the cached circles [bytes], a static buffer. The least recently used ones are dropped above it.*/
+        #ifndef LV_CIRCLE_CACHE_MEM_SIZE
+            #ifdef CONFIG_LV_CIRCLE_CACHE_MEM_SIZE
+                #define LV_CIRCLE_CACHE_MEM_SIZE CONFIG_LV_CIRCLE_CACHE_MEM_SIZE
+            #else
+                #define LV_CIRCLE_CACHE_MEM_SIZE (LV_CIRCLE_CACHE_SIZE * 256)
+            #endif
+        #endif
+    #endif
 #endif /*LV_DRAW_COMPLEX*/
 
 /**
@@ -412,6 +442,46 @@
     #endif
 #endif
 
+/*Allow rendering objects with `LV_OBJ_FLAG_CACHE_BITMAP` once into a cached RGB565(+alpha) bitmap
+ *and redrawing them by blitting the bitmap. The bitmap is re-rendered when the object or its children change.*/
+#ifndef LV_USE_BITMAP_CACHE
+    #ifdef CONFIG_LV_USE_BITMAP_CACHE
+        #define LV_USE_BITMAP_CACHE CONFIG_LV_USE_BITMAP_CACHE
+    #else
+        #define LV_USE_BITMAP_CACHE 0
+    #endif
+#endif
+#if LV_USE_BITMAP_CACHE
+    /*Memory budget of all cached bitmaps [bytes]. The least recently used bitmaps are evicted above it.*/
+    #ifndef LV_BITMAP_CACHE_SIZE
+        #ifdef CONFIG_LV_BITMAP_CACHE_SIZE
+            #define LV_BITMAP_CACHE_SIZE CONFIG_LV_BITMAP_CACHE_SIZE
+        #else
+            #define LV_BITMAP_CACHE_SIZE (64 * 1024)
+        #endif
+    #endif
+#endif
+
+/*Skip drawing objects (or the parts of them) which are fully covered by opaque objects drawn later.
+ *Only objects without intermediate layers are considered. It saves blending on stacked panels.*/
+#ifndef LV_USE_OCCLUSION_CULLING
+    #ifdef CONFIG_LV_USE_OCCLUSION_CULLING
+        #define LV_USE_OCCLUSION_CULLING CONFIG_LV_USE_OCCLUSION_CULLING
+    #else
+        #define LV_USE_OCCLUSION_CULLING 0
+    #endif
+#endif
+#if LV_USE_OCCLUSION_CULLING
+    /*Max number of opaque objects considered as occluders per refreshed area. The largest ones are kept.*/
+    #ifndef LV_OCCLUSION_MAX_OCCLUDERS
+        #ifdef CONFIG_LV_OCCLUSION_MAX_OCCLUDERS
+            #define LV_OCCLUSION_MAX_OCCLUDERS CONFIG_LV_OCCLUSION_MAX_OCCLUDERS
+        #else
+            #define LV_OCCLUSION_MAX_OCCLUDERS 16
+        #endif
+    #endif
+#endif
+
 /*-------------
  * GPU
  *-----------*/
@@ -796,6 +866,64 @@
     #endif
 #endif
 
+/*1: Record the rendering, flushing, input reading, timers and worker threads into per thread
+ *ring buffers. `lv_trace_dump()` saves them as Chrome trace JSON (Perfetto). Requires POSIX threads*/
+#ifndef LV_USE_TRACE
+    #ifdef CONFIG_LV_USE_TRACE
+        #define LV_USE_TRACE CONFIG_LV_USE_TRACE
+    #else
+        #define LV_USE_TRACE 0
+    #endif
+#endif
+#if LV_USE_TRACE
+    /*Number of events kept per thread, the oldest ones are overwritten (power of 2)*/
+    #ifndef LV_TRACE_BUF_SIZE
+        #ifdef CONFIG_LV_TRACE_BUF_SIZE
+            #define LV_TRACE_BUF_SIZE CONFIG_LV_TRACE_BUF_SIZE
+        #else
+            #define LV_TRACE_BUF_SIZE 8192
+        #endif
+    #endif
+
+    /*Max. number of threads with a ring buffer*/
+    #ifndef LV_TRACE_THREAD_MAX
+        #ifdef CONFIG_LV_TRACE_THREAD_MAX
+            #define LV_TRACE_THREAD_MAX CONFIG_LV_TRACE_THREAD_MAX
+        #else
+            #define LV_TRACE_THREAD_MAX 16
+        #endif
+    #endif
+#endif
+
+/*1: Charge the redrawn pixels and flushed bytes to the objects and call sites which invalidated them.
+ *`lv_redraw_prof_dump()` saves the ranking as JSON. Records a call stack per invalidation, so use it for profiling only*/
+#ifndef LV_USE_REDRAW_PROF
+    #ifdef CONFIG_LV_USE_REDRAW_PROF
+        #define LV_USE_REDRAW_PROF CONFIG_LV_USE_REDRAW_PROF
+    #else
+        #define LV_USE_REDRAW_PROF 0
+    #endif
+#endif
+#if LV_USE_REDRAW_PROF
+    /*Max. number of different object + call stack pairs*/
+    #ifndef LV_REDRAW_PROF_ENTRIES
+        #ifdef CONFIG_LV_REDRAW_PROF_ENTRIES
+            #define LV_REDRAW_PROF_ENTRIES CONFIG_LV_REDRAW_PROF_ENTRIES
+        #else
+            #define LV_REDRAW_PROF_ENTRIES 256
+        #endif
+    #endif
+
+    /*Number of return addresses saved per invalidation*/
+    #ifndef LV_REDRAW_PROF_STACK_DEPTH
+        #ifdef CONFIG_LV_REDRAW_PROF_STACK_DEPTH
+            #define LV_REDRAW_PROF_STACK_DEPTH CONFIG_LV_REDRAW_PROF_STACK_DEPTH
+        #else
+            #define LV_REDRAW_PROF_STACK_DEPTH 12
+        #endif
+    #endif
+#endif
+
 /*Change the built in (v)snprintf functions*/
 #ifndef LV_SPRINTF_CUSTOM
     #ifdef CONFIG_LV_SPRINTF_CUSTOM
@@ -1530,6 +1658,25 @@
             #define LV_ROLLER_INF_PAGES 7 /*Number of extra "pages" when the roller is infinite*/
         #endif
     #endif
+
+    /*Render the visible options and some rows around them into 8 bit alpha strips (one with the normal and one
+     *with the selected style) and only blend them while scrolling. They are re-rendered when the scroll leaves the
+     *rendered rows or the options, the size or the font change.*/
+    #ifndef LV_ROLLER_STRIP
+        #ifdef CONFIG_LV_ROLLER_STRIP
+            #define LV_ROLLER_STRIP CONFIG_LV_ROLLER_STRIP
+        #else
+            #define LV_ROLLER_STRIP 0
+        #endif
+    #endif
+    /*Size limit of a strip [bytes] (1 byte/pixel). It limits the rendered rows, a larger visible area is drawn as text*/
+    #ifndef LV_ROLLER_STRIP_MAX_SIZE
+        #ifdef CONFIG_LV_ROLLER_STRIP_MAX_SIZE
+            #define LV_ROLLER_STRIP_MAX_SIZE CONFIG_LV_ROLLER_STRIP_MAX_SIZE
+        #else
+            #define LV_ROLLER_STRIP_MAX_SIZE (64 * 1024)
+        #endif
+    #endif
 #endif
 
 #ifndef LV_USE_SLIDER
@@ -16,6 +16,7 @@ CSRCS += lv_style.c
 CSRCS += lv_style_gen.c
 CSRCS += lv_timer.c
 CSRCS += lv_tlsf.c
+CSRCS += lv_trace.c
 CSRCS += lv_txt.c
 CSRCS += lv_txt_ap.c
 CSRCS += lv_utils.c
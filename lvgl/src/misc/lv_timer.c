@@ -11,6 +11,7 @@
 #include "lv_mem.h"
 #include "lv_ll.h"
 #include "lv_gc.h"
+#include "lv_trace.h"
 
 /*********************
  *      DEFINES
@@ -18,6 +19,12 @@
 #define IDLE_MEAS_PERIOD 500 /*[ms]*/
 #define DEF_PERIOD 500
 
+#if LV_USE_TIMER_HEAP
+    #define HEAP_IDX_NONE   0xFFFFFFFF  /*Not scheduled*/
+    #define HEAP_IDX_PARKED 0x80000000  /*Set in `heap_idx` if it's an index of the parked timers*/
+    #define HEAP_STATIC_CAP 64          /*Timers in the static arrays, only more timers are in the LVGL heap*/
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -25,16 +32,42 @@
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+#if LV_USE_TIMER_HEAP
+static void heap_run(uint32_t now);
+static uint32_t heap_time_till_next(void);
+static void update_deadline(lv_timer_t * timer);
+static bool heap_push(lv_timer_t * timer);
+static void heap_remove(lv_timer_t * timer);
+static void heap_sift_up(uint32_t idx);
+static void heap_sift_down(uint32_t idx);
+static bool park(lv_timer_t * timer);
+static void unpark_resumed(void);
+static void unschedule(lv_timer_t * timer);
+static bool grow(lv_timer_t *** array, uint32_t * cap, lv_timer_t ** static_array);
+#else
 static bool lv_timer_exec(lv_timer_t * timer);
 static uint32_t lv_timer_time_remaining(lv_timer_t * timer);
+#endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
 static bool lv_timer_run = false;
 static uint8_t idle_last = 0;
+#if LV_USE_TIMER_HEAP
+static uint32_t heap_cnt;
+static uint32_t heap_cap;
+static uint32_t parked_cnt;
+static uint32_t parked_cap;
+/*The arrays don't grow and move in the LVGL heap with the number of timers up to `HEAP_STATIC_CAP`*/
+static lv_timer_t * heap_static[HEAP_STATIC_CAP];
+static lv_timer_t * parked_static[HEAP_STATIC_CAP];
+static uint32_t handler_now;        /*Tick at the start of the current/last handler call*/
+static uint32_t handler_run_id;
+#else
 static bool timer_deleted;
 static bool timer_created;
+#endif
 
 /**********************
  *      MACROS
@@ -55,6 +88,14 @@ static bool timer_created;
 void _lv_timer_core_init(void)
 {
     _lv_ll_init(&LV_GC_ROOT(_lv_timer_ll), sizeof(lv_timer_t));
+#if LV_USE_TIMER_HEAP
+    LV_GC_ROOT(_lv_timer_heap) = heap_static;
+    heap_cnt = 0;
+    heap_cap = HEAP_STATIC_CAP;
+    LV_GC_ROOT(_lv_timer_parked) = parked_static;
+    parked_cnt = 0;
+    parked_cap = HEAP_STATIC_CAP;
+#endif
 
     /*Initially enable the lv_timer handling*/
     lv_timer_enable(true);
@@ -81,6 +122,8 @@ uint32_t LV_ATTRIBUTE_TIMER_HANDLER lv_timer_handler(void)
         return 1;
     }
 
+    LV_TRACE_BEGIN("lv_timer_handler");
+
     static uint32_t idle_period_start = 0;
     static uint32_t busy_time         = 0;
 
@@ -95,6 +138,10 @@ uint32_t LV_ATTRIBUTE_TIMER_HANDLER lv_timer_handler(void)
         }
     }
 
+#if LV_USE_TIMER_HEAP
+    heap_run(handler_start);
+    uint32_t time_till_next = heap_time_till_next();
+#else
     /*Run all timer from the list*/
     lv_timer_t * next;
     do {
@@ -129,6 +176,7 @@ uint32_t LV_ATTRIBUTE_TIMER_HANDLER lv_timer_handler(void)
 
         next = _lv_ll_get_next(&LV_GC_ROOT(_lv_timer_ll), next); /*Find the next timer*/
     }
+#endif
 
     busy_time += lv_tick_elaps(handler_start);
     uint32_t idle_period_time = lv_tick_elaps(idle_period_start);
@@ -141,6 +189,7 @@ uint32_t LV_ATTRIBUTE_TIMER_HANDLER lv_timer_handler(void)
 
     already_running = false; /*Release the mutex*/
 
+    LV_TRACE_END("lv_timer_handler");
     TIMER_TRACE("finished (%d ms until the next timer call)", time_till_next);
     return time_till_next;
 }
@@ -179,7 +228,18 @@ lv_timer_t * lv_timer_create(lv_timer_cb_t timer_xcb, uint32_t period, void * us
     new_timer->last_run = lv_tick_get();
     new_timer->user_data = user_data;
 
+#if LV_USE_TIMER_HEAP
+    new_timer->heap_idx = HEAP_IDX_NONE;
+    new_timer->run_id = handler_run_id - 1;
+    new_timer->deadline = new_timer->last_run + period;
+    if(!heap_push(new_timer)) {
+        _lv_ll_remove(&LV_GC_ROOT(_lv_timer_ll), new_timer);
+        lv_mem_free(new_timer);
+        return NULL;
+    }
+#else
     timer_created = true;
+#endif
 
     return new_timer;
 }
@@ -200,8 +260,14 @@ void lv_timer_set_cb(lv_timer_t * timer, lv_timer_cb_t timer_cb)
  */
 void lv_timer_del(lv_timer_t * timer)
 {
-    _lv_ll_remove(&LV_GC_ROOT(_lv_timer_ll), timer);
+#if LV_USE_TIMER_HEAP
+    unschedule(timer);
+    /*Let `lv_timer_handler()` know that the running timer is gone*/
+    if(LV_GC_ROOT(_lv_timer_act) == timer) LV_GC_ROOT(_lv_timer_act) = NULL;
+#else
     timer_deleted = true;
+#endif
+    _lv_ll_remove(&LV_GC_ROOT(_lv_timer_ll), timer);
 
     lv_mem_free(timer);
 }
@@ -228,6 +294,9 @@ void lv_timer_resume(lv_timer_t * timer)
 void lv_timer_set_period(lv_timer_t * timer, uint32_t period)
 {
     timer->period = period;
+#if LV_USE_TIMER_HEAP
+    update_deadline(timer);
+#endif
 }
 
 /**
@@ -237,6 +306,9 @@ void lv_timer_set_period(lv_timer_t * timer, uint32_t period)
 void lv_timer_ready(lv_timer_t * timer)
 {
     timer->last_run = lv_tick_get() - timer->period - 1;
+#if LV_USE_TIMER_HEAP
+    update_deadline(timer);
+#endif
 }
 
 /**
@@ -257,6 +329,9 @@ void lv_timer_set_repeat_count(lv_timer_t * timer, int32_t repeat_count)
 void lv_timer_reset(lv_timer_t * timer)
 {
     timer->last_run = lv_tick_get();
+#if LV_USE_TIMER_HEAP
+    update_deadline(timer);
+#endif
 }
 
 /**
@@ -292,6 +367,217 @@ lv_timer_t * lv_timer_get_next(lv_timer_t * timer)
  *   STATIC FUNCTIONS
  **********************/
 
+#if LV_USE_TIMER_HEAP
+
+/**
+ * Run the due timers in the order of their deadline.
+ * A timer runs at most once per call, like in a walk of the list.
+ * @param now       the tick when the handler started
+ */
+static void heap_run(uint32_t now)
+{
+    handler_now = now;
+    handler_run_id++;
+    unpark_resumed();
+
+    lv_timer_t ** heap = LV_GC_ROOT(_lv_timer_heap);
+    while(heap_cnt > 0) {
+        heap = LV_GC_ROOT(_lv_timer_heap);  /*It might be reallocated by a callback*/
+        lv_timer_t * timer = heap[0];
+        if((int32_t)(timer->deadline - now) > 0) break;
+
+        /*Paused timers are kept aside until they are resumed so they don't hide the next deadline*/
+        if(timer->paused) {
+            heap_remove(timer);
+            if(!park(timer)) break;
+            continue;
+        }
+
+        int32_t original_repeat_count = timer->repeat_count;
+        if(timer->repeat_count > 0) timer->repeat_count--;
+        timer->last_run = lv_tick_get();
+        timer->run_id = handler_run_id;
+        /*Reschedule before the callback as it can change the period or delete the timer*/
+        update_deadline(timer);
+
+        LV_GC_ROOT(_lv_timer_act) = timer;
+        TIMER_TRACE("calling timer callback: %p", *((void **)&timer->timer_cb));
+        if(timer->timer_cb && original_repeat_count != 0) {
+            LV_TRACE_BEGIN_ARG("timer", *((void **)&timer->timer_cb));
+            timer->timer_cb(timer);
+            LV_TRACE_END("timer");
+        }
+        TIMER_TRACE("timer callback %p finished", *((void **)&timer->timer_cb));
+        LV_ASSERT_MEM_INTEGRITY();
+
+        /*Deleted in the callback?*/
+        if(LV_GC_ROOT(_lv_timer_act) && timer->repeat_count == 0) {
+            TIMER_TRACE("deleting timer with %p callback because the repeat count is over", *((void **)&timer->timer_cb));
+            lv_timer_del(timer);
+        }
+    }
+    LV_GC_ROOT(_lv_timer_act) = NULL;
+
+    /*Timers resumed by the callbacks (e.g. the refresh timer after an invalidation)*/
+    unpark_resumed();
+}
+
+static uint32_t heap_time_till_next(void)
+{
+    if(heap_cnt == 0) return LV_NO_TIMER_READY;
+
+    int32_t remaining = LV_GC_ROOT(_lv_timer_heap)[0]->deadline - lv_tick_get();
+    return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+/**
+ * Calculate the deadline from `last_run` and `period` and move the timer to its place in the heap.
+ * A timer which already ran in the current handler call won't be due again before the next tick.
+ */
+static void update_deadline(lv_timer_t * timer)
+{
+    uint32_t deadline = timer->last_run + timer->period;
+    if(timer->run_id == handler_run_id && (int32_t)(deadline - handler_now) <= 0) deadline = handler_now + 1;
+
+    uint32_t old = timer->deadline;
+    timer->deadline = deadline;
+
+    /*A parked timer gets its place when it's resumed*/
+    if(timer->heap_idx == HEAP_IDX_NONE || (timer->heap_idx & HEAP_IDX_PARKED)) return;
+
+    if((int32_t)(deadline - old) < 0) heap_sift_up(timer->heap_idx);
+    else heap_sift_down(timer->heap_idx);
+}
+
+static bool heap_push(lv_timer_t * timer)
+{
+    if(heap_cnt == heap_cap && !grow(&LV_GC_ROOT(_lv_timer_heap), &heap_cap, heap_static)) return false;
+
+    LV_GC_ROOT(_lv_timer_heap)[heap_cnt] = timer;
+    timer->heap_idx = heap_cnt;
+    heap_cnt++;
+    heap_sift_up(timer->heap_idx);
+    return true;
+}
+
+static void heap_remove(lv_timer_t * timer)
+{
+    lv_timer_t ** heap = LV_GC_ROOT(_lv_timer_heap);
+    uint32_t idx = timer->heap_idx;
+    timer->heap_idx = HEAP_IDX_NONE;
+
+    heap_cnt--;
+    if(idx == heap_cnt) return;
+
+    /*Fill the hole with the last timer and move it up or down*/
+    heap[idx] = heap[heap_cnt];
+    heap[idx]->heap_idx = idx;
+    heap_sift_up(idx);
+    heap_sift_down(heap[idx]->heap_idx);
+}
+
+static void heap_sift_up(uint32_t idx)
+{
+    lv_timer_t ** heap = LV_GC_ROOT(_lv_timer_heap);
+    lv_timer_t * timer = heap[idx];
+    while(idx > 0) {
+        uint32_t parent = (idx - 1) / 2;
+        if((int32_t)(timer->deadline - heap[parent]->deadline) >= 0) break;
+        heap[idx] = heap[parent];
+        heap[idx]->heap_idx = idx;
+        idx = parent;
+    }
+    heap[idx] = timer;
+    timer->heap_idx = idx;
+}
+
+static void heap_sift_down(uint32_t idx)
+{
+    lv_timer_t ** heap = LV_GC_ROOT(_lv_timer_heap);
+    lv_timer_t * timer = heap[idx];
+    while(1) {
+        uint32_t child = idx * 2 + 1;
+        if(child >= heap_cnt) break;
+        if(child + 1 < heap_cnt && (int32_t)(heap[child + 1]->deadline - heap[child]->deadline) < 0) child++;
+        if((int32_t)(heap[child]->deadline - timer->deadline) >= 0) break;
+        heap[idx] = heap[child];
+        heap[idx]->heap_idx = idx;
+        idx = child;
+    }
+    heap[idx] = timer;
+    timer->heap_idx = idx;
+}
+
+static bool park(lv_timer_t * timer)
+{
+    if(parked_cnt == parked_cap && !grow(&LV_GC_ROOT(_lv_timer_parked), &parked_cap, parked_static)) {
+        /*Keep it in the heap, it will be checked again in the next call*/
+        heap_push(timer);
+        return false;
+    }
+
+    LV_GC_ROOT(_lv_timer_parked)[parked_cnt] = timer;
+    timer->heap_idx = parked_cnt | HEAP_IDX_PARKED;
+    parked_cnt++;
+    return true;
+}
+
+/*`lv_timer_resume()` only clears `paused` (it's also called from other threads), schedule them here*/
+static void unpark_resumed(void)
+{
+    uint32_t i = 0;
+    while(i < parked_cnt) {
+        lv_timer_t * timer = LV_GC_ROOT(_lv_timer_parked)[i];
+        if(timer->paused) {
+            i++;
+            continue;
+        }
+        unschedule(timer);
+        update_deadline(timer);
+        heap_push(timer);
+    }
+}
+
+/*Remove a timer from the heap or from the parked timers*/
+static void unschedule(lv_timer_t * timer)
+{
+    if(timer->heap_idx == HEAP_IDX_NONE) return;
+
+    if(timer->heap_idx & HEAP_IDX_PARKED) {
+        lv_timer_t ** parked = LV_GC_ROOT(_lv_timer_parked);
+        uint32_t idx = timer->heap_idx & ~HEAP_IDX_PARKED;
+        parked_cnt--;
+        parked[idx] = parked[parked_cnt];
+        parked[idx]->heap_idx = idx | HEAP_IDX_PARKED;
+        timer->heap_idx = HEAP_IDX_NONE;
+    }
+    else {
+        heap_remove(timer);
+    }
+}
+
+/*Double the capacity of a full array. The first time it's moved from its static array to the LVGL heap.*/
+static bool grow(lv_timer_t *** array, uint32_t * cap, lv_timer_t ** static_array)
+{
+    uint32_t new_cap = *cap * 2;
+    lv_timer_t ** new_array;
+    if(*array == static_array) {
+        new_array = lv_mem_alloc(new_cap * sizeof(lv_timer_t *));
+        if(new_array) lv_memcpy(new_array, static_array, *cap * sizeof(lv_timer_t *));
+    }
+    else {
+        new_array = lv_mem_realloc(*array, new_cap * sizeof(lv_timer_t *));
+    }
+    LV_ASSERT_MALLOC(new_array);
+    if(new_array == NULL) return false;
+
+    *array = new_array;
+    *cap = new_cap;
+    return true;
+}
+
+#else
+
 /**
  * Execute timer if its remaining time is zero
  * @param timer pointer to lv_timer
@@ -310,7 +596,12 @@ static bool lv_timer_exec(lv_timer_t * timer)
         if(timer->repeat_count > 0) timer->repeat_count--;
         timer->last_run = lv_tick_get();
         TIMER_TRACE("calling timer callback: %p", *((void **)&timer->timer_cb));
-        if(timer->timer_cb && original_repeat_count != 0) timer->timer_cb(timer);
+        if(timer->timer_cb && original_repeat_count != 0) {
+            /*The timer might be deleted in its callback*/
+            LV_TRACE_BEGIN_ARG("timer", *((void **)&timer->timer_cb));
+            timer->timer_cb(timer);
+            LV_TRACE_END("timer");
+        }
         TIMER_TRACE("timer callback %p finished", *((void **)&timer->timer_cb));
         LV_ASSERT_MEM_INTEGRITY();
         exec = true;
@@ -339,3 +630,5 @@ static uint32_t lv_timer_time_remaining(lv_timer_t * timer)
         return 0;
     return timer->period - elp;
 }
+
+#endif /*LV_USE_TIMER_HEAP*/
@@ -48,6 +48,11 @@ typedef struct _lv_timer_t {
     void * user_data; /**< Custom user data*/
     int32_t repeat_count; /**< 1: One time;  -1 : infinity;  n>0: residual times*/
     uint32_t paused : 1;
+#if LV_USE_TIMER_HEAP
+    uint32_t deadline; /**< Tick when the timer is due, the key of the heap*/
+    uint32_t heap_idx; /**< Position in the heap or in the array of parked (paused) timers*/
+    uint32_t run_id; /**< The `lv_timer_handler()` call which ran it last*/
+#endif
 } lv_timer_t;
 
 /**********************
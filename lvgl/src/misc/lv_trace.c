@@ -0,0 +1,311 @@
+/**
+ * @file lv_trace.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE     /*pthread_getname_np*/
+#endif
+
+#include "lv_trace.h"
+
+#if LV_USE_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if (LV_TRACE_BUF_SIZE & (LV_TRACE_BUF_SIZE - 1)) != 0
+    #error "LV_TRACE_BUF_SIZE must be a power of 2"
+#endif
+
+#define BUF_MASK    (LV_TRACE_BUF_SIZE - 1)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+    EVENT_BEGIN,
+    EVENT_END,
+    EVENT_INSTANT,
+} event_type_t;
+
+typedef struct {
+    uint64_t ts;                /*[ns] CLOCK_MONOTONIC*/
+    const char * name;
+    const void * arg;
+    event_type_t type;
+} trace_event_t;
+
+typedef enum {
+    RING_FREE,                  /*Never used*/
+    RING_ALIVE,                 /*Used by a running thread*/
+    RING_DEAD,                  /*The thread exited, the events are kept until the ring is reused*/
+} ring_state_t;
+
+typedef struct {
+    trace_event_t * buf;
+    uint32_t head;              /*Number of events written. Only the owner thread writes it*/
+    uint32_t state;             /*ring_state_t*/
+    int tid;
+    char name[16];
+} trace_ring_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void add_event(event_type_t type, const char * name, const void * arg);
+static trace_ring_t * ring_claim(void);
+static void ring_release(void * ring);
+static void key_init(void);
+static uint32_t ring_copy(trace_ring_t * ring, trace_event_t * out);
+static void thread_name(trace_ring_t * ring, char * name, size_t size);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static trace_ring_t rings[LV_TRACE_THREAD_MAX];
+static bool trace_enabled = true;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ring_key;
+static __thread trace_ring_t * thread_ring;
+static __thread bool thread_no_ring;    /*All rings are used, don't try again*/
+
+/*Start of the executable (GNU ld), the `arg` pointers are written relative to it*/
+extern const char __executable_start;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_trace_begin(const char * name, const void * arg)
+{
+    add_event(EVENT_BEGIN, name, arg);
+}
+
+void lv_trace_end(const char * name)
+{
+    add_event(EVENT_END, name, NULL);
+}
+
+void lv_trace_instant(const char * name)
+{
+    add_event(EVENT_INSTANT, name, NULL);
+}
+
+void lv_trace_enable(bool en)
+{
+    __atomic_store_n(&trace_enabled, en, __ATOMIC_RELAXED);
+}
+
+lv_res_t lv_trace_dump(const char * path)
+{
+    FILE * f = fopen(path, "w");
+    if(f == NULL) return LV_RES_INV;
+
+    trace_event_t * events = malloc(LV_TRACE_BUF_SIZE * sizeof(trace_event_t));
+    if(events == NULL) {
+        fclose(f);
+        return LV_RES_INV;
+    }
+
+    int pid = getpid();
+    bool first = true;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    uint32_t i;
+    for(i = 0; i < LV_TRACE_THREAD_MAX; i++) {
+        trace_ring_t * ring = &rings[i];
+        if(__atomic_load_n(&ring->state, __ATOMIC_ACQUIRE) == RING_FREE) continue;
+
+        char name[16];
+        thread_name(ring, name, sizeof(name));
+        fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", pid, ring->tid, name);
+        first = false;
+
+        uint32_t cnt = ring_copy(ring, events);
+        uint32_t depth = 0;
+        uint32_t e;
+        for(e = 0; e < cnt; e++) {
+            trace_event_t * ev = &events[e];
+            char ph;
+            if(ev->type == EVENT_BEGIN) {
+                ph = 'B';
+                depth++;
+            }
+            else if(ev->type == EVENT_END) {
+                /*The begin of the span was overwritten*/
+                if(depth == 0) continue;
+                ph = 'E';
+                depth--;
+            }
+            else {
+                ph = 'i';
+            }
+
+            fprintf(f, ",\n{\"ph\":\"%c\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%llu.%03u", ph, ev->name, pid,
+                    ring->tid, (unsigned long long)(ev->ts / 1000), (unsigned)(ev->ts % 1000));
+            if(ev->arg) {
+                fprintf(f, ",\"args\":{\"addr\":\"0x%lx\"}",
+                        (unsigned long)((const char *)ev->arg - &__executable_start));
+            }
+            if(ph == 'i') fprintf(f, ",\"s\":\"t\"");
+            fprintf(f, "}");
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    free(events);
+
+    return LV_RES_OK;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void add_event(event_type_t type, const char * name, const void * arg)
+{
+    if(!__atomic_load_n(&trace_enabled, __ATOMIC_RELAXED)) return;
+
+    trace_ring_t * ring = thread_ring;
+    if(ring == NULL) {
+        if(thread_no_ring) return;
+        ring = ring_claim();
+        if(ring == NULL) {
+            thread_no_ring = true;
+            return;
+        }
+        thread_ring = ring;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    uint32_t head = ring->head;
+    trace_event_t * ev = &ring->buf[head & BUF_MASK];
+    ev->ts = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    ev->name = name;
+    ev->arg = arg;
+    ev->type = type;
+
+    /*Publish the event to lv_trace_dump()*/
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/*Get a ring for the calling thread. Prefer the never used ones to keep the events of exited threads*/
+static trace_ring_t * ring_claim(void)
+{
+    pthread_once(&key_once, key_init);
+
+    static const uint32_t claim_order[] = {RING_FREE, RING_DEAD};
+    trace_ring_t * ring = NULL;
+    uint32_t o;
+    for(o = 0; o < sizeof(claim_order) / sizeof(claim_order[0]) && ring == NULL; o++) {
+        uint32_t i;
+        for(i = 0; i < LV_TRACE_THREAD_MAX; i++) {
+            uint32_t expected = claim_order[o];
+            if(__atomic_compare_exchange_n(&rings[i].state, &expected, RING_ALIVE, false,
+                                           __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                ring = &rings[i];
+                break;
+            }
+        }
+    }
+    if(ring == NULL) return NULL;
+
+    /*Not lv_mem_alloc: it's called from any thread*/
+    if(ring->buf == NULL) {
+        ring->buf = malloc(LV_TRACE_BUF_SIZE * sizeof(trace_event_t));
+        if(ring->buf == NULL) {
+            __atomic_store_n(&ring->state, RING_FREE, __ATOMIC_RELEASE);
+            return NULL;
+        }
+    }
+
+    __atomic_store_n(&ring->head, 0, __ATOMIC_RELEASE);
+    ring->tid = syscall(SYS_gettid);
+    ring->name[0] = '\0';
+    pthread_setspecific(ring_key, ring);
+
+    return ring;
+}
+
+/*Thread exit: keep the events but allow reusing the ring*/
+static void ring_release(void * ring)
+{
+    trace_ring_t * r = ring;
+    pthread_getname_np(pthread_self(), r->name, sizeof(r->name));
+    __atomic_store_n(&r->state, RING_DEAD, __ATOMIC_RELEASE);
+}
+
+static void key_init(void)
+{
+    pthread_key_create(&ring_key, ring_release);
+}
+
+/**
+ * Copy the events of a ring in order while its thread might still write it.
+ * @return number of valid events in `out`
+ */
+static uint32_t ring_copy(trace_ring_t * ring, trace_event_t * out)
+{
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t start = head > LV_TRACE_BUF_SIZE ? head - LV_TRACE_BUF_SIZE : 0;
+    uint32_t i;
+    for(i = start; i < head; i++) out[i - start] = ring->buf[i & BUF_MASK];
+
+    /*The writer might have overwritten the oldest events during the copy, drop them*/
+    uint32_t head_after = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t valid_start = head_after >= LV_TRACE_BUF_SIZE ? head_after - LV_TRACE_BUF_SIZE + 1 : 0;
+    if(head_after < head) return 0; /*Reused by an other thread*/
+    if(valid_start <= start) return head - start;
+    if(valid_start >= head) return 0;
+
+    uint32_t drop = valid_start - start;
+    memmove(out, out + drop, (head - valid_start) * sizeof(trace_event_t));
+    return head - valid_start;
+}
+
+static void thread_name(trace_ring_t * ring, char * name, size_t size)
+{
+    if(__atomic_load_n(&ring->state, __ATOMIC_ACQUIRE) == RING_DEAD && ring->name[0] != '\0') {
+        snprintf(name, size, "%s", ring->name);
+        return;
+    }
+
+    /*The name can be set after the first event so read the current one*/
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", ring->tid);
+    FILE * f = fopen(path, "r");
+    if(f && fgets(name, size, f)) {
+        name[strcspn(name, "\n")] = '\0';
+    }
+    else {
+        snprintf(name, size, "%d", ring->tid);
+    }
+    if(f) fclose(f);
+}
+
+#endif /*LV_USE_TRACE*/
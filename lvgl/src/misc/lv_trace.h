@@ -0,0 +1,97 @@
+/**
+ * @file lv_trace.h
+ * Timeline of the rendering, flushing, input reading, timers and worker threads.
+ *
+ * Each thread writes begin/end events into its own ring buffer without locking,
+ * the oldest events are overwritten, so the last few seconds are always available.
+ * `lv_trace_dump()` writes them in the Chrome trace event format
+ * which can be opened in chrome://tracing or https://ui.perfetto.dev.
+ */
+
+#ifndef LV_TRACE_H
+#define LV_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "../lv_conf_internal.h"
+#include "lv_types.h"
+
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+#if LV_USE_TRACE
+
+/**
+ * Start a span on the calling thread.
+ * @param name      name of the span, must be a string literal (only the pointer is saved)
+ * @param arg       optional pointer saved with the event (e.g. a callback), shown relative to
+ *                  the start of the executable so it can be resolved with `addr2line`
+ */
+void lv_trace_begin(const char * name, const void * arg);
+
+/**
+ * End the last span started by `lv_trace_begin()` on the calling thread.
+ * @param name      name of the span
+ */
+void lv_trace_end(const char * name);
+
+/**
+ * Add an instant event (e.g. a touch press) on the calling thread.
+ * @param name      name of the event, must be a string literal
+ */
+void lv_trace_instant(const char * name);
+
+/**
+ * Enable or disable the recording. It's enabled by default.
+ * @param en        true: enable, false: disable
+ */
+void lv_trace_enable(bool en);
+
+/**
+ * Write the recorded events of all threads to a file as Chrome trace JSON.
+ * Can be called from any thread while the others keep recording.
+ * @param path      path of the file
+ * @return          LV_RES_OK: the file was written; LV_RES_INV: the file can't be opened
+ */
+lv_res_t lv_trace_dump(const char * path);
+
+#endif /*LV_USE_TRACE*/
+
+/**********************
+ *      MACROS
+ **********************/
+
+#if LV_USE_TRACE
+#define LV_TRACE_BEGIN(name)            lv_trace_begin(name, NULL)
+#define LV_TRACE_BEGIN_ARG(name, arg)   lv_trace_begin(name, arg)
+#define LV_TRACE_END(name)              lv_trace_end(name)
+#define LV_TRACE_INSTANT(name)          lv_trace_instant(name)
+#else
+#define LV_TRACE_BEGIN(name)
+#define LV_TRACE_BEGIN_ARG(name, arg)
+#define LV_TRACE_END(name)
+#define LV_TRACE_INSTANT(name)
+#endif
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_TRACE_H*/
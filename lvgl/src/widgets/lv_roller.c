@@ -14,6 +14,7 @@
 #include "../core/lv_group.h"
 #include "../core/lv_indev.h"
 #include "../core/lv_indev_scroll.h"
+#include "../core/lv_refr.h"
 
 /*********************
  *      DEFINES
@@ -29,10 +30,20 @@
  *  STATIC PROTOTYPES
  **********************/
 static void lv_roller_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
+#if LV_ROLLER_STRIP
+static void lv_roller_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
+#endif
 static void lv_roller_event(const lv_obj_class_t * class_p, lv_event_t * e);
 static void lv_roller_label_event(const lv_obj_class_t * class_p, lv_event_t * e);
 static void draw_main(lv_event_t * e);
 static void draw_label(lv_event_t * e);
+static void draw_text(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx, bool sel, const lv_draw_label_dsc_t * dsc,
+                      const lv_area_t * coords, const lv_area_t * visible, const char * txt);
+#if LV_ROLLER_STRIP
+static bool strip_prepare(lv_obj_t * obj, _lv_roller_strip_t * strip, const lv_draw_label_dsc_t * dsc,
+                          const lv_area_t * coords, const lv_area_t * visible, const char * txt);
+static void strip_free(_lv_roller_strip_t * strip);
+#endif
 static void get_sel_area(lv_obj_t * obj, lv_area_t * sel_area);
 static void refr_position(lv_obj_t * obj, lv_anim_enable_t animen);
 static lv_res_t release_handler(lv_obj_t * obj);
@@ -47,6 +58,9 @@ static void set_y_anim(void * obj, int32_t v);
  **********************/
 const lv_obj_class_t lv_roller_class = {
     .constructor_cb = lv_roller_constructor,
+#if LV_ROLLER_STRIP
+    .destructor_cb = lv_roller_destructor,
+#endif
     .event_cb = lv_roller_event,
     .width_def = LV_SIZE_CONTENT,
     .height_def = LV_DPI_DEF,
@@ -104,6 +118,11 @@ void lv_roller_set_options(lv_obj_t * obj, const char * options, lv_roller_mode_
     roller->sel_opt_id     = 0;
     roller->sel_opt_id_ori = 0;
 
+#if LV_ROLLER_STRIP
+    strip_free(&roller->strip);
+    strip_free(&roller->strip_sel);
+#endif
+
     /*Count the '\n'-s to determine the number of options*/
     roller->option_cnt = 0;
     uint32_t cnt;
@@ -312,6 +331,17 @@ static void lv_roller_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj
     LV_LOG_TRACE("finshed");
 }
 
+#if LV_ROLLER_STRIP
+static void lv_roller_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
+{
+    LV_UNUSED(class_p);
+    lv_roller_t * roller = (lv_roller_t *)obj;
+
+    strip_free(&roller->strip);
+    strip_free(&roller->strip_sel);
+}
+#endif
+
 static void lv_roller_event(const lv_obj_class_t * class_p, lv_event_t * e)
 {
     LV_UNUSED(class_p);
@@ -515,7 +545,7 @@ static void draw_main(lv_event_t * e)
             label_dsc.flag |= LV_TEXT_FLAG_EXPAND;
             const lv_area_t * clip_area_ori = draw_ctx->clip_area;
             draw_ctx->clip_area = &mask_sel;
-            lv_draw_label(draw_ctx, &label_dsc, &label_sel_area, lv_label_get_text(label), NULL);
+            draw_text(obj, draw_ctx, true, &label_dsc, &label_sel_area, &sel_area, lv_label_get_text(label));
             draw_ctx->clip_area = clip_area_ori;
         }
     }
@@ -553,7 +583,8 @@ static void draw_label(lv_event_t * e)
     if(_lv_area_intersect(&clip2, draw_ctx->clip_area, &clip2)) {
         const lv_area_t * clip_area_ori2 = draw_ctx->clip_area;
         draw_ctx->clip_area = &clip2;
-        lv_draw_label(draw_ctx, &label_draw_dsc, &label_obj->coords, lv_label_get_text(label_obj), NULL);
+        draw_text(roller, draw_ctx, false, &label_draw_dsc, &label_obj->coords, &roller->coords,
+                  lv_label_get_text(label_obj));
         draw_ctx->clip_area = clip_area_ori2;
     }
 
@@ -564,13 +595,190 @@ static void draw_label(lv_event_t * e)
     if(_lv_area_intersect(&clip2, draw_ctx->clip_area, &clip2)) {
         const lv_area_t * clip_area_ori2 = draw_ctx->clip_area;
         draw_ctx->clip_area = &clip2;
-        lv_draw_label(draw_ctx, &label_draw_dsc, &label_obj->coords, lv_label_get_text(label_obj), NULL);
+        draw_text(roller, draw_ctx, false, &label_draw_dsc, &label_obj->coords, &roller->coords,
+                  lv_label_get_text(label_obj));
         draw_ctx->clip_area = clip_area_ori2;
     }
 
     draw_ctx->clip_area = clip_area_ori;
 }
 
+/**
+ * Draw the options with the normal or the selected style.
+ * Blend the pre-rendered strip if it's possible, else draw the text.
+ * @param obj       pointer to a roller
+ * @param draw_ctx  draw context
+ * @param sel       true: selected style; false: normal style
+ * @param dsc       the label draw descriptor of the style
+ * @param coords    area of the text
+ * @param visible   the text can be seen only in this area
+ * @param txt       the options
+ */
+static void draw_text(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx, bool sel, const lv_draw_label_dsc_t * dsc,
+                      const lv_area_t * coords, const lv_area_t * visible, const char * txt)
+{
+#if LV_ROLLER_STRIP
+    lv_roller_t * roller = (lv_roller_t *)obj;
+    _lv_roller_strip_t * strip = sel ? &roller->strip_sel : &roller->strip;
+    if(strip_prepare(obj, strip, dsc, coords, visible, txt)) {
+        /*The strip is the alpha of the text, the color and opacity are applied here*/
+        lv_draw_img_dsc_t img_dsc;
+        lv_draw_img_dsc_init(&img_dsc);
+        img_dsc.recolor = dsc->color;
+        img_dsc.opa = dsc->opa;
+        img_dsc.blend_mode = dsc->blend_mode;
+
+        lv_area_t strip_area;
+        strip_area.x1 = coords->x1;
+        strip_area.x2 = coords->x2;
+        strip_area.y1 = coords->y1 + strip->y_ofs;
+        strip_area.y2 = strip_area.y1 + strip->img.header.h - 1;
+        lv_draw_img(draw_ctx, &img_dsc, &strip_area, &strip->img);
+        return;
+    }
+#else
+    LV_UNUSED(obj);
+    LV_UNUSED(sel);
+    LV_UNUSED(visible);
+#endif
+
+    lv_draw_label(draw_ctx, dsc, coords, txt, NULL);
+}
+
+#if LV_ROLLER_STRIP
+/**
+ * Render the visible rows of the options into the strip if they aren't rendered yet or the size or the font changed.
+ * The rows around the visible ones are rendered too so a scroll re-renders the strip only when it leaves them.
+ * @return      true: the strip can be used; false: draw the text normally
+ */
+static bool strip_prepare(lv_obj_t * obj, _lv_roller_strip_t * strip, const lv_draw_label_dsc_t * dsc,
+                          const lv_area_t * coords, const lv_area_t * visible, const char * txt)
+{
+    /*A recolored text has more colors and A8 images are drawn directly only without masks*/
+    if(dsc->flag & LV_TEXT_FLAG_RECOLOR) return false;
+#if LV_DRAW_COMPLEX
+    if(lv_draw_mask_is_any(coords)) return false;
+#endif
+
+    lv_coord_t w = lv_area_get_width(coords);
+    lv_coord_t h = lv_area_get_height(coords);
+    if(w <= 0 || h <= 0) {
+        strip_free(strip);
+        return false;
+    }
+
+    /*The visible rows relative to the text*/
+    lv_coord_t vis_y1 = LV_MAX(visible->y1, coords->y1) - coords->y1;
+    lv_coord_t vis_y2 = LV_MIN(visible->y2, coords->y2) - coords->y1;
+    if(vis_y1 > vis_y2) return false;
+
+    lv_coord_t vis_h = vis_y2 - vis_y1 + 1;
+    lv_coord_t max_h = LV_MIN(LV_ROLLER_STRIP_MAX_SIZE / w, h);
+    if(vis_h > max_h) {
+        strip_free(strip);
+        return false;
+    }
+
+    bool same_dsc = strip->dsc.font == dsc->font && strip->dsc.letter_space == dsc->letter_space &&
+                    strip->dsc.line_space == dsc->line_space && strip->dsc.flag == dsc->flag &&
+                    strip->dsc.align == dsc->align && strip->dsc.decor == dsc->decor &&
+                    strip->dsc.bidi_dir == dsc->bidi_dir;
+    if(strip->img.data && strip->img.header.w == w && strip->txt_h == h && same_dsc &&
+       vis_y1 >= strip->y_ofs && vis_y2 < strip->y_ofs + (lv_coord_t)strip->img.header.h) {
+        return true;
+    }
+
+    /*Render half of the visible height above and below too, within the size limit and the text*/
+    lv_coord_t win_h = LV_MIN(vis_h * 2, max_h);
+    lv_coord_t y_ofs = vis_y1 - (win_h - vis_h) / 2;
+    if(y_ofs + win_h > h) y_ofs = h - win_h;
+    if(y_ofs < 0) y_ofs = 0;
+
+    /*Keep the buffer if only the window moved*/
+    uint32_t size = (uint32_t)w * win_h;
+    uint8_t * buf;
+    if(strip->img.data && strip->img.data_size == size) {
+        lv_img_cache_invalidate_src(&strip->img);
+        buf = (uint8_t *)strip->img.data;
+        strip->img.data = NULL;
+    }
+    else {
+        strip_free(strip);
+        buf = lv_mem_alloc(size);
+        if(buf == NULL) {
+            LV_LOG_WARN("couldn't allocate %"LV_PRIu32" bytes for the options", size);
+            return false;
+        }
+    }
+    lv_memset_00(buf, size);
+
+    /*Render the text in white with full opacity to get its alpha.
+     *The text is shifted up by the window's offset and clipped to the window.*/
+    lv_area_t area;
+    lv_area_set(&area, 0, 0, w - 1, win_h - 1);
+    lv_area_t txt_area;
+    lv_area_set(&txt_area, 0, -y_ofs, w - 1, h - 1 - y_ofs);
+
+    lv_disp_t * obj_disp = lv_obj_get_disp(obj);
+    lv_disp_drv_t driver;
+    lv_disp_drv_init(&driver);
+    driver.hor_res = w;
+    driver.ver_res = win_h;
+    lv_disp_drv_use_generic_set_px_cb(&driver, LV_IMG_CF_ALPHA_8BIT);
+
+    lv_disp_t fake_disp;
+    lv_memset_00(&fake_disp, sizeof(lv_disp_t));
+    fake_disp.driver = &driver;
+
+    lv_draw_ctx_t * draw_ctx = lv_mem_alloc(obj_disp->driver->draw_ctx_size);
+    LV_ASSERT_MALLOC(draw_ctx);
+    if(draw_ctx == NULL) {
+        lv_mem_free(buf);
+        return false;
+    }
+    obj_disp->driver->draw_ctx_init(&driver, draw_ctx);
+    driver.draw_ctx = draw_ctx;
+    draw_ctx->clip_area = &area;
+    draw_ctx->buf_area = &area;
+    draw_ctx->buf = buf;
+
+    lv_draw_label_dsc_t render_dsc = *dsc;
+    render_dsc.color = lv_color_white();
+    render_dsc.opa = LV_OPA_COVER;
+    render_dsc.blend_mode = LV_BLEND_MODE_NORMAL;
+
+    lv_disp_t * refr_ori = _lv_refr_get_disp_refreshing();
+    _lv_refr_set_disp_refreshing(&fake_disp);
+
+    lv_draw_label(draw_ctx, &render_dsc, &txt_area, txt, NULL);
+    lv_draw_wait_for_finish(draw_ctx);
+
+    _lv_refr_set_disp_refreshing(refr_ori);
+    obj_disp->driver->draw_ctx_deinit(&driver, draw_ctx);
+    lv_mem_free(draw_ctx);
+
+    strip->img.header.always_zero = 0;
+    strip->img.header.w = w;
+    strip->img.header.h = win_h;
+    strip->img.header.cf = LV_IMG_CF_ALPHA_8BIT;
+    strip->img.data_size = size;
+    strip->img.data = buf;
+    strip->dsc = *dsc;
+    strip->y_ofs = y_ofs;
+    strip->txt_h = h;
+    return true;
+}
+
+static void strip_free(_lv_roller_strip_t * strip)
+{
+    if(strip->img.data == NULL) return;
+
+    lv_img_cache_invalidate_src(&strip->img);
+    lv_mem_free((void *)strip->img.data);
+    strip->img.data = NULL;
+}
+#endif
+
 static void get_sel_area(lv_obj_t * obj, lv_area_t * sel_area)
 {
 
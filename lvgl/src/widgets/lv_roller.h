@@ -41,6 +41,16 @@ enum {
 
 typedef uint8_t lv_roller_mode_t;
 
+#if LV_ROLLER_STRIP
+/*The visible rows of the options (and some more) pre-rendered into an 8 bit alpha map*/
+typedef struct {
+    lv_img_dsc_t img;                   /**< `data` is NULL if it's not rendered*/
+    lv_draw_label_dsc_t dsc;            /**< Rendered with this descriptor (the color and opacity are applied later)*/
+    lv_coord_t y_ofs;                   /**< The first rendered row from the top of the text*/
+    lv_coord_t txt_h;                   /**< Height of the whole text*/
+} _lv_roller_strip_t;
+#endif
+
 typedef struct {
     lv_obj_t obj;
     uint16_t option_cnt;          /**< Number of options*/
@@ -48,6 +58,10 @@ typedef struct {
     uint16_t sel_opt_id_ori;      /**< Store the original index on focus*/
     lv_roller_mode_t mode : 1;
     uint32_t moved : 1;
+#if LV_ROLLER_STRIP
+    _lv_roller_strip_t strip;           /**< The options with the normal style*/
+    _lv_roller_strip_t strip_sel;       /**< The options with the selected style*/
+#endif
 } lv_roller_t;
 
 extern const lv_obj_class_t lv_roller_class;
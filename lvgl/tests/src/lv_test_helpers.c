@@ -0,0 +1,29 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+#include "lv_test_helpers.h"
+
+extern lv_color_t test_fb[];
+
+lv_obj_t * lv_test_rect_create(lv_obj_t * parent, lv_coord_t x, lv_coord_t y, lv_coord_t size, uint32_t color)
+{
+    lv_obj_t * obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_set_pos(obj, x, y);
+    lv_obj_set_size(obj, size, size);
+    lv_obj_set_style_bg_color(obj, lv_color_hex(color), 0);
+    lv_obj_set_style_bg_opa(obj, LV_OPA_COVER, 0);
+    return obj;
+}
+
+void lv_test_redraw_all(void)
+{
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+}
+
+lv_color_t lv_test_px_get(lv_coord_t x, lv_coord_t y)
+{
+    return test_fb[y * lv_disp_get_hor_res(NULL) + x];
+}
+
+#endif
@@ -17,6 +17,15 @@ static inline uint32_t lv_test_get_free_mem(void)
 }
 #endif /* LVGL_CI_USING_SYS_HEAP */
 
+/*A square with an opaque background and no other styles*/
+lv_obj_t * lv_test_rect_create(lv_obj_t * parent, lv_coord_t x, lv_coord_t y, lv_coord_t size, uint32_t color);
+
+/*Redraw the whole screen, the frame buffer is up to date after it*/
+void lv_test_redraw_all(void);
+
+/*A pixel of the frame buffer*/
+lv_color_t lv_test_px_get(lv_coord_t x, lv_coord_t y);
+
 
 #endif /*LV_TEST_HELPERS_H*/
 
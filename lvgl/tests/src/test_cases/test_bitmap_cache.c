@@ -0,0 +1,204 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+#include "lv_test_helpers.h"
+
+#if LV_USE_BITMAP_CACHE
+
+extern lv_color_t test_fb[];
+
+static lv_obj_t * cached;
+static lv_obj_t * child;
+
+static lv_bitmap_cache_stats_t stats_get(void)
+{
+    lv_bitmap_cache_stats_t stats;
+    lv_bitmap_cache_get_stats(&stats);
+    return stats;
+}
+
+void setUp(void)
+{
+    lv_bitmap_cache_set_size(LV_BITMAP_CACHE_SIZE);
+    lv_bitmap_cache_clear();
+    lv_bitmap_cache_reset_stats();
+
+    cached = lv_test_rect_create(lv_scr_act(), 10, 10, 100, 0xff0000);
+    child = lv_test_rect_create(cached, 20, 20, 40, 0x00ff00);
+    lv_obj_add_flag(cached, LV_OBJ_FLAG_CACHE_BITMAP);
+    lv_refr_now(NULL);
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+    lv_bitmap_cache_clear();
+}
+
+void test_bitmap_cache_redraw_from_surface(void)
+{
+    TEST_ASSERT_EQUAL(1, stats_get().miss_cnt);
+    TEST_ASSERT_EQUAL(1, stats_get().entry_cnt);
+    TEST_ASSERT_EQUAL(1, stats_get().opaque_cnt);
+
+    lv_test_redraw_all();
+    TEST_ASSERT_EQUAL(1, stats_get().miss_cnt);
+    TEST_ASSERT_EQUAL(1, stats_get().hit_cnt);
+
+    /*The blitted surface looks the same as the directly drawn subtree*/
+    static lv_color_t fb_cached[800 * 480];
+    lv_memcpy(fb_cached, test_fb, sizeof(fb_cached));
+    lv_obj_clear_flag(cached, LV_OBJ_FLAG_CACHE_BITMAP);
+    lv_test_redraw_all();
+    TEST_ASSERT_EQUAL(0, stats_get().entry_cnt);
+    TEST_ASSERT_EQUAL_MEMORY(fb_cached, test_fb, sizeof(fb_cached));
+}
+
+void test_bitmap_cache_invalidated_on_style_change(void)
+{
+    lv_obj_set_style_bg_color(child, lv_color_hex(0x0000ff), 0);
+    TEST_ASSERT_EQUAL(1, stats_get().inv_cnt);
+
+    lv_test_redraw_all();
+    TEST_ASSERT_EQUAL(2, stats_get().miss_cnt);
+    TEST_ASSERT_EQUAL_COLOR(lv_color_hex(0x0000ff), lv_test_px_get(40, 40));
+}
+
+void test_bitmap_cache_invalidated_on_state_change(void)
+{
+    lv_obj_add_state(child, LV_STATE_PRESSED);
+    TEST_ASSERT_EQUAL(1, stats_get().inv_cnt);
+
+    lv_test_redraw_all();
+    TEST_ASSERT_EQUAL(2, stats_get().miss_cnt);
+}
+
+void test_bitmap_cache_invalidated_on_child_add(void)
+{
+    lv_test_rect_create(child, 5, 5, 10, 0x0000ff);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, stats_get().inv_cnt);
+
+    lv_refr_now(NULL);
+    TEST_ASSERT_EQUAL(2, stats_get().miss_cnt);
+    TEST_ASSERT_EQUAL(0, stats_get().hit_cnt);
+}
+
+void test_bitmap_cache_invalidated_while_invalidation_is_disabled(void)
+{
+    lv_disp_enable_invalidation(NULL, false);
+    lv_obj_set_style_bg_color(child, lv_color_hex(0x0000ff), 0);
+    lv_disp_enable_invalidation(NULL, true);
+    TEST_ASSERT_EQUAL(1, stats_get().inv_cnt);
+
+    lv_test_redraw_all();
+    TEST_ASSERT_EQUAL(2, stats_get().miss_cnt);
+    TEST_ASSERT_EQUAL_COLOR(lv_color_hex(0x0000ff), lv_test_px_get(40, 40));
+}
+
+void test_bitmap_cache_invalidated_on_parent_mask_change(void)
+{
+    lv_obj_t * parent = lv_test_rect_create(lv_scr_act(), 200, 10, 50, 0xffffff);
+    lv_obj_set_style_clip_corner(parent, true, 0);
+    lv_obj_t * masked = lv_test_rect_create(parent, 0, 0, 50, 0x0000ff);
+    lv_obj_set_height(masked, 75);
+    lv_obj_add_flag(masked, LV_OBJ_FLAG_CACHE_BITMAP);
+
+    lv_obj_t * plain = lv_test_rect_create(lv_scr_act(), 400, 10, 50, 0xffffff);
+    lv_obj_t * unmasked = lv_test_rect_create(plain, 0, 0, 50, 0x0000ff);
+    lv_obj_set_height(unmasked, 75);
+    lv_obj_add_flag(unmasked, LV_OBJ_FLAG_CACHE_BITMAP);
+
+    lv_refr_now(NULL);
+    TEST_ASSERT_EQUAL(3, stats_get().entry_cnt);
+    lv_bitmap_cache_reset_stats();
+
+    /*The radius mask of the parent is baked into the surface*/
+    lv_obj_set_style_radius(parent, 20, 0);
+    TEST_ASSERT_EQUAL(1, stats_get().inv_cnt);
+    lv_refr_now(NULL);
+    TEST_ASSERT_EQUAL(1, stats_get().miss_cnt);
+
+    /*Scrolling moves the child under the mask, but an unmasked surface can be moved*/
+    lv_obj_scroll_to_y(parent, 10, LV_ANIM_OFF);
+    lv_obj_scroll_to_y(plain, 10, LV_ANIM_OFF);
+    lv_refr_now(NULL);
+    TEST_ASSERT_EQUAL(2, stats_get().inv_cnt);
+    TEST_ASSERT_EQUAL(2, stats_get().miss_cnt);
+    TEST_ASSERT_EQUAL(1, stats_get().hit_cnt);
+
+    /*The mask follows the size of the parent*/
+    lv_obj_set_height(parent, 40);
+    lv_obj_update_layout(parent);
+    TEST_ASSERT_EQUAL(3, stats_get().inv_cnt);
+}
+
+void test_bitmap_cache_evicts_least_recently_used(void)
+{
+    uint32_t size = stats_get().used_size;
+    lv_bitmap_cache_set_size(size + size / 2);
+
+    lv_obj_t * cached2 = lv_test_rect_create(lv_scr_act(), 200, 10, 100, 0x0000ff);
+    lv_obj_add_flag(cached2, LV_OBJ_FLAG_CACHE_BITMAP);
+    lv_refr_now(NULL);
+
+    /*Only one surface fits so the older one was evicted*/
+    TEST_ASSERT_EQUAL(1, stats_get().evict_cnt);
+    TEST_ASSERT_EQUAL(1, stats_get().entry_cnt);
+    TEST_ASSERT_LESS_OR_EQUAL(stats_get().max_size, stats_get().used_size);
+
+    lv_bitmap_cache_set_size(0);
+    TEST_ASSERT_EQUAL(0, stats_get().used_size);
+}
+
+#else /*LV_USE_BITMAP_CACHE*/
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_bitmap_cache_redraw_from_surface(void)
+{
+
+}
+
+void test_bitmap_cache_invalidated_on_style_change(void)
+{
+
+}
+
+void test_bitmap_cache_invalidated_on_state_change(void)
+{
+
+}
+
+void test_bitmap_cache_invalidated_on_child_add(void)
+{
+
+}
+
+void test_bitmap_cache_invalidated_while_invalidation_is_disabled(void)
+{
+
+}
+
+void test_bitmap_cache_invalidated_on_parent_mask_change(void)
+{
+
+}
+
+void test_bitmap_cache_evicts_least_recently_used(void)
+{
+
+}
+
+#endif
+
+#endif
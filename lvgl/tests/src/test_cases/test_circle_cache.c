@@ -0,0 +1,144 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+#include "lv_test_helpers.h"
+
+#if LV_DRAW_COMPLEX && LV_CIRCLE_CACHE_SIZE
+
+/*A circle of radius r takes 6 * r + 6 bytes*/
+#define CIRCLE_SIZE(r)  ((r) * 6 + 6)
+
+static lv_obj_t * rounded_create(lv_coord_t x, lv_coord_t y, lv_coord_t size, lv_coord_t radius)
+{
+    lv_obj_t * obj = lv_test_rect_create(lv_scr_act(), x, y, size, 0xff0000);
+    lv_obj_set_style_radius(obj, radius, 0);
+    return obj;
+}
+
+/*Redraw only the object*/
+static void redraw(lv_obj_t * obj)
+{
+    lv_obj_invalidate(obj);
+    lv_refr_now(NULL);
+}
+
+static lv_draw_mask_circle_cache_stats_t stats_get(void)
+{
+    lv_draw_mask_circle_cache_stats_t stats;
+    lv_draw_mask_get_circle_cache_stats(&stats);
+    return stats;
+}
+
+/*Draw the new objects and start with an empty cache*/
+static void cache_reset(void)
+{
+    lv_refr_now(NULL);
+    _lv_draw_mask_cleanup();
+    lv_draw_mask_reset_circle_cache_stats();
+}
+
+void setUp(void)
+{
+    cache_reset();
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_circle_cache_hit(void)
+{
+    lv_obj_t * obj = rounded_create(50, 50, 100, 20);
+    redraw(obj);
+    uint32_t miss_cnt = stats_get().miss_cnt;
+    TEST_ASSERT_EQUAL(1, miss_cnt);
+    TEST_ASSERT_EQUAL(1, stats_get().entry_cnt);
+    TEST_ASSERT_EQUAL(CIRCLE_SIZE(20), stats_get().used_size);
+
+    redraw(obj);
+    TEST_ASSERT_EQUAL(miss_cnt, stats_get().miss_cnt);
+    TEST_ASSERT_GREATER_THAN(0, stats_get().hit_cnt);
+}
+
+void test_circle_cache_budget(void)
+{
+    /*Two circles fit into the budget, the third one doesn't*/
+    uint32_t max_size = stats_get().max_size;
+    lv_coord_t r = (max_size / 3 - 6) / 6 + 1;
+    TEST_ASSERT_LESS_OR_EQUAL(max_size, CIRCLE_SIZE(r) + CIRCLE_SIZE(r + 1));
+
+    lv_obj_t * obj1 = rounded_create(20, 20, 2 * r + 2, r);
+    lv_obj_t * obj2 = rounded_create(20 + 2 * r + 10, 20, 2 * r + 4, r + 1);
+    lv_obj_t * obj3 = rounded_create(20, 20 + 2 * r + 10, 2 * r + 6, r + 2);
+    cache_reset();
+
+    redraw(obj1);
+    redraw(obj2);
+    TEST_ASSERT_EQUAL(2, stats_get().entry_cnt);
+    TEST_ASSERT_EQUAL(0, stats_get().evict_cnt);
+
+    /*Use the first one again, so the second one is the least recently used*/
+    redraw(obj1);
+    redraw(obj3);
+    TEST_ASSERT_EQUAL(1, stats_get().evict_cnt);
+    TEST_ASSERT_EQUAL(2, stats_get().entry_cnt);
+    TEST_ASSERT_EQUAL(CIRCLE_SIZE(r) + CIRCLE_SIZE(r + 2), stats_get().used_size);
+    TEST_ASSERT_LESS_OR_EQUAL(max_size, stats_get().used_size);
+
+    uint32_t miss_cnt = stats_get().miss_cnt;
+    redraw(obj1);
+    redraw(obj3);
+    TEST_ASSERT_EQUAL(miss_cnt, stats_get().miss_cnt);
+    redraw(obj2);
+    TEST_ASSERT_EQUAL(miss_cnt + 1, stats_get().miss_cnt);
+}
+
+void test_circle_cache_too_large_circle_is_not_cached(void)
+{
+    /*The inner radius of the border is too large too*/
+    lv_coord_t r = stats_get().max_size / 6 + 2;
+    lv_obj_t * obj = rounded_create(0, 0, 2 * r, r);
+    lv_obj_set_style_bg_opa(obj, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(obj, 2, 0);
+    lv_obj_set_style_border_opa(obj, LV_OPA_COVER, 0);
+    cache_reset();
+    redraw(obj);
+
+    TEST_ASSERT_GREATER_THAN(0, stats_get().miss_cnt);
+    TEST_ASSERT_EQUAL(0, stats_get().entry_cnt);
+    TEST_ASSERT_EQUAL(0, stats_get().used_size);
+}
+
+#else /*LV_DRAW_COMPLEX && LV_CIRCLE_CACHE_SIZE*/
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_circle_cache_hit(void)
+{
+
+}
+
+void test_circle_cache_budget(void)
+{
+
+}
+
+void test_circle_cache_too_large_circle_is_not_cached(void)
+{
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+#define PANEL_CNT   3
+#define ITEM_CNT    4
+
+static lv_obj_t * cont;
+static lv_obj_t * panels[PANEL_CNT];
+static lv_obj_t * items[PANEL_CNT][ITEM_CNT];
+
+static lv_layout_stats_t stats_get(void)
+{
+    lv_layout_stats_t stats;
+    lv_layout_get_stats(&stats);
+    return stats;
+}
+
+void setUp(void)
+{
+    /*A column of panels with rows of items in them*/
+    cont = lv_obj_create(lv_scr_act());
+    lv_obj_set_size(cont, 400, LV_SIZE_CONTENT);
+    lv_obj_set_flex_flow(cont, LV_FLEX_FLOW_COLUMN);
+
+    uint32_t p;
+    for(p = 0; p < PANEL_CNT; p++) {
+        panels[p] = lv_obj_create(cont);
+        lv_obj_set_size(panels[p], LV_PCT(100), LV_SIZE_CONTENT);
+        lv_obj_set_flex_flow(panels[p], LV_FLEX_FLOW_ROW);
+
+        uint32_t i;
+        for(i = 0; i < ITEM_CNT; i++) {
+            items[p][i] = lv_obj_create(panels[p]);
+            lv_obj_set_size(items[p][i], 40, 40);
+        }
+    }
+
+    lv_obj_update_layout(cont);
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_layout_updates_only_the_dirty_path(void)
+{
+    lv_obj_t * item = items[1][1];
+    lv_obj_t * next_item = items[1][2];
+    lv_coord_t next_item_x = lv_obj_get_x(next_item);
+    lv_coord_t panel_h = lv_obj_get_height(panels[1]);
+    lv_coord_t last_panel_y = lv_obj_get_y(panels[2]);
+    lv_layout_stats_t stats_ori = stats_get();
+
+    lv_obj_set_size(item, 80, 80);
+    lv_obj_update_layout(item);
+
+    /*The nested item and everything depending on it is laid out*/
+    TEST_ASSERT_EQUAL(80, lv_obj_get_width(item));
+    TEST_ASSERT_EQUAL(next_item_x + 40, lv_obj_get_x(next_item));
+    TEST_ASSERT_EQUAL(panel_h + 40, lv_obj_get_height(panels[1]));
+    TEST_ASSERT_EQUAL(last_panel_y + 40, lv_obj_get_y(panels[2]));
+
+    /*Only the screen, `cont`, the panel and its items were visited, not the other panels' items*/
+    lv_layout_stats_t stats = stats_get();
+    uint32_t passes = stats.passes - stats_ori.passes;
+    uint32_t visited = stats.visited - stats_ori.visited;
+    TEST_ASSERT_GREATER_OR_EQUAL(1, passes);
+    TEST_ASSERT_LESS_OR_EQUAL(passes * (3 + ITEM_CNT), visited);
+}
+
+void test_layout_clean_tree_is_not_visited(void)
+{
+    lv_layout_stats_t stats_ori = stats_get();
+
+    lv_obj_update_layout(cont);
+
+    lv_layout_stats_t stats = stats_get();
+    TEST_ASSERT_EQUAL(stats_ori.passes, stats.passes);
+    TEST_ASSERT_EQUAL(stats_ori.visited, stats.visited);
+}
+
+void test_layout_nested_dirty_child_in_clean_parent(void)
+{
+    /*A child without layout deep in the tree: only its path is visited*/
+    lv_obj_t * label = lv_label_create(items[2][3]);
+    lv_label_set_text(label, "A");
+    lv_obj_update_layout(label);
+    lv_layout_stats_t stats_ori = stats_get();
+
+    lv_label_set_text(label, "A longer text");
+    lv_obj_update_layout(label);
+
+    TEST_ASSERT_GREATER_THAN(lv_font_get_glyph_width(LV_FONT_DEFAULT, 'A', 0) * 5, lv_obj_get_width(label));
+
+    lv_layout_stats_t stats = stats_get();
+    uint32_t passes = stats.passes - stats_ori.passes;
+    uint32_t visited = stats.visited - stats_ori.visited;
+    TEST_ASSERT_GREATER_OR_EQUAL(1, passes);
+    /*Screen, `cont`, the panel, the item and the label*/
+    TEST_ASSERT_LESS_OR_EQUAL(passes * 5, visited);
+    TEST_ASSERT_LESS_THAN(1 + 1 + PANEL_CNT * (1 + ITEM_CNT), visited);
+}
+
+#endif
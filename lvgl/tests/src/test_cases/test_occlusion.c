@@ -0,0 +1,123 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+#include "lv_test_helpers.h"
+
+#if LV_USE_OCCLUSION_CULLING
+
+static lv_refr_occlusion_stats_t stats_get(void)
+{
+    lv_refr_occlusion_stats_t stats;
+    lv_refr_get_occlusion_stats(&stats);
+    return stats;
+}
+
+void setUp(void)
+{
+    lv_obj_set_style_bg_color(lv_scr_act(), lv_color_white(), 0);
+    lv_refr_reset_occlusion_stats();
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_occlusion_sibling_is_culled(void)
+{
+    lv_test_rect_create(lv_scr_act(), 20, 20, 50, 0xff0000);
+    lv_test_rect_create(lv_scr_act(), 10, 10, 100, 0x00ff00);
+    lv_test_redraw_all();
+
+    TEST_ASSERT_EQUAL(1, stats_get().culled_cnt);
+    TEST_ASSERT_EQUAL_COLOR(lv_color_hex(0x00ff00), lv_test_px_get(40, 40));
+}
+
+void test_occlusion_sibling_is_clipped(void)
+{
+    lv_test_rect_create(lv_scr_act(), 10, 10, 100, 0xff0000);
+    lv_obj_t * top = lv_test_rect_create(lv_scr_act(), 10, 10, 100, 0x00ff00);
+    lv_obj_set_height(top, 50);
+    lv_test_redraw_all();
+
+    TEST_ASSERT_EQUAL(0, stats_get().culled_cnt);
+    TEST_ASSERT_EQUAL(1, stats_get().clipped_cnt);
+    TEST_ASSERT_EQUAL_COLOR(lv_color_hex(0x00ff00), lv_test_px_get(20, 20));
+    TEST_ASSERT_EQUAL_COLOR(lv_color_hex(0xff0000), lv_test_px_get(80, 80));
+}
+
+void test_occlusion_clip_corner_parent(void)
+{
+    lv_obj_t * below = lv_test_rect_create(lv_scr_act(), 10, 10, 100, 0xff0000);
+    lv_obj_t * parent = lv_test_rect_create(lv_scr_act(), 10, 10, 100, 0x0000ff);
+    lv_obj_set_style_radius(parent, 30, 0);
+    lv_obj_set_style_clip_corner(parent, true, 0);
+    lv_test_rect_create(parent, 0, 0, 100, 0x00ff00);
+    lv_test_redraw_all();
+
+    /*The child is masked by the rounded corners so the object below is visible there*/
+    TEST_ASSERT_EQUAL(0, stats_get().culled_cnt);
+    TEST_ASSERT_EQUAL_COLOR(lv_color_hex(0xff0000), lv_test_px_get(11, 11));
+    TEST_ASSERT_EQUAL_COLOR(lv_color_hex(0x00ff00), lv_test_px_get(60, 60));
+
+    /*It's still covered without the corners*/
+    lv_obj_set_size(below, 40, 40);
+    lv_obj_set_pos(below, 40, 40);
+    lv_test_redraw_all();
+    TEST_ASSERT_EQUAL(1, stats_get().culled_cnt);
+}
+
+void test_occlusion_non_opaque_ancestor(void)
+{
+    lv_test_rect_create(lv_scr_act(), 20, 20, 50, 0xff0000);
+    lv_obj_t * parent = lv_test_rect_create(lv_scr_act(), 10, 10, 100, 0x0000ff);
+    lv_obj_set_style_bg_opa(parent, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_opa(parent, LV_OPA_50, 0);
+    lv_test_rect_create(parent, 0, 0, 100, 0x00ff00);
+    lv_test_redraw_all();
+
+    /*The child is opaque itself but blended with 50% opacity*/
+    TEST_ASSERT_EQUAL(0, stats_get().culled_cnt);
+    TEST_ASSERT_EQUAL(0, stats_get().clipped_cnt);
+    lv_color_t c = lv_test_px_get(40, 40);
+    TEST_ASSERT_NOT_EQUAL(0, LV_COLOR_GET_R(c));
+    TEST_ASSERT_NOT_EQUAL(0, LV_COLOR_GET_G(c));
+}
+
+#else /*LV_USE_OCCLUSION_CULLING*/
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_occlusion_sibling_is_culled(void)
+{
+
+}
+
+void test_occlusion_sibling_is_clipped(void)
+{
+
+}
+
+void test_occlusion_clip_corner_parent(void)
+{
+
+}
+
+void test_occlusion_non_opaque_ancestor(void)
+{
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,169 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+#include "lv_test_helpers.h"
+
+#define HOR_RES 800
+
+extern lv_color_t test_fb[];
+
+static lv_obj_t * roller;
+static lv_color_t fb_strip[HOR_RES * 480];
+
+/*Check that the options look the same when they are drawn as text*/
+static void assert_same_as_text(void)
+{
+    lv_test_redraw_all();
+    lv_memcpy(fb_strip, test_fb, sizeof(fb_strip));
+
+    /*Recolored text is never drawn from a strip*/
+    lv_obj_t * label = lv_obj_get_child(roller, 0);
+    lv_label_set_recolor(label, true);
+    lv_test_redraw_all();
+    lv_label_set_recolor(label, false);
+
+    /*The alpha of the anti-aliased edges is rounded once more in the strip*/
+    lv_area_t a;
+    lv_obj_get_coords(roller, &a);
+    lv_coord_t x;
+    lv_coord_t y;
+    for(y = a.y1; y <= a.y2; y++) {
+        for(x = a.x1; x <= a.x2; x++) {
+            lv_color_t c1 = fb_strip[y * HOR_RES + x];
+            lv_color_t c2 = lv_test_px_get(x, y);
+            TEST_ASSERT_INT_WITHIN(2, LV_COLOR_GET_R(c1), LV_COLOR_GET_R(c2));
+            TEST_ASSERT_INT_WITHIN(2, LV_COLOR_GET_G(c1), LV_COLOR_GET_G(c2));
+            TEST_ASSERT_INT_WITHIN(2, LV_COLOR_GET_B(c1), LV_COLOR_GET_B(c2));
+        }
+    }
+}
+
+void setUp(void)
+{
+    roller = lv_roller_create(lv_scr_act());
+    lv_obj_center(roller);
+    lv_roller_set_options(roller, "One\nTwo\nThree\nFour\nFive", LV_ROLLER_MODE_NORMAL);
+    lv_roller_set_visible_row_count(roller, 3);
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_roller_draws_options(void)
+{
+    assert_same_as_text();
+
+    lv_roller_set_selected(roller, 2, LV_ANIM_OFF);
+    assert_same_as_text();
+}
+
+void test_roller_draws_new_options(void)
+{
+    lv_test_redraw_all();
+
+    lv_roller_set_options(roller, "Alpha\nBravo\nCharlie\nDelta\nEcho\nFoxtrot", LV_ROLLER_MODE_NORMAL);
+    lv_roller_set_selected(roller, 4, LV_ANIM_OFF);
+    assert_same_as_text();
+
+    char buf[16];
+    lv_roller_get_selected_str(roller, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("Echo", buf);
+}
+
+void test_roller_draws_while_scrolling(void)
+{
+    /*Finish the other animations so the scroll animation starts now*/
+    lv_tick_inc(1000);
+    lv_timer_handler();
+
+    lv_obj_t * label = lv_obj_get_child(roller, 0);
+    lv_obj_update_layout(label);
+    lv_coord_t y_start = lv_obj_get_y(label);
+    lv_obj_set_style_anim_time(roller, 200, 0);
+    lv_roller_set_selected(roller, 3, LV_ANIM_ON);
+
+    /*Stop half way*/
+    lv_tick_inc(100);
+    lv_timer_handler();
+    lv_obj_update_layout(label);
+    lv_coord_t y_mid = lv_obj_get_y(label);
+    TEST_ASSERT_LESS_THAN(y_start, y_mid);
+    assert_same_as_text();
+
+    lv_tick_inc(200);
+    lv_timer_handler();
+    lv_obj_update_layout(label);
+    TEST_ASSERT_LESS_THAN(y_mid, lv_obj_get_y(label));
+    assert_same_as_text();
+    TEST_ASSERT_EQUAL(3, lv_roller_get_selected(roller));
+}
+
+#if LV_ROLLER_STRIP
+void test_roller_strip_is_rendered_once(void)
+{
+    lv_roller_t * r = (lv_roller_t *)roller;
+    lv_test_redraw_all();
+    const uint8_t * data = r->strip.img.data;
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_NOT_NULL(r->strip_sel.img.data);
+
+    /*Scrolling only moves the strips*/
+    lv_roller_set_selected(roller, 4, LV_ANIM_OFF);
+    lv_test_redraw_all();
+    TEST_ASSERT_EQUAL_PTR(data, r->strip.img.data);
+
+    /*A color change doesn't need a new strip either*/
+    lv_obj_set_style_text_color(roller, lv_palette_main(LV_PALETTE_RED), 0);
+    lv_test_redraw_all();
+    TEST_ASSERT_EQUAL_PTR(data, r->strip.img.data);
+
+    /*New options are rendered again*/
+    lv_roller_set_options(roller, "A\nB", LV_ROLLER_MODE_NORMAL);
+    TEST_ASSERT_NULL(r->strip.img.data);
+    lv_test_redraw_all();
+    TEST_ASSERT_NOT_NULL(r->strip.img.data);
+}
+
+void test_roller_strip_renders_only_around_the_visible_rows(void)
+{
+    lv_roller_t * r = (lv_roller_t *)roller;
+    lv_roller_set_options(roller, "0\n1\n2\n3\n4\n5\n6\n7\n8\n9\n10\n11\n12\n13\n14\n15\n16\n17\n18\n19",
+                          LV_ROLLER_MODE_NORMAL);
+    lv_test_redraw_all();
+
+    lv_obj_t * label = lv_obj_get_child(roller, 0);
+    TEST_ASSERT_NOT_NULL(r->strip.img.data);
+    TEST_ASSERT_LESS_THAN(lv_obj_get_height(label), r->strip.img.header.h);
+    TEST_ASSERT_LESS_OR_EQUAL(2 * lv_obj_get_height(roller), r->strip.img.header.h);
+    lv_coord_t y_ofs = r->strip.y_ofs;
+
+    /*The rows at the end are rendered when they are scrolled in*/
+    lv_roller_set_selected(roller, 19, LV_ANIM_OFF);
+    assert_same_as_text();
+    TEST_ASSERT_NOT_NULL(r->strip.img.data);
+    TEST_ASSERT_GREATER_THAN(y_ofs, r->strip.y_ofs);
+
+    /*Infinite rollers are drawn from the strips too*/
+    lv_roller_set_options(roller, "0\n1\n2\n3\n4\n5\n6\n7\n8\n9", LV_ROLLER_MODE_INFINITE);
+    lv_roller_set_selected(roller, 5, LV_ANIM_OFF);
+    lv_test_redraw_all();
+    TEST_ASSERT_NOT_NULL(r->strip.img.data);
+    assert_same_as_text();
+}
+#else
+void test_roller_strip_is_rendered_once(void)
+{
+
+}
+
+void test_roller_strip_renders_only_around_the_visible_rows(void)
+{
+
+}
+#endif
+
+#endif
@@ -0,0 +1,138 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+#include "../src/draw/sw/lv_draw_sw.h"
+
+#include "unity/unity.h"
+
+#include "lv_test_helpers.h"
+
+#if LV_DRAW_COMPLEX && LV_SHADOW_CACHE_SIZE
+
+/*Without radius and spread the corner of a shadow is `width * width` bytes*/
+static lv_obj_t * shadow_create(lv_coord_t x, lv_coord_t y, lv_coord_t width)
+{
+    lv_obj_t * obj = lv_test_rect_create(lv_scr_act(), x, y, 100, 0xff0000);
+    lv_obj_set_style_shadow_width(obj, width, 0);
+    lv_obj_set_style_shadow_color(obj, lv_color_black(), 0);
+    lv_obj_set_style_shadow_opa(obj, LV_OPA_COVER, 0);
+    return obj;
+}
+
+/*Redraw only the object and its shadow*/
+static void redraw(lv_obj_t * obj)
+{
+    lv_obj_invalidate(obj);
+    lv_refr_now(NULL);
+}
+
+static lv_draw_sw_shadow_cache_stats_t stats_get(void)
+{
+    lv_draw_sw_shadow_cache_stats_t stats;
+    lv_draw_sw_shadow_cache_get_stats(&stats);
+    return stats;
+}
+
+void setUp(void)
+{
+    lv_refr_now(NULL);
+    lv_draw_sw_shadow_cache_clear();
+    lv_draw_sw_shadow_cache_reset_stats();
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_shadow_cache_hit(void)
+{
+    lv_obj_t * obj = shadow_create(50, 50, 20);
+    redraw(obj);
+    uint32_t miss_cnt = stats_get().miss_cnt;
+    TEST_ASSERT_GREATER_THAN(0, miss_cnt);
+    TEST_ASSERT_EQUAL(1, stats_get().entry_cnt);
+    TEST_ASSERT_EQUAL(20 * 20, stats_get().used_size);
+
+    redraw(obj);
+    TEST_ASSERT_EQUAL(miss_cnt, stats_get().miss_cnt);
+    TEST_ASSERT_GREATER_THAN(0, stats_get().hit_cnt);
+}
+
+void test_shadow_cache_budget(void)
+{
+    /*More corners than the budget*/
+    lv_coord_t width = 10;
+    uint32_t size_sum = 0;
+    lv_coord_t x = 0;
+    while(size_sum <= stats_get().max_size) {
+        redraw(shadow_create(x % 700, 50 + (x / 700) * 150, width));
+        size_sum += width * width;
+        width += 10;
+        x += 150;
+    }
+
+    TEST_ASSERT_LESS_OR_EQUAL(stats_get().max_size, stats_get().used_size);
+    TEST_ASSERT_GREATER_THAN(0, stats_get().evict_cnt);
+}
+
+void test_shadow_cache_drops_the_least_recently_used(void)
+{
+    /*Fill the budget with 4 corners*/
+    lv_coord_t width = 0;
+    while((width + 1) * (width + 1) * 4 <= (lv_coord_t)stats_get().max_size) width++;
+    lv_obj_t * objs[4];
+    uint32_t i;
+    for(i = 0; i < 4; i++) {
+        objs[i] = shadow_create(50 + i * 180, 50, width - i);
+        redraw(objs[i]);
+    }
+    TEST_ASSERT_EQUAL(4, stats_get().entry_cnt);
+    TEST_ASSERT_EQUAL(0, stats_get().evict_cnt);
+
+    /*Use the first one again, so the second one is the least recently used*/
+    redraw(objs[0]);
+
+    /*The 5th one needs the place of only one corner*/
+    redraw(shadow_create(50, 250, width - 4));
+    TEST_ASSERT_EQUAL(1, stats_get().evict_cnt);
+
+    uint32_t miss_cnt = stats_get().miss_cnt;
+    redraw(objs[0]);
+    redraw(objs[2]);
+    redraw(objs[3]);
+    TEST_ASSERT_EQUAL(miss_cnt, stats_get().miss_cnt);
+
+    redraw(objs[1]);
+    TEST_ASSERT_GREATER_THAN(miss_cnt, stats_get().miss_cnt);
+}
+
+#else /*LV_DRAW_COMPLEX && LV_SHADOW_CACHE_SIZE*/
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_shadow_cache_hit(void)
+{
+
+}
+
+void test_shadow_cache_budget(void)
+{
+
+}
+
+void test_shadow_cache_drops_the_least_recently_used(void)
+{
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,211 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+#define TIMER_MAX   4
+
+static lv_timer_t * timers[TIMER_MAX];
+static uint32_t run_order[16];
+static uint32_t run_cnt;
+
+static void record_cb(lv_timer_t * timer)
+{
+    run_order[run_cnt++] = (uint32_t)(uintptr_t)timer->user_data;
+}
+
+static void set_period_cb(lv_timer_t * timer)
+{
+    record_cb(timer);
+    lv_timer_set_period(timer, 50);
+}
+
+static void del_self_cb(lv_timer_t * timer)
+{
+    record_cb(timer);
+    timers[(uintptr_t)timer->user_data] = NULL;
+    lv_timer_del(timer);
+}
+
+static lv_timer_t * timer_add(lv_timer_cb_t cb, uint32_t period, uint32_t id)
+{
+    timers[id] = lv_timer_create(cb, period, (void *)(uintptr_t)id);
+    TEST_ASSERT_NOT_NULL(timers[id]);
+    return timers[id];
+}
+
+/*Advance the tick and run the timers once*/
+static uint32_t run_after(uint32_t ms)
+{
+    lv_tick_inc(ms);
+    return lv_timer_handler();
+}
+
+void setUp(void)
+{
+    /*Only the timers of the test should run*/
+    lv_timer_t * timer = lv_timer_get_next(NULL);
+    while(timer) {
+        lv_timer_pause(timer);
+        timer = lv_timer_get_next(timer);
+    }
+    /*Let them become due so their deadline isn't the next one any more*/
+    run_after(10000);
+
+    lv_memset_00(timers, sizeof(timers));
+    run_cnt = 0;
+}
+
+void tearDown(void)
+{
+    uint32_t i;
+    for(i = 0; i < TIMER_MAX; i++) {
+        if(timers[i]) lv_timer_del(timers[i]);
+    }
+
+    lv_timer_t * timer = lv_timer_get_next(NULL);
+    while(timer) {
+        lv_timer_resume(timer);
+        timer = lv_timer_get_next(timer);
+    }
+}
+
+void test_timer_runs_in_deadline_order(void)
+{
+    timer_add(record_cb, 30, 0);
+    lv_timer_set_repeat_count(timer_add(record_cb, 10, 1), 1);
+    timers[1] = NULL;   /*Deleted by the handler*/
+    timer_add(record_cb, 20, 2);
+
+    TEST_ASSERT_EQUAL(10, run_after(0));
+    TEST_ASSERT_EQUAL(0, run_cnt);
+
+    TEST_ASSERT_EQUAL(10, run_after(10));
+    TEST_ASSERT_EQUAL(1, run_cnt);
+    TEST_ASSERT_EQUAL(1, run_order[0]);
+
+    TEST_ASSERT_EQUAL(10, run_after(10));
+    TEST_ASSERT_EQUAL(2, run_cnt);
+    TEST_ASSERT_EQUAL(2, run_order[1]);
+
+    TEST_ASSERT_EQUAL(10, run_after(10));
+    TEST_ASSERT_EQUAL(3, run_cnt);
+    TEST_ASSERT_EQUAL(0, run_order[2]);
+}
+
+#if LV_USE_TIMER_HEAP
+void test_timer_runs_due_timers_once_in_deadline_order(void)
+{
+    timer_add(record_cb, 30, 0);
+    timer_add(record_cb, 10, 1);
+    timer_add(record_cb, 20, 2);
+    timer_add(record_cb, 0, 3);
+
+    /*All are due; a timer runs at most once per handler call even with 0 period*/
+    run_after(100);
+    TEST_ASSERT_EQUAL(4, run_cnt);
+    TEST_ASSERT_EQUAL(3, run_order[0]);
+    TEST_ASSERT_EQUAL(1, run_order[1]);
+    TEST_ASSERT_EQUAL(2, run_order[2]);
+    TEST_ASSERT_EQUAL(0, run_order[3]);
+
+    /*Not again in the same tick*/
+    run_after(0);
+    TEST_ASSERT_EQUAL(4, run_cnt);
+}
+#else
+void test_timer_runs_due_timers_once_in_deadline_order(void)
+{
+
+}
+#endif
+
+void test_timer_pause_resume(void)
+{
+    lv_timer_t * timer = timer_add(record_cb, 10, 0);
+    lv_timer_pause(timer);
+
+    TEST_ASSERT_EQUAL(LV_NO_TIMER_READY, run_after(20));
+    TEST_ASSERT_EQUAL(LV_NO_TIMER_READY, run_after(20));
+    TEST_ASSERT_EQUAL(0, run_cnt);
+
+    /*It was due while paused so it runs right after resuming*/
+    lv_timer_resume(timer);
+    TEST_ASSERT_EQUAL(10, run_after(0));
+    TEST_ASSERT_EQUAL(1, run_cnt);
+
+    run_after(10);
+    TEST_ASSERT_EQUAL(2, run_cnt);
+}
+
+void test_timer_set_period_in_callback(void)
+{
+    timer_add(set_period_cb, 10, 0);
+
+    TEST_ASSERT_EQUAL(50, run_after(10));
+    TEST_ASSERT_EQUAL(1, run_cnt);
+
+    run_after(10);
+    TEST_ASSERT_EQUAL(1, run_cnt);
+
+    run_after(40);
+    TEST_ASSERT_EQUAL(2, run_cnt);
+}
+
+void test_timer_del_in_own_callback(void)
+{
+    timer_add(record_cb, 10, 0);
+    timer_add(del_self_cb, 10, 1);
+    timer_add(record_cb, 10, 2);
+
+    run_after(10);
+    TEST_ASSERT_EQUAL(3, run_cnt);
+    TEST_ASSERT_NULL(timers[1]);
+
+    /*The others keep running*/
+    TEST_ASSERT_EQUAL(10, run_after(10));
+    TEST_ASSERT_EQUAL(5, run_cnt);
+    TEST_ASSERT_NOT_EQUAL(1, run_order[3]);
+    TEST_ASSERT_NOT_EQUAL(1, run_order[4]);
+}
+
+void test_timer_repeat_count(void)
+{
+    lv_timer_t * timer = timer_add(record_cb, 10, 0);
+    lv_timer_set_repeat_count(timer, 2);
+    timers[0] = NULL;   /*Deleted by the handler*/
+
+    run_after(10);
+    run_after(10);
+    run_after(10);
+    TEST_ASSERT_EQUAL(2, run_cnt);
+    TEST_ASSERT_EQUAL(LV_NO_TIMER_READY, run_after(0));
+}
+
+void test_timer_tick_wraparound(void)
+{
+    /*Go 5 ms before the tick overflows*/
+    lv_tick_inc(UINT32_MAX - 5 - lv_tick_get());
+
+    timer_add(record_cb, 10, 0);
+    timer_add(record_cb, 15, 1);
+
+    TEST_ASSERT_EQUAL(10, run_after(0));
+    TEST_ASSERT_EQUAL(5, run_after(5));
+    TEST_ASSERT_EQUAL(0, run_cnt);
+
+    /*The tick overflowed*/
+    TEST_ASSERT_EQUAL(5, run_after(5));
+    TEST_ASSERT_EQUAL(1, run_cnt);
+    TEST_ASSERT_EQUAL(0, run_order[0]);
+
+    TEST_ASSERT_EQUAL(5, run_after(5));
+    TEST_ASSERT_EQUAL(2, run_cnt);
+    TEST_ASSERT_EQUAL(1, run_order[1]);
+
+    run_after(5);
+    TEST_ASSERT_EQUAL(3, run_cnt);
+    TEST_ASSERT_EQUAL(0, run_order[2]);
+}
+
+#endif
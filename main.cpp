@@ -7,14 +7,58 @@
 #include <pthread.h>
 #include <time.h>
 #include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
 #include "ui/src/ui.h"
+#include "ui/src/ui_hud.h"
+#include "ui/src/ui_async.h"
 #include "devices/opencv/cv.h"
 #include "devices/wifi/wifi.h"
 #include "devices/tm7711/tm7711.h"
 #include "devices/power/power.h"
+#include "devices/touch/touch_replay.h"
 
 #define DISP_BUF_SIZE (320 * 240 * 2)
 
+static pthread_t panel_thread;
+static bool panel_ready = false;
+
+#if LV_USE_TRACE || LV_USE_REDRAW_PROF
+#define TRACE_FILE "/tmp/terminal_trace.json"
+#define REDRAW_FILE "/tmp/terminal_redraw.json"
+
+static volatile sig_atomic_t trace_dump_requested = 0;
+
+/*`kill -USR1 <pid>` saves the last seconds of the timeline to TRACE_FILE and the redraw costs to REDRAW_FILE*/
+static void trace_signal_handler(int sig)
+{
+    trace_dump_requested = 1;
+}
+#endif
+
+static volatile sig_atomic_t hud_toggle_requested = 0;
+
+/*`kill -USR2 <pid>` shows/hides the performance HUD like holding the top right corner*/
+static void hud_signal_handler(int sig)
+{
+    hud_toggle_requested = 1;
+}
+
+static struct timespec startup_ts;
+static bool startup_timeline = false;   /*Set by the `STARTUP_TIMELINE` environment variable*/
+
+/*Print the time elapsed since the start of the program for the startup timeline*/
+static void startup_mark(const char *step)
+{
+    if (!startup_timeline) return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double ms = (now.tv_sec - startup_ts.tv_sec) * 1000.0 + (now.tv_nsec - startup_ts.tv_nsec) / 1000000.0;
+    printf("[startup] %7.1f ms  %s\n", ms, step);
+}
+
 void display_init(void)
 {
 #if defined(ILI9341)
@@ -24,8 +68,31 @@ void display_init(void)
 #endif
 }
 
+/*The panel needs ~460 ms of reset and wake-up delays. Do it in the background while the UI is being built.
+ *The touch controller is set up here too because it needs wiringPi which is initialized by the display driver.*/
+static void *panel_init_thread(void *arg)
+{
+    display_init();
+    xpt2046_init();
+    startup_mark("panel ready");
+    return NULL;
+}
+
+/*Wait until the panel and the touch controller are set up, wiringPi can be used after it returns*/
+static void panel_wait(void)
+{
+    if (!panel_ready)
+    {
+        pthread_join(panel_thread, NULL);
+        panel_ready = true;
+    }
+}
+
 void display_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
 {
+    /*The first frame is already rendered here, only wait for the panel to send it*/
+    panel_wait();
+
 #if defined(ILI9341)
     ili9341_flush(disp_drv, area, color_p);
 #elif defined(ST7789)
@@ -35,11 +102,23 @@ void display_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *c
 
 int main(void)
 {
+    clock_gettime(CLOCK_MONOTONIC, &startup_ts);
+    const char *timeline_env = getenv("STARTUP_TIMELINE");
+    startup_timeline = timeline_env && timeline_env[0] != '\0' && timeline_env[0] != '0';
+    if (startup_timeline)
+    {
+        struct timespec boot_ts;
+        clock_gettime(CLOCK_BOOTTIME, &boot_ts);
+        printf("[startup] started %.1f s after boot\n", boot_ts.tv_sec + boot_ts.tv_nsec / 1000000000.0);
+    }
+
+    /*Display and touch init (in the background)*/
+    pthread_create(&panel_thread, NULL, panel_init_thread, NULL);
+    pthread_setname_np(panel_thread, "panel");
+
     /*LittlevGL init*/
     lv_init();
-
-    /*Linux frame buffer device init*/
-    display_init();
+    startup_mark("lv_init");
 
     /*A small buffer for LittlevGL to draw the screen's content*/
     static lv_color_t buf[DISP_BUF_SIZE];
@@ -53,25 +132,62 @@ int main(void)
     lv_disp_drv_init(&disp_drv);
     disp_drv.draw_buf = &disp_buf;
     disp_drv.flush_cb = display_flush;
-    lv_disp_drv_register(&disp_drv);
+    lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
 
-    xpt2046_init();
     static lv_indev_drv_t indev_drv_1;
     lv_indev_drv_init(&indev_drv_1); /*Basic initialization*/
     indev_drv_1.type = LV_INDEV_TYPE_POINTER;
 
     /*This function will be called periodically (by the library) to get the mouse position and state*/
     indev_drv_1.read_cb =  xpt2046_read;
-    lv_indev_drv_register(&indev_drv_1);
+    lv_indev_t *indev = lv_indev_drv_register(&indev_drv_1);
+    touch_replay_init(indev);
+    ui_hud_init(disp, indev);
+    startup_mark("drivers registered");
 
     /*Create a Demo*/
     ui_init();
+    startup_mark("ui_init");
+
+    /*Render the first frame and send it as soon as the panel is ready*/
+    lv_refr_now(NULL);
+    startup_mark("first frame");
+
+    /*The touch reads of lv_timer_handler() and the ADC of the device threads need wiringPi too*/
+    panel_wait();
+    ui_threads_start();
+    startup_mark("threads started");
+
+#if LV_USE_TRACE || LV_USE_REDRAW_PROF
+    signal(SIGUSR1, trace_signal_handler);
+#endif
+    signal(SIGUSR2, hud_signal_handler);
 
     /*Handle LitlevGL tasks (tickless mode)*/
     while (1)
     {
-        lv_timer_handler();
-        usleep(5000);
+        // The UI updates of the device threads, drawn by this lv_timer_handler()
+        ui_async_handler();
+        uint32_t idle_ms = lv_timer_handler();
+#if LV_USE_TRACE || LV_USE_REDRAW_PROF
+        if (trace_dump_requested)
+        {
+            trace_dump_requested = 0;
+#if LV_USE_TRACE
+            if (lv_trace_dump(TRACE_FILE) == LV_RES_OK) printf("trace saved to %s\n", TRACE_FILE);
+#endif
+#if LV_USE_REDRAW_PROF
+            if (lv_redraw_prof_dump(REDRAW_FILE) == LV_RES_OK) printf("redraw costs saved to %s\n", REDRAW_FILE);
+#endif
+        }
+#endif
+        if (hud_toggle_requested)
+        {
+            hud_toggle_requested = 0;
+            ui_hud_toggle();
+        }
+        // Sleep until the next timer is due or a device thread queues a UI update
+        ui_async_wait(idle_ms);
     }
 
     return 0;
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""
+Scenario benchmarks of the host build (`make host`).
+
+Every bench/scenarios/*.txt touch script is replayed by ./demo_host and the
+measurements written by host/host_bench.c are collected into one JSON file.
+Lines like `#@ env NAME=value` in a script set environment variables for its run.
+A script with `#@ env TOUCH_REPLAY=<recording>` replays recorded touch samples instead,
+its input-to-photon latency is added to the results as `touch_latency`.
+
+    scripts/bench.py                          run all scenarios, write bench_results.json
+    scripts/bench.py --only transitions       run some of them
+    scripts/bench.py --save-baseline          also store the results as the baseline
+    scripts/bench.py --baseline FILE          compare with a baseline, exit with 1 on a regression
+
+A metric is compared only if its path (e.g. `transitions/segments/to_set/frame_us/p95`)
+matches a pattern of bench/thresholds.json (the first match is used). It is a regression
+if it increased by more than `rel` times the baseline and also by more than `abs`, so the
+noise of small values (e.g. the 10 ms ticks of the CPU times) doesn't fail the comparison.
+"""
+
+import argparse
+import fnmatch
+import glob
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SCENARIO_DIR = os.path.join(ROOT, "bench", "scenarios")
+THRESHOLDS = os.path.join(ROOT, "bench", "thresholds.json")
+BASELINE = os.path.join(ROOT, "bench", "baseline.json")
+BIN = os.path.join(ROOT, "demo_host")
+
+# Emulate the SPI clock of the Pi so the flush times are realistic
+DEFAULT_ENV = {"HOST_SPI_HZ": "40000000"}
+
+
+def load_scenario_env(path):
+    env = {}
+    with open(path) as f:
+        for line in f:
+            if line.startswith("#@ env "):
+                name, _, value = line[len("#@ env "):].strip().partition("=")
+                env[name] = value
+    return env
+
+
+def run_once(path, timeout):
+    with tempfile.NamedTemporaryFile(suffix=".json", delete=False) as tmp:
+        out = tmp.name
+    with tempfile.NamedTemporaryFile(suffix=".json", delete=False) as tmp:
+        latency_out = tmp.name
+    env = dict(os.environ)
+    env.update(DEFAULT_ENV)
+    env.update(load_scenario_env(path))
+    env["HOST_TOUCH_SCRIPT"] = path
+    env["HOST_BENCH_JSON"] = out
+    if env.get("TOUCH_REPLAY"):
+        env["TOUCH_LATENCY_JSON"] = latency_out
+    try:
+        subprocess.run([BIN], cwd=ROOT, env=env, stdout=subprocess.DEVNULL, timeout=timeout, check=True)
+        with open(out) as f:
+            result = json.load(f)
+        if env.get("TOUCH_REPLAY"):
+            with open(latency_out) as f:
+                result["touch_latency"] = json.load(f)
+        return result
+    finally:
+        os.unlink(out)
+        os.unlink(latency_out)
+
+
+def flatten(d, prefix=""):
+    """{"a": {"b": 1}} -> {"a/b": 1}"""
+    flat = {}
+    for k, v in d.items():
+        key = prefix + k
+        if isinstance(v, dict):
+            flat.update(flatten(v, key + "/"))
+        elif isinstance(v, (int, float)):
+            flat[key] = v
+    return flat
+
+
+def unflatten(flat):
+    d = {}
+    for key, v in flat.items():
+        node = d
+        parts = key.split("/")
+        for p in parts[:-1]:
+            node = node.setdefault(p, {})
+        node[parts[-1]] = v
+    return d
+
+
+def median_of_runs(runs):
+    """Median of each metric over the repeated runs"""
+    flats = [flatten(r) for r in runs]
+    keys = set().union(*flats)
+    return unflatten({k: statistics.median(f[k] for f in flats if k in f) for k in keys})
+
+
+def compare(results, baseline, thresholds):
+    cur = flatten(results)
+    base = flatten(baseline)
+    regressions = []
+    for key in sorted(cur):
+        limit = None
+        for pattern, lim in thresholds.items():
+            if fnmatch.fnmatchcase(key, pattern):
+                limit = lim
+                break
+        if limit is None or key not in base:
+            continue
+        old, new = base[key], cur[key]
+        change = (new - old) / old if old else 0.0
+        flag = "REGRESSION" if new - old > max(old * limit["rel"], limit["abs"]) else ""
+        if flag or abs(change) > 0.05:
+            print("  %-56s %12.1f -> %12.1f  %+7.1f%%  %s" % (key, old, new, change * 100, flag))
+        if flag:
+            regressions.append(key)
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Scenario benchmarks of the host build")
+    parser.add_argument("--only", action="append", help="run only this scenario (can be repeated)")
+    parser.add_argument("--repeat", type=int, default=3, help="run each scenario N times and take the median")
+    parser.add_argument("--out", default=os.path.join(ROOT, "bench_results.json"), help="result file")
+    parser.add_argument("--baseline", help="compare with this result file")
+    parser.add_argument("--save-baseline", action="store_true", help="store the results as " + BASELINE)
+    parser.add_argument("--timeout", type=int, default=180, help="timeout of a run [s]")
+    args = parser.parse_args()
+
+    if not os.path.exists(BIN):
+        sys.exit("%s not found, run `make host` first" % BIN)
+
+    scenarios = sorted(glob.glob(os.path.join(SCENARIO_DIR, "*.txt")))
+    if args.only:
+        scenarios = [s for s in scenarios if os.path.splitext(os.path.basename(s))[0] in args.only]
+
+    results = {}
+    for path in scenarios:
+        name = os.path.splitext(os.path.basename(path))[0]
+        print("running %s..." % name, flush=True)
+        runs = [run_once(path, args.timeout) for _ in range(args.repeat)]
+        results[name] = median_of_runs(runs) if len(runs) > 1 else runs[0]
+        for seg, m in results[name]["segments"].items():
+            print("  %-16s %5d frames  p50 %6d us  p95 %6d us  settle %5d ms" %
+                  (seg, m["frames"], m["frame_us"]["p50"], m["frame_us"]["p95"], m["settle_ms"]))
+        for kind, m in sorted(results[name].get("touch_latency", {}).items()):
+            if isinstance(m, dict):
+                print("  touch %-10s %5d samples  avg %6d us  p95 %6d us" % (kind, m["n"], m["avg_us"], m["p95_us"]))
+
+    with open(args.out, "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+    print("results saved to %s" % args.out)
+
+    if args.save_baseline:
+        with open(BASELINE, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+        print("baseline saved to %s" % BASELINE)
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        with open(THRESHOLDS) as f:
+            thresholds = json.load(f)
+        print("compared with %s:" % args.baseline)
+        regressions = compare(results, baseline, thresholds)
+        if regressions:
+            print("%d regression(s)" % len(regressions))
+            return 1
+        print("no regression")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
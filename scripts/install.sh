@@ -28,6 +28,7 @@ After=network.target
 Type=simple
 User=$USER
 WorkingDirectory=$(pwd)
+Environment=STARTUP_TIMELINE=1
 ExecStart=$(pwd)/demo
 Restart=always
 RestartSec=5
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Print the redraw costs saved by lv_redraw_prof_dump() as a ranked table.
+
+Each row is an object and the first call site outside LVGL which invalidated it,
+e.g. `ui_Time1Label` updated by `date_thread.cpp:40 (lv_label_set_text)`.
+
+    scripts/redraw_report.py terminal_redraw.json ./demo [--top N] [--by-object]
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+
+
+def symbols(binary):
+    """Address -> name of the functions and data (the widget classes) from `nm`"""
+    out = subprocess.run(["nm", "-C", binary], capture_output=True, text=True, check=True).stdout
+    syms = {}
+    for line in out.splitlines():
+        parts = line.split(" ", 2)
+        if len(parts) == 3 and parts[0]:
+            syms[int(parts[0], 16)] = parts[2]
+    return syms
+
+
+def resolve(binary, addrs):
+    """Address -> (function, file:line) with addr2line"""
+    if not addrs:
+        return {}
+    # A return address points after the call, look up the call itself
+    out = subprocess.run(["addr2line", "-f", "-C", "-e", binary] + ["0x%x" % (a - 1) for a in addrs],
+                         capture_output=True, text=True, check=True).stdout.splitlines()
+    return {a: (func, loc) for a, func, loc in zip(addrs, out[0::2], out[1::2])}
+
+
+def in_lvgl(func, loc):
+    # Without debug info (-g0) only the function and file names might be known
+    if not loc.startswith("??"):
+        return "/lvgl/" in "/" + loc or loc.startswith("lv_")
+    return func.startswith(("lv_", "_lv_")) or func == "??"
+
+
+def call_site(stack, frames):
+    """
+    The first function outside LVGL on the stack and the LVGL function it called.
+    If it's reached through `lv_timer_handler()` (animations, input, LVGL timers)
+    the timer callback is reported instead of the main loop.
+    """
+    chain = [frames.get(addr, ("??", "??")) for addr in stack]
+    api = next((f for f, _ in chain if not f.startswith(("lv_obj_invalidate", "_lv_inv_area"))), "??")
+    for i, (func, loc) in enumerate(chain):
+        if func == "lv_timer_handler" and i > 0:
+            func, loc = chain[i - 1]
+            break
+        if not in_lvgl(func, loc):
+            break
+    else:
+        return api
+    name = func if loc.startswith("??") else "%s %s" % (loc.rsplit("/", 1)[-1].split(" ")[0], func)
+    return name if func == api else "%s (%s)" % (name, api)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("report")
+    parser.add_argument("binary")
+    parser.add_argument("--top", type=int, default=30, help="number of rows")
+    parser.add_argument("--by-object", action="store_true", help="sum the call sites of each object")
+    args = parser.parse_args()
+
+    with open(args.report) as f:
+        report = json.load(f)
+
+    # The addresses are relative to __executable_start (0 in PIE binaries)
+    syms = symbols(args.binary)
+    base = next((a for a, n in syms.items() if n.endswith("__executable_start")), 0)
+
+    entries = report["entries"]
+    addrs = sorted({base + int(a, 16) for e in entries for a in e["stack"]})
+    frames = resolve(args.binary, addrs)
+
+    rows = {}
+    for e in entries:
+        cls = syms.get(base + int(e["class"], 16), "-") if e["class"] != "0x0" else "-"
+        site = "" if args.by_object else call_site([base + int(a, 16) for a in e["stack"]], frames)
+        key = (e["obj"], site)
+        row = rows.setdefault(key, {"obj": e["obj"], "class": cls, "hint": e["hint"], "site": site,
+                                    "deleted": e["deleted"], "inv": 0, "px": 0, "bytes": 0})
+        for k in ("inv", "px", "bytes"):
+            row[k] += e[k]
+
+    frames_cnt = max(report["frames"], 1)
+    total_px = max(report["px"], 1)
+    print("%d frames, %.0f px/frame, %.1f kB flushed/frame%s" %
+          (report["frames"], report["px"] / frames_cnt, report["bytes"] / frames_cnt / 1024,
+           ", %d invalidations dropped" % report["dropped"] if report["dropped"] else ""))
+    print("%6s %10s %10s %7s  %-16s %-14s %s" % ("px%", "px/frame", "kB", "inv", "class", "text", "call site"))
+    for row in sorted(rows.values(), key=lambda r: (-r["px"], -r["inv"]))[:args.top]:
+        obj = row["class"].replace("_class", "") + ("*" if row["deleted"] else "")
+        print("%5.1f%% %10.0f %10.1f %7d  %-16s %-14s %s" %
+              (100.0 * row["px"] / total_px, row["px"] / frames_cnt, row["bytes"] / 1024, row["inv"], obj,
+               row["hint"][:14], row["site"] or row["obj"]))
+    if any(r["deleted"] for r in rows.values()):
+        print("* deleted object")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
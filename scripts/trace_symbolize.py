@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+"""
+Name the timer spans of a trace saved by lv_trace_dump().
+
+The `timer` spans carry the address of the callback relative to the start of the
+executable. This resolves them with addr2line and renames the spans to the
+callback, e.g. `timer` -> `_lv_disp_refr_timer`.
+
+    scripts/trace_symbolize.py terminal_trace.json ./demo [out.json]
+"""
+
+import json
+import subprocess
+import sys
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+    trace_path, binary = sys.argv[1], sys.argv[2]
+    out_path = sys.argv[3] if len(sys.argv) > 3 else trace_path
+
+    with open(trace_path) as f:
+        trace = json.load(f)
+    events = trace["traceEvents"]
+
+    addrs = sorted({e["args"]["addr"] for e in events if "addr" in e.get("args", {})})
+    names = {}
+    if addrs:
+        out = subprocess.run(["addr2line", "-f", "-e", binary] + addrs, capture_output=True, text=True,
+                             check=True).stdout.splitlines()
+        # Two lines per address: function, file:line
+        for addr, func in zip(addrs, out[0::2]):
+            names[addr] = func if func != "??" else addr
+
+    # An `E` closes the last open span of its thread, so rename it the same way
+    stacks = {}
+    for e in events:
+        stack = stacks.setdefault(e.get("tid"), [])
+        if e["ph"] == "B":
+            addr = e.get("args", {}).get("addr")
+            if addr in names:
+                e["name"] = names[addr]
+            stack.append(e["name"])
+        elif e["ph"] == "E" and stack:
+            e["name"] = stack.pop()
+
+    with open(out_path, "w") as f:
+        json.dump(trace, f)
+    print("%d callbacks resolved, saved to %s" % (len(names), out_path))
+
+
+if __name__ == "__main__":
+    main()
@@ -5,6 +5,7 @@
 
 #include "ui.h"
 #include "ui_helpers.h"
+#include "ui_screens.h"
 #include "devices/threads/threads_conf.h"
 
 ///////////////////// VARIABLES ////////////////////
@@ -77,6 +78,9 @@ lv_obj_t * ui_Message;
 void ui_event_MessageToMainButton(lv_event_t * e);
 lv_obj_t * ui_MessageToMainButton;
 lv_obj_t * ui_BatteryLabel;
+void ui_event_BatteryChart(lv_event_t * e);
+lv_obj_t * ui_BatteryChart;
+lv_obj_t * ui_BatteryChartLabel;
 // CUSTOM VARIABLES
 
 
@@ -101,11 +105,10 @@ void ui_event_ToOpenCVButton(lv_event_t * e)
     lv_event_code_t event_code = lv_event_get_code(e);
 
     if(event_code == LV_EVENT_CLICKED) {
-        _ui_screen_change(&ui_OpenCV, LV_SCR_LOAD_ANIM_FADE_ON, 100, 0, &ui_OpenCV_screen_init);
-        _ui_screen_delete(&ui_Main);
+        ui_screen_load(UI_SCREEN_OPENCV, LV_SCR_LOAD_ANIM_FADE_ON, 100);
         
-        // Creat OpenCV thread
-        cv_create_thread();
+        // Start the camera
+        cv_service_start();
     }
 }
 
@@ -114,11 +117,10 @@ void ui_event_OpenCVToMainButton(lv_event_t * e)
     lv_event_code_t event_code = lv_event_get_code(e);
 
     if(event_code == LV_EVENT_CLICKED) {
-        _ui_screen_change(&ui_Main, LV_SCR_LOAD_ANIM_FADE_ON, 100, 0, &ui_Main_screen_init);
-        _ui_screen_delete(&ui_OpenCV);
+        ui_screen_load(UI_SCREEN_MAIN, LV_SCR_LOAD_ANIM_FADE_ON, 100);
         
-        // Terminate OpenCV thread
-        cv_destroy_thread();
+        // Close the camera
+        cv_service_stop();
     }
 }
 
@@ -127,11 +129,10 @@ void ui_event_ToSetButton(lv_event_t * e)
     lv_event_code_t event_code = lv_event_get_code(e);
 
     if(event_code == LV_EVENT_CLICKED) {
-        _ui_screen_change(&ui_Set, LV_SCR_LOAD_ANIM_FADE_ON, 100, 0, &ui_Set_screen_init);
-        _ui_screen_delete(&ui_Main);
+        ui_screen_load(UI_SCREEN_SET, LV_SCR_LOAD_ANIM_FADE_ON, 100);
 
-        // Create WiFi thread
-        wifi_create_thread();
+        // Start the WiFi service, it scans right away
+        wifi_service_start();
     }
 }
 
@@ -140,11 +141,10 @@ void ui_event_SetToMainButton(lv_event_t * e)
     lv_event_code_t event_code = lv_event_get_code(e);
 
     if(event_code == LV_EVENT_CLICKED) {
-        _ui_screen_change(&ui_Main, LV_SCR_LOAD_ANIM_FADE_ON, 100, 0, &ui_Main_screen_init);
-        _ui_screen_delete(&ui_Set);
+        ui_screen_load(UI_SCREEN_MAIN, LV_SCR_LOAD_ANIM_FADE_ON, 100);
 
-        // Terminate WiFi thread
-        wifi_destroy_thread();
+        // Stop the WiFi service
+        wifi_service_stop();
     }
 }
 
@@ -154,7 +154,7 @@ void ui_event_WiFiFreshButton(lv_event_t * e)
 
     if(event_code == LV_EVENT_CLICKED) {
         // Refresh WiFi list
-        wifi_isflush();
+        wifi_service_scan();
     }
 }
 
@@ -187,9 +187,7 @@ void ui_event_WiFiKeyboard(lv_event_t * e)
         const char *pass_buf;
         lv_roller_get_selected_str(ui_WiFiScanRoller, ssid_buf, sizeof(ssid_buf));
         pass_buf = lv_textarea_get_text(ui_WiFiPassTextArea);
-        wifi_get_ssid(ssid_buf);
-        wifi_get_pass(pass_buf);
-        wifi_isconnect();
+        wifi_service_connect(ssid_buf, pass_buf);
     }
 }
 
@@ -208,11 +206,10 @@ void ui_event_ToMessageButton(lv_event_t * e)
     lv_event_code_t event_code = lv_event_get_code(e);
 
     if(event_code == LV_EVENT_CLICKED) {
-        _ui_screen_change(&ui_Message, LV_SCR_LOAD_ANIM_FADE_ON, 100, 0, &ui_Message_screen_init);
-        _ui_screen_delete(&ui_Main);
+        ui_screen_load(UI_SCREEN_MESSAGE, LV_SCR_LOAD_ANIM_FADE_ON, 100);
 
-        // Create information thread
-        message_create_thread();
+        // Start or resume the battery readings
+        message_task_start();
     }
 }
 
@@ -221,11 +218,20 @@ void ui_event_MessageToMainButton(lv_event_t * e)
     lv_event_code_t event_code = lv_event_get_code(e);
 
     if(event_code == LV_EVENT_CLICKED) {
-        _ui_screen_change(&ui_Main, LV_SCR_LOAD_ANIM_FADE_ON, 100, 0, &ui_Main_screen_init);
-        _ui_screen_delete(&ui_Message);
+        ui_screen_load(UI_SCREEN_MAIN, LV_SCR_LOAD_ANIM_FADE_ON, 100);
 
-        // Terminate information thread
-        message_destroy_thread();
+        // Suspend the battery readings
+        message_task_suspend();
+    }
+}
+
+void ui_event_BatteryChart(lv_event_t * e)
+{
+    lv_event_code_t event_code = lv_event_get_code(e);
+
+    if(event_code == LV_EVENT_CLICKED) {
+        // Hour, day, weeks
+        message_chart_next_view();
     }
 }
 
@@ -277,15 +283,21 @@ void ui_init(void)
     lv_theme_t * theme = lv_theme_default_init(dispp, lv_palette_main(LV_PALETTE_BLUE), lv_palette_main(LV_PALETTE_RED),
                                                false, LV_FONT_DEFAULT);
     lv_disp_set_theme(dispp, theme);
-    ui_Main_screen_init();
-    ui_OpenCV_screen_init();
-    ui_Set_screen_init();
-    ui_Message_screen_init();
+    // The other screens are built on the first navigation
     ui____initial_actions0 = lv_obj_create(NULL);
-    lv_disp_load_scr(ui_Main);
+    ui_screen_load(UI_SCREEN_MAIN, LV_SCR_LOAD_ANIM_NONE, 0);
+    date_timer_create();
+}
 
-    // Create Date thread
-    date_create_thread();
+void ui_threads_start(void)
+{
+    // The device services are created once, the screens start and stop them
+    cv_service_init();
+    wifi_service_init();
+    // The battery readings are a coroutine of the io thread
+    io_create_thread();
+    // Network status monitor, shown on the Set screen
+    net_create_thread();
 }
 
 
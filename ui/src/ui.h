@@ -27,6 +27,7 @@ extern "C" {
 
 // SCREEN: ui_Main
 void ui_Main_screen_init(void);
+void ui_Main_screen_destroy(void);
 extern lv_obj_t * ui_Main;
 void ui_event_ToOpenCVButton(lv_event_t * e);
 extern lv_obj_t * ui_ToOpenCVButton;
@@ -59,6 +60,7 @@ extern lv_obj_t * ui_UbuntuImage;
 
 // SCREEN: ui_OpenCV
 void ui_OpenCV_screen_init(void);
+void ui_OpenCV_screen_destroy(void);
 extern lv_obj_t * ui_OpenCV;
 void ui_event_OpenCVToMainButton(lv_event_t * e);
 extern lv_obj_t * ui_OpenCVToMainButton;
@@ -67,6 +69,7 @@ extern lv_obj_t * ui_OpenCVDemoLabel;
 
 // SCREEN: ui_Set
 void ui_Set_screen_init(void);
+void ui_Set_screen_destroy(void);
 void ui_event_Set(lv_event_t * e);
 extern lv_obj_t * ui_Set;
 void ui_event_SetToMainButton(lv_event_t * e);
@@ -89,10 +92,14 @@ extern lv_obj_t * ui_WiFiConnectWaitSpinner;
 
 // SCREEN: ui_Message
 void ui_Message_screen_init(void);
+void ui_Message_screen_destroy(void);
 extern lv_obj_t * ui_Message;
 void ui_event_MessageToMainButton(lv_event_t * e);
 extern lv_obj_t * ui_MessageToMainButton;
 extern lv_obj_t * ui_BatteryLabel;
+void ui_event_BatteryChart(lv_event_t * e);
+extern lv_obj_t * ui_BatteryChart;
+extern lv_obj_t * ui_BatteryChartLabel;
 // CUSTOM VARIABLES
 
 // EVENTS
@@ -117,6 +124,8 @@ LV_FONT_DECLARE(ui_font_AlimamaShuHeiTi_16);
 
 // UI INIT
 void ui_init(void);
+// The device threads, they update the screens. Start them once the hardware is set up
+void ui_threads_start(void);
 
 #ifdef __cplusplus
 } /*extern "C"*/
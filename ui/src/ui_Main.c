@@ -196,3 +196,32 @@ void ui_Main_screen_init(void)
     lv_obj_add_event_cb(ui_PowerCancelButton, ui_event_PowerCancelButton, LV_EVENT_ALL, NULL);
 
 }
+
+void ui_Main_screen_destroy(void)
+{
+    if(ui_Main) lv_obj_del(ui_Main);
+
+    // NULL screen variables
+    ui_Main = NULL;
+    ui_ToOpenCVButton = NULL;
+    ui_OpenCVLabel = NULL;
+    ui_ToSetButton = NULL;
+    ui_SetLabel = NULL;
+    ui_ToMessageButton = NULL;
+    ui_MessageLabel = NULL;
+    ui_ToPowerButton = NULL;
+    ui_PowerLabel = NULL;
+    ui_TimePanel = NULL;
+    ui_Time1Label = NULL;
+    ui_Time2Label = NULL;
+    ui_UbuntuImage = NULL;
+    ui_PowerPanel = NULL;
+    ui_ShutdownButton = NULL;
+    ui_ShutdownLabel = NULL;
+    ui_RebootButton = NULL;
+    ui_RebootLabel = NULL;
+    ui_PowerCancelButton = NULL;
+    ui_PowerCancelLabel = NULL;
+    ui_PowerAskLabel = NULL;
+
+}
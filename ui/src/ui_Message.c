@@ -25,6 +25,43 @@ void ui_Message_screen_init(void)
     lv_obj_set_style_text_color(ui_BatteryLabel, lv_color_hex(0x020101), LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_set_style_text_opa(ui_BatteryLabel, 255, LV_PART_MAIN | LV_STATE_DEFAULT);
 
+    ui_BatteryChart = lv_chart_create(ui_Message);
+    lv_obj_set_width(ui_BatteryChart, 280);
+    lv_obj_set_height(ui_BatteryChart, 105);
+    lv_obj_set_x(ui_BatteryChart, 20);
+    lv_obj_set_y(ui_BatteryChart, 100);
+    lv_chart_set_type(ui_BatteryChart, LV_CHART_TYPE_LINE);
+    lv_chart_set_point_count(ui_BatteryChart, 140);
+    lv_chart_set_range(ui_BatteryChart, LV_CHART_AXIS_PRIMARY_Y, 0, 100);
+    lv_chart_set_div_line_count(ui_BatteryChart, 5, 0);
+    lv_chart_series_t * ui_BatteryChart_series_1 = lv_chart_add_series(ui_BatteryChart, lv_color_hex(0x2A9D3A),
+                                                                       LV_CHART_AXIS_PRIMARY_Y);
+    LV_UNUSED(ui_BatteryChart_series_1);
+    lv_obj_set_style_size(ui_BatteryChart, 0, LV_PART_INDICATOR | LV_STATE_DEFAULT);
+
+    ui_BatteryChartLabel = lv_label_create(ui_Message);
+    lv_obj_set_width(ui_BatteryChartLabel, LV_SIZE_CONTENT);   /// 1
+    lv_obj_set_height(ui_BatteryChartLabel, LV_SIZE_CONTENT);    /// 1
+    lv_obj_set_x(ui_BatteryChartLabel, 20);
+    lv_obj_set_y(ui_BatteryChartLabel, 210);
+    lv_label_set_text(ui_BatteryChartLabel, "Last hour");
+    lv_obj_set_style_text_color(ui_BatteryChartLabel, lv_color_hex(0x020101), LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_opa(ui_BatteryChartLabel, 255, LV_PART_MAIN | LV_STATE_DEFAULT);
+
     lv_obj_add_event_cb(ui_MessageToMainButton, ui_event_MessageToMainButton, LV_EVENT_ALL, NULL);
+    lv_obj_add_event_cb(ui_BatteryChart, ui_event_BatteryChart, LV_EVENT_ALL, NULL);
+
+}
+
+void ui_Message_screen_destroy(void)
+{
+    if(ui_Message) lv_obj_del(ui_Message);
+
+    // NULL screen variables
+    ui_Message = NULL;
+    ui_MessageToMainButton = NULL;
+    ui_BatteryLabel = NULL;
+    ui_BatteryChart = NULL;
+    ui_BatteryChartLabel = NULL;
 
 }
@@ -28,3 +28,14 @@ void ui_OpenCV_screen_init(void)
     lv_obj_add_event_cb(ui_OpenCVToMainButton, ui_event_OpenCVToMainButton, LV_EVENT_ALL, NULL);
 
 }
+
+void ui_OpenCV_screen_destroy(void)
+{
+    if(ui_OpenCV) lv_obj_del(ui_OpenCV);
+
+    // NULL screen variables
+    ui_OpenCV = NULL;
+    ui_OpenCVToMainButton = NULL;
+    ui_OpenCVDemoLabel = NULL;
+
+}
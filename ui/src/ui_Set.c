@@ -134,3 +134,24 @@ void ui_Set_screen_init(void)
     lv_obj_add_event_cb(ui_Set, ui_event_Set, LV_EVENT_ALL, NULL);
 
 }
+
+void ui_Set_screen_destroy(void)
+{
+    if(ui_Set) lv_obj_del(ui_Set);
+
+    // NULL screen variables
+    ui_Set = NULL;
+    ui_SetToMainButton = NULL;
+    ui_WiFiScanRoller = NULL;
+    ui_IPAddrLabel = NULL;
+    ui_WiFiFreshButton = NULL;
+    ui_WiFiFreshLabel = NULL;
+    ui_WiFiConnectButton = NULL;
+    ui_WiFiConnectLabel = NULL;
+    ui_WiFiKeyboard = NULL;
+    ui_WiFiEnterPassPanel = NULL;
+    ui_WiFiPassTextArea = NULL;
+    ui_WiFiSSIDLabel = NULL;
+    ui_WiFiConnectWaitSpinner = NULL;
+
+}
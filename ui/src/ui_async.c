@@ -0,0 +1,89 @@
+#include "ui_async.h"
+#include <pthread.h>
+#include <poll.h>
+#include <limits.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// Longest wait if the eventfd can't be created: the queue is polled instead
+#define UI_ASYNC_POLL_MS    5
+
+typedef struct {
+    lv_async_cb_t cb;
+    void * user_data;
+} ui_async_item_t;
+
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ui_async_item_t queue[UI_ASYNC_QUEUE_LEN];
+static uint32_t queue_head;
+static uint32_t queue_cnt;
+
+// Readable when a call was queued since the last ui_async_wait()
+static pthread_once_t wake_once = PTHREAD_ONCE_INIT;
+static int wake_fd = -1;
+
+static void wake_fd_init(void)
+{
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(wake_fd < 0) LV_LOG_WARN("no eventfd, the queue is polled");
+}
+
+lv_res_t ui_async_call(lv_async_cb_t cb, void * user_data)
+{
+    pthread_mutex_lock(&queue_mutex);
+    if(queue_cnt == UI_ASYNC_QUEUE_LEN) {
+        pthread_mutex_unlock(&queue_mutex);
+        LV_LOG_WARN("the queue is full");
+        return LV_RES_INV;
+    }
+    ui_async_item_t * item = &queue[(queue_head + queue_cnt) % UI_ASYNC_QUEUE_LEN];
+    item->cb = cb;
+    item->user_data = user_data;
+    queue_cnt++;
+    pthread_mutex_unlock(&queue_mutex);
+
+    pthread_once(&wake_once, wake_fd_init);
+    if(wake_fd >= 0) {
+        uint64_t one = 1;
+        if(write(wake_fd, &one, sizeof(one)) < 0) LV_LOG_WARN("can't wake up the LVGL thread");
+    }
+    return LV_RES_OK;
+}
+
+void ui_async_wait(uint32_t timeout_ms)
+{
+    pthread_once(&wake_once, wake_fd_init);
+
+    int timeout = timeout_ms == LV_NO_TIMER_READY ? -1 : (int)LV_MIN(timeout_ms, INT_MAX);
+    if(wake_fd < 0) {
+        poll(NULL, 0, timeout < 0 ? UI_ASYNC_POLL_MS : LV_MIN(timeout, UI_ASYNC_POLL_MS));
+        return;
+    }
+
+    // A signal interrupts the wait too
+    struct pollfd pfd = {.fd = wake_fd, .events = POLLIN};
+    if(poll(&pfd, 1, timeout) > 0) {
+        uint64_t cnt;
+        if(read(wake_fd, &cnt, sizeof(cnt)) < 0) LV_LOG_WARN("can't read the eventfd");
+    }
+}
+
+void ui_async_handler(void)
+{
+    // Only the calls queued before this one runs, a call can queue another one for the next loop
+    pthread_mutex_lock(&queue_mutex);
+    uint32_t cnt = queue_cnt;
+    pthread_mutex_unlock(&queue_mutex);
+
+    while(cnt > 0) {
+        pthread_mutex_lock(&queue_mutex);
+        ui_async_item_t item = queue[queue_head];
+        queue_head = (queue_head + 1) % UI_ASYNC_QUEUE_LEN;
+        queue_cnt--;
+        pthread_mutex_unlock(&queue_mutex);
+
+        item.cb(item.user_data);
+        cnt--;
+    }
+}
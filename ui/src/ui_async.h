@@ -0,0 +1,38 @@
+#ifndef _UI_ASYNC_H
+#define _UI_ASYNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ui.h"
+
+// Max. number of calls waiting for the LVGL thread
+#define UI_ASYNC_QUEUE_LEN  16
+
+/**
+ * Call a function in the LVGL thread. Unlike lv_async_call() it can be called from any thread:
+ * the device threads hand their UI updates over with it instead of touching the objects.
+ * The function has to check that the objects still exist, the screens can be deleted in between.
+ * @param cb        the function to call
+ * @param user_data passed to `cb`
+ * @return          LV_RES_INV: the queue is full, the call is dropped
+ */
+lv_res_t ui_async_call(lv_async_cb_t cb, void * user_data);
+
+/**
+ * Run the queued calls, called by the main loop before lv_timer_handler()
+ */
+void ui_async_handler(void);
+
+/**
+ * Sleep until a call is queued, a signal arrives or the time is up
+ * @param timeout_ms    the time until the next LVGL timer is due, LV_NO_TIMER_READY: no timeout
+ */
+void ui_async_wait(uint32_t timeout_ms);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif
@@ -0,0 +1,396 @@
+#include "ui_hud.h"
+#include "../../lvgl/src/draw/sw/lv_draw_sw.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#define THREAD_MAX      16
+
+typedef struct {
+    int tid;
+    char name[16];
+    uint64_t ticks;             // utime + stime at the last update
+    uint32_t seen;              // Update counter when it was last found in /proc
+} hud_thread_t;
+
+// Measurements since the last update of the HUD
+typedef struct {
+    uint32_t frame_cnt;
+    uint64_t frame_us;
+    uint32_t frame_us_max;
+    uint64_t flush_us;
+    uint64_t spi_bytes;
+    uint64_t px;
+    uint32_t read_cnt;
+    uint64_t read_us;
+    uint32_t touch_latency_ms;  // Press to the end of the next frame, last one
+    uint32_t touch_latency_max;
+} hud_window_t;
+
+static void hud_show(void);
+static void hud_hide(void);
+static void hud_timer_cb(lv_timer_t * timer);
+static void render_start_cb(lv_disp_drv_t * drv);
+static void monitor_cb(lv_disp_drv_t * drv, uint32_t time, uint32_t px);
+static void flush_cb(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_p);
+static void read_cb(lv_indev_drv_t * drv, lv_indev_data_t * data);
+static uint32_t format_caches(char * buf, uint32_t size);
+static uint32_t format_threads(char * buf, uint32_t size, uint32_t elapsed_ms);
+static uint32_t buf_printf(char * buf, uint32_t size, uint32_t len, const char * fmt, ...);
+static uint64_t now_us(void);
+
+static lv_indev_t * hud_indev;
+static bool visible;
+static lv_obj_t * hud_label;
+static lv_timer_t * hud_timer;
+static uint32_t last_update;
+
+// The original driver callbacks
+static void (*orig_render_start_cb)(lv_disp_drv_t * drv);
+static void (*orig_monitor_cb)(lv_disp_drv_t * drv, uint32_t time, uint32_t px);
+static void (*orig_flush_cb)(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_p);
+static void (*orig_read_cb)(lv_indev_drv_t * drv, lv_indev_data_t * data);
+
+static hud_window_t win;
+static uint64_t frame_start_us;
+static uint64_t frame_flush_us;
+static uint64_t press_us;           // Waiting for a frame after this press, 0: none
+static bool last_pressed;
+static uint32_t press_start;
+static bool press_toggled;
+
+static hud_thread_t threads[THREAD_MAX];
+static uint32_t thread_update_cnt;
+static lv_layout_stats_t last_layout_stats;
+
+#if LV_USE_BITMAP_CACHE
+static lv_bitmap_cache_stats_t last_bitmap_stats;
+#endif
+#if LV_DRAW_COMPLEX && LV_SHADOW_CACHE_SIZE
+static lv_draw_sw_shadow_cache_stats_t last_shadow_stats;
+#endif
+#if LV_DRAW_COMPLEX
+static lv_draw_mask_circle_cache_stats_t last_circle_stats;
+#endif
+
+void ui_hud_init(lv_disp_t * disp, lv_indev_t * indev)
+{
+    lv_disp_drv_t * drv = disp->driver;
+    orig_render_start_cb = drv->render_start_cb;
+    orig_monitor_cb = drv->monitor_cb;
+    orig_flush_cb = drv->flush_cb;
+    drv->render_start_cb = render_start_cb;
+    drv->monitor_cb = monitor_cb;
+    drv->flush_cb = flush_cb;
+
+    hud_indev = indev;
+    if(indev) {
+        orig_read_cb = indev->driver->read_cb;
+        indev->driver->read_cb = read_cb;
+    }
+}
+
+void ui_hud_toggle(void)
+{
+    if(visible) hud_hide();
+    else hud_show();
+}
+
+static void hud_show(void)
+{
+    hud_label = lv_label_create(lv_layer_sys());
+    lv_obj_set_style_bg_opa(hud_label, LV_OPA_70, 0);
+    lv_obj_set_style_bg_color(hud_label, lv_color_black(), 0);
+    lv_obj_set_style_text_color(hud_label, lv_color_white(), 0);
+    lv_obj_set_style_text_font(hud_label, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_pad_all(hud_label, 3, 0);
+    lv_obj_align(hud_label, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+    lv_label_set_text(hud_label, "HUD");
+
+    memset(&win, 0, sizeof(win));
+    press_us = 0;
+    last_update = lv_tick_get();
+    visible = true;
+
+    // Start the deltas of the counters from now
+    char tmp[64];
+    format_caches(tmp, sizeof(tmp));
+    format_threads(tmp, sizeof(tmp), 0);
+
+    hud_timer = lv_timer_create(hud_timer_cb, UI_HUD_PERIOD, NULL);
+}
+
+static void hud_hide(void)
+{
+    visible = false;
+    lv_timer_del(hud_timer);
+    hud_timer = NULL;
+    lv_obj_del(hud_label);
+    hud_label = NULL;
+}
+
+static void hud_timer_cb(lv_timer_t * timer)
+{
+    uint32_t elapsed = lv_tick_elaps(last_update);
+    last_update = lv_tick_get();
+    if(elapsed == 0) elapsed = 1;
+
+    char buf[512];
+    uint32_t len = 0;
+    uint32_t frames = win.frame_cnt ? win.frame_cnt : 1;
+    uint64_t render_us = win.frame_us > win.flush_us ? win.frame_us - win.flush_us : 0;
+
+    len = buf_printf(buf, sizeof(buf), len, "%d fps  frame %d.%d ms (max %d.%d)\n",
+                       (int)(win.frame_cnt * 1000 / elapsed), (int)(win.frame_us / frames / 1000),
+                       (int)(win.frame_us / frames / 100 % 10), (int)(win.frame_us_max / 1000),
+                       (int)(win.frame_us_max / 100 % 10));
+    len = buf_printf(buf, sizeof(buf), len, "render %d.%d ms  flush %d.%d ms\n",
+                       (int)(render_us / frames / 1000), (int)(render_us / frames / 100 % 10),
+                       (int)(win.flush_us / frames / 1000), (int)(win.flush_us / frames / 100 % 10));
+
+    // Bytes per us = MB/s
+    uint32_t spi_kbps = win.flush_us ? (uint32_t)(win.spi_bytes * 1000 / win.flush_us) : 0;
+    len = buf_printf(buf, sizeof(buf), len, "SPI %d.%d MB/s  %d px/frame\n", (int)(spi_kbps / 1000),
+                       (int)(spi_kbps / 100 % 10), (int)(win.px / frames));
+
+#if LV_MEM_CUSTOM == 0
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    len = buf_printf(buf, sizeof(buf), len, "mem %d/%d kB  %d%% frag\n",
+                       (int)((mon.total_size - mon.free_size) / 1024), (int)(mon.total_size / 1024), mon.frag_pct);
+#endif
+
+    len += format_caches(buf + len, sizeof(buf) - len);
+
+    // Objects visited per layout pass since the last update
+    lv_layout_stats_t layout;
+    lv_layout_get_stats(&layout);
+    uint32_t passes = layout.passes - last_layout_stats.passes;
+    if(passes) {
+        len = buf_printf(buf, sizeof(buf), len, "layout %d passes  %d obj/pass (%d updated)\n", (int)passes,
+                           (int)((layout.visited - last_layout_stats.visited) / passes),
+                           (int)((layout.updated - last_layout_stats.updated) / passes));
+    }
+    last_layout_stats = layout;
+
+    if(win.read_cnt) {
+        len = buf_printf(buf, sizeof(buf), len, "touch read %d us  to frame %d ms (max %d)\n",
+                           (int)(win.read_us / win.read_cnt), (int)win.touch_latency_ms, (int)win.touch_latency_max);
+    }
+
+    len += format_threads(buf + len, sizeof(buf) - len, elapsed);
+
+    if(len > 0 && buf[len - 1] == '\n') buf[len - 1] = '\0';
+    lv_label_set_text(hud_label, buf);
+
+    uint32_t latency_max = win.touch_latency_max;
+    memset(&win, 0, sizeof(win));
+    win.touch_latency_max = latency_max;
+}
+
+static void render_start_cb(lv_disp_drv_t * drv)
+{
+    if(visible) {
+        frame_start_us = now_us();
+        frame_flush_us = 0;
+    }
+    if(orig_render_start_cb) orig_render_start_cb(drv);
+}
+
+static void monitor_cb(lv_disp_drv_t * drv, uint32_t time, uint32_t px)
+{
+    if(visible && frame_start_us) {
+        uint64_t now = now_us();
+        uint32_t frame_us = now - frame_start_us;
+        win.frame_cnt++;
+        win.frame_us += frame_us;
+        if(frame_us > win.frame_us_max) win.frame_us_max = frame_us;
+        win.flush_us += frame_flush_us;
+        win.px += px;
+        frame_start_us = 0;
+
+        if(press_us) {
+            win.touch_latency_ms = (now - press_us) / 1000;
+            if(win.touch_latency_ms > win.touch_latency_max) win.touch_latency_max = win.touch_latency_ms;
+            press_us = 0;
+        }
+    }
+    if(orig_monitor_cb) orig_monitor_cb(drv, time, px);
+}
+
+static void flush_cb(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_p)
+{
+    if(!visible) {
+        orig_flush_cb(drv, area, color_p);
+        return;
+    }
+
+    uint64_t start = now_us();
+    orig_flush_cb(drv, area, color_p);
+    uint64_t t = now_us() - start;
+    frame_flush_us += t;
+    win.spi_bytes += lv_area_get_size(area) * sizeof(lv_color_t);
+}
+
+static void read_cb(lv_indev_drv_t * drv, lv_indev_data_t * data)
+{
+    uint64_t start = visible ? now_us() : 0;
+    orig_read_cb(drv, data);
+    if(visible) {
+        win.read_us += now_us() - start;
+        win.read_cnt++;
+    }
+
+    bool pressed = data->state == LV_INDEV_STATE_PRESSED;
+    if(pressed && !last_pressed) {
+        press_start = lv_tick_get();
+        press_toggled = false;
+        if(visible) press_us = now_us();
+    }
+    last_pressed = pressed;
+
+    // Hold the top right corner to toggle. Reset the input so the widget under it isn't clicked on release.
+    if(pressed && !press_toggled && data->point.x >= lv_disp_get_hor_res(NULL) - UI_HUD_CORNER_SIZE &&
+       data->point.y < UI_HUD_CORNER_SIZE && lv_tick_elaps(press_start) >= UI_HUD_HOLD_TIME) {
+        press_toggled = true;
+        ui_hud_toggle();
+        lv_indev_reset(hud_indev, NULL);
+        lv_indev_wait_release(hud_indev);
+    }
+}
+
+// Hit rates of the draw caches since the last update
+static uint32_t format_caches(char * buf, uint32_t size)
+{
+    uint32_t len = buf_printf(buf, size, 0, "hit");
+    uint32_t hit, miss;
+
+#if LV_USE_BITMAP_CACHE
+    lv_bitmap_cache_stats_t bitmap;
+    lv_bitmap_cache_get_stats(&bitmap);
+    hit = bitmap.hit_cnt - last_bitmap_stats.hit_cnt;
+    miss = bitmap.miss_cnt - last_bitmap_stats.miss_cnt;
+    last_bitmap_stats = bitmap;
+    if(hit + miss) len = buf_printf(buf, size, len, " bmp %d%%", (int)(hit * 100 / (hit + miss)));
+    else len = buf_printf(buf, size, len, " bmp -");
+#endif
+
+#if LV_DRAW_COMPLEX && LV_SHADOW_CACHE_SIZE
+    lv_draw_sw_shadow_cache_stats_t shadow;
+    lv_draw_sw_shadow_cache_get_stats(&shadow);
+    hit = shadow.hit_cnt - last_shadow_stats.hit_cnt;
+    miss = shadow.miss_cnt - last_shadow_stats.miss_cnt;
+    last_shadow_stats = shadow;
+    if(hit + miss) len = buf_printf(buf, size, len, " shadow %d%%", (int)(hit * 100 / (hit + miss)));
+    else len = buf_printf(buf, size, len, " shadow -");
+#endif
+
+#if LV_DRAW_COMPLEX
+    lv_draw_mask_circle_cache_stats_t circle;
+    lv_draw_mask_get_circle_cache_stats(&circle);
+    hit = circle.hit_cnt - last_circle_stats.hit_cnt;
+    miss = circle.miss_cnt - last_circle_stats.miss_cnt;
+    last_circle_stats = circle;
+    if(hit + miss) len = buf_printf(buf, size, len, " circle %d%%", (int)(hit * 100 / (hit + miss)));
+    else len = buf_printf(buf, size, len, " circle -");
+#endif
+
+    LV_UNUSED(hit);
+    LV_UNUSED(miss);
+    len = buf_printf(buf, size, len, "\n");
+    return len;
+}
+
+// CPU usage of each thread since the last update from /proc/self/task/<tid>/stat
+static uint32_t format_threads(char * buf, uint32_t size, uint32_t elapsed_ms)
+{
+    DIR * dir = opendir("/proc/self/task");
+    if(dir == NULL) return 0;
+
+    long ticks_per_s = sysconf(_SC_CLK_TCK);
+    int main_tid = getpid();
+    uint32_t len = buf_printf(buf, size, 0, "CPU");
+    thread_update_cnt++;
+
+    struct dirent * ent;
+    while((ent = readdir(dir)) != NULL) {
+        int tid = atoi(ent->d_name);
+        if(tid <= 0) continue;
+
+        char path[64];
+        char line[512];
+        snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+        FILE * f = fopen(path, "r");
+        if(f == NULL) continue;
+        bool ok = fgets(line, sizeof(line), f) != NULL;
+        fclose(f);
+        if(!ok) continue;
+
+        // pid (comm) state ... utime is the 14th and stime the 15th field
+        char * name_start = strchr(line, '(');
+        char * name_end = strrchr(line, ')');
+        if(name_start == NULL || name_end == NULL) continue;
+        unsigned long utime, stime;
+        if(sscanf(name_end + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2) continue;
+
+        // Find the thread or a free slot
+        hud_thread_t * t = NULL;
+        uint32_t i;
+        for(i = 0; i < THREAD_MAX; i++) {
+            if(threads[i].tid == tid) {
+                t = &threads[i];
+                break;
+            }
+        }
+        bool is_new = t == NULL;
+        for(i = 0; i < THREAD_MAX && t == NULL; i++) {
+            if(threads[i].tid == 0 || threads[i].seen + 1 < thread_update_cnt) t = &threads[i];
+        }
+        if(t == NULL) continue;
+
+        uint64_t ticks = utime + stime;
+        if(is_new) {
+            t->tid = tid;
+            t->ticks = ticks;
+            *name_end = '\0';
+            snprintf(t->name, sizeof(t->name), "%s", tid == main_tid ? "ui" : name_start + 1);
+        }
+        t->seen = thread_update_cnt;
+
+        if(elapsed_ms > 0 && !is_new) {
+            uint32_t pct = (ticks - t->ticks) * 1000 * 100 / ticks_per_s / elapsed_ms;
+            len = buf_printf(buf, size, len, " %s %d%%", t->name, (int)pct);
+        }
+        t->ticks = ticks;
+    }
+    closedir(dir);
+
+    len = buf_printf(buf, size, len, "\n");
+    return len;
+}
+
+// Append to the `len` long text in `buf` and return the new length, at most `size - 1` if the text was truncated
+static uint32_t buf_printf(char * buf, uint32_t size, uint32_t len, const char * fmt, ...)
+{
+    if(len + 1 >= size) return len;
+
+    va_list args;
+    va_start(args, fmt);
+    int ret = lv_vsnprintf(buf + len, size - len, fmt, args);
+    va_end(args);
+
+    if(ret < 0) return len;
+    len += ret;
+    return len < size ? len : size - 1;
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -0,0 +1,37 @@
+#ifndef _UI_HUD_H
+#define _UI_HUD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ui.h"
+
+// Hold the top right corner of the screen this long to show/hide the HUD [ms]
+#define UI_HUD_HOLD_TIME    2000
+#define UI_HUD_CORNER_SIZE  40
+
+// Refresh period of the HUD [ms]
+#define UI_HUD_PERIOD       1000
+
+/**
+ * Set up the performance HUD: an overlay on the system layer with the render/flush time per frame,
+ * SPI throughput, redrawn pixels, lv_mem usage, the hit rates of the draw caches, touch latency and
+ * the CPU usage of each thread.
+ * The flush, render and touch read callbacks of the drivers are wrapped to measure them.
+ * While the HUD is hidden the wrappers only call the original callbacks.
+ * @param disp      the display to measure
+ * @param indev     the touch input device, holding its top right corner toggles the HUD
+ */
+void ui_hud_init(lv_disp_t * disp, lv_indev_t * indev);
+
+/**
+ * Show or hide the HUD
+ */
+void ui_hud_toggle(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif
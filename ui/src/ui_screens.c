@@ -0,0 +1,118 @@
+#include "ui_screens.h"
+
+typedef struct {
+    lv_obj_t ** scr;            // Where the generated code saves the screen
+    void (*init)(void);
+    void (*destroy)(void);
+    bool pinned;                // Never delete it
+    uint32_t last_used;         // Value of `use_cnt` when it was loaded last time
+} ui_screen_slot_t;
+
+static void screen_build(ui_screen_id_t id);
+static void screen_free(ui_screen_id_t id);
+static void screen_cache_trim(void * user_data);
+static void screen_unloaded_event_cb(lv_event_t * e);
+static uint32_t mem_used(void);
+
+static ui_screen_slot_t slots[_UI_SCREEN_NUM] = {
+    [UI_SCREEN_MAIN]    = { &ui_Main, ui_Main_screen_init, ui_Main_screen_destroy, true },
+    [UI_SCREEN_OPENCV]  = { &ui_OpenCV, ui_OpenCV_screen_init, ui_OpenCV_screen_destroy, false },
+    [UI_SCREEN_SET]     = { &ui_Set, ui_Set_screen_init, ui_Set_screen_destroy, false },
+    [UI_SCREEN_MESSAGE] = { &ui_Message, ui_Message_screen_init, ui_Message_screen_destroy, false },
+};
+
+static ui_screen_info_t infos[_UI_SCREEN_NUM] = {
+    [UI_SCREEN_MAIN]    = { .name = "Main" },
+    [UI_SCREEN_OPENCV]  = { .name = "OpenCV" },
+    [UI_SCREEN_SET]     = { .name = "Set" },
+    [UI_SCREEN_MESSAGE] = { .name = "Message" },
+};
+
+static uint32_t use_cnt;
+
+void ui_screen_load(ui_screen_id_t id, lv_scr_load_anim_t anim, uint32_t time)
+{
+    if(*slots[id].scr == NULL) screen_build(id);
+
+    use_cnt++;
+    slots[id].last_used = use_cnt;
+
+    if(lv_scr_act() == *slots[id].scr) return;
+    lv_scr_load_anim(*slots[id].scr, anim, time, 0, false);
+}
+
+const ui_screen_info_t * ui_screen_get_info(ui_screen_id_t id)
+{
+    return &infos[id];
+}
+
+static void screen_build(ui_screen_id_t id)
+{
+    uint32_t mem_before = mem_used();
+    uint32_t start = lv_tick_get();
+
+    slots[id].init();
+    lv_obj_add_event_cb(*slots[id].scr, screen_unloaded_event_cb, LV_EVENT_SCREEN_UNLOADED, NULL);
+
+    infos[id].build_time = lv_tick_elaps(start);
+    infos[id].mem_size = mem_used() - mem_before;
+    infos[id].build_cnt++;
+    infos[id].built = true;
+
+    LV_LOG_USER("%s screen built in %d ms, %d bytes", infos[id].name, (int)infos[id].build_time,
+                (int)infos[id].mem_size);
+}
+
+static void screen_free(ui_screen_id_t id)
+{
+    uint32_t mem_before = mem_used();
+
+    slots[id].destroy();
+    infos[id].built = false;
+
+    LV_LOG_USER("%s screen deleted, %d bytes freed", infos[id].name, (int)(mem_before - mem_used()));
+    LV_UNUSED(mem_before);  // Only for the log
+}
+
+// Delete the least recently used screens while there are too many.
+// Called asynchronously because the screen being unloaded can't be deleted in its own event.
+static void screen_cache_trim(void * user_data)
+{
+    lv_disp_t * disp = lv_disp_get_default();
+
+    while(1) {
+        uint32_t built_cnt = 0;
+        ui_screen_id_t lru = _UI_SCREEN_NUM;
+        uint32_t i;
+        for(i = 0; i < _UI_SCREEN_NUM; i++) {
+            if(!infos[i].built) continue;
+            built_cnt++;
+
+            // Keep the screens which are shown or about to be shown
+            lv_obj_t * scr = *slots[i].scr;
+            if(slots[i].pinned) continue;
+            if(scr == lv_disp_get_scr_act(disp) || scr == lv_disp_get_scr_prev(disp) || scr == disp->scr_to_load) continue;
+
+            if(lru == _UI_SCREEN_NUM || slots[i].last_used < slots[lru].last_used) lru = (ui_screen_id_t)i;
+        }
+
+        if(built_cnt <= UI_SCREEN_CACHE_SIZE || lru == _UI_SCREEN_NUM) break;
+        screen_free(lru);
+    }
+}
+
+static void screen_unloaded_event_cb(lv_event_t * e)
+{
+    lv_async_call(screen_cache_trim, NULL);
+}
+
+static uint32_t mem_used(void)
+{
+#if LV_MEM_CUSTOM == 0
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.total_size - mon.free_size;
+#else
+    return 0;
+#endif
+}
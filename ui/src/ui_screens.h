@@ -0,0 +1,52 @@
+#ifndef _UI_SCREENS_H
+#define _UI_SCREENS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ui.h"
+
+// Max. number of constructed screens kept in memory (the active one and the home screen included)
+#define UI_SCREEN_CACHE_SIZE 3
+
+typedef enum {
+    UI_SCREEN_MAIN,
+    UI_SCREEN_OPENCV,
+    UI_SCREEN_SET,
+    UI_SCREEN_MESSAGE,
+    _UI_SCREEN_NUM,
+} ui_screen_id_t;
+
+typedef struct {
+    const char * name;
+    bool built;             // The screen exists now
+    uint32_t build_cnt;     // How many times it was constructed
+    uint32_t build_time;    // Duration of the last construction [ms]
+    uint32_t mem_size;      // lv_mem bytes allocated by the last construction
+} ui_screen_info_t;
+
+/**
+ * Construct a screen if it doesn't exist and load it.
+ * Screens which are not used recently are deleted after the screen is unloaded
+ * to keep at most `UI_SCREEN_CACHE_SIZE` screens.
+ * The home screen (Main) is never deleted. The device threads don't touch the objects of the screens:
+ * they queue their updates with ui_async_call(), which drop them while the screen is deleted.
+ * @param id        the screen to load
+ * @param anim      screen load animation
+ * @param time      duration of the animation [ms]
+ */
+void ui_screen_load(ui_screen_id_t id, lv_scr_load_anim_t anim, uint32_t time);
+
+/**
+ * Get the construction statistics of a screen
+ * @param id        a screen
+ * @return          pointer to the statistics
+ */
+const ui_screen_info_t * ui_screen_get_info(ui_screen_id_t id);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif